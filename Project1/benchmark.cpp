@@ -0,0 +1,1467 @@
+﻿#include "utils.h"
+#include <filesystem>
+
+// ====================================================
+// ✅ 性能测试入口
+//     用法：Project1 --bench <名称|all> [图像路径] [K]
+//     先按常规流程完成一次分割，再把结果交给各项测试
+// ====================================================
+
+// 标签图编解码：压缩率、编码/解码吞吐量，并与 PNG-16 对比
+void benchmarkLabelMapCodec(const cv::Mat& markers, int repeats) {
+    const double rawBytes = static_cast<double>(markers.total()) * sizeof(int);
+    std::cout << "【标签图编解码】" << markers.cols << " x " << markers.rows
+        << "，原始大小 " << rawBytes / 1024.0 << " KB" << std::endl;
+
+    std::vector<uint8_t> encoded;
+    double encodeMs = 1e30, decodeMs = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        encodeLabelMap(markers, encoded);
+        encodeMs = std::min(encodeMs, elapsedMs(start));
+    }
+    cv::Mat decoded;
+    bool ok = true;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        ok = decodeLabelMap(encoded, decoded) && ok;
+        decodeMs = std::min(decodeMs, elapsedMs(start));
+    }
+
+    // 往返校验：逐像素比较
+    if (ok) {
+        for (int y = 0; y < markers.rows && ok; ++y) {
+            ok = std::memcmp(markers.ptr<int>(y), decoded.ptr<int>(y), markers.cols * sizeof(int)) == 0;
+        }
+    }
+    std::cout << " 往返校验：" << (ok ? "通过" : "失败") << std::endl;
+
+    auto report = [&](const std::string& name, size_t bytes, double encMs, double decMs) {
+        std::cout << "  " << name
+            << "  大小 " << bytes / 1024.0 << " KB"
+            << "  压缩比 " << rawBytes / std::max<size_t>(bytes, 1)
+            << "  编码 " << rawBytes / 1e6 / (encMs / 1000.0) << " MB/s"
+            << "  解码 " << rawBytes / 1e6 / (decMs / 1000.0) << " MB/s" << std::endl;
+        };
+    report("游程+哈夫曼", encoded.size(), encodeMs, decodeMs);
+
+    // PNG-16（内部为 zlib deflate），标签超出 16 位时跳过
+    double minVal = 0, maxVal = 0;
+    cv::minMaxLoc(markers, &minVal, &maxVal);
+    if (minVal < 0 || maxVal > 65535) {
+        std::cout << "  PNG-16：标签超出 16 位范围，跳过" << std::endl;
+        return;
+    }
+    cv::Mat markers16;
+    markers.convertTo(markers16, CV_16U);
+    for (int level : { 1, 9 }) {
+        std::vector<uchar> png;
+        double pngEncMs = 1e30, pngDecMs = 1e30;
+        for (int i = 0; i < repeats; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            cv::imencode(".png", markers16, png, { cv::IMWRITE_PNG_COMPRESSION, level });
+            pngEncMs = std::min(pngEncMs, elapsedMs(start));
+        }
+        for (int i = 0; i < repeats; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            cv::Mat back = cv::imdecode(png, cv::IMREAD_UNCHANGED);
+            pngDecMs = std::min(pngDecMs, elapsedMs(start));
+        }
+        report("PNG-16 (zlib 级别 " + std::to_string(level) + ")", png.size(), pngEncMs, pngDecMs);
+    }
+}
+
+// 熵编码后端对比：同一标签图分别用哈夫曼与交错 rANS 编码
+void benchmarkEntropyBackends(const cv::Mat& markers, int repeats) {
+    const double rawBytes = static_cast<double>(markers.total()) * sizeof(int);
+    std::cout << "【熵编码后端对比】" << markers.cols << " x " << markers.rows
+        << "，rANS 状态路数 " << RANS_STATE_COUNT << std::endl;
+
+    const std::pair<LabelCodecBackend, const char*> backends[] = {
+        { LABEL_CODEC_HUFFMAN, "哈夫曼" },
+        { LABEL_CODEC_RANS, "交错 rANS" },
+    };
+    for (const auto& [backend, name] : backends) {
+        std::vector<uint8_t> encoded;
+        cv::Mat decoded;
+        double encodeMs = 1e30, decodeMs = 1e30;
+        bool ok = true;
+        for (int i = 0; i < repeats; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            encodeLabelMap(markers, encoded, backend);
+            encodeMs = std::min(encodeMs, elapsedMs(start));
+        }
+        for (int i = 0; i < repeats; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            ok = decodeLabelMap(encoded, decoded) && ok;
+            decodeMs = std::min(decodeMs, elapsedMs(start));
+        }
+        for (int y = 0; y < markers.rows && ok; ++y) {
+            ok = std::memcmp(markers.ptr<int>(y), decoded.ptr<int>(y), markers.cols * sizeof(int)) == 0;
+        }
+        // 后端字节位于头部第 6 字节，标签种类过多时 rANS 会退回哈夫曼
+        bool fellBack = encoded.size() > 5 && encoded[5] != static_cast<uint8_t>(backend);
+        std::cout << "  " << name << (fellBack ? "（标签过多，已退回哈夫曼）" : "")
+            << "  大小 " << encoded.size() / 1024.0 << " KB"
+            << "  压缩比 " << rawBytes / std::max<size_t>(encoded.size(), 1)
+            << "  编码 " << rawBytes / 1e6 / (encodeMs / 1000.0) << " MB/s"
+            << "  解码 " << rawBytes / 1e6 / (decodeMs / 1000.0) << " MB/s"
+            << "  往返校验 " << (ok ? "通过" : "失败") << std::endl;
+    }
+
+    // 裸 rANS 流：每个像素一个上下文符号（0 同左、1 同上、2 其他），直接走 ransEncodeInterleaved / ransDecodeInterleaved，
+    // 解码端同时校验各路终态与字节流是否恰好读完
+    std::vector<uint32_t> symbols;
+    symbols.reserve(markers.total());
+    for (int y = 0; y < markers.rows; ++y) {
+        const int* row = markers.ptr<int>(y);
+        const int* above = y > 0 ? markers.ptr<int>(y - 1) : nullptr;
+        for (int x = 0; x < markers.cols; ++x) {
+            symbols.push_back(x > 0 && row[x] == row[x - 1] ? 0 : above && row[x] == above[x] ? 1 : 2);
+        }
+    }
+    std::vector<uint64_t> counts(3, 0);
+    for (uint32_t s : symbols) counts[s]++;
+    RansModel model;
+    if (!buildRansModel(counts, RANS_MAX_SCALE_BITS, model)) return;
+    const RansModel* models[] = { &model };
+    std::vector<uint8_t> stream;
+    std::vector<uint32_t> decodedSymbols;
+    double encodeMs = 1e30, decodeMs = 1e30;
+    bool ok = true;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        ransEncodeInterleaved(symbols, models, 1, stream);
+        encodeMs = std::min(encodeMs, elapsedMs(start));
+    }
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        ok = ransDecodeInterleaved(stream.data(), stream.size(), models, 1, symbols.size(), decodedSymbols) && ok;
+        decodeMs = std::min(decodeMs, elapsedMs(start));
+    }
+    ok = ok && decodedSymbols == symbols;
+    // 截掉最后一个字节必须被识别出来
+    std::vector<uint32_t> truncated;
+    const bool truncationCaught = stream.size() <= 4 * RANS_STATE_COUNT
+        || !ransDecodeInterleaved(stream.data(), stream.size() - 1, models, 1, symbols.size(), truncated);
+    std::cout << "  裸 rANS 上下文符号  " << symbols.size() << " 个，" << stream.size() / 1024.0 << " KB（"
+        << stream.size() * 8.0 / std::max<size_t>(symbols.size(), 1) << " 位/符号）"
+        << "  编码 " << symbols.size() / 1e6 / (encodeMs / 1000.0) << " M符号/s"
+        << "  解码 " << symbols.size() / 1e6 / (decodeMs / 1000.0) << " M符号/s"
+        << "  往返校验 " << (ok ? "通过" : "失败") << "  截断检测 " << (truncationCaught ? "通过" : "失败") << std::endl;
+}
+
+// 只统计字节数的输出流，用来测量 SVG 生成本身的耗时
+class CountingStreamBuf : public std::streambuf {
+public:
+    size_t bytes = 0;
+protected:
+    std::streamsize xsputn(const char*, std::streamsize n) override { bytes += static_cast<size_t>(n); return n; }
+    int overflow(int c) override { bytes++; return c; }
+};
+
+// 哈夫曼树布局与渲染：随机面积构造 leafCount 片叶子的树
+void benchmarkHuffmanLayout(int leafCount) {
+    std::cout << "【哈夫曼树布局与渲染】叶子数 " << leafCount << std::endl;
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> areaDist(1, 100000);
+    std::map<int, int> areaMap;
+    for (int i = 1; i <= leafCount; ++i) areaMap[i] = areaDist(rng);
+    HuffmanNode* root = buildHuffmanTree(areaMap);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    HuffmanLayout layout = layoutHuffmanTree(root);
+    double layoutMs = elapsedMs(start);
+
+    CountingStreamBuf counter;
+    std::ostream sink(&counter);
+    start = std::chrono::high_resolution_clock::now();
+    writeHuffmanTreeSVG(root, layout, sink);
+    double svgMs = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    cv::Rect tile(std::max(0, root->x - 512), 0, 1024, 1024);
+    cv::Mat tileImage = renderHuffmanTreeTile(root, tile);
+    double tileMs = elapsedMs(start);
+
+    std::cout << "  布局 " << layoutMs << " ms（画布 " << layout.width << " x " << layout.height
+        << "，深度 " << layout.maxDepth << "）" << std::endl;
+    std::cout << "  SVG 流式输出 " << svgMs << " ms，" << counter.bytes / (1024.0 * 1024.0) << " MB" << std::endl;
+    std::cout << "  1024 x 1024 分块渲染 " << tileMs << " ms" << std::endl;
+    deleteHuffmanTree(root);
+}
+
+// 自适应哈夫曼：逐次小幅改变面积，对比增量更新与整棵重建（建树 + 生成字符串码）的单次代价
+void benchmarkAdaptiveHuffman(int regionCount, int updates) {
+    std::cout << "【自适应哈夫曼】区域数 " << regionCount << "，更新次数 " << updates << std::endl;
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> areaDist(50, 5000);
+    std::uniform_int_distribution<int> labelDist(1, regionCount);
+    std::uniform_int_distribution<int> deltaDist(-8, 8);
+    std::map<int, int> areaMap;
+    for (int i = 1; i <= regionCount; ++i) areaMap[i] = areaDist(rng);
+
+    AdaptiveHuffmanTree tree;
+    tree.build(areaMap);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < updates; ++i) {
+        int label = labelDist(rng);
+        int& area = areaMap[label];
+        area = std::max(1, area + deltaDist(rng));
+        tree.updateWeight(label, area);
+    }
+    double adaptiveUs = elapsedMs(start) * 1000.0 / updates;
+
+    // 大幅变化：面积直接换成新的随机值（|Δ| 可达数千，超过阈值时整棵重建）
+    std::uniform_int_distribution<int> jumpDist(50, 50000);
+    const int jumps = std::max(1, updates / 20);
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < jumps; ++i) {
+        int label = labelDist(rng);
+        areaMap[label] = jumpDist(rng);
+        tree.updateWeight(label, areaMap[label]);
+    }
+    double jumpUs = elapsedMs(start) * 1000.0 / jumps;
+
+    // 码字查询：第一遍沿父指针重算并缓存，第二遍命中缓存
+    double lookupUs[2];
+    for (int pass = 0; pass < 2; ++pass) {
+        start = std::chrono::high_resolution_clock::now();
+        for (const auto& entry : areaMap) {
+            HuffmanCode code{};
+            tree.getCode(entry.first, code);
+        }
+        lookupUs[pass] = elapsedMs(start) * 1000.0 / areaMap.size();
+    }
+
+    // 正确性：兄弟性质成立，且总码长与静态最优哈夫曼一致
+    uint64_t adaptiveCost = 0;
+    std::vector<uint64_t> weights;
+    weights.reserve(areaMap.size());
+    for (const auto& [label, area] : areaMap) {
+        HuffmanCode code{};
+        tree.getCode(label, code);
+        adaptiveCost += static_cast<uint64_t>(area) * code.len;
+        weights.push_back(area);
+    }
+    std::vector<uint8_t> lengths;
+    computeHuffmanCodeLengths(weights, HUFFMAN_MAX_CODE_LENGTH, lengths);
+    uint64_t optimalCost = 0;
+    for (size_t i = 0; i < weights.size(); ++i) optimalCost += weights[i] * lengths[i];
+    bool ok = tree.checkSiblingProperty() && adaptiveCost == optimalCost;
+
+    const int rebuilds = std::max(1, std::min(20, 2000000 / regionCount));
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < rebuilds; ++i) {
+        HuffmanNode* root = buildHuffmanTree(areaMap);
+        std::map<int, std::string> codeMap;
+        generateHuffmanCodes(root, "", codeMap);
+        deleteHuffmanTree(root);
+    }
+    double rebuildUs = elapsedMs(start) * 1000.0 / rebuilds;
+
+    std::cout << "  增量更新 " << adaptiveUs << " us/次  整棵重建 " << rebuildUs << " us/次"
+        << "  加速 " << rebuildUs / std::max(adaptiveUs, 1e-9) << "x"
+        << "  校验 " << (ok ? "通过" : "失败") << std::endl;
+    std::cout << "  大幅变化 " << jumpUs << " us/次  码字查询 " << lookupUs[0] << " us（重算） / "
+        << lookupUs[1] << " us（缓存）" << std::endl;
+}
+
+// 分割上下文：逐帧复用缓冲区，统计稳态（第 2 帧起）各阶段的堆分配次数与耗时，并与原有函数对比
+void benchmarkSegmentationContext(const cv::Mat& src, const std::vector<cv::Point>& seeds, int frames) {
+    std::cout << "【分割上下文】" << src.cols << " x " << src.rows << "，种子数 " << seeds.size()
+        << "，帧数 " << frames << std::endl;
+
+    struct StageStats {
+        const char* name;
+        bool owned;            // 完全由本项目代码实现（不依赖 OpenCV 内部临时内存）
+        size_t heap = 0, mat = 0;
+        double ms = 0;
+    };
+    StageStats stages[] = {
+        { "relief", false }, { "flood", false }, { "render:watershed", false },
+        { "adjacency", true }, { "coloring", true }, { "render:coloring", true },
+        { "stats", true }, { "select", true }, { "huffman", true }, { "render:highlight", true },
+    };
+
+    SegmentationContext ctx;
+    cv::Mat watershedView, colorView, highlightView;
+    int conflicts = 0;
+    size_t treeLeaves = 0;
+    setAllocationCounting(true);
+    for (int frame = 0; frame < frames; ++frame) {
+        int s = 0;
+        auto measure = [&](auto&& fn) {
+            size_t heap0 = heapAllocationCount(), mat0 = matAllocationCount();
+            auto start = std::chrono::high_resolution_clock::now();
+            fn();
+            double ms = elapsedMs(start);
+            StageStats& st = stages[s++];
+            if (frame == 0) return;    // 第 1 帧为预热，缓冲区在此扩容
+            st.heap = std::max(st.heap, heapAllocationCount() - heap0);
+            st.mat = std::max(st.mat, matAllocationCount() - mat0);
+            st.ms += ms / (frames - 1);
+            };
+        ctx.beginFrame();
+        measure([&] { ctx.computeRelief(src); });
+        measure([&] { ctx.flood(seeds); });
+        measure([&] { ctx.renderWatershed(src, watershedView); });
+        measure([&] { ctx.buildAdjacency(); });
+        measure([&] { conflicts = ctx.colorRegions(); });
+        measure([&] { ctx.renderColoring(colorView); });
+        measure([&] { ctx.computeRegionStats(); });
+        measure([&] { ctx.selectAreaRange(0, INT_MAX); });
+        measure([&] {
+            HuffmanNode* root = ctx.buildHuffmanTree();
+            treeLeaves = root ? static_cast<size_t>(ctx.selectedEnd() - ctx.selectedBegin()) : 0;
+            });
+        measure([&] { ctx.renderHighlight(src, highlightView, false); });
+    }
+
+    // 原有函数逐帧重新分配，作为对照
+    size_t legacyHeap = 0, legacyMat = 0;
+    double legacyMs = 0;
+    const int legacyFrames = std::max(1, std::min(frames, 3));
+    for (int frame = 0; frame < legacyFrames; ++frame) {
+        std::vector<cv::Point> frameSeeds = seeds;   // 非平面时会被改写，每帧从同一组种子开始
+        size_t heap0 = heapAllocationCount(), mat0 = matAllocationCount();
+        auto start = std::chrono::high_resolution_clock::now();
+        cv::Mat markers = computeMarkers(src.size(), frameSeeds, src);
+        cv::Mat view = applyWatershedWithColor(src, markers);
+        RegionGraph graph = buildRegionAdjacencyGraph(markers);
+        repeatUntilFourColorSuccess(graph);
+        cv::Mat coloring = visualizeFourColoring(markers, graph);
+        std::map<int, int> areaMap = computeRegionAreas(markers);
+        std::vector<AreaEntry> sorted;
+        for (const auto& [label, area] : areaMap) sorted.push_back({ label, area });
+        std::sort(sorted.begin(), sorted.end(), [](const AreaEntry& a, const AreaEntry& b) { return a.area < b.area; });
+        std::set<int> targets = binarySearchInRange(sorted, 0, INT_MAX);
+        auto colorMap = generateColorMap(targets);
+        auto centerMap = computeRegionCenters(markers, areaMap);
+        cv::Mat highlighted = src.clone();
+        highlightRegions(highlighted, markers, targets, colorMap, areaMap, centerMap);
+        deleteHuffmanTree(buildHuffmanTree(areaMap));
+        legacyMs += elapsedMs(start) / legacyFrames;
+        legacyHeap = std::max(legacyHeap, heapAllocationCount() - heap0);
+        legacyMat = std::max(legacyMat, matAllocationCount() - mat0);
+    }
+    setAllocationCounting(false);
+
+    // 邻接关系与原实现逐条比对
+    RegionGraph reference = buildRegionAdjacencyGraph(ctx.markers());
+    const RegionAdjacencyCSR& csr = ctx.adjacency();
+    bool sameGraph = true;
+    for (int l = 1; l <= csr.maxLabel && sameGraph; ++l) {
+        auto it = reference.adjacency.find(l);
+        if (!csr.present[l]) {
+            sameGraph = it == reference.adjacency.end();
+            continue;
+        }
+        sameGraph = it != reference.adjacency.end() && static_cast<int>(it->second.size()) == csr.degree(l)
+            && std::equal(it->second.begin(), it->second.end(), csr.neighbors.begin() + csr.offsets[l]);
+    }
+
+    double totalMs = 0;
+    bool zeroOwned = true;
+    for (const auto& st : stages) {
+        std::cout << "  " << st.name << (st.owned ? "" : "（含 OpenCV 内部分配）")
+            << "  " << st.ms << " ms  operator new " << st.heap << " 次  cv::Mat " << st.mat << " 次" << std::endl;
+        totalMs += st.ms;
+        if (st.owned && (st.heap || st.mat)) zeroOwned = false;
+    }
+    std::cout << "  上下文每帧 " << totalMs << " ms，内存池 " << ctx.arenaCapacity() / 1024 << " KB，哈夫曼叶子 " << treeLeaves
+        << "；原有函数每帧 " << legacyMs << " ms，operator new " << legacyHeap << " 次，cv::Mat " << legacyMat << " 次" << std::endl;
+    std::cout << "  稳态零分配（自有阶段）：" << (zeroOwned ? "通过" : "失败")
+        << "  邻接图一致：" << (sameGraph ? "通过" : "失败")
+        << "  着色冲突边数：" << conflicts << std::endl;
+}
+
+// 标签类型：同一组种子在 12 MP 图像上分别以 32 位与 16 位标签图运行各阶段，取多次中的最短耗时。
+// "遍数"为内核完整扫描标签图的次数，标签带宽 = 遍数 × 标签图字节 / 耗时；
+// flood 与 render:watershed 的主体是 OpenCV watershed（只支持 32 位），不计带宽
+void benchmarkLabelDepth(const cv::Mat& src, int K, int repeats) {
+    cv::Mat image;
+    cv::resize(src, image, cv::Size(4000, 3000));
+    std::vector<cv::Point> seeds = generateSeedPoints(image.size(), K);
+    std::cout << "【标签类型】" << image.cols << " x " << image.rows << "，K = " << K
+        << "，自动选择：" << (selectLabelDepth(K) == CV_16U ? "16 位" : "32 位") << std::endl;
+
+    struct StageTiming {
+        const char* name;
+        int passes;
+        double ms[2] = { 1e300, 1e300 };   // [0] 32 位，[1] 16 位
+    };
+    StageTiming stages[] = {
+        { "flood", 0 }, { "render:watershed", 0 }, { "adjacency", 2 }, { "render:coloring", 1 },
+        { "stats", 1 }, { "render:highlight", 1 }, { "codec:encode", 2 },
+    };
+    SegmentationContext contexts[2];
+    contexts[0].setLabelStorage(LABEL_STORAGE_32S);
+    contexts[1].setLabelStorage(LABEL_STORAGE_16U);
+    cv::Mat watershedView, colorView, highlightView;
+    std::vector<uint8_t> encoded[2];
+    for (int d = 0; d < 2; ++d) {
+        SegmentationContext& ctx = contexts[d];
+        ctx.computeRelief(image);
+        for (int r = 0; r < repeats; ++r) {
+            int s = 0;
+            auto measure = [&](auto&& fn) {
+                auto start = std::chrono::high_resolution_clock::now();
+                fn();
+                stages[s].ms[d] = std::min(stages[s].ms[d], elapsedMs(start));
+                s++;
+                };
+            measure([&] { ctx.flood(seeds); });
+            measure([&] { ctx.renderWatershed(image, watershedView); });
+            measure([&] { ctx.buildAdjacency(); });
+            ctx.colorRegions();
+            measure([&] { ctx.renderColoring(colorView); });
+            measure([&] { ctx.computeRegionStats(); });
+            ctx.selectAreaRange(0, INT_MAX);
+            measure([&] { ctx.renderHighlight(image, highlightView, false); });
+            measure([&] { encodeLabelMap(ctx.markers(), encoded[d]); });
+        }
+    }
+
+    // 两种标签类型的结果逐项比对（32 位图中的非正值在 16 位图中为 0）
+    const cv::Mat& m32 = contexts[0].markers();
+    const cv::Mat& m16 = contexts[1].markers();
+    bool sameMarkers = m16.depth() == CV_16U && m32.size() == m16.size();
+    for (int y = 0; y < m32.rows && sameMarkers; ++y) {
+        const int* a = m32.ptr<int>(y);
+        const uint16_t* b = m16.ptr<uint16_t>(y);
+        for (int x = 0; x < m32.cols; ++x) {
+            if (std::max(a[x], 0) != b[x]) { sameMarkers = false; break; }
+        }
+    }
+    const RegionAdjacencyCSR& g32 = contexts[0].adjacency();
+    const RegionAdjacencyCSR& g16 = contexts[1].adjacency();
+    bool sameResults = sameMarkers && g32.offsets == g16.offsets && g32.neighbors == g16.neighbors
+        && contexts[0].areas() == contexts[1].areas();
+    cv::Mat decoded;
+    bool roundTrip = decodeLabelMap(encoded[1], decoded) && decoded.size() == m16.size();
+    for (int y = 0; y < decoded.rows && roundTrip; ++y) {
+        const int* a = decoded.ptr<int>(y);
+        const uint16_t* b = m16.ptr<uint16_t>(y);
+        for (int x = 0; x < decoded.cols; ++x) {
+            if (a[x] != b[x]) { roundTrip = false; break; }
+        }
+    }
+
+    const double bytes32 = static_cast<double>(m32.total()) * 4, bytes16 = static_cast<double>(m16.total()) * 2;
+    std::cout << "  标签图每遍 " << bytes32 / 1e6 << " MB（32 位） / " << bytes16 / 1e6 << " MB（16 位）" << std::endl;
+    for (const auto& st : stages) {
+        std::cout << "  " << st.name << "  32 位 " << st.ms[0] << " ms  16 位 " << st.ms[1] << " ms  加速 "
+            << st.ms[0] / std::max(st.ms[1], 1e-9) << "x";
+        if (st.passes > 0) {
+            std::cout << "  标签带宽 " << st.passes * bytes32 / (st.ms[0] * 1e6) << " / "
+                << st.passes * bytes16 / (st.ms[1] * 1e6) << " GB/s";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "  结果一致：" << (sameResults ? "通过" : "失败") << "  16 位编解码往返：" << (roundTrip ? "通过" : "失败")
+        << "  码流 " << encoded[0].size() << " / " << encoded[1].size() << " 字节" << std::endl;
+}
+
+// 条带流式分割：
+//   1. 原图写成 PPM，按约 4 条条带的预算流式处理，与整图 SegmentationContext 的结果逐像素比对；
+//   2. 把原图平铺成 8192 x 8192 的 PPM（逐行写出，不在内存中拼整图），在 256 MB 预算下流式处理。
+// 常驻内存峰值是进程级的，包含此前各阶段；单独测量请用 --stream
+void benchmarkStreaming(const cv::Mat& src, const std::vector<cv::Point>& seeds) {
+    std::cout << "【条带流式】" << std::endl;
+    const std::string smallPath = "bench_stream_small.ppm", bigPath = "bench_stream_big.ppm", labelPath = "bench_stream.labels";
+    if (!writePPM(smallPath, src)) {
+        std::cerr << " 无法写入 " << smallPath << std::endl;
+        return;
+    }
+    StripImageReader reader;
+    StreamingOptions options;
+    options.memoryBudget = static_cast<size_t>(src.cols) * 48 * (src.rows / 4 + 3 * options.halo + 2);
+    StreamingResult result;
+    if (!reader.openPPM(smallPath) || !segmentStreaming(reader, seeds, labelPath, options, result)) {
+        std::cerr << " 流式分割失败。" << std::endl;
+        return;
+    }
+    cv::Mat streamed;
+    bool loaded = readLabelFile(labelPath, streamed);
+
+    SegmentationContext ctx;
+    auto start = std::chrono::high_resolution_clock::now();
+    ctx.computeRelief(src);
+    ctx.flood(seeds);
+    ctx.computeRegionStats();
+    double inMemoryMs = elapsedMs(start);
+    cv::Mat reference;
+    ctx.markers().convertTo(reference, CV_32S);
+    cv::Mat streamed32;
+    if (loaded) streamed.convertTo(streamed32, CV_32S);
+    size_t same = 0;
+    for (int y = 0; loaded && y < reference.rows; ++y) {
+        const int* a = reference.ptr<int>(y);
+        const int* b = streamed32.ptr<int>(y);
+        for (int x = 0; x < reference.cols; ++x) same += std::max(a[x], 0) == b[x];
+    }
+    int sameArea = 0;
+    const std::vector<int>& areas = ctx.areas();
+    for (size_t l = 1; l < areas.size() && l < result.areas.size(); ++l) sameArea += areas[l] == result.areas[l];
+    std::cout << "  " << src.cols << " x " << src.rows << "：条带 " << result.strips << " × " << result.stripRows << " 行，流式 "
+        << result.reliefMs + result.floodMs + result.statsMs << " ms，整图 " << inMemoryMs << " ms" << std::endl;
+    std::cout << "  与整图结果一致的像素 " << (loaded ? 100.0 * same / reference.total() : 0.0) << "%，面积一致的区域 "
+        << sameArea << " / " << seeds.size() << std::endl;
+
+    // 平铺大图：逐行镜像平铺原图
+    const int bigCols = 8192, bigRows = 8192;
+    {
+        std::ofstream out(bigPath, std::ios::binary);
+        out << "P6\n" << bigCols << " " << bigRows << "\n255\n";
+        std::vector<uint8_t> row(static_cast<size_t>(bigCols) * 3);
+        for (int y = 0; y < bigRows && out; ++y) {
+            int sy = (y / src.rows) % 2 ? src.rows - 1 - y % src.rows : y % src.rows;
+            const cv::Vec3b* s = src.ptr<cv::Vec3b>(sy);
+            for (int x = 0; x < bigCols; ++x) {
+                int sx = (x / src.cols) % 2 ? src.cols - 1 - x % src.cols : x % src.cols;
+                row[3 * x] = s[sx][2];
+                row[3 * x + 1] = s[sx][1];
+                row[3 * x + 2] = s[sx][0];
+            }
+            out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+        }
+        if (!out) {
+            std::cerr << " 无法写入 " << bigPath << std::endl;
+            return;
+        }
+    }
+    std::vector<cv::Point> bigSeeds = generateSeedPoints(cv::Size(bigCols, bigRows), static_cast<int>(seeds.size()));
+    options.memoryBudget = static_cast<size_t>(256) << 20;
+    if (!reader.openPPM(bigPath) || !segmentStreaming(reader, bigSeeds, labelPath, options, result)) {
+        std::cerr << " 大图流式分割失败。" << std::endl;
+        return;
+    }
+    std::cout << "  " << bigCols << " x " << bigRows << "（预算 256 MB）：条带 " << result.strips << " × " << result.stripRows
+        << " 行，地形图统计 " << result.reliefMs << " ms，淹没 " << result.floodMs << " ms，面积/邻接/着色 " << result.statsMs
+        << " ms，区域 " << result.regions << "，冲突边 " << result.conflicts
+        << "，进程常驻内存峰值 " << (result.peakRss >> 20) << " MB" << std::endl;
+    std::remove(smallPath.c_str());
+    std::remove(bigPath.c_str());
+    std::remove(labelPath.c_str());
+}
+
+// 结果缓存：冷启动（地形图 + 淹没 + 邻接 + 统计 + 写入）与热启动（散列 + 查找 + 映射）对比，
+// 热启动结果逐项比对；再用约 2.5 条记录的磁盘上限连续写入 4 条，检查最近最少使用的记录被淘汰
+void benchmarkResultCache(const cv::Mat& src, const std::vector<cv::Point>& seeds) {
+    std::cout << "【结果缓存】" << std::endl;
+    const std::string directory = "bench_cache";
+    const int K = static_cast<int>(seeds.size());
+    const uint32_t seed = 0;   // 种子点由调用方给出，缓存键中的随机种子取定值
+    std::filesystem::remove_all(directory);
+
+    SegmentationContext cold;
+    uint64_t imageHash = 0;
+    double hashMs, coldMs, storeMs;
+    {
+        SegmentationCache cache(directory);
+        auto start = std::chrono::high_resolution_clock::now();
+        imageHash = SegmentationCache::imageHash(src);
+        hashMs = elapsedMs(start);
+        start = std::chrono::high_resolution_clock::now();
+        cold.computeRelief(src);
+        cold.flood(seeds);
+        cold.buildAdjacency();
+        cold.computeRegionStats();
+        coldMs = elapsedMs(start);
+        start = std::chrono::high_resolution_clock::now();
+        cache.store(imageHash, K, seed, seeds, cold.markers());
+        storeMs = elapsedMs(start);
+    }
+
+    SegmentationCache cache(directory);
+    CachedSegmentation entry;
+    SegmentationContext warm;
+    auto start = std::chrono::high_resolution_clock::now();
+    bool hit = cache.lookup(SegmentationCache::imageHash(src), K, seed, entry);
+    if (hit) warm.attachCached(entry);
+    double warmMs = elapsedMs(start);
+    if (!hit) {
+        std::cerr << " 缓存未命中，测试中止。" << std::endl;
+        return;
+    }
+
+    const cv::Mat& a = cold.markers();
+    const cv::Mat& b = warm.markers();
+    bool same = a.size() == b.size() && a.type() == b.type() && entry.seeds() == seeds;
+    for (int y = 0; y < a.rows && same; ++y) same = std::memcmp(a.ptr(y), b.ptr(y), a.cols * a.elemSize()) == 0;
+    same = same && cold.adjacency().offsets == warm.adjacency().offsets &&
+        cold.adjacency().neighbors == warm.adjacency().neighbors && cold.areas() == warm.areas();
+    cold.colorRegions();
+    warm.colorRegions();
+    same = same && cold.colors() == warm.colors();
+
+    const uint64_t entryBytes = cache.diskUsage();
+    std::cout << "  " << src.cols << " x " << src.rows << "，K = " << K << "，记录 " << entryBytes / 1024 << " KB（标签 "
+        << (entry.labels().depth() == CV_16U ? "16" : "32") << " 位）" << std::endl;
+    std::cout << "  冷启动 " << hashMs + coldMs + storeMs << " ms（散列 " << hashMs << "，分割 " << coldMs << "，写入 " << storeMs
+        << "），热启动 " << warmMs << " ms，加速 " << (hashMs + coldMs + storeMs) / std::max(warmMs, 1e-9) << "x" << std::endl;
+    std::cout << "  热启动结果一致：" << (same ? "通过" : "失败") << std::endl;
+    entry.close();
+    warm.beginFrame();
+
+    // 淘汰：上限约 2.5 条记录，依次写入 K+1..K+4，最早的两条应被删除
+    const std::string evictDirectory = directory + "_lru";
+    std::filesystem::remove_all(evictDirectory);
+    {
+        SegmentationCache small(evictDirectory, entryBytes * 5 / 2);
+        for (int i = 1; i <= 4; ++i) {
+            small.store(imageHash, K + i, seed, seeds, cold.markers());
+            // 修改时间精度可能较粗，先命中第 i 条使其成为最近使用
+            CachedSegmentation touched;
+            small.lookup(imageHash, K + i, seed, touched);
+        }
+        int survivors = 0;
+        for (int i = 1; i <= 4; ++i) {
+            CachedSegmentation probe;
+            survivors += small.lookup(imageHash, K + i, seed, probe);
+        }
+        std::cout << "  磁盘上限 " << entryBytes * 5 / 2 / 1024 << " KB：写入 4 条，淘汰 " << small.evictions() << " 条，保留 "
+            << survivors << " 条，占用 " << small.diskUsage() / 1024 << " KB" << std::endl;
+        small.printStats(std::cout);
+    }
+    cache.printStats(std::cout);
+    std::filesystem::remove_all(evictDirectory);
+}
+
+// 金字塔分水岭：不同下采样层数与条带宽度下，相对原分辨率淹没的加速比和边界一致性；另测 JPEG 缩小解码
+void benchmarkPyramid(const cv::Mat& src, const std::vector<cv::Point>& seeds, const std::string& path) {
+    std::cout << "【金字塔分水岭】" << std::endl;
+    cv::Mat relief = computeWatershedRelief(src);
+    std::vector<cv::Point> referenceSeeds = seeds;   // 对照淹没若重新生成了种子，金字塔也用同一组
+    auto start = std::chrono::high_resolution_clock::now();
+    cv::Mat reference = computeMarkersFromRelief(src.size(), referenceSeeds, relief);
+    double fullMs = elapsedMs(start);
+    std::cout << "  原分辨率淹没 " << fullMs << " ms" << std::endl;
+
+    for (int levels = 1; levels <= 3; ++levels) {
+        for (int band : { 1, 2, 4 }) {
+            PyramidOptions options;
+            options.levels = levels;
+            options.band = band;
+            PyramidStats stats;
+            cv::Mat markers = computeMarkersPyramidFromRelief(referenceSeeds, relief, options, &stats);
+            LabelMapAgreement agreement = compareLabelMaps(reference, markers, 1);
+            const double totalMs = stats.coarseMs + stats.upsampleMs + stats.refineMs;
+            std::cout << "  " << (1 << levels) << " 倍 band " << band << "：" << totalMs << " ms（粗 " << stats.coarseMs
+                << "，细化 " << stats.refineMs << "，条带 " << stats.bandFraction * 100 << "%），加速 "
+                << fullMs / std::max(totalMs, 1e-9) << "x，像素一致 " << agreement.pixelAgreement * 100
+                << "%，边界精确率 " << agreement.boundaryPrecision * 100 << "%，召回率 " << agreement.boundaryRecall * 100
+                << "%" << std::endl;
+        }
+    }
+
+    for (int factor : { 1, 2, 4, 8 }) {
+        start = std::chrono::high_resolution_clock::now();
+        cv::Mat reduced = loadImageReduced(path, factor);
+        double decodeMs = elapsedMs(start);
+        if (reduced.empty()) continue;
+        std::cout << "  解码 1/" << factor << "：" << reduced.cols << " x " << reduced.rows << "，" << decodeMs << " ms" << std::endl;
+    }
+}
+
+// 扫描多个 K：每个 K 重新撒种子淹没，与一次细粒度淹没 + 合并树逐层提取对比；
+// 提取结果的面积与邻接边另按标签图重新统计一遍校验
+void benchmarkHierarchy(const cv::Mat& src, const std::vector<int>& levels) {
+    std::cout << "【层次分水岭】" << std::endl;
+    const int fineK = *std::max_element(levels.begin(), levels.end());
+    SegmentationContext ctx;
+
+    double sweepMs = 0;
+    for (int k : levels) {
+        auto start = std::chrono::high_resolution_clock::now();
+        ctx.beginFrame();
+        ctx.computeRelief(src);
+        ctx.flood(generateSeedPoints(src.size(), k));
+        ctx.buildAdjacency();
+        int conflicts = ctx.colorRegions();
+        ctx.computeRegionStats();
+        double ms = elapsedMs(start);
+        sweepMs += ms;
+        std::cout << "  逐个 K = " << k << "：" << ms << " ms，冲突 " << conflicts << std::endl;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ctx.beginFrame();
+    ctx.computeRelief(src);
+    ctx.flood(generateSeedPoints(src.size(), fineK));
+    ctx.buildAdjacency();
+    ctx.computeRegionStats();
+    WatershedHierarchy hierarchy;
+    if (!hierarchy.build(ctx)) return;
+    double hierarchyMs = elapsedMs(start);
+    std::cout << "  细粒度淹没 + 合并树（" << hierarchy.fineRegionCount() << " 个区域）：" << hierarchyMs << " ms" << std::endl;
+
+    HierarchyLevel level;
+    SegmentationContext check;
+    for (int k : levels) {
+        start = std::chrono::high_resolution_clock::now();
+        hierarchy.extract(k, level);
+        ctx.beginFrame();
+        ctx.attachLevel(level);
+        int conflicts = ctx.colorRegions();
+        double ms = elapsedMs(start);
+        hierarchyMs += ms;
+
+        check.setMarkers(level.labels);
+        check.buildAdjacency();
+        check.computeRegionStats();
+        bool consistent = check.areas() == level.areas && check.adjacency().neighbors == level.graph.neighbors;
+        std::cout << "  提取 " << k << " 个区域：" << ms << " ms，实际 " << level.regionCount << " 个，冲突 " << conflicts
+            << "，面积与邻接" << (consistent ? "一致" : "不一致") << std::endl;
+    }
+    std::cout << "  扫描 " << levels.size() << " 个 K：逐个淹没 " << sweepMs << " ms，层次提取 " << hierarchyMs
+        << " ms，加速 " << sweepMs / std::max(hierarchyMs, 1e-9) << "x" << std::endl;
+}
+
+static RegionAdjacencyCSR graphFromEdges(int vertexCount, const std::vector<std::pair<int, int>>& pairs) {
+    std::vector<uint64_t> edges;
+    for (const auto& [a, b] : pairs) {
+        edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | static_cast<uint32_t>(std::max(a, b)));
+    }
+    RegionAdjacencyCSR graph;
+    finishRegionAdjacencyCSR(edges, vertexCount, graph);
+    graph.present.assign(vertexCount + 1, 1);
+    return graph;
+}
+
+// LR 平面性测试：先在已知答案的小图上自检，再在不同区域数的分割结果上计时（与任务2 共用 CSR 邻接图）；
+// generateSeedPoints 为 O(K²)，这里用固定随机数的均匀种子
+void benchmarkPlanarity(const cv::Mat& src, const std::vector<int>& regionCounts) {
+    std::cout << "【平面性测试】" << std::endl;
+    PlanarityScratch scratch;
+    std::vector<std::pair<int, int>> k5, k33, grid;
+    for (int a = 1; a <= 5; ++a) {
+        for (int b = a + 1; b <= 5; ++b) k5.emplace_back(a, b);
+    }
+    for (int a = 1; a <= 3; ++a) {
+        for (int b = 4; b <= 6; ++b) k33.emplace_back(a, b);
+    }
+    // 约 10 万个顶点的三角网格（平面），以及小网格上对角相连的两条交叉长边（非平面，Kuratowski 子图沿网格延伸）
+    auto triangulatedGrid = [](int side, std::vector<std::pair<int, int>>& edges, bool crossed) {
+        auto id = [&](int y, int x) { return y * side + x + 1; };
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                if (x + 1 < side) edges.emplace_back(id(y, x), id(y, x + 1));
+                if (y + 1 < side) edges.emplace_back(id(y, x), id(y + 1, x));
+                if (x + 1 < side && y + 1 < side) edges.emplace_back(id(y, x), id(y + 1, x + 1));
+            }
+        }
+        if (crossed) {
+            edges.emplace_back(id(0, 0), id(side - 1, side - 1));
+            edges.emplace_back(id(0, side - 1), id(side - 1, 0));
+        }
+        };
+    std::vector<std::pair<int, int>> crossed;
+    triangulatedGrid(316, grid, false);
+    triangulatedGrid(20, crossed, true);
+    struct Case { const char* name; std::vector<std::pair<int, int>>* edges; int vertices; bool planar; };
+    for (const Case& c : { Case{ "K5", &k5, 5, false }, Case{ "K3,3", &k33, 6, false },
+        Case{ "三角网格 316 x 316", &grid, 316 * 316, true }, Case{ "三角网格 20 x 20 + 两条交叉长边", &crossed, 20 * 20, false } }) {
+        RegionAdjacencyCSR graph = graphFromEdges(c.vertices, *c.edges);
+        auto start = std::chrono::high_resolution_clock::now();
+        bool planar = isPlanarCSR(graph, scratch);
+        double testMs = elapsedMs(start);
+        std::cout << "  自检 " << c.name << "：" << (planar ? "平面" : "非平面") << (planar == c.planar ? "（正确）" : "（错误）")
+            << "，" << testMs << " ms";
+        if (!planar) {
+            std::vector<std::pair<int, int>> kuratowski;
+            start = std::chrono::high_resolution_clock::now();
+            findKuratowskiSubgraph(graph, kuratowski, scratch);
+            std::cout << "，" << describeKuratowskiSubgraph(kuratowski) << "，提取 " << elapsedMs(start) << " ms";
+        }
+        std::cout << std::endl;
+    }
+
+    SegmentationContext ctx;
+    ctx.computeRelief(src);
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> xDist(0, src.cols - 1), yDist(0, src.rows - 1);
+    for (int k : regionCounts) {
+        std::vector<cv::Point> seeds(k);
+        for (cv::Point& p : seeds) p = cv::Point(xDist(rng), yDist(rng));
+        ctx.flood(seeds);
+        auto start = std::chrono::high_resolution_clock::now();
+        const RegionAdjacencyCSR& graph = ctx.buildAdjacency();
+        double adjacencyMs = elapsedMs(start);
+        const int repeats = 5;
+        bool planar = true;
+        start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; ++r) planar = ctx.checkPlanarity();
+        double testMs = elapsedMs(start) / repeats;
+        std::cout << "  K = " << k << "：邻接图 " << graph.neighbors.size() / 2 << " 条边（构建 " << adjacencyMs
+            << " ms），LR 测试 " << testMs << " ms，" << (planar ? "平面" : "非平面");
+        if (!planar) {
+            std::vector<std::pair<int, int>> kuratowski;
+            start = std::chrono::high_resolution_clock::now();
+            ctx.checkPlanarity(&kuratowski);
+            std::cout << "，" << describeKuratowskiSubgraph(kuratowski) << "，提取 " << elapsedMs(start) << " ms";
+        }
+        std::cout << std::endl;
+    }
+}
+
+// 标签碎片检测：先在人工植入碎片的块状标签图上自检，再在真实分割结果上与单遍读扫描对比耗时，
+// 拆分后重新检测应不再有碎片
+void benchmarkFragments(const cv::Mat& src, const std::vector<cv::Point>& seeds) {
+    std::cout << "【标签碎片检测】" << std::endl;
+    ComponentScratch scratch;
+    FragmentReport report;
+
+    // 16 x 16 的块，每隔 4 块在块中心植入右侧第二块的标签（3 x 3），与本标签主体不相邻
+    const int block = 16, side = 64;
+    cv::Mat planted(block * side, block * side, CV_32S);
+    for (int y = 0; y < planted.rows; ++y) {
+        for (int x = 0; x < planted.cols; ++x) planted.at<int>(y, x) = (y / block) * side + x / block + 1;
+    }
+    int plantedCount = 0;
+    for (int by = 0; by < side; by += 4) {
+        for (int bx = 0; bx + 2 < side; bx += 4) {
+            cv::Rect patch(bx * block + block / 2 - 1, by * block + block / 2 - 1, 3, 3);
+            planted(patch).setTo(cv::Scalar(by * side + bx + 3));
+            ++plantedCount;
+        }
+    }
+    cv::Mat absorbed = planted.clone();
+    resolveLabelFragments(planted, FRAGMENTS_REPORT, 0, report, scratch);
+    bool ok = report.fragmentedLabels == plantedCount && report.components == side * side + plantedCount;
+    resolveLabelFragments(absorbed, FRAGMENTS_ABSORB, 16, report, scratch);
+    ok = ok && report.absorbedFragments == plantedCount && report.absorbedPixels == plantedCount * 9;
+    for (int y = 0; y < absorbed.rows && ok; ++y) {
+        for (int x = 0; x < absorbed.cols && ok; ++x) ok = absorbed.at<int>(y, x) == (y / block) * side + x / block + 1;
+    }
+    std::cout << "  自检：植入 " << plantedCount << " 个碎片，检测与并入" << (ok ? "正确" : "错误") << std::endl;
+
+    SegmentationContext ctx;
+    ctx.computeRelief(src);
+    ctx.flood(seeds);
+    const cv::Mat& markers = ctx.markers();
+    const int repeats = 5;
+    auto start = std::chrono::high_resolution_clock::now();
+    int64_t checksum = 0;
+    for (int r = 0; r < repeats; ++r) {
+        for (int y = 0; y < markers.rows; ++y) {
+            const int* row = markers.ptr<int>(y);
+            for (int x = 0; x < markers.cols; ++x) checksum += row[x];
+        }
+    }
+    double scanMs = elapsedMs(start) / repeats;
+    std::cout << "  " << markers.cols << " x " << markers.rows << "：单遍读扫描 " << scanMs << " ms（校验和 " << checksum % 1000
+        << "）" << std::endl;
+
+    const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    for (int threads : { 1, std::max(hardware, 1) }) {
+        cv::Mat labels = markers.clone();
+        resolveLabelFragments(labels, FRAGMENTS_REPORT, 0, report, scratch, threads);
+        start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; ++r) resolveLabelFragments(labels, FRAGMENTS_REPORT, 0, report, scratch, threads);
+        double ms = elapsedMs(start) / repeats;
+        int worst = *std::max_element(report.fragmentsPerLabel.begin(), report.fragmentsPerLabel.end());
+        std::cout << "  检测（" << threads << " 线程）：" << ms << " ms，" << ms / std::max(scanMs, 1e-9) << " 倍扫描；"
+            << report.labels << " 个标签，" << report.components << " 个连通分量，" << report.fragmentedLabels
+            << " 个标签有碎片，单个标签最多 " << worst << " 块" << std::endl;
+    }
+
+    for (FragmentPolicy policy : { FRAGMENTS_SPLIT, FRAGMENTS_ABSORB }) {
+        cv::Mat labels = markers.clone();
+        start = std::chrono::high_resolution_clock::now();
+        resolveLabelFragments(labels, policy, 64, report, scratch);
+        double ms = elapsedMs(start);
+        FragmentReport after;
+        resolveLabelFragments(labels, FRAGMENTS_REPORT, 0, after, scratch);
+        std::cout << "  " << (policy == FRAGMENTS_SPLIT ? "拆分" : "并入（面积 < 64）") << "：" << ms << " ms，新标签 "
+            << report.splitFragments << " 个，并入 " << report.absorbedFragments << " 个（" << report.absorbedPixels
+            << " 像素），之后有碎片的标签 " << after.fragmentedLabels << " 个" << std::endl;
+    }
+}
+
+// Lloyd 细化：12 MP、给定 K 时单轮耗时（单线程与全部线程）、每轮 Voronoi 单元面积变异系数，
+// 以及细化前后分水岭区域的面积变异系数与碎区个数
+void benchmarkLloyd(const cv::Mat& src, int K, int iterations) {
+    cv::Mat image;
+    cv::resize(src, image, cv::Size(4000, 3000));
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<cv::Point> seeds = generateSeedPoints(image.size(), K);
+    std::cout << "【Lloyd 细化】" << image.cols << " x " << image.rows << "，K = " << K << "，生成种子 " << elapsedMs(start)
+        << " ms" << std::endl;
+
+    LloydScratch scratch;
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    for (int threads : { 1, hardware }) {
+        std::vector<cv::Point> refined = seeds;
+        LloydOptions options;
+        options.iterations = 1;
+        options.threads = threads;
+        LloydStats stats;
+        refineSeedsLloyd(refined, image.size(), options, scratch, &stats);
+        std::cout << "  " << threads << " 线程单轮：" << stats.jfaMs + stats.reduceMs << " ms（跳跃洪泛 " << stats.jfaMs
+            << "，归约 " << stats.reduceMs << "）" << std::endl;
+    }
+
+    std::vector<cv::Point> refined = seeds;
+    LloydOptions options;
+    options.iterations = iterations;
+    LloydStats stats;
+    refineSeedsLloyd(refined, image.size(), options, scratch, &stats);
+    std::cout << "  " << iterations << " 轮共 " << stats.jfaMs + stats.reduceMs << " ms，Voronoi 单元面积变异系数：";
+    for (double cv : stats.cellAreaCv) std::cout << cv << " ";
+    std::cout << std::endl;
+
+    SegmentationContext ctx;
+    ctx.computeRelief(image);
+    double before = 0;
+    for (const std::vector<cv::Point>* set : { &seeds, &refined }) {
+        ctx.flood(*set);
+        ctx.computeRegionStats();
+        const double spread = areaCoefficientOfVariation(ctx.areas());
+        const double mean = static_cast<double>(image.total()) / K;
+        int slivers = 0;
+        for (int a : ctx.areas()) slivers += a > 0 && a < mean / 10;
+        std::cout << "  " << (set == &seeds ? "细化前" : "细化后") << "分水岭区域面积变异系数 " << spread << "，碎区 " << slivers
+            << " 个";
+        if (set == &seeds) before = spread;
+        else std::cout << "，下降 " << (before > 0 ? (1 - spread / before) * 100 : 0) << "%";
+        std::cout << std::endl;
+    }
+}
+
+// 交互式标记：12 MP 图像上交替画新标记与擦除初始种子，每笔增量重淹没 + 局部重绘的延迟分布，
+// 与整图重淹没 + 整图重绘对比；最后整图重淹没一次，淹没高度应逐像素相同，标签只在等高处可能不同
+void benchmarkInteractive(const cv::Mat& src, int K, int strokes) {
+    cv::Mat image;
+    cv::resize(src, image, cv::Size(4000, 3000));
+    std::vector<cv::Point> seeds = generateSeedPoints(image.size(), K);
+    InteractiveWatershed tool;
+    auto start = std::chrono::high_resolution_clock::now();
+    tool.reset(image, seeds);
+    double resetMs = elapsedMs(start);
+    start = std::chrono::high_resolution_clock::now();
+    tool.refloodAll();
+    double fullMs = elapsedMs(start);
+    std::cout << "【交互式标记】" << image.cols << " x " << image.rows << "，K = " << K << "：地形图 + 首次淹没 " << resetMs
+        << " ms，整图重淹没 + 重绘 " << fullMs << " ms" << std::endl;
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> xDist(0, image.cols - 1), yDist(0, image.rows - 1), lengthDist(-100, 100);
+    std::vector<double> latency;
+    double dirtyArea = 0, relabeled = 0;
+    for (int i = 0; i < strokes; ++i) {
+        StrokeUpdate update;
+        if (i % 2 == 0) {
+            const cv::Point from(xDist(rng), yDist(rng));
+            tool.stroke(from, from + cv::Point(lengthDist(rng), lengthDist(rng)), tool.newLabel(), 5, update);
+        }
+        else {
+            const cv::Point& seed = seeds[rng() % seeds.size()];
+            tool.stroke(seed - cv::Point(20, 0), seed + cv::Point(20, 0), 0, 9, update);
+        }
+        latency.push_back(update.floodMs + update.paintMs);
+        dirtyArea += update.dirty.area();
+        relabeled += update.relabeled;
+    }
+    std::vector<double> sorted = latency;
+    std::sort(sorted.begin(), sorted.end());
+    double mean = 0;
+    for (double ms : latency) mean += ms;
+    mean /= std::max<size_t>(latency.size(), 1);
+    std::cout << "  " << strokes << " 笔（新标记与擦除交替）：平均 " << mean << " ms，p95 " << sorted[sorted.size() * 95 / 100]
+        << " ms，最长 " << sorted.back() << " ms；平均重绘 " << dirtyArea / strokes << " 像素，重定标签 " << relabeled / strokes
+        << " 像素；相对整图加速 " << fullMs / std::max(mean, 1e-9) << "x" << std::endl;
+
+    cv::Mat labels = tool.labels().clone(), levels = tool.levels().clone();
+    tool.refloodAll();
+    size_t sameLevel = 0, sameLabel = 0;
+    for (int y = 0; y < labels.rows; ++y) {
+        const uint16_t* a = levels.ptr<uint16_t>(y);
+        const uint16_t* b = tool.levels().ptr<uint16_t>(y);
+        const int* la = labels.ptr<int>(y);
+        const int* lb = tool.labels().ptr<int>(y);
+        for (int x = 0; x < labels.cols; ++x) {
+            sameLevel += a[x] == b[x];
+            sameLabel += la[x] == lb[x];
+        }
+    }
+    std::cout << "  与整图重淹没对比：淹没高度" << (sameLevel == labels.total() ? "完全一致" : "不一致") << "，标签一致 "
+        << 100.0 * sameLabel / labels.total() << "%" << std::endl;
+}
+
+// 改用共享内核之前 computeMarkersFromRelief 中的修复：逐像素建 std::map 计数，原地按光栅顺序改写
+static void legacyRepairBoundaries(cv::Mat& markers) {
+    for (int y = 0; y < markers.rows; ++y) {
+        for (int x = 0; x < markers.cols; ++x) {
+            int& label = markers.at<int>(y, x);
+            if (label > 0) continue;
+            std::map<int, int> labelCount;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if (dy == 0 && dx == 0) continue;
+                    int ny = y + dy, nx = x + dx;
+                    if (ny >= 0 && ny < markers.rows && nx >= 0 && nx < markers.cols && markers.at<int>(ny, nx) > 0) {
+                        labelCount[markers.at<int>(ny, nx)]++;
+                    }
+                }
+            }
+            if (!labelCount.empty()) {
+                label = std::max_element(labelCount.begin(), labelCount.end(),
+                    [](const auto& a, const auto& b) { return a.second < b.second; })->first;
+            }
+        }
+    }
+}
+
+// 区域轮廓：一遍裂缝跟踪与逐标签 cv::findContours（取前 50 个标签按比例估算全部）的耗时对比，
+// 轮廓序列化与标签图编解码的大小、编码耗时对比；往返校验，并统计多边形面积与区域面积一致的比例
+void benchmarkContours(const cv::Mat& markers, int repeats) {
+    const double rawBytes = static_cast<double>(markers.total()) * markers.elemSize();
+    RegionContours contours;
+    double extractMs = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        extractRegionContours(markers, contours);
+        extractMs = std::min(extractMs, elapsedMs(start));
+    }
+    std::cout << "【区域轮廓】" << markers.cols << " x " << markers.rows << "，" << contours.size() << " 条轮廓，链码共 "
+        << contours.chain.size() << " 步，角点 " << contours.polygon.size() << " 个；一遍提取 " << extractMs << " ms" << std::endl;
+
+    const size_t sampled = std::min<size_t>(contours.size(), 50);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < sampled; ++i) {
+        cv::Mat mask = markers == contours.labels[i];
+        std::vector<std::vector<cv::Point>> found;
+        cv::findContours(mask, found, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+    }
+    const double perLabelMs = sampled ? elapsedMs(start) / sampled * contours.size() : 0;
+    std::cout << "  逐标签 findContours（按 " << sampled << " 个标签估算）：" << perLabelMs << " ms，加速 "
+        << perLabelMs / std::max(extractMs, 1e-9) << "x" << std::endl;
+
+    for (double epsilon : { 1.0, 2.0 }) {
+        RegionContours simplified;
+        start = std::chrono::high_resolution_clock::now();
+        extractRegionContours(markers, simplified, epsilon);
+        std::cout << "  Douglas-Peucker（epsilon = " << epsilon << "）：" << elapsedMs(start) << " ms，顶点 "
+            << simplified.polygon.size() << " 个" << std::endl;
+    }
+
+    // 外边界围成的面积（含孔洞）与区域面积相同时，说明该区域只有一块且没有孔洞
+    std::vector<int64_t> area;
+    for (int y = 0; y < markers.rows; ++y) {
+        for (int x = 0; x < markers.cols; ++x) {
+            const int label = markers.depth() == CV_16U ? markers.at<uint16_t>(y, x) : markers.at<int>(y, x);
+            if (label <= 0) continue;
+            if (static_cast<size_t>(label) >= area.size()) area.resize(static_cast<size_t>(label) + 1, 0);
+            ++area[label];
+        }
+    }
+    size_t exact = 0;
+    for (size_t i = 0; i < contours.size(); ++i) {
+        int64_t twice = 0;
+        const uint32_t a = contours.polygonOffset[i], b = contours.polygonOffset[i + 1];
+        for (uint32_t k = a; k < b; ++k) {
+            const cv::Point& p = contours.polygon[k];
+            const cv::Point& q = contours.polygon[k + 1 < b ? k + 1 : a];
+            twice += static_cast<int64_t>(p.x) * q.y - static_cast<int64_t>(q.x) * p.y;
+        }
+        exact += twice == 2 * area[contours.labels[i]];
+    }
+    std::cout << "  多边形面积与区域面积一致：" << exact << " / " << contours.size() << "（其余区域有碎片或孔洞）" << std::endl;
+
+    std::vector<uint8_t> encoded, labelMap;
+    double encodeMs = 1e30, labelMapMs = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        start = std::chrono::high_resolution_clock::now();
+        encodeRegionContours(contours, encoded);
+        encodeMs = std::min(encodeMs, elapsedMs(start));
+        start = std::chrono::high_resolution_clock::now();
+        encodeLabelMap(markers, labelMap);
+        labelMapMs = std::min(labelMapMs, elapsedMs(start));
+    }
+    RegionContours decoded;
+    const bool ok = decodeRegionContours(encoded.data(), encoded.size(), decoded) && decoded.chain == contours.chain &&
+        decoded.labels == contours.labels && decoded.polygon == contours.polygon;
+    std::cout << "  原始标签图 " << rawBytes / 1024.0 << " KB；轮廓序列化 " << encoded.size() / 1024.0 << " KB（压缩比 "
+        << rawBytes / std::max<size_t>(encoded.size(), 1) << "，提取 + 编码 " << extractMs + encodeMs << " ms，往返"
+        << (ok ? "通过" : "失败") << "）；游程+哈夫曼 " << labelMap.size() / 1024.0 << " KB（" << labelMapMs << " ms）"
+        << std::endl;
+}
+
+// 两张 CV_32S 标签图中不同的像素数
+static size_t countLabelDifferences(const cv::Mat& a, const cv::Mat& b) {
+    size_t diff = 0;
+    for (int y = 0; y < a.rows; ++y) {
+        const int* ra = a.ptr<int>(y);
+        const int* rb = b.ptr<int>(y);
+        for (int x = 0; x < a.cols; ++x) diff += ra[x] != rb[x];
+    }
+    return diff;
+}
+
+// 边界修复：12 MP 淹没结果上对比旧的 std::map 逐像素修复与共享内核（单线程 / 全部线程 / 原地），
+// 内核结果应与线程数无关，且与扫描方向无关（先翻转再修复 == 先修复再翻转）
+void benchmarkBoundary(const cv::Mat& src, int K) {
+    cv::Mat image;
+    cv::resize(src, image, cv::Size(4000, 3000));
+    std::vector<cv::Point> seeds = generateSeedPoints(image.size(), K);
+    SegmentationContext ctx;
+    cv::Mat relief = ctx.computeRelief(image).clone();
+    cv::Mat flooded = cv::Mat::zeros(image.size(), CV_32S);
+    int radius = std::max(3, static_cast<int>(std::sqrt((image.cols * image.rows) / (float)seeds.size()) * 0.001));
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        cv::circle(flooded, seeds[i], radius, cv::Scalar(static_cast<double>(i + 1)), -1);
+    }
+    cv::watershed(relief, flooded);
+    size_t boundary = 0;
+    for (int y = 0; y < flooded.rows; ++y) {
+        const int* row = flooded.ptr<int>(y);
+        for (int x = 0; x < flooded.cols; ++x) boundary += row[x] <= 0;
+    }
+    std::cout << "【边界修复】" << image.cols << " x " << image.rows << "，K = " << K << "，待修复像素 " << boundary << "（"
+        << 100.0 * boundary / flooded.total() << "%）" << std::endl;
+
+    cv::Mat legacy = flooded.clone();
+    auto start = std::chrono::high_resolution_clock::now();
+    legacyRepairBoundaries(legacy);
+    double legacyMs = elapsedMs(start);
+    std::cout << "  std::map 逐像素修复：" << legacyMs << " ms" << std::endl;
+
+    const int repeats = 5;
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    cv::Mat reference;
+    resolveBoundaryLabels(flooded, reference, CV_32S, 1);
+    for (int threads : { 1, hardware }) {
+        cv::Mat out;
+        start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; ++r) resolveBoundaryLabels(flooded, out, CV_32S, threads);
+        double ms = elapsedMs(start) / repeats;
+        std::cout << "  共享内核（" << threads << " 线程）：" << ms << " ms，加速 " << legacyMs / std::max(ms, 1e-9)
+            << "x，与单线程" << (countLabelDifferences(out, reference) == 0 ? "一致" : "不一致") << std::endl;
+    }
+    double inPlaceMs = 0;
+    for (int r = 0; r < repeats; ++r) {
+        cv::Mat labels = flooded.clone();
+        start = std::chrono::high_resolution_clock::now();
+        repairWatershedBoundaries(labels);
+        inPlaceMs += elapsedMs(start);
+        if (r == 0) std::cout << "  原地修复与异址" << (countLabelDifferences(labels, reference) == 0 ? "一致" : "不一致");
+    }
+    std::cout << "，" << inPlaceMs / repeats << " ms" << std::endl;
+
+    cv::Mat flipped, resolvedFlipped, referenceFlipped;
+    cv::flip(flooded, flipped, -1);
+    resolveBoundaryLabels(flipped, resolvedFlipped, CV_32S);
+    cv::flip(reference, referenceFlipped, -1);
+    std::cout << "  扫描方向无关：" << (countLabelDifferences(resolvedFlipped, referenceFlipped) == 0 ? "是" : "否")
+        << "；与旧修复逐像素一致 " << 100.0 - 100.0 * countLabelDifferences(legacy, reference) / flooded.total() << "%"
+        << "（差异来自旧实现按光栅顺序读到已改写的邻居）" << std::endl;
+}
+
+// 同尺寸同类型的两张图逐字节相同
+static bool sameBytes(const cv::Mat& a, const cv::Mat& b) {
+    for (int y = 0; y < a.rows; ++y) {
+        if (std::memcmp(a.ptr(y), b.ptr(y), a.cols * a.elemSize()) != 0) return false;
+    }
+    return true;
+}
+
+// 标签扫描内核：12 MP 分割结果上逐档（标量 / AVX2 / AVX-512，只测本机支持的）计时五个扫描，
+// CV_32S 与 CV_16U 各一遍，输出与标量版逐字节比较
+void benchmarkLabelKernels(const cv::Mat& src, int K, int repeats) {
+    cv::Mat image;
+    cv::resize(src, image, cv::Size(4000, 3000));
+    std::vector<cv::Point> seeds = generateSeedPoints(image.size(), K);
+    cv::Mat labels32 = computeMarkers(image.size(), seeds, image);
+    cv::Mat labels16;
+    labels32.convertTo(labels16, CV_16U);
+    const LabelKernelIsa detected = detectLabelKernelIsa();
+    const double megapixels = labels32.total() / 1e6;
+    std::cout << "【标签扫描内核】" << image.cols << " x " << image.rows << "，K = " << K << "，本机最高档 "
+        << labelKernelIsaName(detected) << std::endl;
+
+    // 每个扫描跑一遍并把输出摊平成字节，用于与标量版比较
+    struct Output {
+        int maxLabel = 0;
+        std::vector<int> areas;
+        std::vector<int64_t> sums;
+        std::vector<uint64_t> edges;
+        cv::Mat rendered, boundary;
+    };
+    std::vector<uint32_t> lut;
+    for (cv::Mat* labels : { &labels32, &labels16 }) {
+        const int maxLabel = labelKernels(LABEL_ISA_SCALAR).maxLabel(*labels);
+        lut.assign(maxLabel + 1, 0);
+        for (int l = 1; l <= maxLabel; ++l) lut[l] = l % 3 ? 0xFF000000u | static_cast<uint32_t>(l) * 2654435761u >> 8 : 0;
+        std::cout << "  " << (labels->depth() == CV_16U ? "CV_16U" : "CV_32S") << std::endl;
+
+        Output reference;
+        double scalarMs[5] = {};
+        for (int isa = LABEL_ISA_SCALAR; isa <= detected; ++isa) {
+            const LabelKernels& k = labelKernels(static_cast<LabelKernelIsa>(isa));
+            Output o;
+            double ms[5] = {};
+            std::vector<int64_t> sumX(maxLabel + 1), sumY(maxLabel + 1);
+            std::vector<uint8_t> present(maxLabel + 1);
+            o.rendered.create(labels->size(), CV_8UC3);
+            o.boundary.create(labels->size(), CV_8U);
+            for (int r = 0; r < repeats; ++r) {
+                auto start = std::chrono::high_resolution_clock::now();
+                o.maxLabel = k.maxLabel(*labels);
+                ms[0] += elapsedMs(start);
+
+                o.areas.assign(maxLabel + 1, 0);
+                std::fill(sumX.begin(), sumX.end(), 0);
+                std::fill(sumY.begin(), sumY.end(), 0);
+                start = std::chrono::high_resolution_clock::now();
+                k.regionStats(*labels, o.areas.data(), sumX.data(), sumY.data());
+                ms[1] += elapsedMs(start);
+
+                o.edges.clear();
+                start = std::chrono::high_resolution_clock::now();
+                k.adjacencyEdges(*labels, labels->rows, o.edges, present);
+                ms[2] += elapsedMs(start);
+
+                o.rendered.setTo(cv::Scalar(0, 0, 0));
+                start = std::chrono::high_resolution_clock::now();
+                k.renderLut(*labels, lut, o.rendered);
+                ms[3] += elapsedMs(start);
+
+                start = std::chrono::high_resolution_clock::now();
+                k.boundaryMask(*labels, o.boundary);
+                ms[4] += elapsedMs(start);
+            }
+            o.sums = sumX;
+            o.sums.insert(o.sums.end(), sumY.begin(), sumY.end());
+            if (isa == LABEL_ISA_SCALAR) reference = o;
+            const bool same[5] = {
+                o.maxLabel == reference.maxLabel,
+                o.areas == reference.areas && o.sums == reference.sums,
+                o.edges == reference.edges,
+                sameBytes(o.rendered, reference.rendered),
+                sameBytes(o.boundary, reference.boundary),
+            };
+            static const char* names[5] = { "maxLabel", "regionStats", "adjacencyEdges", "renderLut", "boundaryMask" };
+            for (int i = 0; i < 5; ++i) {
+                ms[i] /= repeats;
+                if (isa == LABEL_ISA_SCALAR) scalarMs[i] = ms[i];
+                std::cout << "    " << names[i] << "（" << labelKernelIsaName(k.isa) << "）  " << ms[i] << " ms  "
+                    << megapixels / std::max(ms[i], 1e-9) * 1000 << " MP/s  加速 " << scalarMs[i] / std::max(ms[i], 1e-9)
+                    << "x  与标量" << (same[i] ? "一致" : "不一致") << std::endl;
+            }
+        }
+    }
+}
+
+// 合成负载：纹理图像生成吞吐（整图与按行生成须一致）；不同规模、区域数与面积偏斜的合成标签图上
+// 建图、着色、面积统计、哈夫曼与碎片检测耗时；Apollonian 网络与 K5 链上的 CSR 着色与平面性测试，
+// 以及原有 std::map 着色在同一张图上的对照
+void benchmarkSynthetic(const std::vector<int>& megapixels, const std::vector<int>& regionCounts,
+    const std::vector<int>& graphSizes) {
+    std::cout << "【合成负载】" << std::endl;
+    const cv::Size textureSize(4000, 3000);
+    auto start = std::chrono::high_resolution_clock::now();
+    cv::Mat texture = generateTexturedImage(textureSize, 1);
+    double textureMs = elapsedMs(start);
+    cv::Mat strip;
+    generateTextureRows(textureSize, 1, 1000, 1300, strip);
+    std::cout << "  纹理图像 " << textureSize.width << " x " << textureSize.height << "：" << textureMs << " ms，"
+        << textureSize.area() / 1e3 / std::max(textureMs, 1e-9) << " MP/s，按行生成与整图"
+        << (sameBytes(strip, texture.rowRange(1000, 1300)) ? "一致" : "不一致") << std::endl;
+
+    SegmentationContext ctx;
+    ComponentScratch fragmentScratch;
+    for (int mp : megapixels) {
+        const int side = static_cast<int>(std::sqrt(mp * 1e6));
+        for (int k : regionCounts) {
+            for (double skew : { 0.0, 2.0 }) {
+                LabelMapSpec spec;
+                spec.size = cv::Size(side, side);
+                spec.regions = k;
+                spec.sizeSkew = skew;
+                spec.fragmentRate = 0.01;
+                cv::Mat labels;
+                LabelMapInfo info;
+                start = std::chrono::high_resolution_clock::now();
+                if (!generateLabelMap(spec, 7, labels, &info)) continue;
+                double generateMs = elapsedMs(start);
+
+                ctx.beginFrame();
+                ctx.setMarkers(labels);
+                start = std::chrono::high_resolution_clock::now();
+                const RegionAdjacencyCSR& graph = ctx.buildAdjacency();
+                double adjacencyMs = elapsedMs(start);
+                start = std::chrono::high_resolution_clock::now();
+                int conflicts = ctx.colorRegions();
+                double coloringMs = elapsedMs(start);
+                start = std::chrono::high_resolution_clock::now();
+                ctx.computeRegionStats();
+                ctx.selectAreaRange(0, INT_MAX);
+                ctx.buildHuffmanTree();
+                double huffmanMs = elapsedMs(start);
+                FragmentReport report;
+                start = std::chrono::high_resolution_clock::now();
+                resolveLabelFragments(labels, FRAGMENTS_REPORT, 0, report, fragmentScratch);
+                double fragmentMs = elapsedMs(start);
+                std::cout << "  " << side << " x " << side << "，" << k << " 区域，偏斜 " << skew << "（面积 "
+                    << info.smallestArea << " ~ " << info.largestArea << "）：生成 " << generateMs << " ms，建图 "
+                    << adjacencyMs << " ms（" << graph.neighbors.size() / 2 << " 条边），着色 " << coloringMs
+                    << " ms（冲突 " << conflicts << "），面积 + 哈夫曼 " << huffmanMs << " ms，碎片检测 " << fragmentMs
+                    << " ms（植入 " << info.plantedFragments << "，检出 " << report.fragmentedLabels << "）" << std::endl;
+            }
+        }
+    }
+
+    PlanarityScratch planarityScratch;
+    CSRColoringScratch coloringScratch;
+    std::vector<int8_t> colors;
+    for (SyntheticGraphKind kind : { SYNTHETIC_APOLLONIAN, SYNTHETIC_K5_CHAIN, SYNTHETIC_K5_CHAIN_CLOSED }) {
+        for (int n : graphSizes) {
+            RegionAdjacencyCSR graph;
+            start = std::chrono::high_resolution_clock::now();
+            if (!generateSyntheticGraph(kind, n, 7, graph)) continue;
+            double generateMs = elapsedMs(start);
+            start = std::chrono::high_resolution_clock::now();
+            int conflicts = fourColorCSR(graph, colors, coloringScratch);
+            double coloringMs = elapsedMs(start);
+            start = std::chrono::high_resolution_clock::now();
+            bool planar = isPlanarCSR(graph, planarityScratch);
+            double planarMs = elapsedMs(start);
+            std::cout << "  " << syntheticGraphName(kind) << "，" << graph.maxLabel << " 顶点 " << graph.neighbors.size() / 2
+                << " 边：生成 " << generateMs << " ms，CSR 着色 " << coloringMs << " ms（冲突 " << conflicts << "），LR 测试 "
+                << planarMs << " ms，" << (planar ? "平面" : "非平面");
+            // Kuratowski 提取逐边删除重测，随链长超线性增长，只在小图上做
+            if (!planar && graph.maxLabel <= 2000) {
+                std::vector<std::pair<int, int>> kuratowski;
+                start = std::chrono::high_resolution_clock::now();
+                findKuratowskiSubgraph(graph, kuratowski, planarityScratch);
+                std::cout << "，" << describeKuratowskiSubgraph(kuratowski) << "，提取 " << elapsedMs(start) << " ms";
+            }
+            std::cout << std::endl;
+            if (n <= 10000) {
+                RegionGraph legacy;
+                regionGraphFromCSR(graph, legacy);
+                start = std::chrono::high_resolution_clock::now();
+                bool ok = fourColorGraphOptimized(legacy);
+                double legacyMs = elapsedMs(start);
+                // 原实现着色受阻时会删边重试，冲突按未删边的原图计
+                int legacyConflicts = 0;
+                for (int l = 1; l <= graph.maxLabel; ++l) {
+                    auto a = legacy.colorMap.find(l);
+                    for (int i = graph.offsets[l]; i < graph.offsets[l + 1]; ++i) {
+                        const int m = graph.neighbors[i];
+                        if (m < l) continue;
+                        auto b = legacy.colorMap.find(m);
+                        legacyConflicts += a == legacy.colorMap.end() || b == legacy.colorMap.end() || a->second == b->second;
+                    }
+                }
+                std::cout << "    std::map 着色 " << legacyMs << " ms（" << (ok ? "成功" : "失败") << "，原图冲突 " << legacyConflicts
+                    << "）" << std::endl;
+            }
+        }
+    }
+}
+
+int runBenchmarks(int argc, char** argv) {
+    std::string name = argc > 0 ? argv[0] : "all";
+    std::string path = argc > 1 ? argv[1] : "wife.jpg";
+    int K = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    cv::Mat src = cv::imread(path);
+    if (src.empty()) {
+        std::cerr << " 无法读取图像文件 " << path << std::endl;
+        return -1;
+    }
+    if (K < 2) {
+        std::cerr << " K 应不小于 2。" << std::endl;
+        return -1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<cv::Point> seeds = generateSeedPoints(src.size(), K);
+    cv::Mat markers = computeMarkers(src.size(), seeds, src);
+    std::cout << " 分割完成：" << src.cols << " x " << src.rows << "，K = " << K
+        << "，用时 " << elapsedMs(start) << " ms\n" << std::endl;
+
+    bool all = name == "all";
+    bool matched = false;
+    if (all || name == "codec") {
+        benchmarkLabelMapCodec(markers);
+        matched = true;
+    }
+    if (all || name == "entropy") {
+        benchmarkEntropyBackends(markers);
+        matched = true;
+    }
+    if (all || name == "huffman-layout") {
+        benchmarkHuffmanLayout(100000);
+        matched = true;
+    }
+    if (all || name == "context") {
+        benchmarkSegmentationContext(src, seeds);
+        matched = true;
+    }
+    if (all || name == "label-depth") {
+        benchmarkLabelDepth(src, K);
+        matched = true;
+    }
+    if (all || name == "streaming") {
+        benchmarkStreaming(src, seeds);
+        matched = true;
+    }
+    if (all || name == "cache") {
+        benchmarkResultCache(src, seeds);
+        matched = true;
+    }
+    if (all || name == "pyramid") {
+        benchmarkPyramid(src, seeds, path);
+        matched = true;
+    }
+    if (all || name == "hierarchy") {
+        benchmarkHierarchy(src, { 100, 500, 1000, 5000 });
+        matched = true;
+    }
+    if (all || name == "planarity") {
+        benchmarkPlanarity(src, { 1000, 10000, 100000 });
+        matched = true;
+    }
+    if (all || name == "fragments") {
+        benchmarkFragments(src, seeds);
+        matched = true;
+    }
+    if (all || name == "lloyd") {
+        benchmarkLloyd(src, 10000, 5);
+        matched = true;
+    }
+    if (all || name == "interactive") {
+        benchmarkInteractive(src, 1000, 200);
+        matched = true;
+    }
+    if (all || name == "contours") {
+        benchmarkContours(markers);
+        matched = true;
+    }
+    if (all || name == "boundary") {
+        benchmarkBoundary(src, 1000);
+        matched = true;
+    }
+    if (all || name == "kernels") {
+        benchmarkLabelKernels(src, 1000);
+        matched = true;
+    }
+    if (all || name == "synthetic") {
+        benchmarkSynthetic({ 1, 4, 16 }, { 1000, 10000, 100000 }, { 2000, 10000, 1000000 });
+        matched = true;
+    }
+    if (all || name == "adaptive") {
+        for (int n : { 1000, 10000, 100000 }) benchmarkAdaptiveHuffman(n);
+        matched = true;
+    }
+    if (!matched) {
+        std::cerr << " 未知的测试项：" << name << std::endl;
+        return -1;
+    }
+    return 0;
+}
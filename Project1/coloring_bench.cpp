@@ -0,0 +1,289 @@
+﻿#include "utils.h"
+#include <filesystem>
+#include <sstream>
+
+// ====================================================
+// ✅ 着色引擎测试工具
+//     1. 读图：DIMACS（.col / .dimacs）或边表文件读成 RegionAdjacencyCSR，原有 std::map 引擎
+//        再经 regionGraphFromCSR 转成 RegionGraph；未给文件时用 --generate 的合成图；
+//     2. 每个引擎单独计时，带 ColoringProbe 时间预算，统计搜索结点、重来次数与 operator new 峰值字节数
+//        （相对调用前的在用字节数，输入图不计）；
+//     3. 着色结果一律对照原图校验：同色边与未着色顶点都算不合格，引擎自报成功与否单列；
+//     4. 每行一个（图, 引擎）写入 CSV，同时打印到屏幕。
+//     回溯引擎递归深度等于顶点数（-O2 下每层约 200 字节），超过 BACKTRACKING_MAX_VERTICES 时跳过，
+//     以免在 1 MB 默认栈（MSVC）上溢出。
+// ====================================================
+
+const int BACKTRACKING_MAX_VERTICES = 2000;
+
+// ---------------------- 读图 ----------------------
+static uint64_t edgeKey(int a, int b) {
+    return static_cast<uint64_t>(std::min(a, b)) << 32 | static_cast<uint32_t>(std::max(a, b));
+}
+
+static void finishImportedGraph(std::vector<uint64_t>& edges, int vertices, RegionAdjacencyCSR& graph) {
+    finishRegionAdjacencyCSR(edges, vertices, graph);
+    graph.present.assign(vertices + 1, 1);
+    graph.present[0] = 0;
+}
+
+// DIMACS：c 注释，p edge|col 顶点数 边数，e u v（从 1 起）；其他行（n 顶点权重等）忽略，自环与重边去掉
+bool readDimacsGraph(const std::string& path, RegionAdjacencyCSR& graph) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << " 无法打开图文件 " << path << std::endl;
+        return false;
+    }
+    std::vector<uint64_t> edges;
+    std::string line;
+    int vertices = -1, lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        std::istringstream fields(line);
+        char tag = 0;
+        fields >> tag;
+        if (tag == 'p') {
+            std::string format;
+            long long v = -1, e = 0;
+            fields >> format >> v >> e;
+            if (!fields || v < 0 || v > INT_MAX - 3 || e < 0) {
+                std::cerr << " " << path << " 第 " << lineNo << " 行：p 行格式错误。" << std::endl;
+                return false;
+            }
+            vertices = static_cast<int>(v);
+            edges.reserve(static_cast<size_t>(std::min<long long>(e, 1 << 26)));
+        }
+        else if (tag == 'e') {
+            int u = 0, v = 0;
+            fields >> u >> v;
+            if (!fields || vertices < 0 || u < 1 || v < 1 || u > vertices || v > vertices) {
+                std::cerr << " " << path << " 第 " << lineNo << " 行：边格式错误或顶点越界（须在 p 行之后）。" << std::endl;
+                return false;
+            }
+            if (u != v) edges.push_back(edgeKey(u, v));
+        }
+    }
+    if (vertices < 0) {
+        std::cerr << " " << path << " 缺少 p 行。" << std::endl;
+        return false;
+    }
+    finishImportedGraph(edges, vertices, graph);
+    return true;
+}
+
+// 边表：每行 "u v"，其后的权重等列忽略，# 或 % 开头为注释；编号为任意非负整数，按大小依次映射到 1..n
+bool readEdgeListGraph(const std::string& path, RegionAdjacencyCSR& graph) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << " 无法打开图文件 " << path << std::endl;
+        return false;
+    }
+    std::vector<std::pair<long long, long long>> pairs;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#' || line[first] == '%') continue;
+        std::istringstream fields(line);
+        long long u = -1, v = -1;
+        fields >> u >> v;
+        if (!fields || u < 0 || v < 0) {
+            std::cerr << " " << path << " 第 " << lineNo << " 行：应为两个非负整数。" << std::endl;
+            return false;
+        }
+        pairs.emplace_back(u, v);
+    }
+    std::vector<long long> ids;
+    ids.reserve(pairs.size() * 2);
+    for (const auto& [u, v] : pairs) {
+        ids.push_back(u);
+        ids.push_back(v);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    if (ids.size() > static_cast<size_t>(INT_MAX - 3)) {
+        std::cerr << " " << path << " 顶点过多。" << std::endl;
+        return false;
+    }
+    auto label = [&](long long id) {
+        return static_cast<int>(std::lower_bound(ids.begin(), ids.end(), id) - ids.begin()) + 1;
+    };
+    std::vector<uint64_t> edges;
+    edges.reserve(pairs.size());
+    for (const auto& [u, v] : pairs) {
+        if (u != v) edges.push_back(edgeKey(label(u), label(v)));
+    }
+    finishImportedGraph(edges, static_cast<int>(ids.size()), graph);
+    return true;
+}
+
+bool readGraphFile(const std::string& path, RegionAdjacencyCSR& graph) {
+    const std::string ext = std::filesystem::path(path).extension().string();
+    if (ext == ".col" || ext == ".dimacs") return readDimacsGraph(path, graph);
+    return readEdgeListGraph(path, graph);
+}
+
+// ---------------------- 运行与校验 ----------------------
+enum ColoringEngine { ENGINE_BACKTRACKING, ENGINE_OPTIMIZED, ENGINE_REPEAT, ENGINE_CSR, ENGINE_COUNT };
+static const char* const ENGINE_NAMES[ENGINE_COUNT] = { "backtracking", "optimized", "repeat", "csr" };
+
+struct ColoringRun {
+    const char* status = "skipped";   // ok / invalid（自报成功但校验不过）/ failed / timeout / skipped
+    bool claimed = false;             // 引擎自报成功
+    double ms = 0;
+    int64_t nodes = 0;
+    int restarts = 0;
+    size_t peakBytes = 0;
+    int conflicts = 0, uncolored = 0;
+};
+
+// 原有引擎逐区域打印着色结果，计时期间摘掉 cout / cerr 的缓冲区（流置 bad，输出直接丢弃）
+struct MutedStreams {
+    std::streambuf* out = std::cout.rdbuf(nullptr);
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    ~MutedStreams() {
+        std::cout.rdbuf(out);
+        std::cerr.rdbuf(err);
+        std::cout.clear();
+        std::cerr.clear();
+    }
+};
+
+static void validateColoring(const RegionAdjacencyCSR& graph, const std::vector<int8_t>& colors, ColoringRun& run) {
+    run.conflicts = run.uncolored = 0;
+    for (int l = 1; l <= graph.maxLabel; ++l) {
+        if (!graph.present[l]) continue;
+        if (colors[l] < 0 || colors[l] > 3) {
+            run.uncolored++;
+            continue;
+        }
+        for (int i = graph.offsets[l]; i < graph.offsets[l + 1]; ++i) {
+            const int m = graph.neighbors[i];
+            if (m > l && colors[m] == colors[l]) run.conflicts++;
+        }
+    }
+}
+
+static ColoringRun runColoringEngine(ColoringEngine engine, const RegionAdjacencyCSR& graph, double budgetMs) {
+    ColoringRun run;
+    if (engine == ENGINE_BACKTRACKING && graph.maxLabel > BACKTRACKING_MAX_VERTICES) return run;
+    RegionGraph legacy;
+    if (engine != ENGINE_CSR) regionGraphFromCSR(graph, legacy);   // 输入准备不计时、不计峰值
+
+    std::vector<int8_t> colors;
+    ColoringProbe probe;
+    setAllocationCounting(true);   // 只在计时区间内计数，关闭前分配的块释放时不计
+    const size_t liveBefore = heapLiveBytes();
+    resetHeapPeak();
+    auto start = std::chrono::high_resolution_clock::now();
+    probe.deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(budgetMs * 1000));
+    {
+        MutedStreams muted;
+        switch (engine) {
+        case ENGINE_BACKTRACKING: run.claimed = fourColorGraphBacktracking(legacy, &probe); break;
+        case ENGINE_OPTIMIZED: run.claimed = fourColorGraphOptimized(legacy, &probe); break;
+        case ENGINE_REPEAT: run.claimed = repeatUntilFourColorSuccess(legacy, &probe); break;
+        default: {
+            CSRColoringScratch scratch;
+            run.claimed = fourColorCSR(graph, colors, scratch, &probe) == 0 && !probe.timedOut;
+        }
+        }
+    }
+    run.ms = elapsedMs(start);
+    run.peakBytes = heapPeakBytes() - liveBefore;
+    setAllocationCounting(false);
+    run.nodes = probe.nodes;
+    run.restarts = probe.restarts;
+
+    if (engine != ENGINE_CSR) {
+        colors.assign(graph.maxLabel + 1, -1);
+        for (const auto& [label, c] : legacy.colorMap) {
+            if (label >= 1 && label <= graph.maxLabel) colors[label] = static_cast<int8_t>(c >= 0 && c < 4 ? c : -1);
+        }
+    }
+    validateColoring(graph, colors, run);
+    if (probe.timedOut) run.status = "timeout";
+    else if (!run.claimed) run.status = "failed";
+    else run.status = run.conflicts || run.uncolored ? "invalid" : "ok";
+    return run;
+}
+
+// 含逗号或引号的字段按 RFC 4180 加引号
+static std::string csvField(const std::string& s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string quoted = "\"";
+    for (char c : s) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// ---------------------- 入口 ----------------------
+// 着色测试模式：Project1 --color-bench [输出.csv] [时间预算ms] [引擎列表，逗号分隔|all] [图文件...]
+//   引擎：backtracking、optimized（单次 fourColorGraphOptimized）、repeat（repeatUntilFourColorSuccess）、csr；
+//   .col / .dimacs 按 DIMACS 读，其余按边表读；不给图文件时跑内置的合成图（固定随机种子）
+int runColorBench(int argc, char** argv) {
+    const std::string csvPath = argc > 0 ? argv[0] : "coloring.csv";
+    const double budgetMs = argc > 1 ? std::atof(argv[1]) : 10000;
+    const std::string engineList = argc > 2 ? argv[2] : "all";
+    if (budgetMs <= 0) {
+        std::cerr << " 参数非法：时间预算应为正数（毫秒）。" << std::endl;
+        return -1;
+    }
+    std::vector<ColoringEngine> engines;
+    std::stringstream names(engineList);
+    for (std::string name; std::getline(names, name, ',');) {
+        for (int e = 0; e < ENGINE_COUNT; ++e) {
+            if (name == "all" || name == ENGINE_NAMES[e]) engines.push_back(static_cast<ColoringEngine>(e));
+        }
+    }
+    if (engines.empty()) {
+        std::cerr << " 未知引擎 " << engineList << "，可选 backtracking、optimized、repeat、csr 或 all。" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::pair<std::string, RegionAdjacencyCSR>> graphs;
+    for (int i = 3; i < argc; ++i) {
+        RegionAdjacencyCSR graph;
+        if (!readGraphFile(argv[i], graph)) return -1;
+        graphs.emplace_back(std::filesystem::path(argv[i]).filename().string(), std::move(graph));
+    }
+    if (graphs.empty()) {
+        const std::pair<SyntheticGraphKind, int> suite[] = {
+            { SYNTHETIC_APOLLONIAN, 1000 }, { SYNTHETIC_APOLLONIAN, 10000 }, { SYNTHETIC_APOLLONIAN, 100000 },
+            { SYNTHETIC_K5_CHAIN, 1001 }, { SYNTHETIC_K5_CHAIN, 100001 },
+            { SYNTHETIC_K5_CHAIN_CLOSED, 1001 }, { SYNTHETIC_K5_CHAIN_CLOSED, 100001 } };
+        for (const auto& [kind, n] : suite) {
+            RegionAdjacencyCSR graph;
+            generateSyntheticGraph(kind, n, 1, graph);
+            graphs.emplace_back(std::string(syntheticGraphName(kind)) + "-" + std::to_string(n), std::move(graph));
+        }
+    }
+
+    std::ofstream csv(csvPath);
+    if (!csv) {
+        std::cerr << " 无法写出 " << csvPath << std::endl;
+        return -1;
+    }
+    csv << "graph,vertices,edges,engine,status,claimed,ms,nodes,restarts,peak_bytes,conflicts,uncolored\n";
+    std::cout << "【着色引擎】时间预算 " << budgetMs << " ms，结果写入 " << csvPath << std::endl;
+    for (const auto& [name, graph] : graphs) {
+        const size_t edges = graph.neighbors.size() / 2;
+        std::cout << " " << name << "：" << graph.maxLabel << " 顶点，" << edges << " 条边" << std::endl;
+        for (ColoringEngine engine : engines) {
+            const ColoringRun run = runColoringEngine(engine, graph, budgetMs);
+            csv << csvField(name) << "," << graph.maxLabel << "," << edges << "," << ENGINE_NAMES[engine] << ","
+                << run.status << "," << run.claimed << "," << run.ms << "," << run.nodes << "," << run.restarts << ","
+                << run.peakBytes << "," << run.conflicts << "," << run.uncolored << "\n";
+            std::cout << "   " << ENGINE_NAMES[engine] << "  " << run.status;
+            if (std::string(run.status) != "skipped") {
+                std::cout << "  " << run.ms << " ms  结点 " << run.nodes << "  重来 " << run.restarts << "  峰值 "
+                    << run.peakBytes / 1024.0 << " KB  同色边 " << run.conflicts << "  未着色 " << run.uncolored;
+            }
+            std::cout << std::endl;
+        }
+    }
+    return csv ? 0 : -1;
+}
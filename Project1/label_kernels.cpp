@@ -0,0 +1,528 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 逐像素标签扫描内核（标量 / AVX2 / AVX-512，运行时按 CPUID 选择）
+//     最大标签、面积与质心累加、邻接边扫描、查表渲染、边界掩码五个扫描各有三份实现，
+//     同一份可执行文件在不同机器上自动取 CPU 与操作系统都支持的最高档，无需分别编译。
+//     向量版只负责"跳过无事可做的像素"或"批量算同一件事"，落到每个像素上的结果与标量版逐字节相同：
+//       · 面积与质心：向量比较找同标签游程的终点，整段一次累加（等差数列求和，整数运算）；
+//       · 邻接边：与右、下、右下、左下都相同的像素不产生边，整段跳过，其余像素按原顺序逐个处理；
+//       · 查表渲染：gather 取 32 位表项（低 3 字节为 BGR，最高位为 1 表示写入），按符号位合并；
+//       · 边界掩码：与右邻或下邻不同记为 1。
+//     只在 x64 上编译向量版；32 位与其他平台只有标量版。
+// ====================================================
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define LABEL_KERNELS_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#include <cpuid.h>
+#define TARGET_AVX2 __attribute__((target("avx2,bmi")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,bmi,bmi2")))
+#endif
+#endif
+
+// ---------------------- 共用的逐像素处理 ----------------------
+// 邻接边：(小标签 << 32 | 大标签)，沿边界连续重复的边只记一次
+struct EdgeAppender {
+    std::vector<uint64_t>& edges;
+    uint64_t last = ~static_cast<uint64_t>(0);
+    void add(int a, int b) {
+        if (a == b || b <= 0) return;
+        uint64_t key = a < b ? (static_cast<uint64_t>(a) << 32 | static_cast<uint32_t>(b))
+            : (static_cast<uint64_t>(b) << 32 | static_cast<uint32_t>(a));
+        if (key != last) {
+            edges.push_back(key);
+            last = key;
+        }
+    }
+};
+
+// 单个像素的右、下、右下、左下四个方向
+template <typename Label>
+static inline void visitAdjacency(const Label* row, const Label* next, int x, int cols, EdgeAppender& out,
+    std::vector<uint8_t>& present) {
+    int a = row[x];
+    if (a <= 0) return;
+    present[a] = 1;
+    if (x + 1 < cols) out.add(a, row[x + 1]);
+    if (next) {
+        out.add(a, next[x]);
+        if (x + 1 < cols) out.add(a, next[x + 1]);
+        if (x > 0) out.add(a, next[x - 1]);
+    }
+}
+
+static inline void writeLutPixel(uchar* dst, uint32_t v) {
+    if (!(v >> 31)) return;
+    dst[0] = static_cast<uchar>(v);
+    dst[1] = static_cast<uchar>(v >> 8);
+    dst[2] = static_cast<uchar>(v >> 16);
+}
+
+static inline uint32_t lutEntry(const std::vector<uint32_t>& lut, int l) {
+    return lut[l > 0 && l < static_cast<int>(lut.size()) ? l : 0];
+}
+
+// ---------------------- 标量参考实现 ----------------------
+template <typename Label>
+static int maxLabelScalarT(const cv::Mat& labels) {
+    Label m = 0;
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        for (int x = 0; x < labels.cols; ++x) m = std::max(m, row[x]);
+    }
+    return static_cast<int>(m);
+}
+
+template <typename Label>
+static void regionStatsScalarT(const cv::Mat& labels, int* areas, int64_t* sumX, int64_t* sumY) {
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        for (int x = 0; x < labels.cols; ++x) {
+            int l = row[x];
+            if (l <= 0) continue;
+            areas[l]++;
+            sumX[l] += x;
+            sumY[l] += y;
+        }
+    }
+}
+
+template <typename Label>
+static void adjacencyEdgesScalarT(const cv::Mat& labels, int rowCount, std::vector<uint64_t>& edges, std::vector<uint8_t>& present) {
+    EdgeAppender out{ edges };
+    for (int y = 0; y < rowCount; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        const Label* next = y + 1 < labels.rows ? labels.ptr<Label>(y + 1) : nullptr;
+        for (int x = 0; x < labels.cols; ++x) visitAdjacency(row, next, x, labels.cols, out, present);
+    }
+}
+
+template <typename Label>
+static void renderLutScalarT(const cv::Mat& labels, const std::vector<uint32_t>& lut, cv::Mat& out) {
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        uchar* dst = out.ptr<uchar>(y);
+        for (int x = 0; x < labels.cols; ++x) writeLutPixel(dst + 3 * x, lutEntry(lut, row[x]));
+    }
+}
+
+template <typename Label>
+static void boundaryMaskScalarT(const cv::Mat& labels, cv::Mat& out) {
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        const Label* next = y + 1 < labels.rows ? labels.ptr<Label>(y + 1) : nullptr;
+        uchar* b = out.ptr<uchar>(y);
+        for (int x = 0; x < labels.cols; ++x) {
+            b[x] = (x + 1 < labels.cols && row[x] != row[x + 1]) || (next && row[x] != next[x]);
+        }
+    }
+}
+
+#ifdef LABEL_KERNELS_X64
+// ---------------------- AVX2：每次 8 个标签（16 位标签零扩展到 32 位） ----------------------
+TARGET_AVX2 static inline __m256i load8(const int* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+TARGET_AVX2 static inline __m256i load8(const uint16_t* p) {
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+TARGET_AVX2 static inline unsigned mask8(__m256i v) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(v))); }
+
+template <typename Label>
+TARGET_AVX2 static int maxLabelAvx2T(const cv::Mat& labels) {
+    __m256i m = _mm256_setzero_si256();
+    int tail = 0;
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        int x = 0;
+        for (; x + 8 <= labels.cols; x += 8) m = _mm256_max_epi32(m, load8(row + x));
+        for (; x < labels.cols; ++x) tail = std::max(tail, static_cast<int>(row[x]));
+    }
+    alignas(32) int lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), m);
+    for (int v : lanes) tail = std::max(tail, v);
+    return tail;
+}
+
+// 从 x 起第一个标签不等于 l 的位置（没有则为 cols）
+template <typename Label>
+TARGET_AVX2 static inline int runEndAvx2(const Label* row, int x, int cols, int l) {
+    const __m256i v = _mm256_set1_epi32(l);
+    for (; x + 8 <= cols; x += 8) {
+        unsigned diff = ~mask8(_mm256_cmpeq_epi32(load8(row + x), v)) & 0xFF;
+        if (diff) return x + static_cast<int>(_tzcnt_u32(diff));
+    }
+    while (x < cols && static_cast<int>(row[x]) == l) ++x;
+    return x;
+}
+
+template <typename Label>
+TARGET_AVX2 static void regionStatsAvx2T(const cv::Mat& labels, int* areas, int64_t* sumX, int64_t* sumY) {
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        for (int x = 0; x < labels.cols;) {
+            const int l = row[x];
+            const int end = runEndAvx2(row, x + 1, labels.cols, l);
+            if (l > 0) {
+                const int64_t len = end - x;
+                areas[l] += static_cast<int>(len);
+                sumX[l] += (static_cast<int64_t>(x) + end - 1) * len / 2;
+                sumY[l] += static_cast<int64_t>(y) * len;
+            }
+            x = end;
+        }
+    }
+}
+
+template <typename Label>
+TARGET_AVX2 static void adjacencyEdgesAvx2T(const cv::Mat& labels, int rowCount, std::vector<uint64_t>& edges, std::vector<uint8_t>& present) {
+    EdgeAppender out{ edges };
+    const int cols = labels.cols;
+    const __m256i zero = _mm256_setzero_si256();
+    for (int y = 0; y < rowCount; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        const Label* next = y + 1 < labels.rows ? labels.ptr<Label>(y + 1) : nullptr;
+        if (cols > 0) visitAdjacency(row, next, 0, cols, out, present);
+        int x = 1;
+        // 读 row[x, x + 8] 与 next[x - 1, x + 8]，最后一列总是逐像素处理
+        for (; x + 9 <= cols; x += 8) {
+            const __m256i a = load8(row + x);
+            __m256i same = _mm256_cmpeq_epi32(a, load8(row + x + 1));
+            if (next) {
+                same = _mm256_and_si256(same, _mm256_cmpeq_epi32(a, load8(next + x)));
+                same = _mm256_and_si256(same, _mm256_cmpeq_epi32(a, load8(next + x + 1)));
+                same = _mm256_and_si256(same, _mm256_cmpeq_epi32(a, load8(next + x - 1)));
+            }
+            unsigned todo = mask8(_mm256_andnot_si256(same, _mm256_cmpgt_epi32(a, zero)));
+            while (todo) {
+                visitAdjacency(row, next, x + static_cast<int>(_tzcnt_u32(todo)), cols, out, present);
+                todo &= todo - 1;
+            }
+        }
+        for (; x < cols; ++x) visitAdjacency(row, next, x, cols, out, present);
+    }
+}
+
+// 8 个 BGRx 像素按写入掩码合并到 dst[0, 24)；两次 16 字节读写，dst[24, 28) 原样写回，调用方保证行内可读写
+TARGET_AVX2 static inline void blendBgr8(uchar* dst, __m256i bgrx, __m256i write) {
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256i c = _mm256_shuffle_epi8(bgrx, pack);
+    const __m256i m = _mm256_shuffle_epi8(write, pack);
+    const __m128i old0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+    const __m128i old1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + 12));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+        _mm_blendv_epi8(old0, _mm256_castsi256_si128(c), _mm256_castsi256_si128(m)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 12),
+        _mm_blendv_epi8(old1, _mm256_extracti128_si256(c, 1), _mm256_extracti128_si256(m, 1)));
+}
+
+template <typename Label>
+TARGET_AVX2 static void renderLutAvx2T(const cv::Mat& labels, const std::vector<uint32_t>& lut, cv::Mat& out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i size = _mm256_set1_epi32(static_cast<int>(lut.size()));
+    const int* table = reinterpret_cast<const int*>(lut.data());
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        uchar* dst = out.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 10 <= labels.cols; x += 8) {
+            const __m256i l = load8(row + x);
+            const __m256i valid = _mm256_and_si256(_mm256_cmpgt_epi32(l, zero), _mm256_cmpgt_epi32(size, l));
+            const __m256i v = _mm256_i32gather_epi32(table, _mm256_and_si256(l, valid), 4);
+            blendBgr8(dst + 3 * x, v, _mm256_srai_epi32(v, 31));
+        }
+        for (; x < labels.cols; ++x) writeLutPixel(dst + 3 * x, lutEntry(lut, row[x]));
+    }
+}
+
+template <typename Label>
+TARGET_AVX2 static void boundaryMaskAvx2T(const cv::Mat& labels, cv::Mat& out) {
+    const __m128i one = _mm_set1_epi8(1);
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        const Label* next = y + 1 < labels.rows ? labels.ptr<Label>(y + 1) : nullptr;
+        uchar* b = out.ptr<uchar>(y);
+        int x = 0;
+        // 每次 16 个像素：两组 8 路比较结果收窄成 16 个字节
+        for (; x + 17 <= labels.cols; x += 16) {
+            const __m256i a0 = load8(row + x), a1 = load8(row + x + 8);
+            __m256i same0 = _mm256_cmpeq_epi32(a0, load8(row + x + 1));
+            __m256i same1 = _mm256_cmpeq_epi32(a1, load8(row + x + 9));
+            if (next) {
+                same0 = _mm256_and_si256(same0, _mm256_cmpeq_epi32(a0, load8(next + x)));
+                same1 = _mm256_and_si256(same1, _mm256_cmpeq_epi32(a1, load8(next + x + 8)));
+            }
+            const __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(same0, same1), 0xD8);
+            const __m128i bytes = _mm_packs_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(b + x), _mm_andnot_si128(bytes, one));
+        }
+        for (; x < labels.cols; ++x) {
+            b[x] = (x + 1 < labels.cols && row[x] != row[x + 1]) || (next && row[x] != next[x]);
+        }
+    }
+}
+
+// ---------------------- AVX-512：每次 16 个标签，比较结果直接落在掩码寄存器 ----------------------
+TARGET_AVX512 static inline __m512i load16(const int* p) { return _mm512_loadu_si512(p); }
+TARGET_AVX512 static inline __m512i load16(const uint16_t* p) {
+    return _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+
+template <typename Label>
+TARGET_AVX512 static int maxLabelAvx512T(const cv::Mat& labels) {
+    __m512i m = _mm512_setzero_si512();
+    int tail = 0;
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        int x = 0;
+        for (; x + 16 <= labels.cols; x += 16) m = _mm512_max_epi32(m, load16(row + x));
+        for (; x < labels.cols; ++x) tail = std::max(tail, static_cast<int>(row[x]));
+    }
+    return std::max(tail, _mm512_reduce_max_epi32(m));
+}
+
+template <typename Label>
+TARGET_AVX512 static inline int runEndAvx512(const Label* row, int x, int cols, int l) {
+    const __m512i v = _mm512_set1_epi32(l);
+    for (; x + 16 <= cols; x += 16) {
+        const __mmask16 diff = _mm512_cmpneq_epi32_mask(load16(row + x), v);
+        if (diff) return x + static_cast<int>(_tzcnt_u32(diff));
+    }
+    while (x < cols && static_cast<int>(row[x]) == l) ++x;
+    return x;
+}
+
+template <typename Label>
+TARGET_AVX512 static void regionStatsAvx512T(const cv::Mat& labels, int* areas, int64_t* sumX, int64_t* sumY) {
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        for (int x = 0; x < labels.cols;) {
+            const int l = row[x];
+            const int end = runEndAvx512(row, x + 1, labels.cols, l);
+            if (l > 0) {
+                const int64_t len = end - x;
+                areas[l] += static_cast<int>(len);
+                sumX[l] += (static_cast<int64_t>(x) + end - 1) * len / 2;
+                sumY[l] += static_cast<int64_t>(y) * len;
+            }
+            x = end;
+        }
+    }
+}
+
+template <typename Label>
+TARGET_AVX512 static void adjacencyEdgesAvx512T(const cv::Mat& labels, int rowCount, std::vector<uint64_t>& edges, std::vector<uint8_t>& present) {
+    EdgeAppender out{ edges };
+    const int cols = labels.cols;
+    const __m512i zero = _mm512_setzero_si512();
+    for (int y = 0; y < rowCount; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        const Label* next = y + 1 < labels.rows ? labels.ptr<Label>(y + 1) : nullptr;
+        if (cols > 0) visitAdjacency(row, next, 0, cols, out, present);
+        int x = 1;
+        for (; x + 17 <= cols; x += 16) {
+            const __m512i a = load16(row + x);
+            __mmask16 differs = _mm512_cmpneq_epi32_mask(a, load16(row + x + 1));
+            if (next) {
+                differs |= _mm512_cmpneq_epi32_mask(a, load16(next + x));
+                differs |= _mm512_cmpneq_epi32_mask(a, load16(next + x + 1));
+                differs |= _mm512_cmpneq_epi32_mask(a, load16(next + x - 1));
+            }
+            unsigned todo = differs & _mm512_cmpgt_epi32_mask(a, zero);
+            while (todo) {
+                visitAdjacency(row, next, x + static_cast<int>(_tzcnt_u32(todo)), cols, out, present);
+                todo &= todo - 1;
+            }
+        }
+        for (; x < cols; ++x) visitAdjacency(row, next, x, cols, out, present);
+    }
+}
+
+// 16 个 BGRx 像素压成 48 字节，按像素写入掩码展开成字节掩码后带掩码存储，不读 dst
+TARGET_AVX512 static inline void storeBgr16(uchar* dst, __m512i bgrx, __mmask16 write) {
+    const __m512i pack = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+    const __m512i order = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 15, 15, 15, 15);
+    const __m512i packed = _mm512_permutexvar_epi32(order, _mm512_shuffle_epi8(bgrx, pack));
+    const __mmask64 bytes = _pdep_u64(write, 0x249249249249ull) * 7;
+    _mm512_mask_storeu_epi8(dst, bytes, packed);
+}
+
+template <typename Label>
+TARGET_AVX512 static void renderLutAvx512T(const cv::Mat& labels, const std::vector<uint32_t>& lut, cv::Mat& out) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i size = _mm512_set1_epi32(static_cast<int>(lut.size()));
+    const int* table = reinterpret_cast<const int*>(lut.data());
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        uchar* dst = out.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 16 <= labels.cols; x += 16) {
+            const __m512i l = load16(row + x);
+            const __mmask16 valid = _mm512_cmpgt_epi32_mask(l, zero) & _mm512_cmplt_epi32_mask(l, size);
+            const __m512i v = _mm512_i32gather_epi32(_mm512_maskz_mov_epi32(valid, l), table, 4);
+            storeBgr16(dst + 3 * x, v, _mm512_cmplt_epi32_mask(v, zero));
+        }
+        for (; x < labels.cols; ++x) writeLutPixel(dst + 3 * x, lutEntry(lut, row[x]));
+    }
+}
+
+template <typename Label>
+TARGET_AVX512 static void boundaryMaskAvx512T(const cv::Mat& labels, cv::Mat& out) {
+    const __m128i one = _mm_set1_epi8(1);
+    for (int y = 0; y < labels.rows; ++y) {
+        const Label* row = labels.ptr<Label>(y);
+        const Label* next = y + 1 < labels.rows ? labels.ptr<Label>(y + 1) : nullptr;
+        uchar* b = out.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 17 <= labels.cols; x += 16) {
+            const __m512i a = load16(row + x);
+            __mmask16 differs = _mm512_cmpneq_epi32_mask(a, load16(row + x + 1));
+            if (next) differs |= _mm512_cmpneq_epi32_mask(a, load16(next + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(b + x), _mm_maskz_mov_epi8(differs, one));
+        }
+        for (; x < labels.cols; ++x) {
+            b[x] = (x + 1 < labels.cols && row[x] != row[x + 1]) || (next && row[x] != next[x]);
+        }
+    }
+}
+#endif
+
+// ---------------------- 按标签位宽分派 ----------------------
+// 每档指令集的每个扫描各实例化 CV_32S 与 CV_16U 两份，入口按 depth 选择
+template <int (*F32)(const cv::Mat&), int (*F16)(const cv::Mat&)>
+static int maxLabelByDepth(const cv::Mat& labels) {
+    return labels.depth() == CV_16U ? F16(labels) : F32(labels);
+}
+
+template <void (*F32)(const cv::Mat&, int*, int64_t*, int64_t*), void (*F16)(const cv::Mat&, int*, int64_t*, int64_t*)>
+static void regionStatsByDepth(const cv::Mat& labels, int* areas, int64_t* sumX, int64_t* sumY) {
+    (labels.depth() == CV_16U ? F16 : F32)(labels, areas, sumX, sumY);
+}
+
+template <void (*F32)(const cv::Mat&, int, std::vector<uint64_t>&, std::vector<uint8_t>&),
+    void (*F16)(const cv::Mat&, int, std::vector<uint64_t>&, std::vector<uint8_t>&)>
+static void adjacencyEdgesByDepth(const cv::Mat& labels, int rowCount, std::vector<uint64_t>& edges, std::vector<uint8_t>& present) {
+    (labels.depth() == CV_16U ? F16 : F32)(labels, rowCount, edges, present);
+}
+
+template <void (*F32)(const cv::Mat&, const std::vector<uint32_t>&, cv::Mat&),
+    void (*F16)(const cv::Mat&, const std::vector<uint32_t>&, cv::Mat&)>
+static void renderLutByDepth(const cv::Mat& labels, const std::vector<uint32_t>& lut, cv::Mat& out) {
+    (labels.depth() == CV_16U ? F16 : F32)(labels, lut, out);
+}
+
+template <void (*F32)(const cv::Mat&, cv::Mat&), void (*F16)(const cv::Mat&, cv::Mat&)>
+static void boundaryMaskByDepth(const cv::Mat& labels, cv::Mat& out) {
+    (labels.depth() == CV_16U ? F16 : F32)(labels, out);
+}
+
+static const LabelKernels SCALAR_KERNELS = {
+    LABEL_ISA_SCALAR,
+    maxLabelByDepth<maxLabelScalarT<int>, maxLabelScalarT<uint16_t>>,
+    regionStatsByDepth<regionStatsScalarT<int>, regionStatsScalarT<uint16_t>>,
+    adjacencyEdgesByDepth<adjacencyEdgesScalarT<int>, adjacencyEdgesScalarT<uint16_t>>,
+    renderLutByDepth<renderLutScalarT<int>, renderLutScalarT<uint16_t>>,
+    boundaryMaskByDepth<boundaryMaskScalarT<int>, boundaryMaskScalarT<uint16_t>>,
+};
+
+#ifdef LABEL_KERNELS_X64
+static const LabelKernels AVX2_KERNELS = {
+    LABEL_ISA_AVX2,
+    maxLabelByDepth<maxLabelAvx2T<int>, maxLabelAvx2T<uint16_t>>,
+    regionStatsByDepth<regionStatsAvx2T<int>, regionStatsAvx2T<uint16_t>>,
+    adjacencyEdgesByDepth<adjacencyEdgesAvx2T<int>, adjacencyEdgesAvx2T<uint16_t>>,
+    renderLutByDepth<renderLutAvx2T<int>, renderLutAvx2T<uint16_t>>,
+    boundaryMaskByDepth<boundaryMaskAvx2T<int>, boundaryMaskAvx2T<uint16_t>>,
+};
+
+static const LabelKernels AVX512_KERNELS = {
+    LABEL_ISA_AVX512,
+    maxLabelByDepth<maxLabelAvx512T<int>, maxLabelAvx512T<uint16_t>>,
+    regionStatsByDepth<regionStatsAvx512T<int>, regionStatsAvx512T<uint16_t>>,
+    adjacencyEdgesByDepth<adjacencyEdgesAvx512T<int>, adjacencyEdgesAvx512T<uint16_t>>,
+    renderLutByDepth<renderLutAvx512T<int>, renderLutAvx512T<uint16_t>>,
+    boundaryMaskByDepth<boundaryMaskAvx512T<int>, boundaryMaskAvx512T<uint16_t>>,
+};
+#endif
+
+// ---------------------- CPUID 检测 ----------------------
+#ifdef LABEL_KERNELS_X64
+static void cpuidCount(unsigned leaf, unsigned sub, unsigned r[4]) {
+#ifdef _MSC_VER
+    int v[4];
+    __cpuidex(v, static_cast<int>(leaf), static_cast<int>(sub));
+    for (int i = 0; i < 4; ++i) r[i] = static_cast<unsigned>(v[i]);
+#else
+    __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+static uint64_t readXcr0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return static_cast<uint64_t>(hi) << 32 | lo;
+#endif
+}
+#endif
+
+// CPU 支持且操作系统保存对应寄存器状态（XCR0）时才算可用
+LabelKernelIsa detectLabelKernelIsa() {
+#ifdef LABEL_KERNELS_X64
+    unsigned r[4];
+    cpuidCount(0, 0, r);
+    if (r[0] < 7) return LABEL_ISA_SCALAR;
+    cpuidCount(1, 0, r);
+    const bool osxsave = (r[2] >> 27) & 1, avx = (r[2] >> 28) & 1;
+    if (!osxsave || !avx) return LABEL_ISA_SCALAR;
+    const uint64_t xcr0 = readXcr0();
+    cpuidCount(7, 0, r);
+    const unsigned ebx = r[1];
+    const bool bmi1 = (ebx >> 3) & 1, avx2 = (ebx >> 5) & 1, bmi2 = (ebx >> 8) & 1;
+    const bool avx512 = ((ebx >> 16) & 1) && ((ebx >> 30) & 1) && ((ebx >> 31) & 1);   // F、BW、VL
+    if (!avx2 || !bmi1 || (xcr0 & 0x6) != 0x6) return LABEL_ISA_SCALAR;
+    if (avx512 && bmi2 && (xcr0 & 0xE6) == 0xE6) return LABEL_ISA_AVX512;
+    return LABEL_ISA_AVX2;
+#else
+    return LABEL_ISA_SCALAR;
+#endif
+}
+
+const char* labelKernelIsaName(LabelKernelIsa isa) {
+    switch (isa) {
+    case LABEL_ISA_AVX2: return "AVX2";
+    case LABEL_ISA_AVX512: return "AVX-512";
+    default: return "标量";
+    }
+}
+
+const LabelKernels& labelKernels(LabelKernelIsa isa) {
+    isa = std::min(isa, detectLabelKernelIsa());
+#ifdef LABEL_KERNELS_X64
+    if (isa == LABEL_ISA_AVX512) return AVX512_KERNELS;
+    if (isa == LABEL_ISA_AVX2) return AVX2_KERNELS;
+#endif
+    return SCALAR_KERNELS;
+}
+
+static std::atomic<const LabelKernels*> g_activeKernels{ nullptr };
+
+const LabelKernels& labelKernels() {
+    const LabelKernels* k = g_activeKernels.load(std::memory_order_acquire);
+    if (!k) {
+        k = &labelKernels(detectLabelKernelIsa());
+        g_activeKernels.store(k, std::memory_order_release);
+    }
+    return *k;
+}
+
+void setLabelKernelIsa(LabelKernelIsa isa) {
+    g_activeKernels.store(&labelKernels(isa), std::memory_order_release);
+}
@@ -1,144 +1,254 @@
-﻿#include "utils.h"
-#include <chrono>
-
-int main() {
-    cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_SILENT);
-
-    // -------- Step 0: 加载图像 --------
-    cv::Mat src = cv::imread("wife.jpg");
-    if (src.empty()) {
-        std::cerr << " 无法读取图像文件 wife.jpg，请检查路径和文件是否存在。" << std::endl;
-        return -1;
-    }
-    std::cout << " 图像加载成功，尺寸：" << src.cols << " x " << src.rows << "\n" << std::endl;
-
-    // -------- Step 1: 分水岭分割 --------
-    std::cout << "【任务1】分水岭分割 + 随机种子采样" << std::endl;
-    std::cout << "请输入随机种子点个数 K（推荐100~1000）：";
-    int K;
-    std::cin >> K;
-    if (K < 2 || K > 10000) {
-        std::cerr << " 输入非法，K 应在 [2, 10000] 范围内。" << std::endl;
-        return -1;
-    }
-
-    std::cout << "按下回车键开始任务1..." << std::endl;
-    std::cin.ignore(); std::cin.get();
-    auto t1_start = std::chrono::high_resolution_clock::now();
-
-    std::vector<cv::Point> seeds = generateSeedPoints(src.size(), K);
-    cv::Mat markers = computeMarkers(src.size(), seeds, src);
-    cv::Mat seedOverlay = visualizeSeedOverlay(src, seeds);
-    cv::Mat watershedView = applyWatershedWithColor(src, markers);
-
-    auto t1_end = std::chrono::high_resolution_clock::now();
-    std::cout << " 任务1完成，用时 "
-        << std::chrono::duration_cast<std::chrono::milliseconds>(t1_end - t1_start).count()
-        << " ms\n" << std::endl;
-
-    // 立即显示任务1结果并等待用户确认
-    cv::imshow("任务1 - 原图与种子点叠加", seedOverlay);
-    cv::imshow("任务1 - 分水岭区域图", watershedView);
-    cv::waitKey(1); // 刷新窗口
-    std::cout << "按回车键继续任务2..." << std::endl;
-    std::cin.get();
-
-
-
-
-    // -------- Step 2: 四色图着色 --------
-    std::cout << "【任务2】四色图着色" << std::endl;
-    auto t2_start = std::chrono::high_resolution_clock::now();
-
-    RegionGraph graph = buildRegionAdjacencyGraph(markers);
-    if (!repeatUntilFourColorSuccess(graph)) {
-        std::cerr << " 四色着色失败，图结构可能异常。" << std::endl;
-        return -1;
-    }
-    cv::Mat colorView = visualizeFourColoring(markers, graph);
-
-    auto t2_end = std::chrono::high_resolution_clock::now();
-    std::cout << " 任务2完成，用时 "
-        << std::chrono::duration_cast<std::chrono::milliseconds>(t2_end - t2_start).count()
-        << " ms\n" << std::endl;
-
-    // 立即显示任务2结果并等待用户确认
-    cv::imshow("任务2 - 四色着色图", colorView);
-    cv::waitKey(1); // 刷新窗口
-    std::cout << "按回车键继续任务3..." << std::endl;
-    std::cin.get();
-
-    // -------- Step 3: 面积排序 + 哈夫曼 --------
-    std::cout << "【任务3】区域面积排序 + 哈夫曼编码" << std::endl;
-
-
-    std::map<int, int> areaMap = computeRegionAreas(markers);
-    if (areaMap.empty()) {
-        std::cerr << " 区域面积计算失败，无法继续任务3。" << std::endl;
-        return -1;
-    }
-
-    heapSortAndDisplay(areaMap);
-
-    int low, high;
-    std::cout << "请输入面积下限：";
-    while (!(std::cin >> low) || low < 0) {
-        std::cin.clear(); std::cin.ignore(INT_MAX, '\n');
-        std::cout << " 无效输入，请输入非负整数：";
-    }
-    std::cout << "请输入面积上限：";
-    while (!(std::cin >> high) || high < low) {
-        std::cin.clear(); std::cin.ignore(INT_MAX, '\n');
-        std::cout << " 无效输入，上限应 ≥ 下限：";
-    }
-    auto t3_start = std::chrono::high_resolution_clock::now();
-    std::vector<AreaEntry> sortedAreas;
-    for (const auto& [label, area] : areaMap)
-        sortedAreas.push_back({ label, area });
-    std::sort(sortedAreas.begin(), sortedAreas.end(),
-        [](const AreaEntry& a, const AreaEntry& b) { return a.area < b.area; });
-
-    std::set<int> targetLabels = binarySearchInRange(sortedAreas, low, high);
-    std::cout << " 共找到 " << targetLabels.size() << " 个区域符合条件。\n" << std::endl;
-
-    auto colorMap = generateColorMap(targetLabels);
-    auto centerMap = computeRegionCenters(markers, areaMap);
-    cv::Mat highlightedImage = src.clone();
-    highlightRegions(highlightedImage, markers, targetLabels, colorMap, areaMap, centerMap);
-    cv::imshow("任务3 - 高亮显示目标区域", highlightedImage);
-
-    std::map<int, int> filteredAreaMap;
-    for (const auto& entry : sortedAreas) {
-        if (entry.area >= low && entry.area <= high)
-            filteredAreaMap[entry.label] = entry.area;
-    }
-    HuffmanNode* huffmanTree = buildHuffmanTree(filteredAreaMap);
-    if (!huffmanTree) {
-        std::cerr << " 哈夫曼树构建失败！" << std::endl;
-        return -1;
-    }
-
-    std::map<int, std::string> huffmanCodes;
-    generateHuffmanCodes(huffmanTree, "", huffmanCodes);
-    //std::cout << " 哈夫曼编码：" << std::endl;
-    //for (const auto& [label, code] : huffmanCodes) {
-    //    std::cout << "区域 " << label << " (面积=" << areaMap[label] << ") -> " << code << std::endl;
-    //}
-
-    cv::Mat huffmanView = visualizeHuffmanTree(huffmanTree);
-    cv::imshow("任务3 - 哈夫曼树可视化", huffmanView);
-
-    auto t3_end = std::chrono::high_resolution_clock::now();
-    std::cout << "\n 任务3完成，用时 "
-        << std::chrono::duration_cast<std::chrono::milliseconds>(t3_end - t3_start).count()
-        << " ms\n" << std::endl;
-
-    // 立即显示任务3结果并等待用户确认
-    cv::waitKey(1); // 刷新窗口
-    std::cout << " 所有任务执行完毕！按任意键退出程序。" << std::endl;
-    cv::waitKey(0);
-
-    // -------- 释放资源 --------
-    deleteHuffmanTree(huffmanTree);
-    return 0;
+﻿#include "utils.h"
+#include <chrono>
+
+int main(int argc, char** argv) {
+    cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_SILENT);
+
+    // 性能测试模式：Project1 --bench <名称|all> [图像路径] [K]
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        return runBenchmarks(argc - 2, argv + 2);
+    }
+    // 性能回归检查：Project1 --perf-check [基线.json] [update]
+    if (argc > 1 && std::string(argv[1]) == "--perf-check") {
+        return runPerfCheck(argc - 2, argv + 2);
+    }
+
+    // 任务图流水线模式：Project1 --pipeline [图像路径] [K] [面积下限] [面积上限] [线程数] [缓存目录|-] [缓存上限MB] [mem|-] [种子]
+    if (argc > 1 && std::string(argv[1]) == "--pipeline") {
+        return runPipeline(argc - 2, argv + 2);
+    }
+    // 条带流式模式（超大图像）：Project1 --stream <输入 .ppm|.raw> [K] [内存预算MB] [标签文件] [着色图.ppm|-] [halo] [raw宽] [raw高]
+    if (argc > 1 && std::string(argv[1]) == "--stream") {
+        return runStreaming(argc - 2, argv + 2);
+    }
+    // 金字塔分割模式：Project1 --pyramid [图像路径] [K] [层数] [band] [preview]
+    if (argc > 1 && std::string(argv[1]) == "--pyramid") {
+        return runPyramid(argc - 2, argv + 2);
+    }
+    // 层次分水岭模式：Project1 --hierarchy [图像路径] [细粒度K] [区域数列表，逗号分隔]
+    if (argc > 1 && std::string(argv[1]) == "--hierarchy") {
+        return runHierarchy(argc - 2, argv + 2);
+    }
+    // Lloyd 细化模式：Project1 --lloyd [图像路径] [K] [迭代次数] [线程数]
+    if (argc > 1 && std::string(argv[1]) == "--lloyd") {
+        return runLloyd(argc - 2, argv + 2);
+    }
+    // 交互式标记模式：Project1 --interactive [图像路径] [K] [笔刷粗细]
+    if (argc > 1 && std::string(argv[1]) == "--interactive") {
+        return runInteractive(argc - 2, argv + 2);
+    }
+    // 合成负载模式：Project1 --generate <image|labels|graph> <输出路径> ...（参数见 workload.cpp）
+    if (argc > 1 && std::string(argv[1]) == "--generate") {
+        return runGenerate(argc - 2, argv + 2);
+    }
+
+    // 着色引擎测试模式：Project1 --color-bench [输出.csv] [时间预算ms] [引擎列表|all] [图文件...]
+    if (argc > 1 && std::string(argv[1]) == "--color-bench") {
+        return runColorBench(argc - 2, argv + 2);
+    }
+
+    // 常驻服务模式：Project1 --serve <套接字路径> [工作线程数] [单批上限] [种子]
+    if (argc > 1 && std::string(argv[1]) == "--serve") {
+        return runServer(argc - 2, argv + 2);
+    }
+    // 服务压测客户端：Project1 --loadgen <套接字路径> <图像路径> [K] [并发数] [请求数] [面积下限] [面积上限] [file|shm]
+    if (argc > 1 && std::string(argv[1]) == "--loadgen") {
+        return runLoadGenerator(argc - 2, argv + 2);
+    }
+
+    // 交互流程选项：Project1 [--seed <种子>] [--cache [缓存目录]]
+    //   --seed：固定随机种子以复现同一次分割；缺省取 std::random_device，并在任务1中打印
+    //   --cache：按（图像, K, 种子）缓存种子与淹没结果，目录缺省为 seg_cache（与 --pipeline 共用）；不加时不读写缓存
+    uint32_t seed = std::random_device{}();
+    std::string cacheDir;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--cache") {
+            cacheDir = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : "seg_cache";
+        }
+        else {
+            std::cerr << " 未知参数 " << arg << "，用法：Project1 [--seed <种子>] [--cache [缓存目录]]" << std::endl;
+            return -1;
+        }
+    }
+
+    // -------- Step 0: 加载图像 --------
+    cv::Mat src = cv::imread("wife.jpg");
+    if (src.empty()) {
+        std::cerr << " 无法读取图像文件 wife.jpg，请检查路径和文件是否存在。" << std::endl;
+        return -1;
+    }
+    std::cout << " 图像加载成功，尺寸：" << src.cols << " x " << src.rows << "\n" << std::endl;
+
+    // -------- Step 1: 分水岭分割 --------
+    std::cout << "【任务1】分水岭分割 + 随机种子采样" << std::endl;
+    std::cout << "请输入随机种子点个数 K（推荐100~1000）：";
+    int K;
+    std::cin >> K;
+    if (K < 2 || K > 10000) {
+        std::cerr << " 输入非法，K 应在 [2, 10000] 范围内。" << std::endl;
+        return -1;
+    }
+
+    std::cout << "按下回车键开始任务1..." << std::endl;
+    std::cin.ignore(); std::cin.get();
+    auto t1_start = std::chrono::high_resolution_clock::now();
+
+    // 交互流程只有一路分割：随机数与日志都走这一个运行环境
+    TaskEnv env(seed, consoleLogSink());
+    std::cout << " 随机种子 " << seed << "（--seed " << seed << " 可复现本次分割）" << std::endl;
+    // --cache：同一图像、K 与种子再次运行时复用种子和淹没结果
+    std::unique_ptr<SegmentationCache> cache;
+    uint64_t imageHash = 0;
+    if (!cacheDir.empty()) {
+        cache = std::make_unique<SegmentationCache>(cacheDir);
+        imageHash = SegmentationCache::imageHash(src);
+    }
+    CachedSegmentation cached;
+    std::vector<cv::Point> seeds;
+    cv::Mat markers;
+    if (cache && cache->lookup(imageHash, K, seed, cached)) {
+        seeds = cached.seeds();
+        cached.labels().convertTo(markers, CV_32S);   // 映射随 close 释放，取 32 位副本（与 computeMarkers 的结果同类型）
+        cached.close();
+        std::cout << " 结果缓存命中，跳过种子生成与淹没。" << std::endl;
+    }
+    else {
+        seeds = generateSeedPoints(src.size(), K, env.rng);
+        markers = computeMarkers(src.size(), seeds, src, &env);
+        if (cache) cache->store(imageHash, K, seed, seeds, markers);
+    }
+    cv::Mat seedOverlay = visualizeSeedOverlay(src, seeds);
+    cv::Mat watershedView = applyWatershedWithColor(src, markers);
+
+    auto t1_end = std::chrono::high_resolution_clock::now();
+    std::cout << " 任务1完成，用时 "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(t1_end - t1_start).count()
+        << " ms\n" << std::endl;
+
+    // 立即显示任务1结果并等待用户确认
+    cv::imshow("任务1 - 原图与种子点叠加", seedOverlay);
+    cv::imshow("任务1 - 分水岭区域图", watershedView);
+    cv::waitKey(1); // 刷新窗口
+    std::cout << "按回车键继续任务2..." << std::endl;
+    std::cin.get();
+
+
+
+
+    // -------- Step 2: 四色图着色 --------
+    std::cout << "【任务2】四色图着色" << std::endl;
+    auto t2_start = std::chrono::high_resolution_clock::now();
+
+    RegionGraph graph = buildRegionAdjacencyGraph(markers);
+    if (!repeatUntilFourColorSuccess(graph, nullptr, &env)) {
+        std::cerr << " 四色着色失败，图结构可能异常。" << std::endl;
+        return -1;
+    }
+    cv::Mat colorView = visualizeFourColoring(markers, graph);
+
+    auto t2_end = std::chrono::high_resolution_clock::now();
+    std::cout << " 任务2完成，用时 "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(t2_end - t2_start).count()
+        << " ms\n" << std::endl;
+
+    // 立即显示任务2结果并等待用户确认
+    cv::imshow("任务2 - 四色着色图", colorView);
+    cv::waitKey(1); // 刷新窗口
+    std::cout << "按回车键继续任务3..." << std::endl;
+    std::cin.get();
+
+    // -------- Step 3: 面积排序 + 哈夫曼 --------
+    std::cout << "【任务3】区域面积排序 + 哈夫曼编码" << std::endl;
+
+
+    std::map<int, int> areaMap = computeRegionAreas(markers);
+    if (areaMap.empty()) {
+        std::cerr << " 区域面积计算失败，无法继续任务3。" << std::endl;
+        return -1;
+    }
+
+    heapSortAndDisplay(areaMap, &env);
+
+    int low, high;
+    std::cout << "请输入面积下限：";
+    while (!(std::cin >> low) || low < 0) {
+        std::cin.clear(); std::cin.ignore(INT_MAX, '\n');
+        std::cout << " 无效输入，请输入非负整数：";
+    }
+    std::cout << "请输入面积上限：";
+    while (!(std::cin >> high) || high < low) {
+        std::cin.clear(); std::cin.ignore(INT_MAX, '\n');
+        std::cout << " 无效输入，上限应 ≥ 下限：";
+    }
+    auto t3_start = std::chrono::high_resolution_clock::now();
+    std::vector<AreaEntry> sortedAreas;
+    for (const auto& [label, area] : areaMap)
+        sortedAreas.push_back({ label, area });
+    std::sort(sortedAreas.begin(), sortedAreas.end(),
+        [](const AreaEntry& a, const AreaEntry& b) { return a.area < b.area; });
+
+    std::set<int> targetLabels = binarySearchInRange(sortedAreas, low, high);
+    std::cout << " 共找到 " << targetLabels.size() << " 个区域符合条件。\n" << std::endl;
+
+    auto colorMap = generateColorMap(targetLabels, &env);
+    auto centerMap = computeRegionCenters(markers, areaMap);
+    cv::Mat highlightedImage = src.clone();
+    highlightRegions(highlightedImage, markers, targetLabels, colorMap, areaMap, centerMap);
+    cv::imshow("任务3 - 高亮显示目标区域", highlightedImage);
+
+    std::map<int, int> filteredAreaMap;
+    for (const auto& entry : sortedAreas) {
+        if (entry.area >= low && entry.area <= high)
+            filteredAreaMap[entry.label] = entry.area;
+    }
+    HuffmanNode* huffmanTree = buildHuffmanTree(filteredAreaMap);
+    if (!huffmanTree) {
+        std::cerr << " 哈夫曼树构建失败！" << std::endl;
+        return -1;
+    }
+
+    // 范式哈夫曼码表（码长上限 24 位），码字按紧凑下标平铺存储；区域多时只列出前 HUFFMAN_PRINT_LIMIT 个
+    CanonicalHuffmanTable huffmanTable;
+    if (!buildCanonicalHuffmanTable(filteredAreaMap, huffmanTable, 24)) {
+        std::cerr << " 范式哈夫曼码表构建失败！" << std::endl;
+        deleteHuffmanTree(huffmanTree);
+        return -1;
+    }
+    const size_t HUFFMAN_PRINT_LIMIT = 20;
+    uint64_t weightedBits = 0, totalArea = 0;
+    for (size_t i = 0; i < huffmanTable.labels.size(); ++i) {
+        const int area = filteredAreaMap.at(huffmanTable.labels[i]);
+        weightedBits += static_cast<uint64_t>(area) * huffmanTable.lengths[i];
+        totalArea += area;
+    }
+    std::cout << " 哈夫曼编码：" << huffmanTable.labels.size() << " 个区域，最长码 " << huffmanTable.maxLength
+        << " 位，按面积加权平均码长 " << static_cast<double>(weightedBits) / std::max<uint64_t>(totalArea, 1) << " 位" << std::endl;
+    for (size_t i = 0; i < huffmanTable.labels.size() && i < HUFFMAN_PRINT_LIMIT; ++i) {
+        int label = huffmanTable.labels[i];
+        std::cout << "  区域 " << label << " (面积=" << areaMap[label] << ") -> " << huffmanCodeToString(huffmanTable.codes[i]) << std::endl;
+    }
+    if (huffmanTable.labels.size() > HUFFMAN_PRINT_LIMIT) {
+        std::cout << "  …（其余 " << huffmanTable.labels.size() - HUFFMAN_PRINT_LIMIT << " 个区域略）" << std::endl;
+    }
+
+    cv::Mat huffmanView = visualizeHuffmanTree(huffmanTree, &env);
+    cv::imshow("任务3 - 哈夫曼树可视化", huffmanView);
+
+    auto t3_end = std::chrono::high_resolution_clock::now();
+    std::cout << "\n 任务3完成，用时 "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(t3_end - t3_start).count()
+        << " ms\n" << std::endl;
+
+    // 立即显示任务3结果并等待用户确认
+    cv::waitKey(1); // 刷新窗口
+    std::cout << " 所有任务执行完毕！按任意键退出程序。" << std::endl;
+    cv::waitKey(0);
+
+    // -------- 释放资源 --------
+    deleteHuffmanTree(huffmanTree);
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 内存统计
+//     1. 替换全局 operator new / delete：每块前放一个对齐的头，记录请求大小与分配时所在的阶段；
+//        计数默认关闭，此时只写头、不碰任何原子量，setAllocationCounting 打开后才统计分配次数、在用字节数与峰值。
+//        头不能随开关省掉：关闭前分配的块可能在打开后才释放，反之亦然，释放时只看头里的记号；
+//     2. cv::Mat 的像素缓冲走 fastMalloc，由 CountingMatAllocator 包装标准分配器单独统计，
+//        阶段编号记在 UMatData::userdata（标准分配器不使用该字段），释放时据此归还；
+//     3. 打开按阶段统计后，分配计入当前线程所在的阶段（MemoryStageScope 设定），释放计回分配它的阶段，
+//        于是阶段结束后的“留存”即该阶段产出、仍被后续持有的数据（邻接表、距离变换、哈夫曼结点等）。
+//        阶段记在 thread_local 中，库里的条带线程与 OpenCV 线程池看不到它，这些线程的分配计入 0 号阶段。
+//     OpenCV 内部 AutoBuffer 等临时缓冲直接 malloc，不在统计范围内。
+// ====================================================
+
+const int MEMORY_MAX_STAGES = 64;
+// 头里放 size_t 大小与 int 阶段，至少 16 字节，且保持 max_align_t 对齐
+static constexpr size_t HEAP_HEADER = alignof(std::max_align_t) < 16 ? 16 : alignof(std::max_align_t);
+
+struct StageCounters {
+    std::atomic<size_t> heapAllocations{ 0 }, heapBytes{ 0 }, heapLive{ 0 }, heapPeak{ 0 };
+    std::atomic<size_t> matAllocations{ 0 }, matBytes{ 0 }, matLive{ 0 }, matPeak{ 0 };
+};
+
+static std::atomic<size_t> g_heapAllocations{ 0 };
+static std::atomic<size_t> g_heapLiveBytes{ 0 }, g_heapPeakBytes{ 0 };
+static std::atomic<bool> g_heapCounting{ false }, g_stageTracking{ false };
+static StageCounters g_stages[MEMORY_MAX_STAGES];
+static thread_local int t_stage = 0;
+
+static void raisePeak(std::atomic<size_t>& peak, size_t live) {
+    size_t seen = peak.load(std::memory_order_relaxed);
+    while (live > seen && !peak.compare_exchange_weak(seen, live, std::memory_order_relaxed)) {}
+}
+
+// 返回分配所属的阶段，未打开按阶段统计时为 -1（释放时不计回任何阶段）
+static int chargeStage(std::atomic<size_t> StageCounters::* allocations, std::atomic<size_t> StageCounters::* bytes,
+    std::atomic<size_t> StageCounters::* live, std::atomic<size_t> StageCounters::* peak, size_t size) {
+    if (!g_stageTracking.load(std::memory_order_relaxed)) return -1;
+    StageCounters& c = g_stages[t_stage];
+    (c.*allocations).fetch_add(1, std::memory_order_relaxed);
+    (c.*bytes).fetch_add(size, std::memory_order_relaxed);
+    raisePeak(c.*peak, (c.*live).fetch_add(size, std::memory_order_relaxed) + size);
+    return t_stage;
+}
+
+// ---------------------- operator new ----------------------
+// 头里的阶段：>= 0 计入该阶段，-1 只计入全局，HEAP_UNCOUNTED 分配时计数未打开，释放时什么都不做
+static constexpr int HEAP_UNCOUNTED = -2;
+
+static void* countedAlloc(size_t size) noexcept {
+    char* raw = static_cast<char*>(std::malloc(size + HEAP_HEADER));
+    if (!raw) return nullptr;
+    *reinterpret_cast<size_t*>(raw) = size;
+    if (!g_heapCounting.load(std::memory_order_relaxed)) {
+        *reinterpret_cast<int*>(raw + sizeof(size_t)) = HEAP_UNCOUNTED;
+        return raw + HEAP_HEADER;
+    }
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    raisePeak(g_heapPeakBytes, g_heapLiveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+    *reinterpret_cast<int*>(raw + sizeof(size_t)) = chargeStage(&StageCounters::heapAllocations, &StageCounters::heapBytes,
+        &StageCounters::heapLive, &StageCounters::heapPeak, size);
+    return raw + HEAP_HEADER;
+}
+static void countedFree(void* p) noexcept {
+    if (!p) return;
+    char* raw = static_cast<char*>(p) - HEAP_HEADER;
+    const int stage = *reinterpret_cast<int*>(raw + sizeof(size_t));
+    if (stage == HEAP_UNCOUNTED) {
+        std::free(raw);
+        return;
+    }
+    const size_t size = *reinterpret_cast<size_t*>(raw);
+    g_heapLiveBytes.fetch_sub(size, std::memory_order_relaxed);
+    if (stage >= 0) g_stages[stage].heapLive.fetch_sub(size, std::memory_order_relaxed);
+    std::free(raw);
+}
+
+void* operator new(size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+// ---------------------- cv::Mat 分配器 ----------------------
+// 分配交给标准分配器后把 currAllocator 换成自己，释放才会回到这里
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    mutable std::atomic<size_t> count{ 0 };
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+        cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        count.fetch_add(1, std::memory_order_relaxed);
+        cv::UMatData* u = cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        if (!u) return u;
+        const int stage = chargeStage(&StageCounters::matAllocations, &StageCounters::matBytes,
+            &StageCounters::matLive, &StageCounters::matPeak, u->size);
+        u->userdata = reinterpret_cast<void*>(static_cast<intptr_t>(stage + 1));
+        u->prevAllocator = u->currAllocator = this;
+        return u;
+    }
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(data, accessFlags, usageFlags);
+    }
+    void deallocate(cv::UMatData* data) const override {
+        if (!data) return;
+        const int stage = static_cast<int>(reinterpret_cast<intptr_t>(data->userdata)) - 1;
+        if (stage >= 0) g_stages[stage].matLive.fetch_sub(data->size, std::memory_order_relaxed);
+        data->userdata = nullptr;
+        cv::Mat::getStdAllocator()->deallocate(data);
+    }
+};
+static CountingMatAllocator g_matAllocator;
+
+size_t heapAllocationCount() { return g_heapAllocations.load(std::memory_order_relaxed); }
+size_t heapLiveBytes() { return g_heapLiveBytes.load(std::memory_order_relaxed); }
+size_t heapPeakBytes() { return g_heapPeakBytes.load(std::memory_order_relaxed); }
+void resetHeapPeak() { g_heapPeakBytes.store(g_heapLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+size_t matAllocationCount() { return g_matAllocator.count.load(std::memory_order_relaxed); }
+void setAllocationCounting(bool enabled) {
+    g_heapCounting.store(enabled, std::memory_order_relaxed);
+    cv::Mat::setDefaultAllocator(enabled ? &g_matAllocator : nullptr);
+}
+
+// ---------------------- 按阶段统计 ----------------------
+// 阶段名只增不减；0 号为未标记的分配
+static std::mutex g_stageMutex;
+static std::vector<std::string> g_stageNames = { "(未标记)" };
+
+void setMemoryTracking(bool enabled) {
+    g_stageTracking.store(enabled, std::memory_order_relaxed);
+    if (enabled) setAllocationCounting(true);
+}
+
+bool memoryTrackingEnabled() { return g_stageTracking.load(std::memory_order_relaxed); }
+
+int memoryStageId(const std::string& name) {
+    std::lock_guard<std::mutex> lock(g_stageMutex);
+    for (size_t i = 1; i < g_stageNames.size(); ++i) {
+        if (g_stageNames[i] == name) return static_cast<int>(i);
+    }
+    if (static_cast<int>(g_stageNames.size()) >= MEMORY_MAX_STAGES) return 0;
+    g_stageNames.push_back(name);
+    return static_cast<int>(g_stageNames.size()) - 1;
+}
+
+MemoryStageScope::MemoryStageScope(int stage) : previous_(t_stage) {
+    t_stage = stage >= 0 && stage < MEMORY_MAX_STAGES ? stage : 0;
+}
+MemoryStageScope::~MemoryStageScope() { t_stage = previous_; }
+
+MemoryStageStats memoryStageStats(int stage) {
+    MemoryStageStats s;
+    if (stage < 0 || stage >= MEMORY_MAX_STAGES) return s;
+    {
+        std::lock_guard<std::mutex> lock(g_stageMutex);
+        if (stage < static_cast<int>(g_stageNames.size())) s.name = g_stageNames[stage];
+    }
+    const StageCounters& c = g_stages[stage];
+    s.heapAllocations = c.heapAllocations.load(std::memory_order_relaxed);
+    s.heapBytes = c.heapBytes.load(std::memory_order_relaxed);
+    s.heapLive = c.heapLive.load(std::memory_order_relaxed);
+    s.heapPeak = c.heapPeak.load(std::memory_order_relaxed);
+    s.matAllocations = c.matAllocations.load(std::memory_order_relaxed);
+    s.matBytes = c.matBytes.load(std::memory_order_relaxed);
+    s.matLive = c.matLive.load(std::memory_order_relaxed);
+    s.matPeak = c.matPeak.load(std::memory_order_relaxed);
+    return s;
+}
+
+void printMemoryStage(std::ostream& os, const MemoryStageStats& s) {
+    os << "堆 峰值 " << s.heapPeak / 1024.0 << " KB、留存 " << s.heapLive / 1024.0 << " KB、" << s.heapAllocations
+        << " 次；Mat 峰值 " << s.matPeak / 1024.0 << " KB、留存 " << s.matLive / 1024.0 << " KB、" << s.matAllocations << " 次";
+}
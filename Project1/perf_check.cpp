@@ -0,0 +1,236 @@
+﻿#include "utils.h"
+#include <filesystem>
+#include <sstream>
+
+// ====================================================
+// ✅ 性能回归检查
+//     1. 固定负载：合成纹理图（固定尺寸与随机种子）+ 固定种子点，OpenCV 与本项目的条带内核都限定单线程；
+//     2. 任务一 / 二 / 三的若干阶段各跑 PERF_WARMUP + PERF_RUNS 轮，取后 PERF_RUNS 轮的中位数
+//        与 95% 置信区间（按次序统计量：秩 n/2 ± 0.98√n，不假设正态）；
+//     3. 与基线 JSON 比较：当前区间下界高出基线区间上界 PERF_TOLERANCE 以上、且中位数慢出
+//        PERF_MIN_DELTA_MS 以上才算回归，两区间重叠的抖动不报；反方向同理记为变快。
+//     有回归时打印逐阶段对比表并返回 1。基线与机器、编译选项绑定，换机器后应重新生成。
+// ====================================================
+
+const int PERF_WARMUP = 2;
+const int PERF_RUNS = 15;
+const double PERF_TOLERANCE = 0.10;
+const double PERF_MIN_DELTA_MS = 0.05;
+const cv::Size PERF_IMAGE_SIZE(1024, 1024);
+const int PERF_SEEDS = 1000;
+const int PERF_GRAPH_VERTICES = 100000;
+const uint64_t PERF_RNG_SEED = 1;
+
+static const char* const PERF_STAGES[] = {
+    "task1:relief", "task1:flood", "task1:jfa",
+    "task2:adjacency", "task2:coloring", "task2:coloring-apollonian",
+    "task3:area-stats", "task3:huffman", "task3:codec",
+};
+const int PERF_STAGE_COUNT = sizeof(PERF_STAGES) / sizeof(PERF_STAGES[0]);
+
+struct StageSummary {
+    double median = 0, low = 0, high = 0;   // 毫秒；[low, high] 为中位数的 95% 置信区间
+    int runs = 0;
+};
+
+static StageSummary summarize(std::vector<double> samples) {
+    StageSummary s;
+    const int n = static_cast<int>(samples.size());
+    if (n == 0) return s;
+    std::sort(samples.begin(), samples.end());
+    s.runs = n;
+    s.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    const double half = 0.98 * std::sqrt(static_cast<double>(n));   // 1.96 · √n / 2
+    s.low = samples[std::max(0, static_cast<int>(std::floor(n / 2.0 - half)))];
+    s.high = samples[std::min(n - 1, static_cast<int>(std::ceil(n / 2.0 + half)) - 1)];
+    return s;
+}
+
+static std::string perfConfig() {
+    std::ostringstream config;
+    config << PERF_IMAGE_SIZE.width << "x" << PERF_IMAGE_SIZE.height << " texture, " << PERF_SEEDS << " seeds, "
+        << PERF_GRAPH_VERTICES << "-vertex apollonian, seed " << PERF_RNG_SEED << ", 1 thread, "
+        << PERF_RUNS << " runs, kernels " << labelKernelIsaName(labelKernels().isa);
+    return config.str();
+}
+
+// ---------------------- 测量 ----------------------
+static void measureStages(std::vector<StageSummary>& summaries) {
+    cv::setNumThreads(1);
+    const cv::Mat src = generateTexturedImage(PERF_IMAGE_SIZE, PERF_RNG_SEED);
+    cv::RNG rng(PERF_RNG_SEED);
+    std::vector<cv::Point> seeds(PERF_SEEDS);
+    for (cv::Point& p : seeds) {
+        p.x = rng.uniform(0, src.cols);
+        p.y = rng.uniform(0, src.rows);
+    }
+    RegionAdjacencyCSR apollonian;
+    generateSyntheticGraph(SYNTHETIC_APOLLONIAN, PERF_GRAPH_VERTICES, PERF_RNG_SEED, apollonian);
+
+    SegmentationContext ctx;
+    ctx.setThreads(1);
+    LloydScratch lloydScratch;
+    CSRColoringScratch coloringScratch;
+    cv::Mat nearest;
+    std::vector<int8_t> colors;
+    std::vector<uint8_t> encoded;
+    std::vector<std::vector<double>> samples(PERF_STAGE_COUNT);
+
+    for (int frame = 0; frame < PERF_WARMUP + PERF_RUNS; ++frame) {
+        int s = 0;
+        auto measure = [&](auto&& fn) {
+            auto start = std::chrono::high_resolution_clock::now();
+            fn();
+            const double ms = elapsedMs(start);
+            if (frame >= PERF_WARMUP) samples[s].push_back(ms);
+            s++;
+            };
+        ctx.beginFrame();
+        measure([&] { ctx.computeRelief(src); });
+        measure([&] { ctx.flood(seeds); });
+        measure([&] { computeVoronoiJFA(seeds, src.size(), nearest, lloydScratch, 1); });
+        measure([&] { ctx.buildAdjacency(); });
+        measure([&] { ctx.colorRegions(); });
+        measure([&] { fourColorCSR(apollonian, colors, coloringScratch); });
+        measure([&] {
+            ctx.computeRegionStats();
+            ctx.selectAreaRange(0, INT_MAX);
+            });
+        measure([&] { ctx.buildHuffmanTree(); });
+        measure([&] { encodeLabelMap(ctx.markers(), encoded); });
+    }
+    summaries.clear();
+    for (auto& v : samples) summaries.push_back(summarize(std::move(v)));
+}
+
+// ---------------------- 基线 JSON ----------------------
+static bool writeBaseline(const std::string& path, const std::vector<StageSummary>& summaries) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "{\n  \"version\": 1,\n  \"config\": \"" << perfConfig() << "\",\n  \"stages\": {\n";
+    for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+        const StageSummary& s = summaries[i];
+        out << "    \"" << PERF_STAGES[i] << "\": { \"median\": " << s.median << ", \"low\": " << s.low
+            << ", \"high\": " << s.high << ", \"runs\": " << s.runs << " }" << (i + 1 < PERF_STAGE_COUNT ? "," : "") << "\n";
+    }
+    out << "  }\n}\n";
+    return static_cast<bool>(out);
+}
+
+// 只认 writeBaseline 写出的结构：按阶段名找到其后的 { ... }，再在其中按键名取数
+static bool jsonNumber(const std::string& object, const char* key, double& value) {
+    const size_t at = object.find("\"" + std::string(key) + "\"");
+    if (at == std::string::npos) return false;
+    const size_t colon = object.find(':', at);
+    if (colon == std::string::npos) return false;
+    char* end = nullptr;
+    value = std::strtod(object.c_str() + colon + 1, &end);
+    return end != object.c_str() + colon + 1;
+}
+
+static bool readBaseline(const std::string& path, std::vector<StageSummary>& summaries, std::string& config) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+    const size_t configAt = text.find("\"config\"");
+    if (configAt != std::string::npos) {
+        const size_t open = text.find('"', text.find(':', configAt));
+        const size_t close = open == std::string::npos ? open : text.find('"', open + 1);
+        if (close != std::string::npos) config = text.substr(open + 1, close - open - 1);
+    }
+    summaries.assign(PERF_STAGE_COUNT, StageSummary());
+    for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+        const size_t at = text.find("\"" + std::string(PERF_STAGES[i]) + "\"");
+        if (at == std::string::npos) continue;   // 新增阶段：基线中没有，只报不判
+        const size_t open = text.find('{', at), close = text.find('}', at);
+        if (open == std::string::npos || close == std::string::npos || close < open) return false;
+        const std::string object = text.substr(open, close - open + 1);
+        double runs = 0;
+        StageSummary& s = summaries[i];
+        if (!jsonNumber(object, "median", s.median) || !jsonNumber(object, "low", s.low) ||
+            !jsonNumber(object, "high", s.high) || !jsonNumber(object, "runs", runs)) return false;
+        s.runs = static_cast<int>(runs);
+    }
+    return true;
+}
+
+// ---------------------- 入口 ----------------------
+// 性能回归检查：Project1 --perf-check [基线.json] [update]
+//   指定 update 时按本机测量结果写出基线；否则与基线比较，有回归时返回 1，无法解析时返回 -1。
+//   基线缺失：未指定路径（默认 perf_baseline.json，门禁尚未建立）时提示初始化步骤并返回 0；
+//   显式指定的基线文件不存在时返回 -1，避免 CI 里写错路径被当作通过
+int runPerfCheck(int argc, char** argv) {
+    const bool explicitPath = argc > 0;
+    const std::string path = explicitPath ? argv[0] : "perf_baseline.json";
+    const bool update = argc > 1 && std::string(argv[1]) == "update";
+    if (!update && !std::filesystem::exists(path)) {
+        if (explicitPath) {
+            std::cerr << " 基线 " << path << " 不存在。" << std::endl;
+            return -1;
+        }
+        std::cout << "【性能回归检查】尚未建立基线（" << path << " 不存在），本次未做比较。" << std::endl
+            << " 初始化：在参考机器上用 Release 构建运行 --perf-check " << path
+            << " update，确认结果后提交该文件；之后 CI 以 --perf-check " << path << " 显式指定基线。" << std::endl;
+        return 0;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<StageSummary> current;
+    measureStages(current);
+    std::cout << "【性能回归检查】" << perfConfig() << "，测量用时 " << elapsedMs(start) / 1000 << " s" << std::endl;
+
+    if (update) {
+        if (!writeBaseline(path, current)) {
+            std::cerr << " 无法写出基线 " << path << std::endl;
+            return -1;
+        }
+        for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+            std::cout << " " << PERF_STAGES[i] << "  " << current[i].median << " ms  [" << current[i].low << ", "
+                << current[i].high << "]" << std::endl;
+        }
+        std::cout << " 已写出基线 " << path << "，请确认本机状态正常后提交。" << std::endl;
+        return 0;
+    }
+
+    std::vector<StageSummary> baseline;
+    std::string baselineConfig;
+    if (!readBaseline(path, baseline, baselineConfig)) {
+        std::cerr << " 无法解析基线 " << path << "，可用 update 重新生成。" << std::endl;
+        return -1;
+    }
+    if (baselineConfig != perfConfig()) {
+        std::cout << " 注意：基线配置为 \"" << baselineConfig << "\"，与本次不同，结论仅供参考。" << std::endl;
+    }
+
+    int regressions = 0, improvements = 0;
+    std::cout << " 阶段  基线中位数 [95% 区间]  当前中位数 [95% 区间]  变化  结论" << std::endl;
+    for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+        const StageSummary& b = baseline[i];
+        const StageSummary& c = current[i];
+        const char* verdict = "持平";
+        if (b.runs == 0) verdict = "新增（无基线）";
+        else if (c.low > b.high * (1 + PERF_TOLERANCE) && c.median - b.median > PERF_MIN_DELTA_MS) {
+            verdict = "回归";
+            regressions++;
+        }
+        else if (c.high * (1 + PERF_TOLERANCE) < b.low && b.median - c.median > PERF_MIN_DELTA_MS) {
+            verdict = "变快";
+            improvements++;
+        }
+        std::cout << " " << PERF_STAGES[i] << "  ";
+        if (b.runs) std::cout << b.median << " ms [" << b.low << ", " << b.high << "]";
+        else std::cout << "-";
+        std::cout << "  " << c.median << " ms [" << c.low << ", " << c.high << "]  ";
+        if (b.runs && b.median > 0) std::cout << (c.median / b.median - 1) * 100 << "%";
+        std::cout << "  " << verdict << std::endl;
+    }
+    if (regressions) {
+        std::cout << " 共 " << regressions << " 个阶段回归（区间下界高出基线上界 " << PERF_TOLERANCE * 100
+            << "% 以上）。" << std::endl;
+        return 1;
+    }
+    std::cout << " 未发现回归" << (improvements ? "；有阶段明显变快，可用 update 刷新基线。" : "。") << std::endl;
+    return 0;
+}
@@ -0,0 +1,351 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 任务图执行器
+//     每个工作线程持有一个双端队列：自己从尾部取任务，空闲时从其他线程的头部窃取。
+//     evaluate 只调度目标结点及其尚未完成的依赖（惰性求值），
+//     已完成结点的输出被缓存，之后的 evaluate 直接复用。
+// ====================================================
+
+TaskGraph::TaskGraph(int threadCount) {
+    int n = threadCount > 0 ? threadCount : static_cast<int>(std::thread::hardware_concurrency());
+    n = std::max(n, 1);
+    for (int i = 0; i < n; ++i) workers_.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < n; ++i) threads_.emplace_back(&TaskGraph::workerLoop, this, i);
+}
+
+TaskGraph::~TaskGraph() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeWorkers_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+int TaskGraph::addNode(const std::string& name, std::function<void()> fn, const std::vector<int>& deps) {
+    nodes_.emplace_back();
+    Node& node = nodes_.back();
+    node.name = name;
+    node.fn = std::move(fn);
+    node.deps = deps;
+    node.timing.name = name;
+    node.timing.memoryStage = memoryStageId(name);
+    return static_cast<int>(nodes_.size()) - 1;
+}
+
+void TaskGraph::pushTask(int index, int node) {
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(node);
+    }
+    queued_++;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wakeWorkers_.notify_one();
+}
+
+// 先取自己队列的尾部（最近产生、缓存最热），再依次窃取其他队列的头部
+bool TaskGraph::popTask(int index, int& node) {
+    const int n = static_cast<int>(workers_.size());
+    for (int k = 0; k < n; ++k) {
+        Worker& w = *workers_[(index + k) % n];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.tasks.empty()) continue;
+        if (k == 0) {
+            node = w.tasks.back();
+            w.tasks.pop_back();
+        }
+        else {
+            node = w.tasks.front();
+            w.tasks.pop_front();
+        }
+        queued_--;
+        return true;
+    }
+    return false;
+}
+
+void TaskGraph::runNode(int index, int node) {
+    Node& n = nodes_[node];
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        MemoryStageScope scope(n.timing.memoryStage);
+        n.fn();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    n.timing.startMs = std::chrono::duration<double, std::milli>(start - runStart_).count();
+    n.timing.endMs = std::chrono::duration<double, std::milli>(end - runStart_).count();
+    n.timing.worker = index;
+    n.done = true;
+
+    for (int dep : n.dependents) {
+        if (--nodes_[dep].pending == 0) pushTask(index, dep);
+    }
+    if (--remaining_ == 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        runFinished_.notify_all();
+    }
+}
+
+void TaskGraph::workerLoop(int index) {
+    while (true) {
+        int node;
+        if (popTask(index, node)) {
+            runNode(index, node);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wakeWorkers_.wait(lock, [&] { return stopping_ || queued_ > 0; });
+        if (stopping_) return;
+    }
+}
+
+void TaskGraph::evaluate(const std::vector<int>& targets) {
+    // 收集未完成的依赖闭包，后序遍历即拓扑序
+    std::vector<int> closure;
+    std::vector<char> visited(nodes_.size(), 0);
+    std::function<void(int)> collect = [&](int id) {
+        if (visited[id] || nodes_[id].done) return;
+        visited[id] = 1;
+        for (int dep : nodes_[id].deps) collect(dep);
+        closure.push_back(id);
+        };
+    for (int id : targets) collect(id);
+
+    report_ = RunReport();
+    if (closure.empty()) return;
+
+    // 先确定就绪结点再统一入队：一旦开始入队，工作线程就会并发修改 pending
+    std::vector<int> ready;
+    for (int id : closure) nodes_[id].dependents.clear();
+    for (int id : closure) {
+        int pending = 0;
+        for (int dep : nodes_[id].deps) {
+            if (nodes_[dep].done) continue;
+            nodes_[dep].dependents.push_back(id);
+            pending++;
+        }
+        nodes_[id].pending = pending;
+        if (pending == 0) ready.push_back(id);
+    }
+
+    runStart_ = std::chrono::high_resolution_clock::now();
+    remaining_ = static_cast<int>(closure.size());
+    for (size_t i = 0; i < ready.size(); ++i) pushTask(static_cast<int>(i % workers_.size()), ready[i]);
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        runFinished_.wait(lock, [&] { return remaining_ == 0; });
+    }
+    report_.wallMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - runStart_).count();
+
+    // 关键路径：按拓扑序求每个结点的最早完成时间（只计结点自身耗时）
+    std::map<int, double> finish;
+    std::map<int, int> via;
+    int last = -1;
+    for (int id : closure) {
+        const NodeTiming& t = nodes_[id].timing;
+        double cost = t.endMs - t.startMs;
+        double before = 0;
+        via[id] = -1;
+        for (int dep : nodes_[id].deps) {
+            auto it = finish.find(dep);
+            if (it != finish.end() && it->second > before) {
+                before = it->second;
+                via[id] = dep;
+            }
+        }
+        finish[id] = before + cost;
+        report_.cpuMs += cost;
+        report_.nodes.push_back(t);
+        if (last == -1 || finish[id] > finish[last]) last = id;
+    }
+    report_.criticalPathMs = finish[last];
+    for (int id = last; id != -1; id = via[id]) report_.criticalPath.push_back(nodes_[id].name);
+    std::reverse(report_.criticalPath.begin(), report_.criticalPath.end());
+    std::sort(report_.nodes.begin(), report_.nodes.end(),
+        [](const NodeTiming& a, const NodeTiming& b) { return a.startMs < b.startMs; });
+}
+
+void TaskGraph::printReport(std::ostream& os) const {
+    os << "【任务图】线程数 " << workers_.size() << "，本次计算结点 " << report_.nodes.size() << std::endl;
+    for (const auto& t : report_.nodes) {
+        os << "  [线程 " << t.worker << "] " << t.name << "  " << t.startMs << " ~ " << t.endMs
+            << " ms（" << t.endMs - t.startMs << " ms）" << std::endl;
+        if (memoryTrackingEnabled()) {
+            os << "      ";
+            printMemoryStage(os, memoryStageStats(t.memoryStage));
+            os << std::endl;
+        }
+    }
+    std::string path;
+    for (const auto& name : report_.criticalPath) path += (path.empty() ? "" : " → ") + name;
+    os << "  关键路径 " << report_.criticalPathMs << " ms：" << path << std::endl;
+    os << "  CPU 总时间 " << report_.cpuMs << " ms，墙钟 " << report_.wallMs << " ms，可达并行度 "
+        << report_.cpuMs / std::max(report_.criticalPathMs, 1e-9) << std::endl;
+    if (memoryTrackingEnabled()) {
+        os << "  结点外（含条带线程与 OpenCV 工作线程的分配）：";
+        printMemoryStage(os, memoryStageStats(0));
+        os << std::endl << "  堆峰值 " << heapPeakBytes() / 1048576.0 << " MB，进程常驻内存峰值 "
+            << peakResidentBytes() / 1048576.0 << " MB" << std::endl;
+    }
+}
+
+
+// ====================================================
+// ✅ 分割流水线
+//     markers 生成后，邻接图/着色 与 面积统计/排序/哈夫曼 两条支路互不依赖，
+//     各可视化结点只在被请求时才计算。
+// ====================================================
+
+SegmentationPipeline::SegmentationPipeline(const cv::Mat& src, int K, int areaLow, int areaHigh, uint32_t seed, int threadCount)
+    : src_(src), K_(K), areaLow_(areaLow), areaHigh_(areaHigh), env_(seed, consoleLogSink()),
+    graph_(threadCount) {
+    PipelineOutputs& o = out_;
+    // env_ 只交给 seeds → flood → adjacency → coloring 这条依赖链上的结点，同一时刻至多一个结点在用
+    // 其随机数引擎；与之并行的 render:highlight 不传 env，自行以 std::random_device 播种
+    ids_[STAGE_RELIEF] = graph_.addNode("relief", [this, &o] { o.relief = computeWatershedRelief(src_); });
+    ids_[STAGE_SEEDS] = graph_.addNode("seeds", [this, &o] { o.seeds = generateSeedPoints(src_.size(), K_, env_.rng); });
+    ids_[STAGE_FLOOD] = graph_.addNode("flood", [this, &o] {
+        o.markers = computeMarkersFromRelief(src_.size(), o.seeds, o.relief, &env_);
+        }, { ids_[STAGE_RELIEF], ids_[STAGE_SEEDS] });
+
+    ids_[STAGE_ADJACENCY] = graph_.addNode("adjacency", [&o] {
+        o.graph = buildRegionAdjacencyGraph(o.markers);
+        }, { ids_[STAGE_FLOOD] });
+    ids_[STAGE_COLORING] = graph_.addNode("coloring", [this, &o] {
+        o.coloringOk = repeatUntilFourColorSuccess(o.graph, nullptr, &env_);
+        }, { ids_[STAGE_ADJACENCY] });
+
+    ids_[STAGE_STATS] = graph_.addNode("stats", [&o] { o.areaMap = computeRegionAreas(o.markers); }, { ids_[STAGE_FLOOD] });
+    ids_[STAGE_SORT] = graph_.addNode("sort", [this, &o] {
+        o.sortedAreas.clear();
+        for (const auto& [label, area] : o.areaMap) o.sortedAreas.push_back({ label, area });
+        std::sort(o.sortedAreas.begin(), o.sortedAreas.end(),
+            [](const AreaEntry& a, const AreaEntry& b) { return a.area < b.area; });
+        o.targetLabels = binarySearchInRange(o.sortedAreas, areaLow_, areaHigh_);
+        o.filteredAreaMap.clear();
+        for (int label : o.targetLabels) o.filteredAreaMap[label] = o.areaMap.at(label);
+        }, { ids_[STAGE_STATS] });
+    ids_[STAGE_HUFFMAN] = graph_.addNode("huffman", [&o] {
+        if (o.filteredAreaMap.empty()) return;
+        o.huffmanTree = buildHuffmanTree(o.filteredAreaMap);
+        if (!buildCanonicalHuffmanTable(o.filteredAreaMap, o.huffmanTable, 24)) {
+            std::cerr << " 范式哈夫曼码表构建失败。" << std::endl;
+        }
+        }, { ids_[STAGE_SORT] });
+
+    // flood 在邻接图非平面时会改写 o.seeds，叠加图须等它完成，画的才是实际使用的种子
+    ids_[STAGE_RENDER_SEEDS] = graph_.addNode("render:seeds", [this, &o] {
+        o.seedOverlay = visualizeSeedOverlay(src_, o.seeds);
+        }, { ids_[STAGE_FLOOD] });
+    ids_[STAGE_RENDER_WATERSHED] = graph_.addNode("render:watershed", [this, &o] {
+        o.watershedView = applyWatershedWithColor(src_, o.markers);
+        }, { ids_[STAGE_FLOOD] });
+    ids_[STAGE_RENDER_COLORING] = graph_.addNode("render:coloring", [&o] {
+        o.colorView = visualizeFourColoring(o.markers, o.graph);
+        }, { ids_[STAGE_COLORING] });
+    ids_[STAGE_RENDER_HIGHLIGHT] = graph_.addNode("render:highlight", [this, &o] {
+        auto colorMap = generateColorMap(o.targetLabels);
+        auto centerMap = computeRegionCenters(o.markers, o.areaMap);
+        o.highlightView = src_.clone();
+        highlightRegions(o.highlightView, o.markers, o.targetLabels, colorMap, o.areaMap, centerMap);
+        }, { ids_[STAGE_SORT] });
+    ids_[STAGE_RENDER_HUFFMAN] = graph_.addNode("render:huffman", [&o] {
+        TaskEnv logEnv(0, consoleLogSink());   // 只用日志出口；env_ 属于种子链上的结点
+        if (o.huffmanTree) o.huffmanView = visualizeHuffmanTree(o.huffmanTree, &logEnv);
+        }, { ids_[STAGE_HUFFMAN] });
+}
+
+SegmentationPipeline::~SegmentationPipeline() {
+    deleteHuffmanTree(out_.huffmanTree);
+}
+
+void SegmentationPipeline::evaluate(const std::vector<PipelineStage>& stages) {
+    std::vector<int> targets;
+    for (PipelineStage stage : stages) targets.push_back(ids_[stage]);
+    graph_.evaluate(targets);
+}
+
+// 缓存命中：种子、淹没、邻接与面积结点直接取缓存并标记完成，地形图不再被依赖，任务1 整体跳过。
+// 旧接口按 CV_32S 读标签：32 位记录直接引用映射内存，16 位记录展开一次；entry 须比流水线活得久
+void SegmentationPipeline::restore(const CachedSegmentation& entry) {
+    PipelineOutputs& o = out_;
+    o.seeds = entry.seeds();
+    if (entry.labels().depth() == CV_32S) o.markers = entry.labels();
+    else entry.labels().convertTo(o.markers, CV_32S);
+
+    o.areaMap.clear();
+    for (int l = 1; l <= entry.maxLabel(); ++l) {
+        if (entry.areas()[l] > 0) o.areaMap[l] = entry.areas()[l];
+    }
+    RegionAdjacencyCSR csr;
+    entry.adjacency(csr);
+    o.graph = RegionGraph();
+    for (int l = 1; l <= csr.maxLabel; ++l) {
+        for (int k = csr.offsets[l]; k < csr.offsets[l + 1]; ++k) o.graph.adjacency[l].insert(csr.neighbors[k]);
+    }
+    for (PipelineStage stage : { STAGE_SEEDS, STAGE_FLOOD, STAGE_ADJACENCY, STAGE_STATS }) graph_.markDone(ids_[stage]);
+}
+
+// 流水线模式：Project1 --pipeline [图像路径] [K] [面积下限] [面积上限] [线程数] [缓存目录|-] [缓存上限MB] [mem|-] [种子]
+//   mem：按结点统计堆与 cv::Mat 分配（峰值、留存、次数），与耗时一起列在任务图报告中
+//   种子：缺省取 std::random_device 并打印出来；缓存按（图像, K, 种子）命中，复用结果须指定同一种子
+int runPipeline(int argc, char** argv) {
+    std::string path = argc > 0 ? argv[0] : "wife.jpg";
+    int K = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int low = argc > 2 ? std::atoi(argv[2]) : 0;
+    int high = argc > 3 ? std::atoi(argv[3]) : INT_MAX;
+    int threads = argc > 4 ? std::atoi(argv[4]) : 0;
+    std::string cacheDir = argc > 5 ? argv[5] : "seg_cache";
+    long long cacheMB = argc > 6 ? std::atoll(argv[6]) : 1024;
+    if (argc > 7 && std::string(argv[7]) == "mem") setMemoryTracking(true);
+    const uint32_t seed = argc > 8 ? static_cast<uint32_t>(std::strtoul(argv[8], nullptr, 10)) : std::random_device{}();
+
+    cv::Mat src = cv::imread(path);
+    if (src.empty()) {
+        std::cerr << " 无法读取图像文件 " << path << std::endl;
+        return -1;
+    }
+    if (K < 2 || K > 10000 || low < 0 || high < low || cacheMB <= 0) {
+        std::cerr << " 参数非法：K 应在 [2, 10000] 范围内，0 ≤ 面积下限 ≤ 面积上限，缓存上限为正。" << std::endl;
+        return -1;
+    }
+
+    // 同一图像、K 与种子的分割结果落盘复用，再次运行（例如只改面积区间）时跳过任务1
+    std::cout << " 随机种子 " << seed << std::endl;
+    std::unique_ptr<SegmentationCache> cache;
+    CachedSegmentation cached;
+    uint64_t imageHash = 0;
+    SegmentationPipeline pipeline(src, K, low, high, seed, threads);
+    if (cacheDir != "-") {
+        cache = std::make_unique<SegmentationCache>(cacheDir, static_cast<uint64_t>(cacheMB) << 20);
+        imageHash = SegmentationCache::imageHash(src);
+        if (cache->lookup(imageHash, K, seed, cached)) {
+            pipeline.restore(cached);
+            std::cout << " 结果缓存命中，跳过任务1。" << std::endl;
+        }
+    }
+    pipeline.evaluate({ STAGE_RENDER_SEEDS, STAGE_RENDER_WATERSHED, STAGE_RENDER_COLORING,
+        STAGE_RENDER_HIGHLIGHT, STAGE_RENDER_HUFFMAN });
+    pipeline.graph().printReport(std::cout);
+
+    const PipelineOutputs& o = pipeline.outputs();
+    if (cache) {
+        if (!cached.isOpen()) cache->store(imageHash, K, seed, o.seeds, o.markers);
+        cache->printStats(std::cout);
+    }
+    if (!o.coloringOk) {
+        std::cerr << " 四色着色失败，图结构可能异常。" << std::endl;
+    }
+    std::cout << " 共找到 " << o.targetLabels.size() << " 个区域符合条件。" << std::endl;
+
+    cv::imshow("任务1 - 原图与种子点叠加", o.seedOverlay);
+    cv::imshow("任务1 - 分水岭区域图", o.watershedView);
+    cv::imshow("任务2 - 四色着色图", o.colorView);
+    cv::imshow("任务3 - 高亮显示目标区域", o.highlightView);
+    if (!o.huffmanView.empty()) cv::imshow("任务3 - 哈夫曼树可视化", o.huffmanView);
+    cv::waitKey(0);
+    return 0;
+}
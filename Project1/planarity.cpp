@@ -0,0 +1,322 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 左右（LR）平面性测试（Brandes, "The Left-Right Planarity Test"）
+//     1. 定向：DFS 给每条边定向并求 lowpt / lowpt2，嵌套深度 = 2 * lowpt（+1 表示弦边）；
+//     2. 每个顶点的出边按嵌套深度计数排序；
+//     3. 测试：再做一次 DFS，用冲突对栈维护回边区间的左右约束，无法分到两侧即非平面。
+//     直接在区域邻接 CSR 上进行，有向边用 CSR 下标表示；两次 DFS 都用显式栈，
+//     十万级区域时不会因递归过深溢出。E > 3V - 6 时直接判为非平面。
+// ====================================================
+
+typedef PlanarityScratch::Interval Interval;
+typedef PlanarityScratch::ConflictPair ConflictPair;
+
+static bool isEmpty(const Interval& i) {
+    return i.low < 0 && i.high < 0;
+}
+
+// 区间中最高的回边比 b 的 lowpt 更高，则与 b 冲突
+static bool conflicting(const Interval& i, int b, const PlanarityScratch& s) {
+    return !isEmpty(i) && s.lowpt[i.high] > s.lowpt[b];
+}
+
+static int lowest(const ConflictPair& p, const PlanarityScratch& s) {
+    if (isEmpty(p.left)) return s.lowpt[p.right.low];
+    if (isEmpty(p.right)) return s.lowpt[p.left.low];
+    return std::min(s.lowpt[p.left.low], s.lowpt[p.right.low]);
+}
+
+static bool addConstraints(int ei, int e, PlanarityScratch& s) {
+    ConflictPair p;
+    // ei 的回边并入 p.right
+    do {
+        ConflictPair q = s.stack.back();
+        s.stack.pop_back();
+        if (!isEmpty(q.left)) std::swap(q.left, q.right);
+        if (!isEmpty(q.left)) return false;
+        if (s.lowpt[q.right.low] > s.lowpt[e]) {
+            if (isEmpty(p.right)) p.right = q.right;
+            else s.ref[p.right.low] = q.right.high;
+            p.right.low = q.right.low;
+        }
+        else {
+            s.ref[q.right.low] = s.lowptEdge[e];
+        }
+    } while (static_cast<int>(s.stack.size()) > s.stackBottom[ei]);
+
+    // 之前兄弟边中与 ei 冲突的回边并入 p.left
+    while (!s.stack.empty() && (conflicting(s.stack.back().left, ei, s) || conflicting(s.stack.back().right, ei, s))) {
+        ConflictPair q = s.stack.back();
+        s.stack.pop_back();
+        if (conflicting(q.right, ei, s)) std::swap(q.left, q.right);
+        if (conflicting(q.right, ei, s)) return false;
+        if (p.right.low >= 0) s.ref[p.right.low] = q.right.high;
+        if (q.right.low >= 0) p.right.low = q.right.low;
+        if (isEmpty(p.left)) p.left = q.left;
+        else s.ref[p.left.low] = q.left.high;
+        p.left.low = q.left.low;
+    }
+    if (!isEmpty(p.left) || !isEmpty(p.right)) s.stack.push_back(p);
+    return true;
+}
+
+// 树边 e = (u, v) 处理完毕：去掉终点为 u 的回边，并记录 e 一侧最高的回边
+static void removeBackEdges(int e, const int* nbr, PlanarityScratch& s) {
+    const int u = s.source[e];
+    while (!s.stack.empty() && lowest(s.stack.back(), s) == s.height[u]) s.stack.pop_back();
+    if (!s.stack.empty()) {
+        ConflictPair& p = s.stack.back();
+        while (p.left.high >= 0 && nbr[p.left.high] == u) p.left.high = s.ref[p.left.high];
+        if (p.left.high < 0 && p.left.low >= 0) {
+            s.ref[p.left.low] = p.right.low;
+            p.left.low = -1;
+        }
+        while (p.right.high >= 0 && nbr[p.right.high] == u) p.right.high = s.ref[p.right.high];
+        if (p.right.high < 0 && p.right.low >= 0) {
+            s.ref[p.right.low] = p.left.low;
+            p.right.low = -1;
+        }
+    }
+    if (s.lowpt[e] < s.height[u] && !s.stack.empty()) {
+        int hl = s.stack.back().left.high, hr = s.stack.back().right.high;
+        s.ref[e] = hl >= 0 && (hr < 0 || s.lowpt[hl] > s.lowpt[hr]) ? hl : hr;
+    }
+}
+
+bool isPlanarCSR(const RegionAdjacencyCSR& graph, PlanarityScratch& s) {
+    const int n = graph.maxLabel + 1;
+    if (static_cast<int>(graph.offsets.size()) < n + 1) return true;
+    const int* off = graph.offsets.data();
+    const int* nbr = graph.neighbors.data();
+    const int slots = off[n];
+
+    int vertexCount = 0;
+    for (int v = 1; v < n; ++v) vertexCount += off[v + 1] > off[v];
+    if (vertexCount >= 3 && static_cast<int64_t>(slots / 2) > 3 * static_cast<int64_t>(vertexCount) - 6) return false;
+
+    // 反向边下标与起点（邻居表升序，二分查找）
+    s.twin.resize(slots);
+    s.source.resize(slots);
+    for (int v = 1; v < n; ++v) {
+        for (int j = off[v]; j < off[v + 1]; ++j) {
+            s.source[j] = v;
+            const int u = nbr[j];
+            if (v < u) {
+                int k = static_cast<int>(std::lower_bound(nbr + off[u], nbr + off[u + 1], v) - nbr);
+                s.twin[j] = k;
+                s.twin[k] = j;
+            }
+        }
+    }
+
+    // ---------- 定向 ----------
+    s.height.assign(n, -1);
+    s.parentEdge.assign(n, -1);
+    s.direction.assign(slots, 0);   // 1 = 按此方向定向，2 = 反向已定向
+    s.skip.assign(slots, 0);
+    s.lowpt.resize(slots);
+    s.lowpt2.resize(slots);
+    s.nesting.resize(slots);
+    s.next.assign(off, off + n);
+    s.roots.clear();
+    int maxNesting = 0;
+    for (int root = 1; root < n; ++root) {
+        if (s.height[root] >= 0 || off[root + 1] == off[root]) continue;
+        s.height[root] = 0;
+        s.roots.push_back(root);
+        s.dfs.assign(1, root);
+        while (!s.dfs.empty()) {
+            const int v = s.dfs.back();
+            s.dfs.pop_back();
+            const int e = s.parentEdge[v];
+            for (; s.next[v] < off[v + 1]; ++s.next[v]) {
+                const int j = s.next[v], w = nbr[j];
+                if (!s.skip[j]) {
+                    if (s.direction[j]) continue;
+                    s.direction[j] = 1;
+                    s.direction[s.twin[j]] = 2;
+                    s.lowpt[j] = s.lowpt2[j] = s.height[v];
+                    if (s.height[w] < 0) {
+                        // 树边：先处理子结点，回到 v 时再从这条边继续
+                        s.parentEdge[w] = j;
+                        s.height[w] = s.height[v] + 1;
+                        s.skip[j] = 1;
+                        s.dfs.push_back(v);
+                        s.dfs.push_back(w);
+                        break;
+                    }
+                    s.lowpt[j] = s.height[w];
+                }
+                s.nesting[j] = 2 * s.lowpt[j] + (s.lowpt2[j] < s.height[v] ? 1 : 0);
+                maxNesting = std::max(maxNesting, s.nesting[j]);
+                if (e >= 0) {
+                    if (s.lowpt[j] < s.lowpt[e]) {
+                        s.lowpt2[e] = std::min(s.lowpt[e], s.lowpt2[j]);
+                        s.lowpt[e] = s.lowpt[j];
+                    }
+                    else if (s.lowpt[j] > s.lowpt[e]) {
+                        s.lowpt2[e] = std::min(s.lowpt2[e], s.lowpt[j]);
+                    }
+                    else {
+                        s.lowpt2[e] = std::min(s.lowpt2[e], s.lowpt2[j]);
+                    }
+                }
+            }
+        }
+    }
+
+    // ---------- 出边按嵌套深度计数排序，写回各顶点在 CSR 中的区段 ----------
+    s.count.assign(maxNesting + 2, 0);
+    for (int j = 0; j < slots; ++j) {
+        if (s.direction[j] == 1) s.count[s.nesting[j] + 1]++;
+    }
+    for (int d = 1; d <= maxNesting + 1; ++d) s.count[d] += s.count[d - 1];
+    s.dfs.resize(slots / 2);
+    for (int j = 0; j < slots; ++j) {
+        if (s.direction[j] == 1) s.dfs[s.count[s.nesting[j]]++] = j;
+    }
+    s.ordered.resize(slots);
+    s.outEnd.assign(off, off + n);
+    for (int j : s.dfs) s.ordered[s.outEnd[s.source[j]]++] = j;
+
+    // ---------- 测试 ----------
+    s.ref.assign(slots, -1);
+    s.lowptEdge.assign(slots, -1);
+    s.stackBottom.resize(slots);
+    s.stack.clear();
+    std::fill(s.skip.begin(), s.skip.end(), 0);
+    s.next.assign(off, off + n);
+    for (int root : s.roots) {
+        s.dfs.assign(1, root);
+        while (!s.dfs.empty()) {
+            const int v = s.dfs.back();
+            s.dfs.pop_back();
+            const int e = s.parentEdge[v];
+            bool descended = false;
+            for (; s.next[v] < s.outEnd[v]; ++s.next[v]) {
+                const int ei = s.ordered[s.next[v]], w = nbr[ei];
+                if (!s.skip[ei]) {
+                    s.stackBottom[ei] = static_cast<int>(s.stack.size());
+                    if (ei == s.parentEdge[w]) {
+                        s.skip[ei] = 1;
+                        s.dfs.push_back(v);
+                        s.dfs.push_back(w);
+                        descended = true;
+                        break;
+                    }
+                    s.lowptEdge[ei] = ei;
+                    s.stack.push_back({ Interval(), Interval{ ei, ei } });
+                }
+                if (s.lowpt[ei] < s.height[v]) {
+                    if (s.next[v] == off[v]) s.lowptEdge[e] = s.lowptEdge[ei];
+                    else if (!addConstraints(ei, e, s)) return false;
+                }
+            }
+            if (!descended && e >= 0) removeBackEdges(e, nbr, s);
+        }
+    }
+    return true;
+}
+
+// ====================================================
+// ✅ Kuratowski 子图提取（诊断用）
+//     成组删除：去掉一段候选后仍非平面就整段删除并加倍段长，否则段长减半；
+//     段长为 1 且删后变平面的候选必须保留。先按顶点删到极小非平面的导出子图，
+//     再在重新编号后的小图上按边删，剩下的边集是极小非平面图，即 K5 或 K3,3 的细分。
+//     测试次数约为 子图规模 × log(V)；分割结果的冲突是局部的，子图通常只有十几条边，
+//     细分路径很长（跨越整张图）时会明显变慢。
+// ====================================================
+template <typename StillNonPlanar>
+static void shrinkCandidates(std::vector<int>& candidates, StillNonPlanar&& stillNonPlanar) {
+    size_t pos = 0, chunk = std::max<size_t>(1, candidates.size() / 2);
+    while (pos < candidates.size()) {
+        const size_t len = std::min(chunk, candidates.size() - pos);
+        if (stillNonPlanar(pos, len)) {
+            candidates.erase(candidates.begin() + pos, candidates.begin() + pos + len);
+            chunk = len * 2;
+        }
+        else if (len == 1) {
+            ++pos;
+        }
+        else {
+            chunk = len / 2;
+        }
+    }
+}
+
+bool findKuratowskiSubgraph(const RegionAdjacencyCSR& graph, std::vector<std::pair<int, int>>& edges, PlanarityScratch& s) {
+    edges.clear();
+    if (isPlanarCSR(graph, s)) return false;
+    const int n = graph.maxLabel + 1;
+    const int* off = graph.offsets.data();
+    const int* nbr = graph.neighbors.data();
+
+    // 按顶点删：候选以外的顶点视为已删除
+    std::vector<int> vertices;
+    for (int v = 1; v < n; ++v) {
+        if (off[v + 1] > off[v]) vertices.push_back(v);
+    }
+    std::vector<uint8_t> alive(n, 0);
+    for (int v : vertices) alive[v] = 1;
+    shrinkCandidates(vertices, [&](size_t pos, size_t len) {
+        for (size_t i = pos; i < pos + len; ++i) alive[vertices[i]] = 0;
+        s.edges.clear();
+        for (int v : vertices) {
+            if (!alive[v]) continue;
+            for (int j = off[v]; j < off[v + 1]; ++j) {
+                if (v < nbr[j] && alive[nbr[j]]) s.edges.push_back(static_cast<uint64_t>(v) << 32 | static_cast<uint32_t>(nbr[j]));
+            }
+        }
+        finishRegionAdjacencyCSR(s.edges, graph.maxLabel, s.subgraph);
+        const bool nonPlanar = !isPlanarCSR(s.subgraph, s);
+        if (!nonPlanar) {
+            for (size_t i = pos; i < pos + len; ++i) alive[vertices[i]] = 1;
+        }
+        return nonPlanar;
+        });
+
+    // 按边删：导出子图重新编号为 1..|V|
+    std::vector<int> compact(n, 0);
+    for (size_t i = 0; i < vertices.size(); ++i) compact[vertices[i]] = static_cast<int>(i + 1);
+    std::vector<uint64_t> keys;
+    for (int v : vertices) {
+        for (int j = off[v]; j < off[v + 1]; ++j) {
+            const int u = nbr[j];
+            if (v < u && compact[u]) keys.push_back(static_cast<uint64_t>(compact[v]) << 32 | static_cast<uint32_t>(compact[u]));
+        }
+    }
+    std::vector<int> candidates(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) candidates[i] = static_cast<int>(i);
+    const int compactMax = static_cast<int>(vertices.size());
+    shrinkCandidates(candidates, [&](size_t pos, size_t len) {
+        s.edges.clear();
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (i < pos || i >= pos + len) s.edges.push_back(keys[candidates[i]]);
+        }
+        finishRegionAdjacencyCSR(s.edges, compactMax, s.subgraph);
+        return !isPlanarCSR(s.subgraph, s);
+        });
+
+    for (int i : candidates) {
+        const int a = vertices[(keys[i] >> 32) - 1], b = vertices[(keys[i] & 0xFFFFFFFFu) - 1];
+        edges.emplace_back(a, b);
+    }
+    return true;
+}
+
+// 按分支顶点（度数 >= 3）判别：5 个 4 度为 K5，6 个 3 度为 K3,3
+std::string describeKuratowskiSubgraph(const std::vector<std::pair<int, int>>& edges) {
+    std::map<int, int> degree;
+    for (const auto& [a, b] : edges) {
+        degree[a]++;
+        degree[b]++;
+    }
+    int degree3 = 0, degree4 = 0;
+    for (const auto& [v, d] : degree) {
+        degree3 += d == 3;
+        degree4 += d == 4;
+    }
+    std::string kind = degree4 == 5 ? "K5" : degree3 == 6 ? "K3,3" : "未知";
+    return kind + " 细分（" + std::to_string(degree.size()) + " 个顶点，" + std::to_string(edges.size()) + " 条边）";
+}
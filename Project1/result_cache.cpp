@@ -0,0 +1,368 @@
+﻿#include "utils.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+// ====================================================
+// ✅ 分割结果缓存
+//     文件名为 <图像散列>-<参数散列>.seg，内容为平铺二进制（小端，各段 8 字节对齐）：
+//       头部 | 种子 (x, y) int32 × seedCount | 标签图（按行，每像素 labelBytes 字节）
+//       | 面积 int32 | sumX int64 | sumY int64 | present u8（以上长度均为 maxLabel + 1）
+//       | CSR offsets int32 × (maxLabel + 2) | neighbors int32 × neighborCount
+//     读取时整体只读映射，各段直接作为数组使用；写入先落到临时文件再改名，读者不会看到半截记录。
+//     文件修改时间即最近使用时间，超出磁盘上限时从最旧的记录开始删除。
+// ====================================================
+
+struct SegmentationCacheHeader {
+    char magic[4];          // "SEGC"
+    uint32_t version;
+    uint64_t imageHash;
+    uint64_t paramsHash;
+    int32_t K;
+    int32_t rows, cols;
+    int32_t labelBytes;     // 2（CV_16U）或 4（CV_32S）
+    int32_t seedCount;
+    int32_t maxLabel;
+    int64_t neighborCount;
+};
+static_assert(sizeof(SegmentationCacheHeader) == 56, "缓存头部须无填充");
+
+struct SegmentationCacheLayout {
+    uint64_t seeds, labels, areas, sumX, sumY, present, offsets, neighbors, total;
+};
+
+static SegmentationCacheLayout cacheLayout(const SegmentationCacheHeader& h) {
+    const uint64_t labels = static_cast<uint64_t>(h.maxLabel) + 1;
+    SegmentationCacheLayout l;
+    l.seeds = align8(sizeof(SegmentationCacheHeader));
+    l.labels = align8(l.seeds + static_cast<uint64_t>(h.seedCount) * 8);
+    l.areas = align8(l.labels + static_cast<uint64_t>(h.rows) * h.cols * h.labelBytes);
+    l.sumX = align8(l.areas + labels * 4);
+    l.sumY = l.sumX + labels * 8;
+    l.present = l.sumY + labels * 8;
+    l.offsets = align8(l.present + labels);
+    l.neighbors = align8(l.offsets + (labels + 1) * 4);
+    l.total = l.neighbors + static_cast<uint64_t>(h.neighborCount) * 4;
+    return l;
+}
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+template <typename T>
+static uint64_t fnv1aValue(uint64_t h, T value) {
+    return fnv1a(h, &value, sizeof(value));
+}
+
+
+// ---------- 已映射的缓存记录 ----------
+
+bool CachedSegmentation::open(const std::string& path) {
+    close();
+    if (!file_.open(path, 0, false) || file_.size() < sizeof(SegmentationCacheHeader)) {
+        file_.close();
+        return false;
+    }
+    const uint8_t* base = file_.map(0, static_cast<size_t>(file_.size()));
+    if (!base) {
+        file_.close();
+        return false;
+    }
+    SegmentationCacheHeader h;
+    std::memcpy(&h, base, sizeof(h));
+    bool valid = std::memcmp(h.magic, "SEGC", 4) == 0 && h.version == SEGMENTATION_CACHE_VERSION &&
+        h.rows > 0 && h.cols > 0 && (h.labelBytes == 2 || h.labelBytes == 4) &&
+        h.seedCount >= 0 && h.maxLabel >= 0 && h.neighborCount >= 0 && cacheLayout(h).total == file_.size();
+    if (!valid) {
+        file_.close();
+        return false;
+    }
+
+    const SegmentationCacheLayout l = cacheLayout(h);
+    base_ = base;
+    imageHash_ = h.imageHash;
+    paramsHash_ = h.paramsHash;
+    K_ = h.K;
+    seedCount_ = h.seedCount;
+    maxLabel_ = h.maxLabel;
+    neighborCount_ = h.neighborCount;
+    seeds_ = reinterpret_cast<const int32_t*>(base + l.seeds);
+    labels_ = cv::Mat(h.rows, h.cols, h.labelBytes == 2 ? CV_16U : CV_32S, const_cast<uint8_t*>(base + l.labels));
+    areas_ = reinterpret_cast<const int32_t*>(base + l.areas);
+    sumX_ = reinterpret_cast<const int64_t*>(base + l.sumX);
+    sumY_ = reinterpret_cast<const int64_t*>(base + l.sumY);
+    present_ = base + l.present;
+    offsets_ = reinterpret_cast<const int32_t*>(base + l.offsets);
+    neighbors_ = reinterpret_cast<const int32_t*>(base + l.neighbors);
+    return true;
+}
+
+void CachedSegmentation::close() {
+    labels_.release();
+    file_.close();
+    base_ = nullptr;
+    seeds_ = nullptr;
+    areas_ = nullptr;
+    sumX_ = sumY_ = nullptr;
+    present_ = nullptr;
+    offsets_ = neighbors_ = nullptr;
+    imageHash_ = paramsHash_ = 0;
+    K_ = seedCount_ = maxLabel_ = 0;
+    neighborCount_ = 0;
+}
+
+std::vector<cv::Point> CachedSegmentation::seeds() const {
+    std::vector<cv::Point> out(seedCount_);
+    for (int i = 0; i < seedCount_; ++i) out[i] = cv::Point(seeds_[2 * i], seeds_[2 * i + 1]);
+    return out;
+}
+
+void CachedSegmentation::adjacency(RegionAdjacencyCSR& graph) const {
+    graph.maxLabel = maxLabel_;
+    graph.offsets.assign(offsets_, offsets_ + maxLabel_ + 2);
+    graph.neighbors.assign(neighbors_, neighbors_ + neighborCount_);
+    graph.present.assign(present_, present_ + maxLabel_ + 1);
+}
+
+
+// ---------- 缓存目录 ----------
+
+SegmentationCache::SegmentationCache(const std::string& directory, uint64_t diskBudget)
+    : directory_(directory), diskBudget_(diskBudget) {
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+}
+
+// stats 文件为三行文本："hits N" / "misses N" / "evictions N"，记录所有运行的累计值
+static void readCacheCounters(const std::string& path, uint64_t counters[3]) {
+    counters[0] = counters[1] = counters[2] = 0;
+    std::ifstream in(path);
+    std::string name;
+    uint64_t value;
+    while (in >> name >> value) {
+        if (name == "hits") counters[0] = value;
+        else if (name == "misses") counters[1] = value;
+        else if (name == "evictions") counters[2] = value;
+    }
+}
+
+SegmentationCache::~SegmentationCache() {
+    if (hits_ + misses_ + evictions_ == 0) return;
+    const std::string path = directory_ + "/stats";
+    uint64_t counters[3];
+    readCacheCounters(path, counters);
+    std::ofstream out(path, std::ios::trunc);
+    out << "hits " << counters[0] + hits_ << "\nmisses " << counters[1] + misses_
+        << "\nevictions " << counters[2] + evictions_ << "\n";
+}
+
+uint64_t SegmentationCache::imageHash(const cv::Mat& image) {
+    uint64_t h = FNV_OFFSET_BASIS;
+    h = fnv1aValue(h, static_cast<int32_t>(image.rows));
+    h = fnv1aValue(h, static_cast<int32_t>(image.cols));
+    h = fnv1aValue(h, static_cast<int32_t>(image.type()));
+    const size_t rowBytes = image.cols * image.elemSize();
+    for (int y = 0; y < image.rows; ++y) h = fnv1a(h, image.ptr(y), rowBytes);
+    return h;
+}
+
+uint64_t SegmentationCache::paramsHash(int K, uint32_t seed) {
+    uint64_t h = FNV_OFFSET_BASIS;
+    h = fnv1aValue(h, SEGMENTATION_CACHE_VERSION);
+    h = fnv1aValue(h, static_cast<int32_t>(K));
+    h = fnv1aValue(h, seed);
+    h = fnv1aValue(h, RELIEF_CANNY_LOW);
+    h = fnv1aValue(h, RELIEF_CANNY_HIGH);
+    h = fnv1aValue(h, static_cast<int32_t>(RELIEF_CLOSE_KERNEL));
+    h = fnv1aValue(h, RELIEF_DISTANCE_WEIGHT);
+    return h;
+}
+
+std::string SegmentationCache::entryPath(uint64_t imageHash, uint64_t paramsHash) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%016llx-%016llx.seg", static_cast<unsigned long long>(imageHash),
+        static_cast<unsigned long long>(paramsHash));
+    return directory_ + "/" + name;
+}
+
+bool SegmentationCache::lookup(uint64_t imageHash, int K, uint32_t seed, CachedSegmentation& entry) {
+    const uint64_t paramsHash = SegmentationCache::paramsHash(K, seed);
+    const std::string path = entryPath(imageHash, paramsHash);
+    std::error_code ec;
+    if (!fs::exists(path, ec) || !entry.open(path)) {
+        misses_++;
+        return false;
+    }
+    // 散列碰撞或记录与文件名不符时视为未命中，旧记录由下一次 store 覆盖
+    if (entry.imageHash() != imageHash || entry.paramsHash() != paramsHash || entry.K() != K) {
+        entry.close();
+        misses_++;
+        return false;
+    }
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    hits_++;
+    return true;
+}
+
+template <typename Label>
+static void regionStatsOf(const cv::Mat& markers, std::vector<int32_t>& areas,
+    std::vector<int64_t>& sumX, std::vector<int64_t>& sumY) {
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        for (int x = 0; x < markers.cols; ++x) {
+            int l = row[x];
+            if (l <= 0) continue;
+            areas[l]++;
+            sumX[l] += x;
+            sumY[l] += y;
+        }
+    }
+}
+
+static bool writePadded(std::ofstream& out, const void* data, uint64_t size, uint64_t& written, uint64_t target) {
+    static const char zeros[8] = {};
+    if (written < target) out.write(zeros, static_cast<std::streamsize>(target - written));
+    written = target;
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    written += size;
+    return static_cast<bool>(out);
+}
+
+// markers 为 CV_32S 或 CV_16U；标签非负且不超过 65535 时按 16 位存盘
+bool SegmentationCache::store(uint64_t imageHash, int K, uint32_t seed, const std::vector<cv::Point>& seeds,
+    const cv::Mat& markers) {
+    if (markers.empty() || (markers.type() != CV_32S && markers.type() != CV_16U)) {
+        std::cerr << " 缓存写入失败：markers 须为 CV_32S 或 CV_16U。" << std::endl;
+        return false;
+    }
+    RegionAdjacencyCSR graph;
+    std::vector<uint64_t> edgeScratch;
+    buildRegionAdjacencyCSR(markers, graph, edgeScratch);
+    double minLabel = 0;
+    cv::minMaxLoc(markers, &minLabel, nullptr);
+
+    SegmentationCacheHeader h;
+    std::memcpy(h.magic, "SEGC", 4);
+    h.version = SEGMENTATION_CACHE_VERSION;
+    h.imageHash = imageHash;
+    h.paramsHash = paramsHash(K, seed);
+    h.K = K;
+    h.rows = markers.rows;
+    h.cols = markers.cols;
+    h.labelBytes = minLabel >= 0 && selectLabelDepth(graph.maxLabel) == CV_16U ? 2 : 4;
+    h.seedCount = static_cast<int32_t>(seeds.size());
+    h.maxLabel = graph.maxLabel;
+    h.neighborCount = static_cast<int64_t>(graph.neighbors.size());
+    const SegmentationCacheLayout l = cacheLayout(h);
+    if (l.total > diskBudget_) {
+        std::cerr << " 缓存记录（" << (l.total >> 20) << " MB）超过磁盘上限，不写入。" << std::endl;
+        return false;
+    }
+
+    const size_t labelCount = static_cast<size_t>(h.maxLabel) + 1;
+    std::vector<int32_t> areas(labelCount, 0);
+    std::vector<int64_t> sumX(labelCount, 0), sumY(labelCount, 0);
+    if (markers.depth() == CV_16U) regionStatsOf<uint16_t>(markers, areas, sumX, sumY);
+    else regionStatsOf<int>(markers, areas, sumX, sumY);
+    std::vector<int32_t> seedData;
+    for (const cv::Point& p : seeds) {
+        seedData.push_back(p.x);
+        seedData.push_back(p.y);
+    }
+
+    const std::string path = entryPath(imageHash, h.paramsHash), tmpPath = path + ".tmp";
+    evict(l.total);
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        uint64_t written = 0;
+        bool ok = writePadded(out, &h, sizeof(h), written, 0) &&
+            writePadded(out, seedData.data(), seedData.size() * 4, written, l.seeds);
+        // 标签逐行写出，32 位收窄为 16 位时借助一行缓冲（CV_16U 输入的标签必然不超过 65535）
+        std::vector<uint16_t> narrow(h.labelBytes == 2 && markers.depth() == CV_32S ? markers.cols : 0);
+        for (int y = 0; ok && y < markers.rows; ++y) {
+            const void* row = markers.ptr(y);
+            if (!narrow.empty()) {
+                const int* src = markers.ptr<int>(y);
+                for (int x = 0; x < markers.cols; ++x) narrow[x] = static_cast<uint16_t>(src[x]);
+                row = narrow.data();
+            }
+            ok = writePadded(out, row, static_cast<uint64_t>(markers.cols) * h.labelBytes, written,
+                y == 0 ? l.labels : written);
+        }
+        ok = ok && writePadded(out, areas.data(), labelCount * 4, written, l.areas) &&
+            writePadded(out, sumX.data(), labelCount * 8, written, l.sumX) &&
+            writePadded(out, sumY.data(), labelCount * 8, written, l.sumY) &&
+            writePadded(out, graph.present.data(), labelCount, written, l.present) &&
+            writePadded(out, graph.offsets.data(), (labelCount + 1) * 4, written, l.offsets) &&
+            writePadded(out, graph.neighbors.data(), graph.neighbors.size() * 4, written, l.neighbors);
+        if (!ok || written != l.total) {
+            out.close();
+            std::remove(tmpPath.c_str());
+            std::cerr << " 缓存写入失败：" << tmpPath << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        std::remove(tmpPath.c_str());
+        std::cerr << " 缓存写入失败：" << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 按最近使用时间从旧到新删除，直到加上即将写入的 incoming 字节后不超过上限
+void SegmentationCache::evict(uint64_t incoming) {
+    struct Entry {
+        fs::file_time_type time;
+        uint64_t size;
+        fs::path path;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".seg") continue;
+        std::error_code entryEc;
+        Entry e{ it->last_write_time(entryEc), it->file_size(entryEc), it->path() };
+        if (entryEc) continue;
+        total += e.size;
+        entries.push_back(std::move(e));
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const Entry& e : entries) {
+        if (total + incoming <= diskBudget_) break;
+        if (fs::remove(e.path, ec)) {
+            total -= e.size;
+            evictions_++;
+        }
+    }
+}
+
+uint64_t SegmentationCache::diskUsage() const {
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code entryEc;
+        if (it->path().extension() == ".seg") total += it->file_size(entryEc);
+    }
+    return total;
+}
+
+void SegmentationCache::printStats(std::ostream& os) const {
+    uint64_t counters[3];
+    readCacheCounters(directory_ + "/stats", counters);
+    os << "【结果缓存】" << directory_ << "：本次命中 " << hits_ << "，未命中 " << misses_ << "，淘汰 " << evictions_
+        << "；累计命中 " << counters[0] + hits_ << "，未命中 " << counters[1] + misses_ << "，淘汰 "
+        << counters[2] + evictions_ << "；占用 " << diskUsage() / 1048576.0 << " / " << (diskBudget_ >> 20) << " MB" << std::endl;
+}
@@ -0,0 +1,641 @@
+﻿#include "utils.h"
+#include <new>
+#include <type_traits>
+
+// ====================================================
+// ✅ 区域邻接图（CSR）
+//     与 buildRegionAdjacencyGraph 相同的 8 邻域规则，但只扫描右、下、右下、左下四个方向，
+//     边以 (小标签 << 32 | 大标签) 编码后排序去重，再一次性展开成 CSR。
+//     所有数组由调用方持有，容量足够时不再分配。
+// ====================================================
+// 扫描前 rowCount 行，其后若还有一行则作为最后一行的下邻（条带处理时由调用方多映射一行）
+void appendRegionAdjacencyEdges(const cv::Mat& markers, int rowCount, std::vector<uint64_t>& edges, std::vector<uint8_t>& present) {
+    labelKernels().adjacencyEdges(markers, rowCount, edges, present);
+    // 边表过大时及时去重（条带累积时控制内存）
+    if (edges.size() > (static_cast<size_t>(1) << 22)) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    }
+}
+
+void finishRegionAdjacencyCSR(std::vector<uint64_t>& edges, int maxLabel, RegionAdjacencyCSR& graph) {
+    graph.maxLabel = maxLabel;
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // offsets[l + 2] 先计度数，前缀和后以 offsets[l + 1] 为写指针，填完恰好得到起始位置
+    graph.offsets.assign(maxLabel + 3, 0);
+    for (uint64_t e : edges) {
+        graph.offsets[(e >> 32) + 2]++;
+        graph.offsets[(e & 0xFFFFFFFFu) + 2]++;
+    }
+    for (int l = 2; l < maxLabel + 3; ++l) graph.offsets[l] += graph.offsets[l - 1];
+    graph.neighbors.resize(edges.size() * 2);
+    for (uint64_t e : edges) {
+        int a = static_cast<int>(e >> 32), b = static_cast<int>(e & 0xFFFFFFFFu);
+        graph.neighbors[graph.offsets[a + 1]++] = b;
+        graph.neighbors[graph.offsets[b + 1]++] = a;
+    }
+    graph.offsets.resize(maxLabel + 2);
+}
+
+void buildRegionAdjacencyCSR(const cv::Mat& markers, RegionAdjacencyCSR& graph, std::vector<uint64_t>& edgeScratch) {
+    const int maxLabel = labelKernels().maxLabel(markers);
+    graph.present.assign(maxLabel + 1, 0);
+    edgeScratch.clear();
+    appendRegionAdjacencyEdges(markers, markers.rows, edgeScratch, graph.present);
+    finishRegionAdjacencyCSR(edgeScratch, maxLabel, graph);
+}
+
+// 只认共边（右、下）的 4 邻域邻接。各标签 4 连通时，这张图是平面网格图收缩所得，必为平面图；
+// 8 邻域多出的角点接触（四个区域交于一点）会引入交叉边，K 到 1000 左右几乎总是非平面，不能用来判定。
+// 连续相同的边只记一次，水平边界上的长串不会撑大边表
+void buildRegionAdjacencyCSR4(const cv::Mat& markers, RegionAdjacencyCSR& graph, std::vector<uint64_t>& edgeScratch) {
+    CV_Assert(markers.type() == CV_32S);
+    const int maxLabel = labelKernels().maxLabel(markers);
+    graph.present.assign(maxLabel + 1, 0);
+    edgeScratch.clear();
+    uint64_t last = 0;
+    auto add = [&](int a, int b) {
+        if (b <= 0 || b == a) return;
+        const uint64_t e = a < b ? static_cast<uint64_t>(a) << 32 | static_cast<uint32_t>(b)
+            : static_cast<uint64_t>(b) << 32 | static_cast<uint32_t>(a);
+        if (e != last) edgeScratch.push_back(last = e);
+        };
+    for (int y = 0; y < markers.rows; ++y) {
+        const int* row = markers.ptr<int>(y);
+        const int* below = y + 1 < markers.rows ? markers.ptr<int>(y + 1) : nullptr;
+        for (int x = 0; x < markers.cols; ++x) {
+            const int a = row[x];
+            if (a <= 0) continue;
+            graph.present[a] = 1;
+            if (x + 1 < markers.cols) add(a, row[x + 1]);
+            if (below) add(a, below[x]);
+        }
+    }
+    finishRegionAdjacencyCSR(edgeScratch, maxLabel, graph);
+}
+
+
+// ====================================================
+// ✅ CSR 四色着色引擎
+//     1. 桶队列求最小度后序（smallest-last），逆序贪心着色；
+//     2. 四色都被占用时尝试 Kempe 链交换：把与邻居相连的 {a, b} 双色连通分量整体对调，
+//        只要该分量不含颜色为 b 的邻居，颜色 a 就会空出来；
+//     3. 仍失败时取冲突最少的颜色（等价于原实现中删边重试），最后对冲突顶点做几轮修补。
+//     返回最终仍同色的边数。
+//     probe：着色一个顶点计一个结点，Kempe 链每访问一个顶点也计一个；发现冲突的修补轮计一次重来。
+//     超时后余下顶点保持 -1 不着色。
+// ====================================================
+int fourColorCSR(const RegionAdjacencyCSR& graph, std::vector<int8_t>& colors, CSRColoringScratch& s, ColoringProbe* probe) {
+    const int n = graph.maxLabel + 1;
+    colors.assign(n, -1);
+    if (n <= 1) return 0;
+    const int* off = graph.offsets.data();
+    const int* nbr = graph.neighbors.data();
+
+    int maxDegree = 0;
+    s.degree.assign(n, -1);
+    for (int v = 1; v < n; ++v) {
+        if (!graph.present[v]) continue;
+        s.degree[v] = off[v + 1] - off[v];
+        maxDegree = std::max(maxDegree, s.degree[v]);
+    }
+    s.bucketHead.assign(maxDegree + 1, -1);
+    s.bucketNext.assign(n, -1);
+    s.bucketPrev.assign(n, -1);
+    auto link = [&](int v) {
+        int d = s.degree[v];
+        s.bucketPrev[v] = -1;
+        s.bucketNext[v] = s.bucketHead[d];
+        if (s.bucketHead[d] != -1) s.bucketPrev[s.bucketHead[d]] = v;
+        s.bucketHead[d] = v;
+        };
+    auto unlink = [&](int v) {
+        int d = s.degree[v];
+        if (s.bucketPrev[v] != -1) s.bucketNext[s.bucketPrev[v]] = s.bucketNext[v];
+        else s.bucketHead[d] = s.bucketNext[v];
+        if (s.bucketNext[v] != -1) s.bucketPrev[s.bucketNext[v]] = s.bucketPrev[v];
+        };
+
+    int active = 0;
+    for (int v = 1; v < n; ++v) {
+        if (s.degree[v] >= 0) {
+            link(v);
+            active++;
+        }
+    }
+    s.order.clear();
+    int minDegree = 0;
+    while (active-- > 0) {
+        while (s.bucketHead[minDegree] == -1) minDegree++;
+        int v = s.bucketHead[minDegree];
+        unlink(v);
+        s.degree[v] = -1;
+        s.order.push_back(v);
+        for (int i = off[v]; i < off[v + 1]; ++i) {
+            int u = nbr[i];
+            if (s.degree[u] < 0) continue;
+            unlink(u);
+            s.degree[u]--;
+            link(u);
+            minDegree = std::min(minDegree, s.degree[u]);
+        }
+    }
+
+    if (static_cast<int>(s.stamp.size()) < n || s.generation > INT_MAX - 64) {
+        s.stamp.assign(std::max<size_t>(n, s.stamp.size()), 0);
+        s.generation = 0;
+    }
+    auto kempeRecolor = [&](int v) {
+        for (int a = 0; a < 4; ++a) {
+            for (int b = 0; b < 4; ++b) {
+                if (a == b) continue;
+                const int gen = ++s.generation;
+                s.queue.clear();
+                for (int i = off[v]; i < off[v + 1]; ++i) {
+                    int u = nbr[i];
+                    if (colors[u] == a && s.stamp[u] != gen) {
+                        s.stamp[u] = gen;
+                        s.queue.push_back(u);
+                    }
+                }
+                for (size_t head = 0; head < s.queue.size(); ++head) {
+                    int w = s.queue[head];
+                    for (int i = off[w]; i < off[w + 1]; ++i) {
+                        int x = nbr[i];
+                        if (s.stamp[x] != gen && (colors[x] == a || colors[x] == b)) {
+                            s.stamp[x] = gen;
+                            s.queue.push_back(x);
+                        }
+                    }
+                }
+                if (probe) probe->nodes += static_cast<int64_t>(s.queue.size());
+                bool blocked = false;
+                for (int i = off[v]; i < off[v + 1] && !blocked; ++i) {
+                    blocked = colors[nbr[i]] == b && s.stamp[nbr[i]] == gen;
+                }
+                if (blocked) continue;
+                for (int w : s.queue) colors[w] = static_cast<int8_t>(colors[w] == a ? b : a);
+                colors[v] = static_cast<int8_t>(a);
+                return true;
+            }
+        }
+        return false;
+        };
+
+    auto assign = [&](int v) {
+        int count[4] = { 0, 0, 0, 0 };
+        for (int i = off[v]; i < off[v + 1]; ++i) {
+            if (colors[nbr[i]] >= 0) count[colors[nbr[i]]]++;
+        }
+        int best = 0;
+        for (int c = 1; c < 4; ++c) if (count[c] < count[best]) best = c;
+        if (count[best] == 0) {
+            for (int c = 0; c < 4; ++c) if (count[c] == 0) { best = c; break; }
+            colors[v] = static_cast<int8_t>(best);
+        }
+        else if (!kempeRecolor(v)) {
+            colors[v] = static_cast<int8_t>(best);
+        }
+        };
+    for (size_t k = s.order.size(); k-- > 0;) {
+        if (probe && !probe->expand()) break;
+        assign(s.order[k]);
+    }
+
+    // 修补：冲突顶点先取消着色再重新分配，后续的 Kempe 交换可能已为它腾出颜色
+    int conflicts = 0;
+    for (int round = 0; round < 4; ++round) {
+        conflicts = 0;
+        bool repaired = false;
+        for (int v = 1; v < n; ++v) {
+            if (colors[v] < 0) continue;
+            bool clash = false;
+            for (int i = off[v]; i < off[v + 1] && !clash; ++i) clash = colors[nbr[i]] == colors[v];
+            if (!clash) continue;
+            if (probe && !repaired) probe->restarts++;
+            repaired = true;
+            colors[v] = -1;
+            assign(v);
+            for (int i = off[v]; i < off[v + 1]; ++i) {
+                if (colors[nbr[i]] == colors[v]) conflicts++;
+            }
+        }
+        if (conflicts == 0) break;
+    }
+    conflicts = 0;
+    for (int v = 1; v < n; ++v) {
+        for (int i = off[v]; i < off[v + 1]; ++i) {
+            if (nbr[i] > v && colors[nbr[i]] == colors[v]) conflicts++;
+        }
+    }
+    return conflicts;
+}
+
+
+// ====================================================
+// ✅ 标签图逐像素内核
+//     按标签类型（int / uint16_t）编译期特化，由 SegmentationContext 按 markers 深度分派。
+//     K 受 main.cpp 限制在 10000 以内，自动选择时总是走 16 位路径，每遍少搬一半字节。
+// ====================================================
+int selectLabelDepth(int maxLabel, LabelStorage storage) {
+    if (storage == LABEL_STORAGE_32S || maxLabel > LABEL16_MAX_LABEL) return CV_32S;
+    return CV_16U;
+}
+
+// 非正值（边界 -1 与未分配 0）在 16 位图中统一存为 0
+template <typename In, typename Out>
+static void copyLabels(const cv::Mat& in, cv::Mat& out) {
+    for (int y = 0; y < in.rows; ++y) {
+        const In* src = in.ptr<In>(y);
+        Out* dst = out.ptr<Out>(y);
+        for (int x = 0; x < in.cols; ++x) dst[x] = static_cast<Out>(std::is_signed<Out>::value || src[x] > 0 ? src[x] : 0);
+    }
+}
+
+// ====================================================
+// ✅ 分水岭边界像素修复（computeMarkersFromRelief、flood、流式与金字塔淹没共用）
+//     值 <= 0 的像素（分水岭线 -1 与未分配 0）取 8 邻域正标签的众数，并列取小标签。
+//     投票固定读 8 个邻居，两两比较计数、条件选择取最优，全在寄存器里完成，不建表。
+//     所有像素只读修复前的标签图（双缓冲：异址时直接写 out，原地时先记下各条带的改写再统一写回），
+//     结果与扫描顺序、线程数无关，各行条带并行；
+//     8 邻域内没有正标签的像素（分水岭线交汇处的粗块）在上一轮结果上按同一规则迭代，直到不再变化。
+// ====================================================
+static inline int majorityLabel(const int (&n)[8]) {
+    int best = 0, bestCount = 0;
+    for (int i = 0; i < 8; ++i) {
+        int count = 0;
+        for (int j = 0; j < 8; ++j) count += n[j] == n[i];
+        count = n[i] > 0 ? count : 0;
+        const bool better = count > bestCount || (count == bestCount && count > 0 && n[i] < best);
+        best = better ? n[i] : best;
+        bestCount = better ? count : bestCount;
+    }
+    return best;
+}
+
+template <typename L>
+static inline void gatherNeighbors(const L* above, const L* row, const L* below, int x, int cols, int (&n)[8]) {
+    const bool left = x > 0, right = x + 1 < cols;
+    n[0] = above && left ? static_cast<int>(above[x - 1]) : 0;
+    n[1] = above ? static_cast<int>(above[x]) : 0;
+    n[2] = above && right ? static_cast<int>(above[x + 1]) : 0;
+    n[3] = left ? static_cast<int>(row[x - 1]) : 0;
+    n[4] = right ? static_cast<int>(row[x + 1]) : 0;
+    n[5] = below && left ? static_cast<int>(below[x - 1]) : 0;
+    n[6] = below ? static_cast<int>(below[x]) : 0;
+    n[7] = below && right ? static_cast<int>(below[x + 1]) : 0;
+}
+
+template <typename Out>
+static void resolveBoundaryKernel(const cv::Mat& in, cv::Mat& out, int threads) {
+    const int rows = in.rows, cols = in.cols;
+    const bool inPlace = in.data == out.data;
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    const int stripes = std::max(1, std::min(std::max(threads, 1), rows / 64));   // 每条至少 64 行
+    std::vector<std::vector<std::pair<int, int>>> pending(stripes);
+    std::vector<std::vector<int>> unresolved(stripes);
+
+    forEachStripe(stripes, [&](int i) {
+        const int y0 = static_cast<int>(static_cast<int64_t>(rows) * i / stripes);
+        const int y1 = static_cast<int>(static_cast<int64_t>(rows) * (i + 1) / stripes);
+        for (int y = y0; y < y1; ++y) {
+            const int* src = in.ptr<int>(y);
+            const int* above = y > 0 ? in.ptr<int>(y - 1) : nullptr;
+            const int* below = y + 1 < rows ? in.ptr<int>(y + 1) : nullptr;
+            Out* dst = out.ptr<Out>(y);
+            for (int x = 0; x < cols; ++x) {
+                const int v = src[x];
+                if (v > 0) {
+                    if (!inPlace) dst[x] = static_cast<Out>(v);
+                    continue;
+                }
+                int n[8];
+                gatherNeighbors(above, src, below, x, cols, n);
+                int label = majorityLabel(n);
+                if (label == 0) {
+                    unresolved[i].push_back(y * cols + x);
+                    label = std::is_signed<Out>::value ? v : 0;
+                    if (inPlace) continue;
+                }
+                if (inPlace) pending[i].emplace_back(y * cols + x, label);
+                else dst[x] = static_cast<Out>(label);
+            }
+        }
+    });
+    for (const auto& list : pending) {
+        for (const auto& [p, label] : list) out.ptr<Out>(p / cols)[p % cols] = static_cast<Out>(label);
+    }
+
+    // 粗块：每轮只读上一轮的结果，全部算完再写回
+    std::vector<int> left;
+    for (const auto& list : unresolved) left.insert(left.end(), list.begin(), list.end());
+    std::vector<std::pair<int, int>> updates;
+    while (!left.empty()) {
+        updates.clear();
+        size_t keep = 0;
+        for (int p : left) {
+            const int y = p / cols, x = p % cols;
+            int n[8];
+            gatherNeighbors(y > 0 ? out.ptr<Out>(y - 1) : nullptr, out.ptr<Out>(y), y + 1 < rows ? out.ptr<Out>(y + 1) : nullptr, x, cols, n);
+            const int label = majorityLabel(n);
+            if (label > 0) updates.emplace_back(p, label);
+            else left[keep++] = p;
+        }
+        if (updates.empty()) break;
+        for (const auto& [p, label] : updates) out.ptr<Out>(p / cols)[p % cols] = static_cast<Out>(label);
+        left.resize(keep);
+    }
+}
+
+void resolveBoundaryLabels(const cv::Mat& in, cv::Mat& out, int depth, int threads) {
+    if (depth == CV_16U) {
+        out.create(in.size(), CV_16U);
+        resolveBoundaryKernel<uint16_t>(in, out, threads);
+        return;
+    }
+    out.create(in.size(), CV_32S);
+    resolveBoundaryKernel<int>(in, out, threads);
+}
+
+// 调色板与 visualizeFourColoring 相同；未着色或越界的标签为黑色
+void buildColoringLut(const std::vector<int8_t>& colors, std::vector<uint32_t>& lut) {
+    // 低 3 字节依次为 B、G、R，最高位为写入标记
+    static const uint32_t palette[4] = { 0xFF0000FFu, 0xFF00FF00u, 0xFFFF0000u, 0xFF00FFFFu };
+    lut.resize(std::max<size_t>(colors.size(), 1));
+    lut[0] = 0xFF000000u;
+    for (size_t l = 1; l < colors.size(); ++l) lut[l] = colors[l] >= 0 ? palette[colors[l]] : 0xFF000000u;
+}
+
+void repairWatershedBoundaries(cv::Mat& markers) {
+    resolveBoundaryLabels(markers, markers, CV_32S);
+}
+
+void renderLabelColors(const cv::Mat& labels, const std::vector<int8_t>& colors, cv::Mat& out) {
+    std::vector<uint32_t> lut;
+    buildColoringLut(colors, lut);
+    out.create(labels.size(), CV_8UC3);
+    labelKernels().renderLut(labels, lut, out);
+}
+
+
+// ====================================================
+// ✅ 分割上下文
+// ====================================================
+
+void* SegmentationContext::OverflowResource::do_allocate(size_t bytes, size_t align) {
+    overflowBytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+}
+
+void SegmentationContext::OverflowResource::do_deallocate(void* p, size_t bytes, size_t align) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+}
+
+SegmentationContext::SegmentationContext() {
+    kernel_ = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(RELIEF_CLOSE_KERNEL, RELIEF_CLOSE_KERNEL));
+    beginFrame();
+}
+
+// 回收内存池；上一帧溢出到上游时按峰值扩容，之后的帧只用自有缓冲
+void SegmentationContext::beginFrame() {
+    if (!arena_ || arenaUpstream_.overflowBytes > 0) {
+        size_t want = std::max<size_t>(64 * 1024, 2 * (arenaStorage_.size() + arenaUpstream_.overflowBytes));
+        arena_.reset();
+        if (want > arenaStorage_.size()) arenaStorage_.resize(want);
+    }
+    arena_.emplace(arenaStorage_.data(), arenaStorage_.size(), &arenaUpstream_);
+    arenaUpstream_.overflowBytes = 0;
+}
+
+// 与 computeWatershedRelief 相同的处理链，中间结果全部写入成员缓冲
+const cv::Mat& SegmentationContext::computeRelief(const cv::Mat& src) {
+    cv::cvtColor(src, gray_, cv::COLOR_BGR2GRAY);
+    cv::equalizeHist(gray_, gray_);
+    cv::Canny(gray_, edges_, RELIEF_CANNY_LOW, RELIEF_CANNY_HIGH);
+    cv::bitwise_not(edges_, invEdges_);
+    cv::distanceTransform(invEdges_, dist_, cv::DIST_L2, 3);
+    cv::normalize(dist_, dist_, 0, 1.0, cv::NORM_MINMAX);
+    cv::morphologyEx(edges_, morph_, cv::MORPH_CLOSE, kernel_);
+    dist_.convertTo(dist8U_, CV_8U, 255.0);
+    cv::addWeighted(dist8U_, RELIEF_DISTANCE_WEIGHT, morph_, 1.0 - RELIEF_DISTANCE_WEIGHT, 0, combined_);
+    cv::cvtColor(combined_, relief_, cv::COLOR_GRAY2BGR);
+    return relief_;
+}
+
+// watershed 只接受 CV_32S：总在 floodMarkers_ 上淹没，修复时按选定位宽写入 markers_
+const cv::Mat& SegmentationContext::flood(const std::vector<cv::Point>& seeds) {
+    detachCachedMarkers();
+    const int depth = selectLabelDepth(static_cast<int>(seeds.size()), labelStorage_);
+    floodMarkers_.create(relief_.size(), CV_32S);
+    floodMarkers_.setTo(cv::Scalar(0));
+    int radius = std::max(3, static_cast<int>(std::sqrt((relief_.cols * relief_.rows) / (float)seeds.size()) * 0.001));
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        cv::circle(floodMarkers_, seeds[i], radius, cv::Scalar(static_cast<double>(i + 1)), -1);
+    }
+    cv::watershed(relief_, floodMarkers_);
+    // 淹没结果与修复结果分属两块缓冲，修复与（16 位时）收窄合为一遍
+    resolveBoundaryLabels(floodMarkers_, markers_, depth, threads_);
+    scanMaxLabel();
+    return markers_;
+}
+
+void SegmentationContext::setMarkers(const cv::Mat& markers) {
+    detachCachedMarkers();
+    const int inputMax = labelKernels().maxLabel(markers);
+    const int depth = selectLabelDepth(inputMax, labelStorage_);
+    markers_.create(markers.size(), depth);
+    if (markers.depth() == CV_16U) {
+        if (depth == CV_16U) copyLabels<uint16_t, uint16_t>(markers, markers_);
+        else copyLabels<uint16_t, int>(markers, markers_);
+    }
+    else {
+        if (depth == CV_16U) copyLabels<int, uint16_t>(markers, markers_);
+        else copyLabels<int, int>(markers, markers_);
+    }
+    maxLabel_ = std::max(inputMax, 0);
+}
+
+// 缓存命中：标签图不复制，直接引用映射内存；统计量与 CSR 只与区域数成正比，复制进成员缓冲
+void SegmentationContext::attachCached(const CachedSegmentation& entry) {
+    markers_ = entry.labels();
+    markersMapped_ = true;
+    maxLabel_ = entry.maxLabel();
+    entry.adjacency(graph_);
+    areas_.assign(entry.areas(), entry.areas() + maxLabel_ + 1);
+    sumX_.assign(entry.sumX(), entry.sumX() + maxLabel_ + 1);
+    sumY_.assign(entry.sumY(), entry.sumY() + maxLabel_ + 1);
+}
+
+// 层次分水岭的一层：标签图引用 level.labels，邻接图与统计量复制（规模与区域数成正比）
+void SegmentationContext::attachLevel(const HierarchyLevel& level) {
+    markers_ = level.labels;
+    markersMapped_ = true;
+    maxLabel_ = level.regionCount;
+    graph_ = level.graph;
+    areas_ = level.areas;
+    sumX_ = level.sumX;
+    sumY_ = level.sumY;
+}
+
+// 外部标签图（映射内存或层级提取结果）不可改写，重新写入 markers_ 前换回自有缓冲
+void SegmentationContext::detachCachedMarkers() {
+    if (!markersMapped_) return;
+    markers_.release();
+    markersMapped_ = false;
+}
+
+void SegmentationContext::scanMaxLabel() {
+    maxLabel_ = labelKernels().maxLabel(markers_);
+}
+
+// 与 applyWatershedWithColor 相同：在原图上再做一次分水岭，RNG(12345) 按标签升序取色，边界为黑色；
+// 区别是在 32 位副本上进行，不修改 markers
+void SegmentationContext::renderWatershed(const cv::Mat& src, cv::Mat& out) {
+    watershedMarkers_.create(markers_.size(), CV_32S);
+    if (markers_.depth() == CV_16U) copyLabels<uint16_t, int>(markers_, watershedMarkers_);
+    else copyLabels<int, int>(markers_, watershedMarkers_);
+    cv::watershed(src, watershedMarkers_);
+
+    labelSeen_.assign(maxLabel_ + 2, 0);   // 下标 0 对应标签 -1
+    for (int y = 0; y < watershedMarkers_.rows; ++y) {
+        const int* row = watershedMarkers_.ptr<int>(y);
+        for (int x = 0; x < watershedMarkers_.cols; ++x) {
+            int l = row[x];
+            if (l >= -1 && l <= maxLabel_) labelSeen_[l + 1] = 1;
+        }
+    }
+    labelPalette_.assign(maxLabel_ + 2, cv::Vec3b(0, 0, 0));
+    cv::RNG rng(12345);
+    for (int l = 0; l <= maxLabel_; ++l) {
+        if (labelSeen_[l + 1]) {
+            labelPalette_[l + 1] = cv::Vec3b(rng.uniform(50, 255), rng.uniform(50, 255), rng.uniform(50, 255));
+        }
+    }
+
+    watershedColor_.create(watershedMarkers_.size(), CV_8UC3);
+    for (int y = 0; y < watershedMarkers_.rows; ++y) {
+        const int* row = watershedMarkers_.ptr<int>(y);
+        cv::Vec3b* dst = watershedColor_.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < watershedMarkers_.cols; ++x) {
+            int l = row[x];
+            dst[x] = l >= -1 && l <= maxLabel_ ? labelPalette_[l + 1] : cv::Vec3b(0, 0, 0);
+        }
+    }
+    cv::addWeighted(src, 0.5, watershedColor_, 0.5, 0, out);
+}
+
+const RegionAdjacencyCSR& SegmentationContext::buildAdjacency() {
+    buildRegionAdjacencyCSR(markers_, graph_, edgeScratch_);
+    return graph_;
+}
+
+int SegmentationContext::colorRegions() {
+    const int conflicts = fourColorCSR(graph_, colors_, coloringScratch_);
+    buildColoringLut(colors_, colorLut_);
+    return conflicts;
+}
+
+// 平面性测试与着色共用 buildAdjacency 得到的 CSR；非平面时可选提取 Kuratowski 子图
+bool SegmentationContext::checkPlanarity(std::vector<std::pair<int, int>>* kuratowski) {
+    if (isPlanarCSR(graph_, planarityScratch_)) return true;
+    if (kuratowski) findKuratowskiSubgraph(graph_, *kuratowski, planarityScratch_);
+    return false;
+}
+
+// 映射的标签图先复制成自有缓冲再改写；标签可能增加，maxLabel 随之更新
+void SegmentationContext::resolveFragments(FragmentPolicy policy, int minFragmentArea, FragmentReport& report) {
+    if (policy != FRAGMENTS_REPORT && markersMapped_) {
+        markers_ = markers_.clone();
+        markersMapped_ = false;
+    }
+    resolveLabelFragments(markers_, policy, minFragmentArea, report, componentScratch_);
+    if (policy != FRAGMENTS_REPORT && report.fragmentedLabels > 0) scanMaxLabel();
+}
+
+// 调色板与 visualizeFourColoring 相同，查找表在 colorRegions 时建好
+void SegmentationContext::renderColoring(cv::Mat& out) const {
+    out.create(markers_.size(), CV_8UC3);
+    labelKernels().renderLut(markers_, colorLut_, out);
+}
+
+void SegmentationContext::computeRegionStats() {
+    areas_.assign(maxLabel_ + 1, 0);
+    sumX_.assign(maxLabel_ + 1, 0);
+    sumY_.assign(maxLabel_ + 1, 0);
+    labelKernels().regionStats(markers_, areas_.data(), sumX_.data(), sumY_.data());
+}
+
+// 面积升序排序后二分出 [low, high] 区间，与 binarySearchInRange 相同
+void SegmentationContext::selectAreaRange(int low, int high) {
+    sortedAreas_.clear();
+    for (int l = 1; l <= maxLabel_; ++l) {
+        if (areas_[l] > 0) sortedAreas_.push_back({ l, areas_[l] });
+    }
+    std::sort(sortedAreas_.begin(), sortedAreas_.end(), [](const AreaEntry& a, const AreaEntry& b) {
+        return a.area != b.area ? a.area < b.area : a.label < b.label;
+        });
+    auto lower = std::lower_bound(sortedAreas_.begin(), sortedAreas_.end(), low,
+        [](const AreaEntry& a, int value) { return a.area < value; });
+    auto upper = std::upper_bound(sortedAreas_.begin(), sortedAreas_.end(), high,
+        [](int value, const AreaEntry& a) { return value < a.area; });
+    selBegin_ = lower - sortedAreas_.begin();
+    selEnd_ = std::max(lower, upper) - sortedAreas_.begin();
+
+    // 高亮查找表：选中的标签按散列取色，其余表项为 0（不写入）
+    highlightLut_.assign(maxLabel_ + 1, 0);
+    for (size_t i = selBegin_; i < selEnd_; ++i) {
+        const int l = sortedAreas_[i].label;
+        const uint32_t h = static_cast<uint32_t>(l) * 2654435761u;
+        highlightLut_[l] = 0xFF000000u | (50 + (h >> 24) % 206) << 16 | (50 + (h >> 16) % 206) << 8 | (50 + (h >> 8) % 206);
+    }
+}
+
+// 叶子已按面积升序排列，双队列合并即可，无需优先队列
+HuffmanNode* SegmentationContext::buildHuffmanTree() {
+    if (selBegin_ == selEnd_) return nullptr;
+    std::pmr::polymorphic_allocator<HuffmanNode> alloc(&*arena_);
+    auto makeNode = [&](int weight, int label) {
+        HuffmanNode* node = alloc.allocate(1);
+        return new (node) HuffmanNode(weight, label);
+        };
+
+    huffmanQueue_.clear();
+    size_t leaf = selBegin_, head = 0;
+    auto popSmallest = [&]() {
+        if (head >= huffmanQueue_.size() ||
+            (leaf < selEnd_ && sortedAreas_[leaf].area <= huffmanQueue_[head]->weight)) {
+            const AreaEntry& e = sortedAreas_[leaf++];
+            return makeNode(e.area, e.label);
+        }
+        return huffmanQueue_[head++];
+        };
+
+    size_t remaining = selEnd_ - selBegin_;
+    if (remaining == 1) return popSmallest();
+    while (remaining > 1) {
+        HuffmanNode* left = popSmallest();
+        HuffmanNode* right = popSmallest();
+        HuffmanNode* parent = makeNode(left->weight + right->weight, -1);
+        parent->left = left;
+        parent->right = right;
+        huffmanQueue_.push_back(parent);
+        remaining--;
+    }
+    return huffmanQueue_.back();
+}
+
+// 选中区域按标签散列取色（同一标签跨帧颜色稳定），annotate 时在质心处标注面积
+void SegmentationContext::renderHighlight(const cv::Mat& src, cv::Mat& out, bool annotate) const {
+    src.copyTo(out);
+    labelKernels().renderLut(markers_, highlightLut_, out);
+    if (!annotate) return;
+    for (size_t i = selBegin_; i < selEnd_; ++i) {
+        const AreaEntry& e = sortedAreas_[i];
+        char text[16];
+        std::snprintf(text, sizeof(text), "%d", e.area);
+        cv::Point center(static_cast<int>(sumX_[e.label] / e.area), static_cast<int>(sumY_[e.label] / e.area));
+        cv::putText(out, text, center, cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 2);
+    }
+}
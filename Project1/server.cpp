@@ -0,0 +1,801 @@
+﻿#ifdef _WIN32
+// winsock2.h 须在 utils.h（using namespace std）之前包含，否则 byte 等名字会冲突
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "utils.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <sstream>
+
+// ====================================================
+// ✅ 常驻分割服务
+//     客户端经 Unix 域套接字按行发送请求，结果写入客户端指定的共享内存文件，套接字上只回一行摘要：
+//       SEGMENT file <图像路径> <K> <面积下限> <面积上限> <结果文件> [种子]
+//       SEGMENT shm <BGR 原始数据文件> <宽> <高> <K> <面积下限> <面积上限> <结果文件> [种子]
+//       STATS / SHUTDOWN
+//     回复 "OK ..." 或 "ERR <原因>"；OK 行末尾是本批生成种子点所用的随机种子，带上它重发可复现结果。
+//     不带种子的请求由服务自有的 TaskEnv（--serve 可指定初始种子）逐批抽取。路径中不能含空白；结果文件与共享内存图像必须位于服务的共享内存目录
+//     （/dev/shm，没有时为临时目录）下，否则拒绝。
+//     每个工作线程持有一个常驻的 SegmentationContext；同一图像与 K 的排队请求合并成一批，
+//     只做一次地形图与淹没，各请求仅面积区间与哈夫曼码不同。
+// ====================================================
+
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+static const SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+static void closeSocket(SocketHandle s) { closesocket(s); }
+static int lastSocketError() { return WSAGetLastError(); }
+// 监听套接字本身失效，重试没有意义
+static bool acceptErrorIsFatal(int err) { return err == WSAENOTSOCK || err == WSAEINVAL || err == WSAEBADF; }
+#else
+typedef int SocketHandle;
+static const SocketHandle INVALID_SOCKET_HANDLE = -1;
+static void closeSocket(SocketHandle s) { ::close(s); }
+static int lastSocketError() { return errno; }
+static bool acceptErrorIsFatal(int err) { return err == EBADF || err == EINVAL || err == ENOTSOCK; }
+#endif
+
+static bool initSockets() {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    signal(SIGPIPE, SIG_IGN);   // 对端断开时 send 返回错误而不是终止进程
+    return true;
+#endif
+}
+
+static bool unixAddress(const std::string& path, sockaddr_un& addr) {
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+static SocketHandle listenUnix(const std::string& path) {
+    sockaddr_un addr;
+    if (!unixAddress(path, addr)) return INVALID_SOCKET_HANDLE;
+    SocketHandle s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET_HANDLE) return s;
+    std::remove(path.c_str());   // 上次异常退出残留的套接字文件
+    if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(s, 64) != 0) {
+        closeSocket(s);
+        return INVALID_SOCKET_HANDLE;
+    }
+    return s;
+}
+
+static SocketHandle connectUnix(const std::string& path) {
+    sockaddr_un addr;
+    if (!unixAddress(path, addr)) return INVALID_SOCKET_HANDLE;
+    SocketHandle s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET_HANDLE) return s;
+    if (connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        closeSocket(s);
+        return INVALID_SOCKET_HANDLE;
+    }
+    return s;
+}
+
+static bool sendAll(SocketHandle s, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = send(s, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+// 读一行（不含换行符）；buffer 保存上次多读的部分
+static bool recvLine(SocketHandle s, std::string& buffer, std::string& line) {
+    while (true) {
+        size_t pos = buffer.find('\n');
+        if (pos != std::string::npos) {
+            line = buffer.substr(0, pos);
+            buffer.erase(0, pos + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return true;
+        }
+        char chunk[4096];
+        int n = recv(s, chunk, static_cast<int>(sizeof(chunk)), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, n);
+    }
+}
+
+static std::string sharedMemoryDirectory() {
+    std::error_code ec;
+    if (std::filesystem::is_directory("/dev/shm", ec)) return "/dev/shm";
+    return std::filesystem::temp_directory_path(ec).string();
+}
+
+
+// ---------- 结果文件 ----------
+// "SEGR" | 版本 u32 | rows, cols, labelBytes, maxLabel, conflicts, codeCount（均为 int32）
+// | 标签图（按行） | colors int8 × (maxLabel + 1) | areas int32 × (maxLabel + 1)
+// | 哈夫曼码 {label int32, bits u32, length u32} × codeCount，各段 8 字节对齐
+const uint32_t SEGMENT_RESPONSE_VERSION = 1;
+
+struct SegmentResponseHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t rows, cols, labelBytes, maxLabel, conflicts, codeCount;
+};
+
+struct SegmentResponseLayout {
+    uint64_t labels, colors, areas, codes, total;
+};
+
+static SegmentResponseLayout responseLayout(const SegmentResponseHeader& h) {
+    const uint64_t labels = static_cast<uint64_t>(h.maxLabel) + 1;
+    SegmentResponseLayout l;
+    l.labels = align8(sizeof(SegmentResponseHeader));
+    l.colors = align8(l.labels + static_cast<uint64_t>(h.rows) * h.cols * h.labelBytes);
+    l.areas = align8(l.colors + labels);
+    l.codes = align8(l.areas + labels * 4);
+    l.total = l.codes + static_cast<uint64_t>(h.codeCount) * 12;
+    return l;
+}
+
+static bool writeSegmentResponse(const std::string& path, const SegmentationContext& ctx, int conflicts,
+    const CanonicalHuffmanTable& table) {
+    const cv::Mat& markers = ctx.markers();
+    const std::vector<int>& areas = ctx.areas();
+    const std::vector<int8_t>& colors = ctx.colors();
+    SegmentResponseHeader h;
+    std::memcpy(h.magic, "SEGR", 4);
+    h.version = SEGMENT_RESPONSE_VERSION;
+    h.rows = markers.rows;
+    h.cols = markers.cols;
+    h.labelBytes = static_cast<int32_t>(markers.elemSize());
+    h.maxLabel = static_cast<int32_t>(areas.size()) - 1;
+    h.conflicts = conflicts;
+    h.codeCount = static_cast<int32_t>(table.labels.size());
+    const SegmentResponseLayout l = responseLayout(h);
+
+    MappedFile file;
+    uint8_t* base = file.open(path, l.total, true) ? file.map(0, static_cast<size_t>(l.total)) : nullptr;
+    if (!base) return false;
+    std::memset(base, 0, static_cast<size_t>(l.total));
+    std::memcpy(base, &h, sizeof(h));
+    const size_t rowBytes = markers.cols * markers.elemSize();
+    for (int y = 0; y < markers.rows; ++y) std::memcpy(base + l.labels + y * rowBytes, markers.ptr(y), rowBytes);
+    int8_t* colorOut = reinterpret_cast<int8_t*>(base + l.colors);
+    for (int32_t label = 0; label <= h.maxLabel; ++label) {
+        colorOut[label] = label < static_cast<int32_t>(colors.size()) ? colors[label] : -1;
+    }
+    std::memcpy(base + l.areas, areas.data(), areas.size() * 4);
+    uint32_t* codeOut = reinterpret_cast<uint32_t*>(base + l.codes);
+    for (size_t i = 0; i < table.labels.size(); ++i) {
+        codeOut[3 * i] = static_cast<uint32_t>(table.labels[i]);
+        codeOut[3 * i + 1] = table.codes[i].bits;
+        codeOut[3 * i + 2] = table.codes[i].len;
+    }
+    file.close();
+    return true;
+}
+
+
+// ---------- 服务端 ----------
+
+struct ServeRequest {
+    bool shared = false;
+    std::string imagePath, responsePath;
+    int width = 0, height = 0;
+    int K = 0, low = 0, high = 0;
+    bool hasSeed = false;
+    uint32_t seed = 0;
+    std::string batchKey;   // 图像（共享内存另含宽高）+ K + 种子，相同者合并处理
+    std::promise<std::string> reply;
+};
+
+// 按规范化路径（先解析符号链接）比较父目录：服务会创建并截断结果文件，
+// 不限制的话任何能连上套接字的客户端都能改写服务进程可写的任意文件
+static bool insideDirectory(const std::string& path, const std::filesystem::path& dir) {
+    std::error_code ec;
+    const std::filesystem::path resolved = std::filesystem::weakly_canonical(path, ec);
+    return !ec && resolved.has_filename() && resolved.parent_path() == dir;
+}
+
+static bool parseServeRequest(const std::string& line, const std::filesystem::path& shmDir, ServeRequest& req,
+    std::string& error) {
+    std::istringstream in(line);
+    std::string command, source;
+    in >> command >> source;
+    if (source == "file") {
+        in >> req.imagePath;
+    }
+    else if (source == "shm") {
+        req.shared = true;
+        in >> req.imagePath >> req.width >> req.height;
+    }
+    else {
+        error = "未知的图像来源 " + source;
+        return false;
+    }
+    in >> req.K >> req.low >> req.high >> req.responsePath;
+    if (!in || req.responsePath.empty()) {
+        error = "请求格式错误";
+        return false;
+    }
+    unsigned long long seed = 0;
+    if (in >> seed) {
+        if (seed > UINT32_MAX) {
+            error = "种子超出 32 位范围";
+            return false;
+        }
+        req.hasSeed = true;
+        req.seed = static_cast<uint32_t>(seed);
+    }
+    else if (!in.eof()) {
+        error = "请求格式错误";
+        return false;
+    }
+    if (req.K < 2 || req.K > 10000 || req.low < 0 || req.high < req.low ||
+        (req.shared && (req.width <= 0 || req.height <= 0))) {
+        error = "参数非法";
+        return false;
+    }
+    if (!insideDirectory(req.responsePath, shmDir) || (req.shared && !insideDirectory(req.imagePath, shmDir))) {
+        error = "结果文件与共享内存图像须位于 " + shmDir.string() + " 下";
+        return false;
+    }
+    req.batchKey = source + ":" + req.imagePath + ":" + std::to_string(req.K);
+    // 共享内存按请求给出的尺寸映射，同一路径尺寸不同的请求不能合并
+    if (req.shared) req.batchKey += ":" + std::to_string(req.width) + "x" + std::to_string(req.height);
+    // 未指定种子的请求可以合并，共用服务为该批抽取的种子
+    req.batchKey += req.hasSeed ? ":" + std::to_string(req.seed) : ":auto";
+    return true;
+}
+
+class SegmentationServer {
+public:
+    SegmentationServer(int workerCount, int maxBatch, uint32_t seed)
+        : workerCount_(std::max(workerCount, 1)), maxBatch_(std::max(maxBatch, 1)), env_(seed) {}
+    ~SegmentationServer();
+    bool start(const std::string& socketPath);
+    void wait();
+
+private:
+    // 工作线程常驻状态：上下文缓冲跨请求复用，同一图像内容不重复计算地形图
+    struct Worker {
+        SegmentationContext ctx;
+        uint64_t reliefImage = 0;
+        bool hasRelief = false;
+    };
+    // 解码后的图像（按路径、修改时间与大小识别），所有工作线程共享
+    struct DecodedImage {
+        std::filesystem::file_time_type time;
+        uintmax_t size = 0;
+        cv::Mat image;
+        uint64_t hash = 0;
+        uint64_t lastUse = 0;
+    };
+
+    void acceptLoop();
+    void connectionLoop(SocketHandle s);
+    void workerLoop(int index);
+    bool popBatch(std::vector<std::shared_ptr<ServeRequest>>& batch);
+    bool loadImage(const ServeRequest& req, MappedFile& shared, cv::Mat& image, uint64_t& hash, std::string& error);
+    void processBatch(Worker& worker, std::vector<std::shared_ptr<ServeRequest>>& batch);
+    void segmentBatch(Worker& worker, std::vector<std::shared_ptr<ServeRequest>>& batch, size_t& answered,
+        const std::function<void(const std::string&)>& fail);
+    std::string statsLine();
+    void requestStop();
+
+    int workerCount_, maxBatch_;
+    std::string socketPath_;
+    std::filesystem::path shmDir_;   // 规范化后的共享内存目录，结果文件只能写在这里
+    SocketHandle listener_ = INVALID_SOCKET_HANDLE;
+    std::thread acceptThread_;
+    std::vector<std::thread> workerThreads_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueReady_, stopped_;
+    std::deque<std::shared_ptr<ServeRequest>> queue_;
+    bool stopping_ = false;
+
+    // 连接线程结束前把自己的 id 记入 finishedConnections_，acceptLoop 每接受一个新连接前回收它们，
+    // 常驻进程的线程数只随同时在线的连接数变化
+    std::mutex connectionMutex_;
+    std::vector<SocketHandle> connections_;
+    std::vector<std::thread> connectionThreads_;
+    std::vector<std::thread::id> finishedConnections_;
+
+    // 只用来给未带种子的批次抽种子；工作线程共用，抽取时加锁
+    std::mutex envMutex_;
+    TaskEnv env_;
+
+    std::mutex imageMutex_;
+    std::map<std::string, DecodedImage> images_;
+    uint64_t imageClock_ = 0;
+    static const size_t IMAGE_CACHE_CAPACITY = 8;
+
+    std::atomic<uint64_t> served_{ 0 }, failed_{ 0 }, batches_{ 0 }, reliefReused_{ 0 };
+};
+
+SegmentationServer::~SegmentationServer() {
+    requestStop();
+    if (acceptThread_.joinable()) acceptThread_.join();
+    for (auto& t : workerThreads_) t.join();
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        for (SocketHandle s : connections_) {
+#ifdef _WIN32
+            shutdown(s, SD_BOTH);
+#else
+            shutdown(s, SHUT_RDWR);
+#endif
+        }
+    }
+    for (auto& t : connectionThreads_) t.join();
+    if (listener_ != INVALID_SOCKET_HANDLE) closeSocket(listener_);
+    std::remove(socketPath_.c_str());
+}
+
+bool SegmentationServer::start(const std::string& socketPath) {
+    socketPath_ = socketPath;
+    std::error_code ec;
+    shmDir_ = std::filesystem::canonical(sharedMemoryDirectory(), ec);
+    if (ec) {
+        std::cerr << " 无法确定共享内存目录 " << sharedMemoryDirectory() << std::endl;
+        return false;
+    }
+    listener_ = listenUnix(socketPath);
+    if (listener_ == INVALID_SOCKET_HANDLE) {
+        std::cerr << " 无法监听套接字 " << socketPath << std::endl;
+        return false;
+    }
+    for (int i = 0; i < workerCount_; ++i) workers_.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < workerCount_; ++i) workerThreads_.emplace_back(&SegmentationServer::workerLoop, this, i);
+    acceptThread_ = std::thread(&SegmentationServer::acceptLoop, this);
+    return true;
+}
+
+void SegmentationServer::wait() {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    stopped_.wait(lock, [&] { return stopping_; });
+}
+
+// 置停止标志后自连一次，唤醒阻塞在 accept 上的线程
+void SegmentationServer::requestStop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    queueReady_.notify_all();
+    stopped_.notify_all();
+    if (listener_ == INVALID_SOCKET_HANDLE) return;
+    SocketHandle wake = connectUnix(socketPath_);
+    if (wake != INVALID_SOCKET_HANDLE) closeSocket(wake);
+}
+
+// accept 失败时：监听套接字失效则停止服务；EMFILE / ENFILE 等资源耗尽会让 accept 立即返回，
+// 按 10 ms 起翻倍、最长 1 s 退避后重试，不空转占满一个核。连续失败只在第一次打印
+void SegmentationServer::acceptLoop() {
+    int failures = 0;
+    while (true) {
+        SocketHandle s = accept(listener_, nullptr, nullptr);
+        const int err = s == INVALID_SOCKET_HANDLE ? lastSocketError() : 0;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (stopping_) {
+                if (s != INVALID_SOCKET_HANDLE) closeSocket(s);
+                return;
+            }
+        }
+        if (s == INVALID_SOCKET_HANDLE) {
+            if (acceptErrorIsFatal(err)) {
+                std::cerr << " 监听套接字失效（错误码 " << err << "），服务停止。" << std::endl;
+                requestStop();
+                return;
+            }
+            if (failures == 0) std::cerr << " accept 失败（错误码 " << err << "），退避后重试。" << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(1000, 10 << std::min(failures, 7))));
+            failures++;
+            continue;
+        }
+        if (failures) {
+            std::cerr << " accept 恢复（此前连续失败 " << failures << " 次）。" << std::endl;
+            failures = 0;
+        }
+        std::vector<std::thread> finished;
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex_);
+            for (std::thread::id id : finishedConnections_) {
+                auto it = std::find_if(connectionThreads_.begin(), connectionThreads_.end(),
+                    [&](const std::thread& t) { return t.get_id() == id; });
+                if (it == connectionThreads_.end()) continue;
+                finished.push_back(std::move(*it));
+                connectionThreads_.erase(it);
+            }
+            finishedConnections_.clear();
+            connections_.push_back(s);
+            connectionThreads_.emplace_back(&SegmentationServer::connectionLoop, this, s);
+        }
+        // 这些线程登记后只剩返回，锁外 join 不会久等
+        for (auto& t : finished) t.join();
+    }
+}
+
+// 每个连接按顺序处理：请求入队后等待工作线程回复，再读下一行
+void SegmentationServer::connectionLoop(SocketHandle s) {
+    std::string buffer, line;
+    while (recvLine(s, buffer, line)) {
+        if (line.empty()) continue;
+        std::string reply;
+        if (line == "STATS") {
+            reply = statsLine();
+        }
+        else if (line == "SHUTDOWN") {
+            sendAll(s, "OK\n");
+            requestStop();
+            break;
+        }
+        else if (line.compare(0, 8, "SEGMENT ") == 0) {
+            auto req = std::make_shared<ServeRequest>();
+            std::string error;
+            if (!parseServeRequest(line, shmDir_, *req, error)) {
+                reply = "ERR " + error;
+            }
+            else {
+                std::future<std::string> result = req->reply.get_future();
+                {
+                    std::lock_guard<std::mutex> lock(queueMutex_);
+                    if (stopping_) break;
+                    queue_.push_back(req);
+                }
+                queueReady_.notify_one();
+                reply = result.get();
+            }
+        }
+        else {
+            reply = "ERR 未知命令";
+        }
+        if (!sendAll(s, reply + "\n")) break;
+    }
+    std::lock_guard<std::mutex> lock(connectionMutex_);
+    connections_.erase(std::remove(connections_.begin(), connections_.end(), s), connections_.end());
+    closeSocket(s);
+    finishedConnections_.push_back(std::this_thread::get_id());
+}
+
+// 取队首请求，并把队列中图像与 K 相同的请求一并取出（至多 maxBatch_ 个）
+bool SegmentationServer::popBatch(std::vector<std::shared_ptr<ServeRequest>>& batch) {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    queueReady_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) return false;
+    batch.clear();
+    batch.push_back(queue_.front());
+    queue_.pop_front();
+    for (auto it = queue_.begin(); it != queue_.end() && static_cast<int>(batch.size()) < maxBatch_;) {
+        if ((*it)->batchKey == batch.front()->batchKey) {
+            batch.push_back(*it);
+            it = queue_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+void SegmentationServer::workerLoop(int index) {
+    std::vector<std::shared_ptr<ServeRequest>> batch;
+    while (popBatch(batch)) processBatch(*workers_[index], batch);
+    // 停止后仍在队列中的请求直接拒绝，连接线程不会永远等待
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    for (auto& req : queue_) {
+        failed_++;
+        req->reply.set_value("ERR 服务正在停止");
+    }
+    queue_.clear();
+}
+
+// 共享内存图像直接映射为 cv::Mat（零拷贝）；文件图像解码后按路径缓存
+bool SegmentationServer::loadImage(const ServeRequest& req, MappedFile& shared, cv::Mat& image, uint64_t& hash,
+    std::string& error) {
+    if (req.shared) {
+        const uint64_t bytes = static_cast<uint64_t>(req.width) * req.height * 3;
+        uint8_t* data = shared.open(req.imagePath, 0, false) && shared.size() == bytes ?
+            shared.map(0, static_cast<size_t>(bytes)) : nullptr;
+        if (!data) {
+            error = "无法映射共享图像 " + req.imagePath;
+            return false;
+        }
+        image = cv::Mat(req.height, req.width, CV_8UC3, data);
+        hash = SegmentationCache::imageHash(image);
+        return true;
+    }
+
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(req.imagePath, ec);
+    uintmax_t size = ec ? 0 : std::filesystem::file_size(req.imagePath, ec);
+    if (ec) {
+        error = "无法读取图像文件 " + req.imagePath;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(imageMutex_);
+        auto it = images_.find(req.imagePath);
+        if (it != images_.end() && it->second.time == time && it->second.size == size) {
+            it->second.lastUse = ++imageClock_;
+            image = it->second.image;
+            hash = it->second.hash;
+            return true;
+        }
+    }
+    cv::Mat decoded = cv::imread(req.imagePath);
+    if (decoded.empty()) {
+        error = "无法读取图像文件 " + req.imagePath;
+        return false;
+    }
+    image = decoded;
+    hash = SegmentationCache::imageHash(decoded);
+    std::lock_guard<std::mutex> lock(imageMutex_);
+    if (images_.size() >= IMAGE_CACHE_CAPACITY && !images_.count(req.imagePath)) {
+        auto oldest = std::min_element(images_.begin(), images_.end(),
+            [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+        images_.erase(oldest);
+    }
+    DecodedImage& entry = images_[req.imagePath];
+    entry.time = time;
+    entry.size = size;
+    entry.image = decoded;
+    entry.hash = hash;
+    entry.lastUse = ++imageClock_;
+    return true;
+}
+
+void SegmentationServer::segmentBatch(Worker& worker, std::vector<std::shared_ptr<ServeRequest>>& batch, size_t& answered,
+    const std::function<void(const std::string&)>& fail) {
+    const ServeRequest& first = *batch.front();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    MappedFile shared;
+    cv::Mat image;
+    uint64_t hash = 0;
+    std::string error;
+    if (!loadImage(first, shared, image, hash, error)) {
+        fail(error);
+        return;
+    }
+
+    SegmentationContext& ctx = worker.ctx;
+    ctx.beginFrame();
+    if (!worker.hasRelief || worker.reliefImage != hash) {
+        ctx.computeRelief(image);
+        worker.reliefImage = hash;
+        worker.hasRelief = true;
+    }
+    else {
+        reliefReused_++;
+    }
+    uint32_t seed = first.seed;
+    if (!first.hasSeed) {
+        std::lock_guard<std::mutex> lock(envMutex_);
+        seed = static_cast<uint32_t>(env_.rng());
+    }
+    std::mt19937 rng(seed);
+    ctx.flood(generateSeedPoints(image.size(), first.K, rng));
+    ctx.buildAdjacency();
+    const int conflicts = ctx.colorRegions();
+    ctx.computeRegionStats();
+    const double segmentMs = elapsedMs(start);
+    batches_++;
+    int regions = 0;
+    for (int area : ctx.areas()) regions += area > 0;
+
+    std::map<int, int> selectedAreas;
+    for (; answered < batch.size(); ++answered) {
+        ServeRequest* req = batch[answered].get();
+        ctx.selectAreaRange(req->low, req->high);
+        selectedAreas.clear();
+        for (const AreaEntry* e = ctx.selectedBegin(); e != ctx.selectedEnd(); ++e) selectedAreas[e->label] = e->area;
+        CanonicalHuffmanTable table;
+        if (!buildCanonicalHuffmanTable(selectedAreas, table, 24)) {
+            failed_++;
+            req->reply.set_value("ERR 范式哈夫曼码表构建失败");
+            continue;
+        }
+        if (!writeSegmentResponse(req->responsePath, ctx, conflicts, table)) {
+            failed_++;
+            req->reply.set_value("ERR 无法写入结果文件 " + req->responsePath);
+            continue;
+        }
+        std::ostringstream reply;
+        reply << "OK " << image.rows << " " << image.cols << " " << regions << " " << conflicts << " "
+            << table.labels.size() << " " << segmentMs << " " << batch.size() << " " << seed;
+        served_++;
+        req->reply.set_value(reply.str());
+    }
+}
+
+// OpenCV 或内存分配抛出的异常在这里截住：工作线程继续服务，尚未回复的请求一律以 ERR 回复，
+// 连接线程不会永远等在 future 上
+void SegmentationServer::processBatch(Worker& worker, std::vector<std::shared_ptr<ServeRequest>>& batch) {
+    size_t answered = 0;   // batch 中已回复的前缀
+    auto fail = [&](const std::string& error) {
+        failed_ += batch.size() - answered;
+        for (; answered < batch.size(); ++answered) batch[answered]->reply.set_value("ERR " + error);
+        };
+    try {
+        segmentBatch(worker, batch, answered, fail);
+    }
+    catch (const std::exception& e) {
+        worker.hasRelief = false;   // 上下文可能停在半途，下一批重新计算地形图
+        fail(std::string("处理失败：") + e.what());
+    }
+}
+
+std::string SegmentationServer::statsLine() {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queued = queue_.size();
+    }
+    std::ostringstream out;
+    out << "OK served " << served_ << " failed " << failed_ << " batches " << batches_ << " relief-reused "
+        << reliefReused_ << " queued " << queued << " workers " << workerCount_;
+    return out.str();
+}
+
+// 服务模式：Project1 --serve <套接字路径> [工作线程数] [单批上限] [种子]
+int runServer(int argc, char** argv) {
+    if (argc < 1) {
+        std::cerr << " 用法：--serve <套接字路径> [工作线程数] [单批上限] [种子]" << std::endl;
+        return -1;
+    }
+    int workers = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    int maxBatch = argc > 2 ? std::atoi(argv[2]) : 16;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : std::random_device{}();
+    if (!initSockets()) {
+        std::cerr << " 套接字初始化失败。" << std::endl;
+        return -1;
+    }
+    SegmentationServer server(workers, maxBatch, seed);
+    if (!server.start(argv[0])) return -1;
+    std::cout << " 分割服务已启动：" << argv[0] << "，工作线程 " << std::max(workers, 1) << "，单批上限 "
+        << std::max(maxBatch, 1) << "，种子 " << seed << "（发送 SHUTDOWN 停止）" << std::endl;
+    server.wait();
+    std::cout << " 分割服务已停止。" << std::endl;
+    return 0;
+}
+
+
+// ---------- 压测客户端 ----------
+
+// 校验结果文件：头部、尺寸与回复一致，码表条数与回复一致
+static bool checkSegmentResponse(const std::string& path, int rows, int cols, int codeCount) {
+    MappedFile file;
+    if (!file.open(path, 0, false) || file.size() < sizeof(SegmentResponseHeader)) return false;
+    const uint8_t* base = file.map(0, static_cast<size_t>(file.size()));
+    if (!base) return false;
+    SegmentResponseHeader h;
+    std::memcpy(&h, base, sizeof(h));
+    return std::memcmp(h.magic, "SEGR", 4) == 0 && h.version == SEGMENT_RESPONSE_VERSION && h.rows == rows &&
+        h.cols == cols && h.codeCount == codeCount && responseLayout(h).total == file.size();
+}
+
+// 压测模式：Project1 --loadgen <套接字路径> <图像路径> [K] [并发数] [请求数] [面积下限] [面积上限] [file|shm]
+int runLoadGenerator(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << " 用法：--loadgen <套接字路径> <图像路径> [K] [并发数] [请求数] [面积下限] [面积上限] [file|shm]" << std::endl;
+        return -1;
+    }
+    const std::string socketPath = argv[0], imagePath = argv[1];
+    const int K = argc > 2 ? std::atoi(argv[2]) : 200;
+    const int concurrency = std::max(1, argc > 3 ? std::atoi(argv[3]) : 4);
+    const int total = std::max(1, argc > 4 ? std::atoi(argv[4]) : 200);
+    const int low = argc > 5 ? std::atoi(argv[5]) : 0;
+    const int high = argc > 6 ? std::atoi(argv[6]) : INT_MAX;
+    const bool shared = argc > 7 && std::string(argv[7]) == "shm";
+    if (!initSockets()) {
+        std::cerr << " 套接字初始化失败。" << std::endl;
+        return -1;
+    }
+
+    // shm：客户端解码一次，BGR 原始数据写入共享内存文件，请求只传文件名
+    const std::string shmDir = sharedMemoryDirectory();
+    const std::string tag = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::string source = "file " + std::filesystem::absolute(imagePath).string();
+    std::string sharedPath;
+    if (shared) {
+        cv::Mat src = cv::imread(imagePath);
+        if (src.empty()) {
+            std::cerr << " 无法读取图像文件 " << imagePath << std::endl;
+            return -1;
+        }
+        sharedPath = shmDir + "/segimg_" + tag + ".bgr";
+        MappedFile file;
+        const size_t rowBytes = static_cast<size_t>(src.cols) * 3;
+        uint8_t* data = file.open(sharedPath, rowBytes * src.rows, true) ? file.map(0, rowBytes * src.rows) : nullptr;
+        if (!data) {
+            std::cerr << " 无法创建共享内存文件 " << sharedPath << std::endl;
+            return -1;
+        }
+        for (int y = 0; y < src.rows; ++y) std::memcpy(data + y * rowBytes, src.ptr(y), rowBytes);
+        file.close();
+        source = "shm " + sharedPath + " " + std::to_string(src.cols) + " " + std::to_string(src.rows);
+    }
+
+    std::vector<std::vector<double>> latencies(concurrency);
+    std::atomic<int> next{ 0 }, succeeded{ 0 }, errors{ 0 }, invalid{ 0 };
+    std::atomic<long long> batchSum{ 0 };
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> clients;
+    for (int c = 0; c < concurrency; ++c) {
+        clients.emplace_back([&, c] {
+            SocketHandle s = connectUnix(socketPath);
+            if (s == INVALID_SOCKET_HANDLE) {
+                errors++;
+                return;
+            }
+            const std::string responsePath = shmDir + "/segresp_" + tag + "_" + std::to_string(c) + ".bin";
+            const std::string request = "SEGMENT " + source + " " + std::to_string(K) + " " + std::to_string(low) + " "
+                + std::to_string(high) + " " + responsePath + "\n";
+            std::string buffer, line;
+            while (next++ < total) {
+                auto t0 = std::chrono::high_resolution_clock::now();
+                if (!sendAll(s, request) || !recvLine(s, buffer, line)) {
+                    errors++;
+                    break;
+                }
+                latencies[c].push_back(elapsedMs(t0));
+                std::istringstream in(line);
+                std::string status;
+                int rows = 0, cols = 0, regions = 0, conflicts = 0, codes = 0, batch = 0;
+                double segmentMs = 0;
+                in >> status >> rows >> cols >> regions >> conflicts >> codes >> segmentMs >> batch;
+                if (status != "OK") {
+                    if (errors++ == 0) std::cerr << " 服务端返回：" << line << std::endl;
+                    continue;
+                }
+                succeeded++;
+                batchSum += batch;
+                if (!checkSegmentResponse(responsePath, rows, cols, codes)) invalid++;
+            }
+            closeSocket(s);
+            std::remove(responsePath.c_str());
+            });
+    }
+    for (auto& t : clients) t.join();
+    const double wallMs = elapsedMs(start);
+    if (!sharedPath.empty()) std::remove(sharedPath.c_str());
+
+    std::vector<double> all;
+    for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) {
+        return all.empty() ? 0.0 : all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+        };
+    std::cout << "【压测】" << (shared ? "共享内存" : "文件路径") << "，并发 " << concurrency << "，请求 " << all.size()
+        << "，失败 " << errors << "，结果校验失败 " << invalid << std::endl;
+    std::cout << "  吞吐 " << all.size() * 1000.0 / std::max(wallMs, 1e-9) << " 请求/秒，平均批大小 "
+        << (succeeded ? static_cast<double>(batchSum) / succeeded : 0.0) << std::endl;
+    std::cout << "  延迟 p50 " << percentile(0.50) << " ms，p90 " << percentile(0.90) << " ms，p99 " << percentile(0.99)
+        << " ms，最大 " << (all.empty() ? 0.0 : all.back()) << " ms" << std::endl;
+
+    SocketHandle s = connectUnix(socketPath);
+    std::string buffer, line;
+    if (s != INVALID_SOCKET_HANDLE && sendAll(s, "STATS\n") && recvLine(s, buffer, line)) {
+        std::cout << "  服务端：" << line.substr(std::min<size_t>(3, line.size())) << std::endl;
+    }
+    if (s != INVALID_SOCKET_HANDLE) closeSocket(s);
+    return errors == 0 && invalid == 0 ? 0 : -1;
+}
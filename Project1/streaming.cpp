@@ -0,0 +1,576 @@
+﻿#ifdef _WIN32
+// windows.h 须在 utils.h（using namespace std）之前包含，否则 byte 等名字会冲突
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "utils.h"
+#include <cctype>
+#include <cfloat>
+#include <cstring>
+
+// ====================================================
+// ✅ 内存映射文件
+//     一次只映射一个窗口，偏移向下对齐到分配粒度；unmap 时写回并释放，
+//     因此常驻内存只随窗口大小增长，与文件大小无关。
+// ====================================================
+MappedFile::~MappedFile() {
+    close();
+}
+
+static uint64_t mappingGranularity() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+bool MappedFile::open(const std::string& path, uint64_t size, bool writable) {
+    close();
+    writable_ = writable;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+        writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    file_ = file;
+    LARGE_INTEGER length;
+    if (writable) {
+        length.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            close();
+            return false;
+        }
+    }
+    else if (!GetFileSizeEx(file, &length)) {
+        close();
+        return false;
+    }
+    size_ = static_cast<uint64_t>(length.QuadPart);
+    if (size_ > 0) {
+        mapping_ = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) {
+            close();
+            return false;
+        }
+    }
+#else
+    fd_ = ::open(path.c_str(), writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+    if (fd_ < 0) return false;
+    if (writable) {
+        if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            close();
+            return false;
+        }
+        size_ = size;
+    }
+    else {
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            close();
+            return false;
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+    }
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    unmap();
+#ifdef _WIN32
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+#endif
+    size_ = 0;
+}
+
+uint8_t* MappedFile::map(uint64_t offset, size_t length) {
+    unmap();
+    if (length == 0 || offset + length > size_) return nullptr;
+    const uint64_t base = offset / mappingGranularity() * mappingGranularity();
+    const size_t span = static_cast<size_t>(offset - base) + length;
+#ifdef _WIN32
+    if (!mapping_) return nullptr;
+    void* p = MapViewOfFile(mapping_, writable_ ? FILE_MAP_WRITE : FILE_MAP_READ,
+        static_cast<DWORD>(base >> 32), static_cast<DWORD>(base & 0xFFFFFFFFu), span);
+    if (!p) return nullptr;
+#else
+    if (fd_ < 0) return nullptr;
+    void* p = mmap(nullptr, span, writable_ ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, static_cast<off_t>(base));
+    if (p == MAP_FAILED) return nullptr;
+#endif
+    view_ = static_cast<uint8_t*>(p);
+    viewLength_ = span;
+    return view_ + (offset - base);
+}
+
+void MappedFile::unmap() {
+    if (!view_) return;
+#ifdef _WIN32
+    if (writable_) FlushViewOfFile(view_, viewLength_);
+    UnmapViewOfFile(view_);
+#else
+    if (writable_) msync(view_, viewLength_, MS_SYNC);   // 写回后页面可被回收，不计入常驻内存
+    munmap(view_, viewLength_);
+#endif
+    view_ = nullptr;
+    viewLength_ = 0;
+}
+
+// 进程常驻内存峰值（字节）
+size_t peakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+
+// ====================================================
+// ✅ 条带读取器：二进制 PPM（P6，8 位）或无头 BGR 原始数据，按行随机读取
+// ====================================================
+static bool readPPMToken(std::istream& in, std::string& token) {
+    token.clear();
+    int c;
+    while ((c = in.get()) != EOF) {
+        if (c == '#') {
+            while ((c = in.get()) != EOF && c != '\n') {}
+            continue;
+        }
+        if (std::isspace(c)) {
+            if (!token.empty()) return true;
+            continue;
+        }
+        token.push_back(static_cast<char>(c));
+    }
+    return !token.empty();
+}
+
+bool StripImageReader::openPPM(const std::string& path) {
+    in_.close();
+    in_.clear();
+    in_.open(path, std::ios::binary);
+    if (!in_) return false;
+    std::string magic, w, h, maxval;
+    if (!readPPMToken(in_, magic) || magic != "P6" || !readPPMToken(in_, w) || !readPPMToken(in_, h)
+        || !readPPMToken(in_, maxval) || maxval != "255") {
+        std::cerr << " 仅支持 8 位二进制 PPM（P6）：" << path << std::endl;
+        return false;
+    }
+    cols_ = std::atoi(w.c_str());
+    rows_ = std::atoi(h.c_str());
+    dataOffset_ = static_cast<uint64_t>(in_.tellg());   // 最后一个记号后恰好跟一个空白字符
+    rgb_ = true;
+    return rows_ > 0 && cols_ > 0;
+}
+
+bool StripImageReader::openRaw(const std::string& path, int width, int height) {
+    in_.close();
+    in_.clear();
+    in_.open(path, std::ios::binary);
+    if (!in_ || width <= 0 || height <= 0) return false;
+    cols_ = width;
+    rows_ = height;
+    dataOffset_ = 0;
+    rgb_ = false;
+    return true;
+}
+
+bool StripImageReader::readRows(int y0, int y1, cv::Mat& out) {
+    if (y0 < 0 || y1 > rows_ || y0 >= y1) return false;
+    out.create(y1 - y0, cols_, CV_8UC3);
+    const uint64_t rowBytes = static_cast<uint64_t>(cols_) * 3;
+    in_.clear();
+    in_.seekg(static_cast<std::streamoff>(dataOffset_ + rowBytes * y0));
+    for (int y = 0; y < out.rows; ++y) {
+        if (!in_.read(reinterpret_cast<char*>(out.ptr(y)), static_cast<std::streamsize>(rowBytes))) return false;
+    }
+    if (rgb_) cv::cvtColor(out, out, cv::COLOR_RGB2BGR);
+    return true;
+}
+
+bool writePPM(const std::string& path, const cv::Mat& bgr) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    out << "P6\n" << bgr.cols << " " << bgr.rows << "\n255\n";
+    std::vector<uint8_t> row(static_cast<size_t>(bgr.cols) * 3);
+    for (int y = 0; y < bgr.rows; ++y) {
+        const cv::Vec3b* src = bgr.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < bgr.cols; ++x) {
+            row[3 * x] = src[x][2];
+            row[3 * x + 1] = src[x][1];
+            row[3 * x + 2] = src[x][0];
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    return static_cast<bool>(out);
+}
+
+
+// ====================================================
+// ✅ 条带流式分割
+//     与 computeWatershedRelief + SegmentationContext::flood 相同的处理链，按水平条带进行：
+//       第 1 遍：统计全图灰度直方图，得到与 equalizeHist 相同的查找表；
+//       第 2、3 遍：距离变换的正向、反向扫描（每行只依赖相邻一行，状态 O(宽度)），
+//                  结果暂存在映射文件中，并得到归一化所需的全局最值（与整图结果的差别见下方倒角常量处）；
+//       第 4 遍：逐条带生成地形图并淹没，核心行修复后写入内存映射的标签文件；
+//       第 5 遍：从标签文件流式统计面积、质心与邻接边，着色；
+//       第 6 遍（可选）：流式输出着色图。
+//     Canny 与淹没在条带上下各带 halo 行上下文；上一条带已定稿的最后两行作为本条带的初始 markers
+//     （第一行会被 watershed 置为边框），区域因此可以向下跨条带延续；
+//     种子在 halo 之外、向上生长超过 halo 的区域会被邻近种子占据，这是与整图结果的主要差别。
+// ====================================================
+// 离开作用域时删除临时文件，任何一处提前返回都不会留下它
+struct TempFileRemover {
+    std::string path;
+    ~TempFileRemover() { removeNow(); }
+    void removeNow() {
+        if (!path.empty()) std::remove(path.c_str());
+        path.clear();
+    }
+};
+
+static const int STREAM_BYTES_PER_PIXEL = 48;   // 窗口内各中间图像 + OpenCV 内部缓冲的估计
+static const uint64_t LABEL_FILE_HEADER = 16;    // "LBLS" | 每像素字节 u8 | 保留 3 字节 | rows u32 | cols u32
+
+// 与 OpenCV distanceTransform（DIST_L2，3x3 掩模）相同的定点两遍扫描：水平/垂直步长 0.955，对角 1.3693。
+// 同一张边缘图上定点结果与 OpenCV 逐位相同，两者都只是 3x3 倒角距离：相对欧氏距离偏差在 -4.5% ~ +4.1% 之间
+// （单点源 2001 x 2001 实测），半径 20 像素内绝对误差不超过 0.9 像素。条带上的 Canny 只有 halo 行上下文，
+// 接缝附近的边缘图可能与整图不同，那里的距离随之不同。
+static const int CHAMFER_SHIFT = 16;
+static const int CHAMFER_INF = INT_MAX >> 2;
+static const int CHAMFER_HV = static_cast<int>(0.955 * (1 << CHAMFER_SHIFT) + 0.5);
+static const int CHAMFER_DIAG = static_cast<int>(1.3693 * (1 << CHAMFER_SHIFT) + 0.5);
+
+// 正向：左、左上、上、右上；edges 非零处为边缘（距离 0）
+static void chamferForwardRow(const uchar* edges, const int* above, int* out, int cols) {
+    for (int x = 0; x < cols; ++x) {
+        if (edges[x]) {
+            out[x] = 0;
+            continue;
+        }
+        int v = CHAMFER_INF;
+        if (x > 0) v = std::min(v, out[x - 1] + CHAMFER_HV);
+        if (above) {
+            v = std::min(v, above[x] + CHAMFER_HV);
+            if (x > 0) v = std::min(v, above[x - 1] + CHAMFER_DIAG);
+            if (x + 1 < cols) v = std::min(v, above[x + 1] + CHAMFER_DIAG);
+        }
+        out[x] = std::min(v, CHAMFER_INF);
+    }
+}
+
+// 反向：右、右下、下、左下，在正向结果上原地更新
+static void chamferBackwardRow(int* row, const int* below, int cols) {
+    for (int x = cols - 1; x >= 0; --x) {
+        int v = row[x];
+        if (x + 1 < cols) v = std::min(v, row[x + 1] + CHAMFER_HV);
+        if (below) {
+            v = std::min(v, below[x] + CHAMFER_HV);
+            if (x + 1 < cols) v = std::min(v, below[x + 1] + CHAMFER_DIAG);
+            if (x > 0) v = std::min(v, below[x - 1] + CHAMFER_DIAG);
+        }
+        row[x] = v;
+    }
+}
+
+// 与 cv::equalizeHist 相同的查找表，累计和用 64 位以支持超大图像
+static void equalizationTable(const std::vector<uint64_t>& hist, uint64_t total, cv::Mat& lut) {
+    lut.create(1, 256, CV_8U);
+    uchar* t = lut.ptr<uchar>(0);
+    int i = 0;
+    while (i < 255 && hist[i] == 0) ++i;
+    if (hist[i] == total) {
+        for (int j = 0; j < 256; ++j) t[j] = static_cast<uchar>(i);
+        return;
+    }
+    const double scale = 255.0 / static_cast<double>(total - hist[i]);
+    uint64_t sum = 0;
+    for (int j = 0; j < i; ++j) t[j] = 0;
+    for (t[i++] = 0; i < 256; ++i) {
+        sum += hist[i];
+        t[i] = cv::saturate_cast<uchar>(static_cast<double>(sum) * scale);
+    }
+}
+
+bool segmentStreaming(StripImageReader& reader, const std::vector<cv::Point>& seeds, const std::string& labelPath,
+    const StreamingOptions& options, StreamingResult& result) {
+    const int rows = reader.rows(), cols = reader.cols();
+    const int halo = std::max(8, options.halo);   // Canny 需要至少几行上下文
+    result = StreamingResult();
+    if (seeds.empty()) return false;
+
+    // 窗口 = 上方 2 行已定稿标签 + 核心行 + 下方 halo 行淹没上下文，再上下各加 halo 行 Canny 上下文
+    const int64_t budgetRows = static_cast<int64_t>(options.memoryBudget / (static_cast<size_t>(cols) * STREAM_BYTES_PER_PIXEL));
+    int stripRows = static_cast<int>(std::min<int64_t>(budgetRows - 3 * halo - 2, rows));
+    if (stripRows < 16) {
+        std::cerr << " 内存预算过小：宽 " << cols << " 像素、halo " << halo << " 行时至少需要 "
+            << (static_cast<size_t>(cols) * STREAM_BYTES_PER_PIXEL * (3 * halo + 18) >> 20) << " MB。" << std::endl;
+        return false;
+    }
+    result.stripRows = stripRows;
+    result.strips = (rows + stripRows - 1) / stripRows;
+    result.labelDepth = selectLabelDepth(static_cast<int>(seeds.size()), options.labelStorage);
+    const int labelBytes = result.labelDepth == CV_16U ? 2 : 4;
+    const uint64_t labelRowBytes = static_cast<uint64_t>(cols) * labelBytes;
+
+    // 种子按 y 排序，逐条带二分取出窗口内的种子；标签仍为原下标 + 1
+    std::vector<int> seedOrder(seeds.size());
+    for (size_t i = 0; i < seedOrder.size(); ++i) seedOrder[i] = static_cast<int>(i);
+    std::stable_sort(seedOrder.begin(), seedOrder.end(), [&](int a, int b) { return seeds[a].y < seeds[b].y; });
+    std::vector<cv::Point> sortedSeeds(seeds.size());
+    std::vector<int> seedLabels(seeds.size());
+    for (size_t i = 0; i < seedOrder.size(); ++i) {
+        sortedSeeds[i] = seeds[seedOrder[i]];
+        seedLabels[i] = seedOrder[i] + 1;
+    }
+    const int radius = std::max(3, static_cast<int>(std::sqrt((cols * static_cast<double>(rows)) / seeds.size()) * 0.001));
+
+    cv::Mat strip, gray, edges, dist, dist8U, morph, combined, relief, markers;
+    const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(RELIEF_CLOSE_KERNEL, RELIEF_CLOSE_KERNEL));
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // ---- 第 1 遍：灰度直方图 ----
+    std::vector<uint64_t> hist(256, 0);
+    for (int y0 = 0; y0 < rows; y0 += stripRows) {
+        int y1 = std::min(rows, y0 + stripRows);
+        if (!reader.readRows(y0, y1, strip)) return false;
+        cv::cvtColor(strip, gray, cv::COLOR_BGR2GRAY);
+        for (int y = 0; y < gray.rows; ++y) {
+            const uchar* g = gray.ptr<uchar>(y);
+            for (int x = 0; x < gray.cols; ++x) hist[g[x]]++;
+        }
+    }
+    cv::Mat lut;
+    equalizationTable(hist, static_cast<uint64_t>(rows) * cols, lut);
+
+    // 读入 [r0, r1) 行，计算均衡化灰度与 Canny 边缘
+    auto readEdges = [&](int r0, int r1) {
+        if (!reader.readRows(r0, r1, strip)) return false;
+        cv::cvtColor(strip, gray, cv::COLOR_BGR2GRAY);
+        cv::LUT(gray, lut, gray);
+        cv::Canny(gray, edges, RELIEF_CANNY_LOW, RELIEF_CANNY_HIGH);
+        return true;
+        };
+
+    // ---- 第 2、3 遍：距离变换，正向与反向扫描各一遍，中间结果存放在临时映射文件中 ----
+    const std::string distPath = labelPath + ".dist";
+    TempFileRemover distCleanup{ distPath };   // 先于 distFile 构造、后于它析构，删除时文件已关闭
+    MappedFile distFile;
+    if (!distFile.open(distPath, static_cast<uint64_t>(rows) * cols * sizeof(int), true)) {
+        std::cerr << " 无法创建临时文件 " << distPath << std::endl;
+        return false;
+    }
+    const uint64_t distRowBytes = static_cast<uint64_t>(cols) * sizeof(int);
+    std::vector<int> carry(cols, CHAMFER_INF);   // 上一行（正向）或下一行（反向）的结果
+    for (int y0 = 0; y0 < rows; y0 += stripRows) {
+        const int y1 = std::min(rows, y0 + stripRows);
+        const int r0 = std::max(0, y0 - halo), r1 = std::min(rows, y1 + halo);
+        if (!readEdges(r0, r1)) return false;
+        int* d = reinterpret_cast<int*>(distFile.map(distRowBytes * y0, static_cast<size_t>(distRowBytes * (y1 - y0))));
+        if (!d) return false;
+        for (int y = y0; y < y1; ++y, d += cols) {
+            chamferForwardRow(edges.ptr<uchar>(y - r0), y > 0 ? carry.data() : nullptr, d, cols);
+            std::copy(d, d + cols, carry.begin());
+        }
+    }
+    int distMin = INT_MAX, distMax = INT_MIN;
+    for (int y1 = rows; y1 > 0; y1 -= stripRows) {
+        const int y0 = std::max(0, y1 - stripRows);
+        int* d = reinterpret_cast<int*>(distFile.map(distRowBytes * y0, static_cast<size_t>(distRowBytes * (y1 - y0))));
+        if (!d) return false;
+        for (int y = y1 - 1; y >= y0; --y) {
+            int* row = d + static_cast<size_t>(y - y0) * cols;
+            chamferBackwardRow(row, y + 1 < rows ? carry.data() : nullptr, cols);
+            for (int x = 0; x < cols; ++x) {
+                distMin = std::min(distMin, row[x]);
+                distMax = std::max(distMax, row[x]);
+            }
+            std::copy(row, row + cols, carry.begin());
+        }
+    }
+    distFile.unmap();
+    // 与 normalize(NORM_MINMAX) 后 convertTo(CV_8U, 255) 相同的两步换算
+    const double fixedScale = 1.0 / (1 << CHAMFER_SHIFT);
+    const double lo = static_cast<float>(distMin * fixedScale), hi = static_cast<float>(distMax * fixedScale);
+    const double normScale = hi > lo ? 1.0 / (hi - lo) : 0.0;
+    result.reliefMs = elapsedMs(start);
+
+    // ---- 第 4 遍：逐条带淹没，写入标签文件 ----
+    start = std::chrono::high_resolution_clock::now();
+    MappedFile labels;
+    if (!labels.open(labelPath, LABEL_FILE_HEADER + labelRowBytes * rows, true)) {
+        std::cerr << " 无法创建标签文件 " << labelPath << std::endl;
+        return false;
+    }
+    uint8_t* header = labels.map(0, LABEL_FILE_HEADER);
+    if (!header) return false;
+    std::memcpy(header, "LBLS", 4);
+    header[4] = static_cast<uint8_t>(labelBytes);
+    header[5] = header[6] = header[7] = 0;
+    const uint32_t dims[2] = { static_cast<uint32_t>(rows), static_cast<uint32_t>(cols) };
+    std::memcpy(header + 8, dims, sizeof(dims));
+    labels.unmap();
+
+    cv::Mat distNorm;
+    for (int y0 = 0; y0 < rows; y0 += stripRows) {
+        const int y1 = std::min(rows, y0 + stripRows);
+        const int w0 = std::max(0, y0 - 2), w1 = std::min(rows, y1 + halo);       // 淹没窗口
+        const int r0 = std::max(0, w0 - halo), r1 = std::min(rows, w1 + halo);    // Canny 上下文
+        if (!readEdges(r0, r1)) return false;
+        cv::morphologyEx(edges, morph, cv::MORPH_CLOSE, kernel);
+        int* d = reinterpret_cast<int*>(distFile.map(distRowBytes * w0, static_cast<size_t>(distRowBytes * (w1 - w0))));
+        if (!d) return false;
+        cv::Mat(w1 - w0, cols, CV_32S, d).convertTo(dist, CV_32F, fixedScale);
+        dist.convertTo(distNorm, CV_32F, normScale, -lo * normScale);
+        distNorm.convertTo(dist8U, CV_8U, 255.0);
+        distFile.unmap();
+        cv::addWeighted(dist8U, RELIEF_DISTANCE_WEIGHT, morph.rowRange(w0 - r0, w1 - r0), 1.0 - RELIEF_DISTANCE_WEIGHT, 0, combined);
+        cv::cvtColor(combined, relief, cv::COLOR_GRAY2BGR);
+
+        markers.create(w1 - w0, cols, CV_32S);
+        markers.setTo(cv::Scalar(0));
+        uint8_t* view = labels.map(LABEL_FILE_HEADER + labelRowBytes * w0, static_cast<size_t>(labelRowBytes * (y1 - w0)));
+        if (!view) return false;
+        cv::Mat fileRows(y1 - w0, cols, result.labelDepth, view);
+        if (y0 > w0) {
+            cv::Mat settled = markers.rowRange(0, y0 - w0);   // 上一条带已定稿的行
+            fileRows.rowRange(0, y0 - w0).convertTo(settled, CV_32S);
+        }
+        auto first = std::lower_bound(sortedSeeds.begin(), sortedSeeds.end(), w0 - radius,
+            [](const cv::Point& p, int y) { return p.y < y; });
+        for (auto it = first; it != sortedSeeds.end() && it->y < w1 + radius; ++it) {
+            int label = seedLabels[it - sortedSeeds.begin()];
+            cv::circle(markers, cv::Point(it->x, it->y - w0), radius, cv::Scalar(label), -1);
+        }
+        cv::watershed(relief, markers);
+        repairWatershedBoundaries(markers);
+        cv::Mat core = fileRows.rowRange(y0 - w0, y1 - w0);
+        markers.rowRange(y0 - w0, y1 - w0).convertTo(core, result.labelDepth);
+        labels.unmap();
+    }
+    distFile.close();
+    distCleanup.removeNow();
+    result.floodMs = elapsedMs(start);
+    strip.release(); gray.release(); edges.release(); dist.release();
+    distNorm.release(); dist8U.release(); morph.release(); combined.release(); relief.release(); markers.release();
+
+    // ---- 第 5 遍：面积、质心、邻接边 ----
+    start = std::chrono::high_resolution_clock::now();
+    const int maxLabel = static_cast<int>(seeds.size());
+    result.areas.assign(maxLabel + 1, 0);
+    result.sumX.assign(maxLabel + 1, 0);
+    result.sumY.assign(maxLabel + 1, 0);
+    result.graph.present.assign(maxLabel + 1, 0);
+    std::vector<uint64_t> edgeList;
+    const int scanRows = std::max(1, static_cast<int>(std::min<uint64_t>(options.memoryBudget / 2 / labelRowBytes, rows)));
+    auto mapLabelRows = [&](int y0, int y1, cv::Mat& view) {
+        uint8_t* p = labels.map(LABEL_FILE_HEADER + labelRowBytes * y0, static_cast<size_t>(labelRowBytes * (y1 - y0)));
+        if (p) view = cv::Mat(y1 - y0, cols, result.labelDepth, p);
+        return p != nullptr;
+        };
+    for (int y0 = 0; y0 < rows; y0 += scanRows) {
+        const int y1 = std::min(rows, y0 + scanRows);
+        cv::Mat view;
+        if (!mapLabelRows(y0, std::min(rows, y1 + 1), view)) return false;   // 多映射一行作为下邻
+        appendRegionAdjacencyEdges(view, y1 - y0, edgeList, result.graph.present);
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < cols; ++x) {
+                int l = result.labelDepth == CV_16U ? view.at<uint16_t>(y - y0, x) : view.at<int>(y - y0, x);
+                if (l <= 0 || l > maxLabel) continue;
+                result.areas[l]++;
+                result.sumX[l] += x;
+                result.sumY[l] += y;
+            }
+        }
+    }
+    labels.unmap();
+    finishRegionAdjacencyCSR(edgeList, maxLabel, result.graph);
+    CSRColoringScratch scratch;
+    result.conflicts = fourColorCSR(result.graph, result.colors, scratch);
+    for (int l = 1; l <= maxLabel; ++l) result.regions += result.graph.present[l];
+    result.statsMs = elapsedMs(start);
+
+    // ---- 第 6 遍：着色图 ----
+    if (!options.coloringPath.empty()) {
+        start = std::chrono::high_resolution_clock::now();
+        std::ofstream out(options.coloringPath, std::ios::binary);
+        if (!out) {
+            std::cerr << " 无法写入 " << options.coloringPath << std::endl;
+            return false;
+        }
+        out << "P6\n" << cols << " " << rows << "\n255\n";
+        cv::Mat view, colorRows;
+        for (int y0 = 0; y0 < rows; y0 += scanRows / 2 + 1) {
+            const int y1 = std::min(rows, y0 + scanRows / 2 + 1);
+            if (!mapLabelRows(y0, y1, view)) return false;
+            renderLabelColors(view, result.colors, colorRows);
+            cv::cvtColor(colorRows, colorRows, cv::COLOR_BGR2RGB);
+            for (int y = 0; y < colorRows.rows; ++y) {
+                out.write(reinterpret_cast<const char*>(colorRows.ptr(y)), static_cast<std::streamsize>(cols) * 3);
+            }
+        }
+        labels.unmap();
+        result.renderMs = elapsedMs(start);
+    }
+    result.peakRss = peakResidentBytes();
+    return true;
+}
+
+// 读取 segmentStreaming 写出的标签文件（整图，仅用于校验与小图）
+bool readLabelFile(const std::string& path, cv::Mat& labels) {
+    MappedFile file;
+    if (!file.open(path, 0, false) || file.size() < LABEL_FILE_HEADER) return false;
+    const uint8_t* header = file.map(0, LABEL_FILE_HEADER);
+    if (!header || std::memcmp(header, "LBLS", 4) != 0 || (header[4] != 2 && header[4] != 4)) return false;
+    const int bytes = header[4];
+    uint32_t dims[2];
+    std::memcpy(dims, header + 8, sizeof(dims));
+    const uint64_t dataBytes = static_cast<uint64_t>(dims[0]) * dims[1] * bytes;
+    if (dims[0] == 0 || dims[1] == 0 || file.size() != LABEL_FILE_HEADER + dataBytes) return false;
+    const uint8_t* data = file.map(LABEL_FILE_HEADER, static_cast<size_t>(dataBytes));
+    if (!data) return false;
+    cv::Mat(static_cast<int>(dims[0]), static_cast<int>(dims[1]), bytes == 2 ? CV_16U : CV_32S,
+        const_cast<uint8_t*>(data)).copyTo(labels);
+    return true;
+}
+
+// 写出与 segmentStreaming 相同格式的标签文件（整图在内存中，供合成负载等使用）
+bool writeLabelFile(const std::string& path, const cv::Mat& labels) {
+    if (labels.depth() != CV_16U && labels.depth() != CV_32S) return false;
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    uint8_t header[LABEL_FILE_HEADER] = { 'L', 'B', 'L', 'S', static_cast<uint8_t>(labels.elemSize()) };
+    const uint32_t dims[2] = { static_cast<uint32_t>(labels.rows), static_cast<uint32_t>(labels.cols) };
+    std::memcpy(header + 8, dims, sizeof(dims));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (int y = 0; y < labels.rows; ++y) {
+        out.write(reinterpret_cast<const char*>(labels.ptr(y)), static_cast<std::streamsize>(labels.cols * labels.elemSize()));
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,238 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 标签连通性校验：条带并行的并查集连通分量标记（8 连通）
+//     分水岭 + repairWatershedBoundaries 之后，同一标签可能落成几块不相连的碎片，
+//     按标签累加的面积、质心、邻接都会把它们当成一个区域。
+//     1. 图像按行切成条带，每个线程对自己的条带做一遍 SAUF 式决策树扫描：
+//        只看上、左上、右上、左四个已扫描邻居中与当前像素同标签者，临时编号从 y0 * cols 起，
+//        并查集只在本条带的编号段内合并，线程间不共享写入；
+//     2. 串行合并相邻条带交界行；
+//     3. 压缩路径、给每个根编分量号，按标签统计分量数，没有碎片时到此结束（读一遍标签图）；
+//     4. 需要改写时再并行写一遍：最大的一块保留原标签，其余碎片改新标签或并入邻居。
+// ====================================================
+
+static int findRoot(std::vector<int>& parent, int p) {
+    int root = p;
+    while (parent[root] != root) root = parent[root];
+    while (parent[p] != root) {
+        int next = parent[p];
+        parent[p] = root;
+        p = next;
+    }
+    return root;
+}
+
+// 小编号作根：非根的 parent 总小于自身，条带内的合并只会指向本条带编号段
+static int unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a == b) return a;
+    if (a < b) {
+        parent[b] = a;
+        return a;
+    }
+    parent[a] = b;
+    return b;
+}
+
+// 第一遍：对 [y0, y1) 行做 SAUF 决策树扫描，b 为正上，a/c 为左上/右上，d 为左
+template <typename Label>
+static void labelStripe(const cv::Mat& markers, ComponentScratch& s, int y0, int y1, int& end) {
+    const int cols = markers.cols;
+    int next = y0 * cols;
+    for (int y = y0; y < y1; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        const Label* up = y > y0 ? markers.ptr<Label>(y - 1) : nullptr;
+        int* prov = s.provisional.ptr<int>(y);
+        const int* provUp = up ? s.provisional.ptr<int>(y - 1) : nullptr;
+        for (int x = 0; x < cols; ++x) {
+            const Label e = row[x];
+            if (static_cast<int>(e) <= 0) {
+                prov[x] = -1;
+                continue;
+            }
+            // 决策树按需读邻居：b 同标签时 a、c、d 必与 b 相连，不再比较
+            int id;
+            if (up && up[x] == e) id = provUp[x];
+            else if (up && x + 1 < cols && up[x + 1] == e) {
+                if (x > 0 && up[x - 1] == e) id = unite(s.parent, provUp[x + 1], provUp[x - 1]);
+                else if (x > 0 && row[x - 1] == e) id = unite(s.parent, provUp[x + 1], prov[x - 1]);
+                else id = provUp[x + 1];
+            }
+            else if (up && x > 0 && up[x - 1] == e) id = provUp[x - 1];
+            else if (x > 0 && row[x - 1] == e) id = prov[x - 1];
+            else {
+                id = next++;
+                s.parent[id] = id;
+                s.labelOf[id] = static_cast<int>(e);
+                s.area[id] = 0;
+            }
+            prov[x] = id;
+            ++s.area[id];
+        }
+    }
+    end = next;
+}
+
+// 条带首行与上一条带末行的 8 邻接
+template <typename Label>
+static void mergeStripeBorder(const cv::Mat& markers, ComponentScratch& s, int y) {
+    const int cols = markers.cols;
+    const Label* row = markers.ptr<Label>(y);
+    const Label* up = markers.ptr<Label>(y - 1);
+    const int* prov = s.provisional.ptr<int>(y);
+    const int* provUp = s.provisional.ptr<int>(y - 1);
+    for (int x = 0; x < cols; ++x) {
+        if (prov[x] < 0) continue;
+        for (int dx = -1; dx <= 1; ++dx) {
+            const int nx = x + dx;
+            if (nx >= 0 && nx < cols && up[nx] == row[x]) unite(s.parent, prov[x], provUp[nx]);
+        }
+    }
+}
+
+// 最后一遍：按分量改写标签，只写发生变化的像素
+template <typename Label>
+static void relabelStripe(cv::Mat& markers, const ComponentScratch& s, int y0, int y1) {
+    for (int y = y0; y < y1; ++y) {
+        Label* row = markers.ptr<Label>(y);
+        const int* prov = s.provisional.ptr<int>(y);
+        for (int x = 0; x < markers.cols; ++x) {
+            if (prov[x] < 0) continue;
+            const int label = s.finalLabel[s.parent[prov[x]]];
+            if (static_cast<int>(row[x]) != label) row[x] = static_cast<Label>(label);
+        }
+    }
+}
+
+template <typename Label>
+static void resolveFragmentsKernel(cv::Mat& markers, FragmentPolicy policy, int minFragmentArea, FragmentReport& report,
+    ComponentScratch& s, int threads) {
+    const int rows = markers.rows, cols = markers.cols;
+    const size_t pixels = static_cast<size_t>(rows) * cols;
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    const int stripes = std::max(1, std::min(std::max(threads, 1), rows / 32));   // 每条至少 32 行
+    s.provisional.create(rows, cols, CV_32S);
+    if (s.parent.size() < pixels) {
+        s.parent.resize(pixels);
+        s.labelOf.resize(pixels);
+        s.area.resize(pixels);
+    }
+    s.stripeBegin.resize(stripes + 1);
+    s.stripeEnd.resize(stripes);
+    for (int i = 0; i <= stripes; ++i) s.stripeBegin[i] = static_cast<int>(static_cast<int64_t>(rows) * i / stripes);
+
+    forEachStripe(stripes, [&](int i) {
+        labelStripe<Label>(markers, s, s.stripeBegin[i], s.stripeBegin[i + 1], s.stripeEnd[i]);
+    });
+    for (int i = 1; i < stripes; ++i) mergeStripeBorder<Label>(markers, s, s.stripeBegin[i]);
+
+    // 压缩：编号升序遍历时 parent[p] 已改写为分量号，原地把 parent 换成分量号，面积累加到分量
+    s.componentLabel.clear();
+    s.componentArea.clear();
+    int maxLabel = 0;
+    for (int i = 0; i < stripes; ++i) {
+        for (int p = s.stripeBegin[i] * cols; p < s.stripeEnd[i]; ++p) {
+            if (s.parent[p] == p) {
+                s.parent[p] = static_cast<int>(s.componentLabel.size());
+                s.componentLabel.push_back(s.labelOf[p]);
+                s.componentArea.push_back(0);
+                maxLabel = std::max(maxLabel, s.labelOf[p]);
+            }
+            else s.parent[p] = s.parent[s.parent[p]];
+            s.componentArea[s.parent[p]] += s.area[p];
+        }
+    }
+    const int components = static_cast<int>(s.componentLabel.size());
+
+    // 每个标签的分量数与最大分量
+    report = FragmentReport();
+    report.components = components;
+    report.fragmentsPerLabel.assign(maxLabel + 1, 0);
+    s.mainComponent.assign(maxLabel + 1, -1);
+    for (int c = 0; c < components; ++c) {
+        const int label = s.componentLabel[c];
+        if (report.fragmentsPerLabel[label]++ == 0) ++report.labels;
+        else if (report.fragmentsPerLabel[label] == 2) ++report.fragmentedLabels;
+        int& main = s.mainComponent[label];
+        if (main < 0 || s.componentArea[c] > s.componentArea[main]) main = c;
+    }
+    if (policy == FRAGMENTS_REPORT || report.fragmentedLabels == 0) return;
+
+    // 碎片：ABSORB 时面积不足者先标记待并入（-1），其余分配新标签
+    s.finalLabel.resize(components);
+    int nextLabel = maxLabel;
+    for (int c = 0; c < components; ++c) {
+        if (s.mainComponent[s.componentLabel[c]] == c) s.finalLabel[c] = s.componentLabel[c];
+        else if (policy == FRAGMENTS_ABSORB && s.componentArea[c] < minFragmentArea) s.finalLabel[c] = -1;
+        else {
+            s.finalLabel[c] = ++nextLabel;
+            ++report.splitFragments;
+        }
+    }
+
+    // 待并入的碎片找面积最大的非待并入 4 邻分量（右、下两个方向即可覆盖所有相邻对）
+    if (policy == FRAGMENTS_ABSORB) {
+        s.absorbInto.assign(components, -1);
+        auto consider = [&](int from, int to) {
+            if (s.finalLabel[from] >= 0 || s.finalLabel[to] < 0) return;
+            int& best = s.absorbInto[from];
+            if (best < 0 || s.componentArea[to] > s.componentArea[best]) best = to;
+        };
+        for (int y = 0; y < rows; ++y) {
+            const int* prov = s.provisional.ptr<int>(y);
+            const int* provDown = y + 1 < rows ? s.provisional.ptr<int>(y + 1) : nullptr;
+            for (int x = 0; x < cols; ++x) {
+                if (prov[x] < 0) continue;
+                const int c = s.parent[prov[x]];
+                if (x + 1 < cols && prov[x + 1] >= 0) {
+                    const int r = s.parent[prov[x + 1]];
+                    if (r != c) {
+                        consider(c, r);
+                        consider(r, c);
+                    }
+                }
+                if (provDown && provDown[x] >= 0) {
+                    const int dn = s.parent[provDown[x]];
+                    if (dn != c) {
+                        consider(c, dn);
+                        consider(dn, c);
+                    }
+                }
+            }
+        }
+        // 没有可并入的邻居（被其他碎片或背景包围）时退回拆分
+        for (int c = 0; c < components; ++c) {
+            if (s.finalLabel[c] >= 0) continue;
+            if (s.absorbInto[c] >= 0) {
+                s.finalLabel[c] = s.finalLabel[s.absorbInto[c]];
+                ++report.absorbedFragments;
+                report.absorbedPixels += s.componentArea[c];
+            }
+            else {
+                s.finalLabel[c] = ++nextLabel;
+                ++report.splitFragments;
+            }
+        }
+    }
+
+    if (sizeof(Label) == sizeof(uint16_t) && nextLabel > USHRT_MAX) {
+        cv::Mat widened;
+        markers.convertTo(widened, CV_32S);
+        markers = widened;
+        forEachStripe(stripes, [&](int i) { relabelStripe<int>(markers, s, s.stripeBegin[i], s.stripeBegin[i + 1]); });
+        return;
+    }
+    forEachStripe(stripes, [&](int i) { relabelStripe<Label>(markers, s, s.stripeBegin[i], s.stripeBegin[i + 1]); });
+}
+
+void resolveLabelFragments(cv::Mat& markers, FragmentPolicy policy, int minFragmentArea, FragmentReport& report,
+    ComponentScratch& scratch, int threads) {
+    if (markers.empty()) {
+        report = FragmentReport();
+        return;
+    }
+    if (markers.depth() == CV_16U) resolveFragmentsKernel<uint16_t>(markers, policy, minFragmentArea, report, scratch, threads);
+    else resolveFragmentsKernel<int>(markers, policy, minFragmentArea, report, scratch, threads);
+}
@@ -0,0 +1,222 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 区域轮廓提取（裂缝跟踪，一遍扫描）
+//     逐像素对每个标签做 cv::findContours 需要 K 次整图扫描；这里只做一遍光栅扫描：
+//     某标签第一次出现的像素，其上方与左方都不属于该标签，左上角必在外边界上。
+//     从该角点向右出发，沿像素之间的裂缝（像素边）行走，区域始终在右侧：
+//       前方左侧像素属于区域 → 左转（8 连通，斜对角相连的像素也算同一块）；
+//       否则前方右侧像素属于区域 → 直行；都不属于 → 右转。
+//     回到起点且下一步又向右时闭合。每条边界只走一遍，总耗时为一遍扫描 + 所有周长之和。
+//     多边形取链码方向改变处的角点，可再按 Douglas-Peucker 化简。
+// ====================================================
+
+static const uint8_t CONTOUR_CODEC_VERSION = 2;   // 2：起点差分改为 zigzag
+
+// 方向 0 右、1 下、2 左、3 上；LEFT / RIGHT 为位于角点 (x, y)、朝向 d 时前方左侧 / 右侧像素相对角点的偏移
+static const int STEP_X[4] = { 1, 0, -1, 0 };
+static const int STEP_Y[4] = { 0, 1, 0, -1 };
+static const int LEFT_X[4] = { 0, 0, -1, -1 };
+static const int LEFT_Y[4] = { -1, 0, 0, -1 };
+static const int RIGHT_X[4] = { 0, -1, -1, 0 };
+static const int RIGHT_Y[4] = { 0, 0, -1, -1 };
+
+template <typename Label>
+static void traceOuterBoundary(const cv::Mat& markers, int x0, int y0, std::vector<uint8_t>& chain) {
+    const int rows = markers.rows, cols = markers.cols;
+    const Label label = markers.ptr<Label>(y0)[x0];
+    auto inside = [&](int x, int y) {
+        return x >= 0 && y >= 0 && x < cols && y < rows && markers.ptr<Label>(y)[x] == label;
+    };
+    const size_t begin = chain.size();
+    int x = x0, y = y0, d = 0;
+    for (;;) {
+        if (inside(x + LEFT_X[d], y + LEFT_Y[d])) d = (d + 3) & 3;
+        else if (!inside(x + RIGHT_X[d], y + RIGHT_Y[d])) d = (d + 1) & 3;
+        if (x == x0 && y == y0 && d == 0 && chain.size() > begin) break;
+        chain.push_back(static_cast<uint8_t>(d));
+        x += STEP_X[d];
+        y += STEP_Y[d];
+    }
+}
+
+// 点 p 到线段 ab 所在直线的距离（a、b 重合时为到 a 的距离）
+static double distanceToLine(cv::Point p, cv::Point a, cv::Point b) {
+    const double dx = b.x - a.x, dy = b.y - a.y;
+    const double len = std::sqrt(dx * dx + dy * dy);
+    if (len == 0) return std::hypot(p.x - a.x, p.y - a.y);
+    return std::abs(dx * (p.y - a.y) - dy * (p.x - a.x)) / len;
+}
+
+// 闭合折线的 Douglas-Peucker 化简：以首点与离它最远的点分成两段，各段用显式栈迭代
+static void simplifyClosedPolygon(const std::vector<cv::Point>& corners, double epsilon, std::vector<cv::Point>& out) {
+    const int n = static_cast<int>(corners.size());
+    if (n <= 3) {
+        out.insert(out.end(), corners.begin(), corners.end());
+        return;
+    }
+    int far = 1;
+    double farDist = 0;
+    for (int i = 1; i < n; ++i) {
+        const double d = std::hypot(corners[i].x - corners[0].x, corners[i].y - corners[0].y);
+        if (d > farDist) {
+            farDist = d;
+            far = i;
+        }
+    }
+    std::vector<uint8_t> keep(n + 1, 0);
+    keep[0] = keep[far] = keep[n] = 1;
+    auto at = [&](int i) { return corners[i % n]; };
+    std::vector<std::pair<int, int>> stack = { { 0, far }, { far, n } };
+    while (!stack.empty()) {
+        const auto [a, b] = stack.back();
+        stack.pop_back();
+        int worst = -1;
+        double worstDist = epsilon;
+        for (int i = a + 1; i < b; ++i) {
+            const double d = distanceToLine(at(i), at(a), at(b));
+            if (d > worstDist) {
+                worstDist = d;
+                worst = i;
+            }
+        }
+        if (worst < 0) continue;
+        keep[worst] = 1;
+        stack.emplace_back(a, worst);
+        stack.emplace_back(worst, b);
+    }
+    for (int i = 0; i < n; ++i) {
+        if (keep[i]) out.push_back(corners[i]);
+    }
+}
+
+// 由链码求角点多边形（起点总是角点：到达时向上、离开时向右）
+static void buildPolygons(RegionContours& contours, double epsilon) {
+    contours.polygon.clear();
+    contours.polygonOffset.assign(1, 0);
+    std::vector<cv::Point> corners;
+    for (size_t i = 0; i < contours.size(); ++i) {
+        const uint8_t* code = contours.chain.data() + contours.chainOffset[i];
+        const int n = contours.perimeter(i);
+        corners.clear();
+        cv::Point p = contours.starts[i];
+        for (int k = 0; k < n; ++k) {
+            if (code[k] != code[k == 0 ? n - 1 : k - 1]) corners.push_back(p);
+            p.x += STEP_X[code[k]];
+            p.y += STEP_Y[code[k]];
+        }
+        if (epsilon > 0) simplifyClosedPolygon(corners, epsilon, contours.polygon);
+        else contours.polygon.insert(contours.polygon.end(), corners.begin(), corners.end());
+        contours.polygonOffset.push_back(static_cast<uint32_t>(contours.polygon.size()));
+    }
+}
+
+template <typename Label>
+static void extractContoursKernel(const cv::Mat& markers, RegionContours& contours) {
+    std::vector<uint8_t> seen;
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        int previous = 0;
+        for (int x = 0; x < markers.cols; ++x) {
+            const int label = static_cast<int>(row[x]);
+            if (label <= 0 || label == previous) continue;
+            previous = label;
+            if (static_cast<size_t>(label) >= seen.size()) seen.resize(static_cast<size_t>(label) + 1, 0);
+            if (seen[label]) continue;
+            seen[label] = 1;
+            contours.labels.push_back(label);
+            contours.starts.emplace_back(x, y);
+            traceOuterBoundary<Label>(markers, x, y, contours.chain);
+            contours.chainOffset.push_back(static_cast<uint32_t>(contours.chain.size()));
+        }
+    }
+}
+
+void extractRegionContours(const cv::Mat& markers, RegionContours& contours, double epsilon) {
+    contours = RegionContours();
+    contours.rows = markers.rows;
+    contours.cols = markers.cols;
+    contours.chainOffset.assign(1, 0);
+    if (markers.depth() == CV_16U) extractContoursKernel<uint16_t>(markers, contours);
+    else extractContoursKernel<int>(markers, contours);
+    buildPolygons(contours, epsilon);
+}
+
+// ---------------------- 序列化 ----------------------
+// 容器格式（小端）："RCTR" | 版本 u8 | 保留 u8 x3 | rows u32 | cols u32 | 轮廓数 varint
+//   每条轮廓：标签与上一条之差 zigzag varint | 起点像素下标与上一条之差 zigzag varint | 周长 varint
+//   之后为全部链码，每步 2 位，低位在前，末字节补 0
+bool encodeRegionContours(const RegionContours& contours, std::vector<uint8_t>& out) {
+    out.clear();
+    if (contours.chainOffset.size() != contours.size() + 1) return false;
+    out.insert(out.end(), { 'R', 'C', 'T', 'R' });
+    out.push_back(CONTOUR_CODEC_VERSION);
+    out.insert(out.end(), { 0, 0, 0 });
+    putU32(out, static_cast<uint32_t>(contours.rows));
+    putU32(out, static_cast<uint32_t>(contours.cols));
+    putVarint(out, contours.size());
+    int64_t previousLabel = 0, previousStart = 0;
+    for (size_t i = 0; i < contours.size(); ++i) {
+        const int64_t start = static_cast<int64_t>(contours.starts[i].y) * contours.cols + contours.starts[i].x;
+        putVarint(out, zigzagEncode(contours.labels[i] - previousLabel));
+        putVarint(out, zigzagEncode(start - previousStart));   // 起点不保证递增
+        putVarint(out, static_cast<uint64_t>(contours.perimeter(i)));
+        previousLabel = contours.labels[i];
+        previousStart = start;
+    }
+    const size_t steps = contours.chain.size();
+    const size_t base = out.size();
+    out.resize(base + (steps + 3) / 4, 0);
+    for (size_t k = 0; k < steps; ++k) out[base + k / 4] |= static_cast<uint8_t>(contours.chain[k] << (2 * (k % 4)));
+    return true;
+}
+
+bool decodeRegionContours(const uint8_t* data, size_t size, RegionContours& contours, double epsilon) {
+    contours = RegionContours();
+    size_t pos = 0;
+    if (size < 16 || std::memcmp(data, "RCTR", 4) != 0 || data[4] != CONTOUR_CODEC_VERSION) return false;
+    pos = 8;
+    uint32_t rows = 0, cols = 0;
+    uint64_t count = 0;
+    if (!getU32(data, size, pos, rows) || !getU32(data, size, pos, cols) || !getVarint(data, size, pos, count)) return false;
+    if (rows > static_cast<uint32_t>(INT_MAX) || cols > static_cast<uint32_t>(INT_MAX)) return false;
+    const uint64_t pixels = static_cast<uint64_t>(rows) * cols;
+    // 每条轮廓至少占 3 个字节，数量不可能超过剩余字节数
+    if (count > (size - pos) / 3 || count > pixels) return false;
+    contours.rows = static_cast<int>(rows);
+    contours.cols = static_cast<int>(cols);
+    contours.chainOffset.assign(1, 0);
+
+    int64_t label = 0, start = 0;
+    uint64_t steps = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t labelDelta = 0, startDelta = 0, perimeter = 0;
+        if (!getVarint(data, size, pos, labelDelta) || !getVarint(data, size, pos, startDelta) ||
+            !getVarint(data, size, pos, perimeter)) return false;
+        if (labelDelta > 2 * static_cast<uint64_t>(INT_MAX) || startDelta >= 2 * pixels) return false;
+        label += zigzagDecode(labelDelta);
+        start += zigzagDecode(startDelta);
+        steps += perimeter;
+        // 单条周长不超过 4 * 像素数；起点须在图内
+        if (label <= 0 || label > INT_MAX || start < 0 || static_cast<uint64_t>(start) >= pixels || perimeter < 4 || perimeter > 4 * pixels) return false;
+        if (steps > UINT32_MAX) return false;
+        contours.labels.push_back(static_cast<int>(label));
+        contours.starts.emplace_back(static_cast<int>(start % cols), static_cast<int>(start / cols));
+        contours.chainOffset.push_back(static_cast<uint32_t>(steps));
+    }
+    if (size - pos < (steps + 3) / 4) return false;
+    contours.chain.resize(steps);
+    for (size_t k = 0; k < steps; ++k) contours.chain[k] = (data[pos + k / 4] >> (2 * (k % 4))) & 3;
+
+    // 每条链码须闭合
+    for (size_t i = 0; i < contours.size(); ++i) {
+        int64_t dx = 0, dy = 0;
+        for (uint32_t k = contours.chainOffset[i]; k < contours.chainOffset[i + 1]; ++k) {
+            dx += STEP_X[contours.chain[k]];
+            dy += STEP_Y[contours.chain[k]];
+        }
+        if (dx != 0 || dy != 0) return false;
+    }
+    buildPolygons(contours, epsilon);
+    return true;
+}
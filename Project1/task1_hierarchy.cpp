@@ -0,0 +1,211 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 层次分水岭（合并树 / 超度量轮廓图）
+//     1. 细粒度淹没一次，相邻两区域的边权取边界上像素对 max(地形高度) 的最小值（鞍点高度）；
+//     2. 边按 (鞍点高度, 标签) 升序做 Kruskal 合并，得到 n - 1 次合并的序列（合并树）；
+//        合并时遍历较小分量的成员，把跨到另一分量的细边记为"在第 t 次合并时消失"；
+//     3. 要 k 个区域时只需应用前 n - k 次合并：并查集求出细标签 -> 粗标签查找表，
+//        标签图逐像素查表一遍，面积/质心按细区域求和，邻接图由细边经查找表收缩后去重得到。
+//     邻接规则与 buildRegionAdjacencyCSR 相同（8 邻域，扫描右、下、右下、左下）。
+// ====================================================
+
+template <typename Label, typename Visit>
+static void scanEdgeAltitudes(const cv::Mat& markers, const cv::Mat& relief, Visit&& visit) {
+    const int cols = markers.cols;
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        const Label* next = y + 1 < markers.rows ? markers.ptr<Label>(y + 1) : nullptr;
+        const cv::Vec3b* h = relief.ptr<cv::Vec3b>(y);
+        const cv::Vec3b* hNext = next ? relief.ptr<cv::Vec3b>(y + 1) : nullptr;
+        for (int x = 0; x < cols; ++x) {
+            int a = row[x];
+            if (a <= 0) continue;
+            if (x + 1 < cols && row[x + 1] > 0 && row[x + 1] != a) visit(a, row[x + 1], std::max(h[x][0], h[x + 1][0]));
+            if (!next) continue;
+            if (next[x] > 0 && next[x] != a) visit(a, next[x], std::max(h[x][0], hNext[x][0]));
+            if (x + 1 < cols && next[x + 1] > 0 && next[x + 1] != a) visit(a, next[x + 1], std::max(h[x][0], hNext[x + 1][0]));
+            if (x > 0 && next[x - 1] > 0 && next[x - 1] != a) visit(a, next[x - 1], std::max(h[x][0], hNext[x - 1][0]));
+        }
+    }
+}
+
+template <typename Label, typename Visit>
+static void scanBoundaryPairs(const cv::Mat& markers, Visit&& visit) {
+    const int cols = markers.cols;
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        const Label* next = y + 1 < markers.rows ? markers.ptr<Label>(y + 1) : nullptr;
+        for (int x = 0; x < cols; ++x) {
+            int a = row[x];
+            if (a <= 0) continue;
+            if (x + 1 < cols && row[x + 1] > 0 && row[x + 1] != a) visit(a, row[x + 1], y, x);
+            if (next && next[x] > 0 && next[x] != a) visit(a, next[x], y, x);
+        }
+    }
+}
+
+template <typename Src, typename Dst>
+static void remapLabels(const cv::Mat& in, const std::vector<int>& lut, cv::Mat& out) {
+    for (int y = 0; y < in.rows; ++y) {
+        const Src* src = in.ptr<Src>(y);
+        Dst* dst = out.ptr<Dst>(y);
+        for (int x = 0; x < in.cols; ++x) {
+            int l = src[x];
+            dst[x] = static_cast<Dst>(l > 0 ? lut[l] : 0);
+        }
+    }
+}
+
+int WatershedHierarchy::find(int v) {
+    while (parent_[v] != v) {
+        parent_[v] = parent_[parent_[v]];
+        v = parent_[v];
+    }
+    return v;
+}
+
+int WatershedHierarchy::slotOf(int a, int b) const {
+    const int* begin = graph_.neighbors.data() + graph_.offsets[a];
+    const int* end = graph_.neighbors.data() + graph_.offsets[a + 1];
+    return static_cast<int>(std::lower_bound(begin, end, b) - graph_.neighbors.data());
+}
+
+bool WatershedHierarchy::build(const SegmentationContext& ctx) {
+    const cv::Mat& markers = ctx.markers();
+    const RegionAdjacencyCSR& graph = ctx.adjacency();
+    if (markers.empty() || ctx.relief().size() != markers.size() || graph.maxLabel + 1 != static_cast<int>(ctx.areas().size())) {
+        std::cerr << " 层次分水岭：分割上下文须先完成地形图、淹没、邻接图与区域统计。" << std::endl;
+        return false;
+    }
+    fine_ = markers.clone();   // 上下文的 markers 缓冲会被下一帧改写
+    graph_ = graph;
+    areas_ = ctx.areas();
+    sumX_ = ctx.sumX();
+    sumY_ = ctx.sumY();
+    const int n = graph_.maxLabel + 1;
+    fineCount_ = 0;
+    for (int l = 1; l < n; ++l) fineCount_ += graph_.present[l] != 0;
+
+    // 鞍点高度：沿边界连续的同一条边只查一次 CSR 下标
+    edgeAltitude_.assign(graph_.neighbors.size(), INT_MAX);
+    int lastA = -1, lastB = -1, lastSlot = 0;
+    auto visitAltitude = [&](int a, int b, int h) {
+        if (a > b) std::swap(a, b);
+        if (a != lastA || b != lastB) {
+            lastA = a;
+            lastB = b;
+            lastSlot = slotOf(a, b);
+        }
+        edgeAltitude_[lastSlot] = std::min(edgeAltitude_[lastSlot], h);
+        };
+    if (fine_.depth() == CV_16U) scanEdgeAltitudes<uint16_t>(fine_, ctx.relief(), visitAltitude);
+    else scanEdgeAltitudes<int>(fine_, ctx.relief(), visitAltitude);
+
+    // Kruskal：只取 a < b 的一侧，CSR 下标本身按 (a, b) 升序，作为同高度时的次序
+    std::vector<int> owner(graph_.neighbors.size());
+    std::vector<int> order;
+    for (int a = 1; a < n; ++a) {
+        for (int j = graph_.offsets[a]; j < graph_.offsets[a + 1]; ++j) {
+            owner[j] = a;
+            if (a < graph_.neighbors[j]) order.push_back(j);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](int i, int j) {
+        return edgeAltitude_[i] != edgeAltitude_[j] ? edgeAltitude_[i] < edgeAltitude_[j] : i < j;
+        });
+
+    parent_.resize(n);
+    for (int v = 0; v < n; ++v) parent_[v] = v;
+    std::vector<int> size(n, 1), next(n, -1), tail(n);
+    for (int v = 0; v < n; ++v) tail[v] = v;
+    edgeLevel_.assign(graph_.neighbors.size(), -1);
+    merges_.clear();
+    for (int j : order) {
+        const int a = owner[j], b = graph_.neighbors[j];
+        int ra = find(a), rb = find(b);
+        if (ra == rb) continue;
+        if (size[ra] > size[rb]) std::swap(ra, rb);
+        const int t = static_cast<int>(merges_.size());
+        for (int v = ra; v != -1; v = next[v]) {
+            for (int k = graph_.offsets[v]; k < graph_.offsets[v + 1]; ++k) {
+                const int u = graph_.neighbors[k];
+                if (find(u) == rb) edgeLevel_[v < u ? k : slotOf(u, v)] = t;
+            }
+        }
+        parent_[ra] = rb;
+        size[rb] += size[ra];
+        next[tail[rb]] = ra;
+        tail[rb] = tail[ra];
+        merges_.push_back({ a, b, edgeAltitude_[j] });
+    }
+    return true;
+}
+
+void WatershedHierarchy::extract(int regionCount, HierarchyLevel& level) {
+    const int n = graph_.maxLabel + 1;
+    const int mergeCount = std::max(0, std::min(fineCount_ - regionCount, static_cast<int>(merges_.size())));
+    for (int v = 0; v < n; ++v) parent_[v] = v;
+    for (int i = 0; i < mergeCount; ++i) {
+        int ra = find(merges_[i].a), rb = find(merges_[i].b);
+        parent_[std::max(ra, rb)] = std::min(ra, rb);
+    }
+
+    // 粗标签按分量内最小细标签的次序编号
+    rootId_.assign(n, 0);
+    lut_.assign(n, 0);
+    int count = 0;
+    for (int l = 1; l < n; ++l) {
+        if (!graph_.present[l]) continue;
+        int r = find(l);
+        if (rootId_[r] == 0) rootId_[r] = ++count;
+        lut_[l] = rootId_[r];
+    }
+
+    level.regionCount = count;
+    level.labels.create(fine_.size(), selectLabelDepth(count));
+    const bool narrowIn = fine_.depth() == CV_16U, narrowOut = level.labels.depth() == CV_16U;
+    if (narrowIn && narrowOut) remapLabels<uint16_t, uint16_t>(fine_, lut_, level.labels);
+    else if (narrowIn) remapLabels<uint16_t, int>(fine_, lut_, level.labels);
+    else if (narrowOut) remapLabels<int, uint16_t>(fine_, lut_, level.labels);
+    else remapLabels<int, int>(fine_, lut_, level.labels);
+
+    level.areas.assign(count + 1, 0);
+    level.sumX.assign(count + 1, 0);
+    level.sumY.assign(count + 1, 0);
+    for (int l = 1; l < n; ++l) {
+        level.areas[lut_[l]] += areas_[l];
+        level.sumX[lut_[l]] += sumX_[l];
+        level.sumY[lut_[l]] += sumY_[l];
+    }
+    level.areas[0] = level.sumX[0] = level.sumY[0] = 0;
+
+    edgeScratch_.clear();
+    for (int a = 1; a < n; ++a) {
+        for (int j = graph_.offsets[a]; j < graph_.offsets[a + 1]; ++j) {
+            const int b = graph_.neighbors[j];
+            if (b <= a) continue;
+            const int ca = lut_[a], cb = lut_[b];
+            if (ca == cb) continue;
+            edgeScratch_.push_back(ca < cb ? (static_cast<uint64_t>(ca) << 32 | static_cast<uint32_t>(cb))
+                : (static_cast<uint64_t>(cb) << 32 | static_cast<uint32_t>(ca)));
+        }
+    }
+    finishRegionAdjacencyCSR(edgeScratch_, count, level.graph);
+    level.graph.present.assign(count + 1, 1);
+    level.graph.present[0] = 0;
+}
+
+// 边界像素（与右邻或下邻标签不同）取其边界在第几次合并后消失（1 起计），非边界为 0；
+// 阈值 saliency > fineRegionCount - k 即为 k 个区域时的边界
+void WatershedHierarchy::saliencyMap(cv::Mat& out) const {
+    out.create(fine_.size(), CV_32S);
+    out.setTo(cv::Scalar(0));
+    auto visit = [&](int a, int b, int y, int x) {
+        int slot = a < b ? slotOf(a, b) : slotOf(b, a);
+        int& s = out.at<int>(y, x);
+        s = std::max(s, edgeLevel_[slot] + 1);
+        };
+    if (fine_.depth() == CV_16U) scanBoundaryPairs<uint16_t>(fine_, visit);
+    else scanBoundaryPairs<int>(fine_, visit);
+}
@@ -0,0 +1,333 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 交互式标记（watershed/watershed.cpp 的新版）
+//     原程序每画一笔都对整幅图像重跑 cvWatershed 并重绘整张叠加图。这里保留淹没状态：
+//     每个像素记下标签与淹没高度（从标记出发的路径上最大边权的最小值），
+//     1. 新增标记像素只会降低高度：从这些像素出发做瓶颈 Dijkstra（256 级桶队列），
+//        邻居的高度严格下降才改标签并继续扩展，没有像素再变化时自然停止；
+//     2. 擦除标记像素只会抬高该标签区域内的高度：整块清空，区域外一圈像素按原高度、
+//        剩余的同标签标记按 0 重新入队，只在清空的区域内重新淹没；
+//     3. 只重绘标签发生变化的外接矩形（向左上多扩 1 像素，边界由右、下邻判断）。
+//     单笔耗时与受影响的区域面积成正比，与图像大小无关。
+// ====================================================
+
+static const uint16_t LEVEL_UNREACHED = 0xFFFF;
+
+// 与 cv::watershed 相同的边权：两像素各通道差的最大值
+static inline int reliefWeight(const uchar* a, const uchar* b) {
+    return std::max(std::abs(a[0] - b[0]), std::max(std::abs(a[1] - b[1]), std::abs(a[2] - b[2])));
+}
+
+static inline void includePoint(InteractiveWatershed::Box& box, int x, int y) {
+    box.x0 = std::min(box.x0, x);
+    box.y0 = std::min(box.y0, y);
+    box.x1 = std::max(box.x1, x);
+    box.y1 = std::max(box.y1, y);
+}
+
+void InteractiveWatershed::reset(const cv::Mat& src, const std::vector<cv::Point>& seeds) {
+    relief_ = computeWatershedRelief(src);
+    cv::Mat gray;
+    cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    cv::cvtColor(gray, gray_, cv::COLOR_GRAY2BGR);
+    markers_ = cv::Mat::zeros(src.size(), CV_32S);
+    labels_.create(src.size(), CV_32S);
+    levels_.create(src.size(), CV_16U);
+    overlay_.create(src.size(), CV_8UC3);
+    bounds_.clear();
+    palette_.clear();
+    rng_ = cv::RNG(12345);
+    nextLabel_ = 1;
+    // 种子与 flood 相同：按图像面积与种子数确定半径的实心圆
+    const int radius = std::max(3, static_cast<int>(std::sqrt((src.cols * src.rows) / (float)std::max<size_t>(seeds.size(), 1)) * 0.001));
+    for (const cv::Point& seed : seeds) cv::circle(markers_, seed, radius, cv::Scalar(newLabel()), -1);
+    refloodAll();
+}
+
+int InteractiveWatershed::newLabel() {
+    palette_.resize(nextLabel_ + 1);
+    palette_[nextLabel_] = cv::Vec3b(static_cast<uchar>(rng_.uniform(0, 180) + 50), static_cast<uchar>(rng_.uniform(0, 180) + 50),
+        static_cast<uchar>(rng_.uniform(0, 180) + 50));
+    bounds_.resize(nextLabel_ + 1);
+    return nextLabel_++;
+}
+
+void InteractiveWatershed::refloodAll() {
+    labels_.setTo(cv::Scalar(0));
+    levels_.setTo(cv::Scalar(LEVEL_UNREACHED));
+    std::fill(bounds_.begin(), bounds_.end(), Box());
+    const int cols = markers_.cols;
+    int* lab = labels_.ptr<int>();
+    uint16_t* lv = levels_.ptr<uint16_t>();
+    for (int y = 0; y < markers_.rows; ++y) {
+        const int* m = markers_.ptr<int>(y);
+        for (int x = 0; x < cols; ++x) {
+            if (m[x] <= 0) continue;
+            const int p = y * cols + x;
+            lab[p] = m[x];
+            lv[p] = 0;
+            includePoint(bounds_[m[x]], x, y);
+            push(p, 0);
+        }
+    }
+    Box dirty;
+    int64_t relabeled = 0;
+    propagate(dirty, relabeled);
+    repaint(cv::Rect(0, 0, markers_.cols, markers_.rows));
+}
+
+// 桶队列按高度升序弹出；入队键 max(高度, 边权) 不小于当前桶，同一桶内先进先出。
+// 出队时高度已被更低的键改写的是过期项，跳过
+void InteractiveWatershed::propagate(Box& dirty, int64_t& relabeled) {
+    const int rows = labels_.rows, cols = labels_.cols;
+    int* lab = labels_.ptr<int>();
+    uint16_t* lv = levels_.ptr<uint16_t>();
+    const uchar* relief = relief_.ptr<uchar>();
+    for (int level = 0; level < 256; ++level) {
+        std::vector<int>& bucket = buckets_[level];
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            const int p = bucket[i];
+            if (lv[p] != level) continue;
+            const int x = p % cols, y = p / cols;
+            auto relax = [&](int q, int qx, int qy) {
+                const int key = std::max(level, reliefWeight(relief + 3 * p, relief + 3 * q));
+                if (key >= lv[q]) return;
+                lv[q] = static_cast<uint16_t>(key);
+                if (lab[q] != lab[p]) {
+                    lab[q] = lab[p];
+                    includePoint(dirty, qx, qy);
+                    includePoint(bounds_[lab[p]], qx, qy);
+                    ++relabeled;
+                }
+                buckets_[key].push_back(q);
+            };
+            if (x > 0) relax(p - 1, x - 1, y);
+            if (x + 1 < cols) relax(p + 1, x + 1, y);
+            if (y > 0) relax(p - cols, x, y - 1);
+            if (y + 1 < rows) relax(p + cols, x, y + 1);
+        }
+        bucket.clear();
+    }
+}
+
+void InteractiveWatershed::stroke(cv::Point from, cv::Point to, int label, int thickness, StrokeUpdate& update) {
+    update = StrokeUpdate();
+    auto start = std::chrono::high_resolution_clock::now();
+    const int rows = markers_.rows, cols = markers_.cols;
+    int* lab = labels_.ptr<int>();
+    uint16_t* lv = levels_.ptr<uint16_t>();
+
+    // 笔画先画进外接矩形大小的掩码，再逐像素比较标记
+    const int r = thickness / 2 + 1;
+    cv::Rect box = cv::Rect(cv::Point(std::min(from.x, to.x) - r, std::min(from.y, to.y) - r),
+        cv::Point(std::max(from.x, to.x) + r + 1, std::max(from.y, to.y) + r + 1)) & cv::Rect(0, 0, cols, rows);
+    if (box.empty()) return;
+    strokeMask_ = cv::Mat::zeros(box.size(), CV_8U);
+    cv::line(strokeMask_, from - box.tl(), to - box.tl(), cv::Scalar(255), thickness, cv::LINE_8);
+
+    // 被覆盖或擦掉的旧标记所属区域整块清空
+    erased_.clear();
+    for (int y = 0; y < box.height; ++y) {
+        const uchar* s = strokeMask_.ptr<uchar>(y);
+        const int* m = markers_.ptr<int>(box.y + y) + box.x;
+        for (int x = 0; x < box.width; ++x) {
+            if (s[x] && m[x] > 0 && m[x] != label) erased_.push_back(m[x]);
+        }
+    }
+    std::sort(erased_.begin(), erased_.end());
+    erased_.erase(std::unique(erased_.begin(), erased_.end()), erased_.end());
+    update.erasedLabels = static_cast<int>(erased_.size());
+
+    Box dirty;
+    rim_.clear();
+    for (int X : erased_) {
+        const Box area = bounds_[X];
+        for (int y = area.y0; y <= area.y1; ++y) {
+            for (int x = area.x0; x <= area.x1; ++x) {
+                const int p = y * cols + x;
+                if (lab[p] != X) continue;
+                lab[p] = 0;
+                lv[p] = LEVEL_UNREACHED;
+                rim_.push_back(p);
+            }
+        }
+        if (!area.empty()) {
+            includePoint(dirty, area.x0, area.y0);
+            includePoint(dirty, area.x1, area.y1);
+        }
+        bounds_[X] = Box();
+    }
+
+    // 更新标记；新标记像素高度为 0
+    for (int y = 0; y < box.height; ++y) {
+        const uchar* s = strokeMask_.ptr<uchar>(y);
+        int* m = markers_.ptr<int>(box.y + y) + box.x;
+        for (int x = 0; x < box.width; ++x) {
+            if (!s[x] || m[x] == label) continue;
+            m[x] = label;
+            if (label == 0) continue;
+            const int p = (box.y + y) * cols + box.x + x;
+            if (lab[p] != label) {
+                includePoint(dirty, box.x + x, box.y + y);
+                ++update.relabeled;
+            }
+            lab[p] = label;
+            lv[p] = 0;
+            includePoint(bounds_[label], box.x + x, box.y + y);
+            push(p, 0);
+        }
+    }
+
+    // 清空区域：剩余的同标签标记按 0、区域外一圈已定像素按原高度入队
+    for (int p : rim_) {
+        if (lab[p] != 0) continue;
+        const int x = p % cols, y = p / cols;
+        const int X = markers_.ptr<int>(y)[x];
+        if (X > 0) {
+            lab[p] = X;
+            lv[p] = 0;
+            includePoint(bounds_[X], x, y);
+            push(p, 0);
+            continue;
+        }
+        const int neighbors[4] = { x > 0 ? p - 1 : -1, x + 1 < cols ? p + 1 : -1, y > 0 ? p - cols : -1, y + 1 < rows ? p + cols : -1 };
+        for (int q : neighbors) {
+            if (q >= 0 && lab[q] > 0) push(q, lv[q]);
+        }
+    }
+    propagate(dirty, update.relabeled);
+    update.floodMs = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    if (!dirty.empty()) {
+        update.dirty = cv::Rect(cv::Point(dirty.x0 - 1, dirty.y0 - 1), cv::Point(dirty.x1 + 1, dirty.y1 + 1)) & cv::Rect(0, 0, cols, rows);
+        repaint(update.dirty);
+    }
+    update.paintMs = elapsedMs(start);
+}
+
+void InteractiveWatershed::repaint(cv::Rect rect) {
+    const int rows = labels_.rows, cols = labels_.cols;
+    for (int y = rect.y; y < rect.y + rect.height; ++y) {
+        const int* row = labels_.ptr<int>(y);
+        const int* next = y + 1 < rows ? labels_.ptr<int>(y + 1) : nullptr;
+        const cv::Vec3b* g = gray_.ptr<cv::Vec3b>(y);
+        cv::Vec3b* out = overlay_.ptr<cv::Vec3b>(y);
+        for (int x = rect.x; x < rect.x + rect.width; ++x) {
+            const int l = row[x];
+            if ((x + 1 < cols && row[x + 1] != l) || (next && next[x] != l)) out[x] = cv::Vec3b(255, 255, 255);
+            else if (l <= 0) out[x] = g[x];
+            else {
+                const cv::Vec3b& c = palette_[l];
+                out[x] = cv::Vec3b(static_cast<uchar>((c[0] + g[x][0] + 1) / 2), static_cast<uchar>((c[1] + g[x][1] + 1) / 2),
+                    static_cast<uchar>((c[2] + g[x][2] + 1) / 2));
+            }
+        }
+    }
+}
+
+// ---------- 交互界面 ----------
+struct InteractiveSession {
+    InteractiveWatershed* tool = nullptr;
+    const cv::Mat* src = nullptr;
+    cv::Mat view;                   // 原图上叠加白色笔画
+    cv::Point prev = cv::Point(-1, -1);
+    int label = 0;
+    int thickness = 5;
+    int segments = 0;
+    double totalMs = 0;
+    double worstMs = 0;
+};
+
+// 左键拖动画新标记（每次按下一个新标签），右键拖动擦除；每段移动后增量重淹没
+static void onInteractiveMouse(int event, int x, int y, int flags, void* param) {
+    InteractiveSession& s = *static_cast<InteractiveSession*>(param);
+    const cv::Point pt(x, y);
+    if (event == cv::EVENT_LBUTTONDOWN || event == cv::EVENT_RBUTTONDOWN) {
+        s.label = event == cv::EVENT_LBUTTONDOWN ? s.tool->newLabel() : 0;
+        s.prev = pt;
+        s.segments = 0;
+        s.totalMs = s.worstMs = 0;
+        return;
+    }
+    if (event == cv::EVENT_LBUTTONUP || event == cv::EVENT_RBUTTONUP) {
+        if (s.segments > 0) {
+            std::cout << (s.label ? " 标记" : " 擦除") << "：" << s.segments << " 段，平均 " << s.totalMs / s.segments
+                << " ms，最长 " << s.worstMs << " ms" << std::endl;
+        }
+        s.prev = cv::Point(-1, -1);
+        return;
+    }
+    if (event != cv::EVENT_MOUSEMOVE || s.prev.x < 0 || !(flags & (cv::EVENT_FLAG_LBUTTON | cv::EVENT_FLAG_RBUTTON))) return;
+
+    StrokeUpdate update;
+    s.tool->stroke(s.prev, pt, s.label, s.thickness, update);
+    const double ms = update.floodMs + update.paintMs;
+    s.totalMs += ms;
+    s.worstMs = std::max(s.worstMs, ms);
+    ++s.segments;
+
+    if (s.label) cv::line(s.view, s.prev, pt, cv::Scalar::all(255), s.thickness, cv::LINE_8);
+    else {
+        cv::Mat mask = cv::Mat::zeros(s.view.size(), CV_8U);
+        cv::line(mask, s.prev, pt, cv::Scalar(255), s.thickness, cv::LINE_8);
+        s.src->copyTo(s.view, mask);
+    }
+    s.prev = pt;
+    cv::imshow("image", s.view);
+    cv::imshow("watershed transform", s.tool->overlay());
+}
+
+// 交互模式：Project1 --interactive [图像路径] [K] [笔刷粗细]
+//   K 为预先撒下的均匀种子数（0 表示与原程序一样从空白开始）；
+//   左键画标记、右键擦除，r 恢复初始种子，w 整图重淹没（对比耗时），ESC 退出
+int runInteractive(int argc, char** argv) {
+    std::string path = argc > 0 ? argv[0] : "wife.jpg";
+    int K = argc > 1 ? std::atoi(argv[1]) : 0;
+    int thickness = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (K < 0 || K > 10000 || thickness < 1) {
+        std::cerr << " 参数非法：K 应在 [0, 10000] 范围内，笔刷粗细不小于 1。" << std::endl;
+        return -1;
+    }
+    cv::Mat src = cv::imread(path);
+    if (src.empty()) {
+        std::cerr << " 无法读取图像文件 " << path << std::endl;
+        return -1;
+    }
+    std::vector<cv::Point> seeds = K > 0 ? generateSeedPoints(src.size(), K) : std::vector<cv::Point>();
+
+    InteractiveWatershed tool;
+    auto start = std::chrono::high_resolution_clock::now();
+    tool.reset(src, seeds);
+    std::cout << " " << src.cols << " x " << src.rows << "，初始种子 " << K << " 个，地形图与整图淹没 " << elapsedMs(start) << " ms" << std::endl;
+    std::cout << " 左键拖动 - 画新标记，右键拖动 - 擦除标记，r - 恢复初始种子，w - 整图重淹没，ESC - 退出" << std::endl;
+
+    InteractiveSession session;
+    session.tool = &tool;
+    session.src = &src;
+    session.view = src.clone();
+    session.thickness = thickness;
+    cv::namedWindow("image", 1);
+    cv::namedWindow("watershed transform", 1);
+    cv::imshow("image", session.view);
+    cv::imshow("watershed transform", tool.overlay());
+    cv::setMouseCallback("image", onInteractiveMouse, &session);
+
+    for (;;) {
+        const int c = cv::waitKey(0);
+        if (c == 27) break;
+        if (c == 'r') {
+            tool.reset(src, seeds);
+            src.copyTo(session.view);
+        }
+        if (c == 'w' || c == '\r') {
+            start = std::chrono::high_resolution_clock::now();
+            tool.refloodAll();
+            std::cout << " 整图重淹没与重绘 " << elapsedMs(start) << " ms" << std::endl;
+        }
+        cv::imshow("image", session.view);
+        cv::imshow("watershed transform", tool.overlay());
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 种子 Lloyd 细化（质心 Voronoi）
+//     每轮：
+//     1. 跳跃洪泛（JFA）求整幅图像的离散 Voronoi 图：种子像素先写入自身下标，
+//        步长从不小于 max(宽, 高) / 2 的 2 的幂逐轮减半到 1，每个像素在自身与 8 个 ±步长 邻居
+//        记录的种子中取最近者；最后再补一轮步长 1（JFA+1）修正大部分误差像素。
+//        每轮按行条带多线程，读上一轮、写另一块缓冲，轮与轮之间 join；
+//     2. 各条带分别累加每个单元的 x、y 坐标和与像素数，再按种子合并（并行归约），
+//        种子移到单元质心。
+//     单轮耗时约为 (log2(max(宽, 高)) + 2) 遍 9 邻域扫描 + 1 遍归约，与种子数无关。
+// ====================================================
+
+// 条带数不超过线程数，每条至少 16 行
+static int stripeCount(int rows, int threads) {
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, std::min(std::max(threads, 1), rows / 16));
+}
+
+// 一轮跳跃：[y0, y1) 行，从 in 读、向 out 写。缓冲中存种子下标 + 1，0 号是远在图外的哨兵，
+// 空像素与真实种子走同一条无分支的比较路径；候选按固定顺序比较，距离相同取先到者，结果与线程数无关。
+// 最后一轮写回种子下标
+static void jumpFloodRows(const cv::Mat& in, cv::Mat& out, const std::vector<int64_t>& sx, const std::vector<int64_t>& sy,
+    int step, int y0, int y1, bool last) {
+    const int rows = in.rows, cols = in.cols;
+    const int64_t* px = sx.data();
+    const int64_t* py = sy.data();
+    for (int y = y0; y < y1; ++y) {
+        // 三行候选的行指针在行首取好，越界行为空
+        const int* src[3];
+        for (int k = 0; k < 3; ++k) {
+            const int ny = y + (k - 1) * step;
+            src[k] = ny >= 0 && ny < rows ? in.ptr<int>(ny) : nullptr;
+        }
+        int* dst = out.ptr<int>(y);
+        for (int x = 0; x < cols; ++x) {
+            int best = 0;
+            int64_t bestDist = INT64_MAX;
+            auto consider = [&](int s) {
+                const int64_t ex = x - px[s], ey = y - py[s];
+                const int64_t d = ex * ex + ey * ey;
+                const bool closer = d < bestDist;
+                bestDist = closer ? d : bestDist;
+                best = closer ? s : best;
+            };
+            const bool left = x >= step, right = x + step < cols;
+            for (const int* row : src) {
+                if (!row) continue;
+                consider(row[x]);
+                if (left) consider(row[x - step]);
+                if (right) consider(row[x + step]);
+            }
+            dst[x] = last ? best - 1 : best;
+        }
+    }
+}
+
+void computeVoronoiJFA(const std::vector<cv::Point>& seeds, cv::Size size, cv::Mat& nearest, LloydScratch& scratch, int threads) {
+    const int rows = size.height, cols = size.width;
+    const int K = static_cast<int>(seeds.size());
+    std::vector<int64_t> sx(K + 1, -(int64_t(1) << 29)), sy(K + 1, -(int64_t(1) << 29));
+    for (int i = 0; i < K; ++i) {
+        sx[i + 1] = std::clamp(seeds[i].x, 0, cols - 1);
+        sy[i + 1] = std::clamp(seeds[i].y, 0, rows - 1);
+    }
+    for (cv::Mat& m : scratch.site) m.create(rows, cols, CV_32S);
+    scratch.site[0].setTo(cv::Scalar(0));
+    // 重合的种子只保留下标最小者，其余单元为空
+    for (int i = K - 1; i >= 0; --i) scratch.site[0].at<int>(static_cast<int>(sy[i + 1]), static_cast<int>(sx[i + 1])) = i + 1;
+
+    std::vector<int> steps;
+    int step = 1;
+    while (step * 2 < std::max(rows, cols)) step *= 2;
+    for (; step >= 1; step /= 2) steps.push_back(step);
+    steps.push_back(1);
+
+    const int stripes = stripeCount(rows, threads);
+    int current = 0;
+    for (size_t k = 0; k < steps.size(); ++k) {
+        cv::Mat& in = scratch.site[current];
+        cv::Mat& out = scratch.site[current ^ 1];
+        const bool last = k + 1 == steps.size();
+        forEachStripe(stripes, [&](int i) {
+            jumpFloodRows(in, out, sx, sy, steps[k], static_cast<int>(static_cast<int64_t>(rows) * i / stripes),
+                static_cast<int>(static_cast<int64_t>(rows) * (i + 1) / stripes), last);
+        });
+        current ^= 1;
+    }
+    nearest = scratch.site[current];
+}
+
+double areaCoefficientOfVariation(const std::vector<int>& areas) {
+    double sum = 0, sumSquares = 0;
+    int n = 0;
+    for (int a : areas) {
+        if (a <= 0) continue;
+        sum += a;
+        sumSquares += static_cast<double>(a) * a;
+        ++n;
+    }
+    if (n == 0) return 0;
+    const double mean = sum / n;
+    return std::sqrt(std::max(0.0, sumSquares / n - mean * mean)) / mean;
+}
+
+void refineSeedsLloyd(std::vector<cv::Point>& seeds, cv::Size size, const LloydOptions& options, LloydScratch& scratch,
+    LloydStats* stats) {
+    const int K = static_cast<int>(seeds.size());
+    const int rows = size.height;
+    if (K == 0 || size.area() == 0) return;
+    const int stripes = stripeCount(rows, options.threads);
+    std::vector<int> areas(K);
+    cv::Mat nearest;
+
+    for (int it = 0; it < options.iterations; ++it) {
+        auto start = std::chrono::high_resolution_clock::now();
+        computeVoronoiJFA(seeds, size, nearest, scratch, options.threads);
+        if (stats) stats->jfaMs += elapsedMs(start);
+
+        // 归约：条带 i 的部分和位于 partial[i * 3K ..]，依次为 x 和、y 和、像素数
+        start = std::chrono::high_resolution_clock::now();
+        scratch.partial.assign(static_cast<size_t>(stripes) * 3 * K, 0);
+        forEachStripe(stripes, [&](int i) {
+            int64_t* sumX = scratch.partial.data() + static_cast<size_t>(i) * 3 * K;
+            int64_t* sumY = sumX + K;
+            int64_t* count = sumY + K;
+            const int y0 = static_cast<int>(static_cast<int64_t>(rows) * i / stripes);
+            const int y1 = static_cast<int>(static_cast<int64_t>(rows) * (i + 1) / stripes);
+            for (int y = y0; y < y1; ++y) {
+                const int* row = nearest.ptr<int>(y);
+                for (int x = 0; x < nearest.cols; ++x) {
+                    const int s = row[x];
+                    sumX[s] += x;
+                    sumY[s] += y;
+                    ++count[s];
+                }
+            }
+        });
+        for (int s = 0; s < K; ++s) {
+            int64_t sumX = 0, sumY = 0, count = 0;
+            for (int i = 0; i < stripes; ++i) {
+                const int64_t* part = scratch.partial.data() + static_cast<size_t>(i) * 3 * K;
+                sumX += part[s];
+                sumY += part[K + s];
+                count += part[2 * K + s];
+            }
+            areas[s] = static_cast<int>(count);
+            if (count == 0) continue;
+            seeds[s] = cv::Point(static_cast<int>((sumX + count / 2) / count), static_cast<int>((sumY + count / 2) / count));
+        }
+        if (stats) {
+            stats->reduceMs += elapsedMs(start);
+            stats->cellAreaCv.push_back(areaCoefficientOfVariation(areas));
+        }
+    }
+}
@@ -0,0 +1,142 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 多分辨率（金字塔）分水岭
+//     1. 地形图按 f = 2^levels 倍面积平均下采样，种子同比缩放，在粗分辨率上淹没并修复边界；
+//     2. 粗边界向两侧膨胀 band 个粗像素得到待细化条带，落入别的区域的种子（缩放后与其他种子重合）
+//        周围也并入条带；
+//     3. 粗标签按块上采样回原尺寸，条带内清零、重新盖上原分辨率种子，在原分辨率地形图上再淹没一次。
+//     条带外的像素已有标签，watershed 只在条带内排队，耗时与条带面积成正比。
+// ====================================================
+
+// 与 computeMarkersFromRelief 相同的种子半径
+static int seedRadius(cv::Size size, size_t seedCount) {
+    return std::max(3, static_cast<int>(std::sqrt((size.width * size.height) / (float)seedCount) * 0.001));
+}
+
+cv::Mat computeMarkersPyramidFromRelief(const std::vector<cv::Point>& seeds, const cv::Mat& relief,
+    const PyramidOptions& options, PyramidStats* stats) {
+    const int f = 1 << std::max(0, options.levels);
+    const int band = std::max(1, options.band);
+    const int rows = relief.rows, cols = relief.cols;
+    const cv::Size coarseSize((cols + f - 1) / f, (rows + f - 1) / f);
+    const int radius = seedRadius(relief.size(), seeds.size());
+
+    // 粗分辨率淹没
+    auto start = std::chrono::high_resolution_clock::now();
+    cv::Mat coarseRelief;
+    cv::resize(relief, coarseRelief, coarseSize, 0, 0, cv::INTER_AREA);
+    cv::Mat coarse = cv::Mat::zeros(coarseSize, CV_32S);
+    const int coarseRadius = std::max(1, radius / f);
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        cv::circle(coarse, cv::Point(seeds[i].x / f, seeds[i].y / f), coarseRadius, cv::Scalar(static_cast<double>(i + 1)), -1);
+    }
+    cv::watershed(coarseRelief, coarse);
+    repairWatershedBoundaries(coarse);
+    if (stats) stats->coarseMs = elapsedMs(start);
+
+    // 条带：粗标签与右、下邻不同的像素两侧都算边界，再膨胀 band 个粗像素
+    start = std::chrono::high_resolution_clock::now();
+    cv::Mat edge = cv::Mat::zeros(coarseSize, CV_8U);
+    for (int y = 0; y < coarse.rows; ++y) {
+        const int* row = coarse.ptr<int>(y);
+        const int* next = y + 1 < coarse.rows ? coarse.ptr<int>(y + 1) : nullptr;
+        uchar* e = edge.ptr<uchar>(y);
+        uchar* eNext = next ? edge.ptr<uchar>(y + 1) : nullptr;
+        for (int x = 0; x < coarse.cols; ++x) {
+            if (x + 1 < coarse.cols && row[x] != row[x + 1]) e[x] = e[x + 1] = 1;
+            if (next && row[x] != next[x]) e[x] = eNext[x] = 1;
+        }
+    }
+    cv::Mat mask;
+    cv::dilate(edge, mask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * band + 1, 2 * band + 1)));
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        cv::Point c(seeds[i].x / f, seeds[i].y / f);
+        if (coarse.at<int>(c) == static_cast<int>(i + 1)) continue;
+        cv::Rect box(c.x - 2 * band, c.y - 2 * band, 4 * band + 1, 4 * band + 1);
+        mask(box & cv::Rect(0, 0, coarse.cols, coarse.rows)).setTo(cv::Scalar(1));
+    }
+
+    // 按块上采样：条带内为 0，其余沿用粗标签
+    cv::Mat markers(rows, cols, CV_32S);
+    size_t bandPixels = 0;
+    for (int y = 0; y < rows; ++y) {
+        const int* c = coarse.ptr<int>(y / f);
+        const uchar* m = mask.ptr<uchar>(y / f);
+        int* dst = markers.ptr<int>(y);
+        for (int x = 0; x < cols; ++x) {
+            const int cx = x / f;
+            dst[x] = m[cx] ? 0 : c[cx];
+            bandPixels += m[cx] != 0;
+        }
+    }
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        cv::circle(markers, seeds[i], radius, cv::Scalar(static_cast<double>(i + 1)), -1);
+    }
+    if (stats) {
+        stats->upsampleMs = elapsedMs(start);
+        stats->bandFraction = static_cast<double>(bandPixels) / (static_cast<double>(rows) * cols);
+    }
+
+    // 原分辨率只细化条带
+    start = std::chrono::high_resolution_clock::now();
+    cv::watershed(relief, markers);
+    repairWatershedBoundaries(markers);
+    if (stats) stats->refineMs = elapsedMs(start);
+    return markers;
+}
+
+cv::Mat computeMarkersPyramid(const std::vector<cv::Point>& seeds, const cv::Mat& src, const PyramidOptions& options) {
+    return computeMarkersPyramidFromRelief(seeds, computeWatershedRelief(src), options, nullptr);
+}
+
+// JPEG 解码时直接按 1/2、1/4、1/8 缩小（IDCT 缩放，不先解出整图）；其他格式由 OpenCV 解码后缩小
+cv::Mat loadImageReduced(const std::string& path, int factor) {
+    int flags = cv::IMREAD_COLOR;
+    if (factor >= 8) flags = cv::IMREAD_REDUCED_COLOR_8;
+    else if (factor >= 4) flags = cv::IMREAD_REDUCED_COLOR_4;
+    else if (factor >= 2) flags = cv::IMREAD_REDUCED_COLOR_2;
+    return cv::imread(path, flags);
+}
+
+// 边界像素：与右邻或下邻标签不同
+static cv::Mat labelBoundaries(const cv::Mat& labels) {
+    cv::Mat boundary(labels.size(), CV_8U);
+    labelKernels().boundaryMask(labels, boundary);
+    return boundary;
+}
+
+// 像素一致率，以及容差 tolerance 像素内的边界精确率 / 召回率（以 reference 为准）
+LabelMapAgreement compareLabelMaps(const cv::Mat& reference, const cv::Mat& labels, int tolerance) {
+    LabelMapAgreement result;
+    if (reference.size() != labels.size() || reference.type() != CV_32S || labels.type() != CV_32S) return result;
+    size_t same = 0;
+    for (int y = 0; y < reference.rows; ++y) {
+        const int* a = reference.ptr<int>(y);
+        const int* b = labels.ptr<int>(y);
+        for (int x = 0; x < reference.cols; ++x) same += a[x] == b[x];
+    }
+    result.pixelAgreement = static_cast<double>(same) / reference.total();
+
+    cv::Mat refEdge = labelBoundaries(reference), edge = labelBoundaries(labels);
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * tolerance + 1, 2 * tolerance + 1));
+    cv::Mat refNear, near;
+    cv::dilate(refEdge, refNear, kernel);
+    cv::dilate(edge, near, kernel);
+    size_t refCount = 0, count = 0, recalled = 0, precise = 0;
+    for (int y = 0; y < reference.rows; ++y) {
+        const uchar* re = refEdge.ptr<uchar>(y);
+        const uchar* e = edge.ptr<uchar>(y);
+        const uchar* rn = refNear.ptr<uchar>(y);
+        const uchar* n = near.ptr<uchar>(y);
+        for (int x = 0; x < reference.cols; ++x) {
+            refCount += re[x];
+            count += e[x];
+            recalled += re[x] && n[x];
+            precise += e[x] && rn[x];
+        }
+    }
+    result.boundaryRecall = refCount ? static_cast<double>(recalled) / refCount : 1.0;
+    result.boundaryPrecision = count ? static_cast<double>(precise) / count : 1.0;
+    return result;
+}
@@ -0,0 +1,259 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 自适应哈夫曼树（FGK 式增量维护）
+//     结点按编号排成一条序列，维持"兄弟性质"：权值随编号非降，且兄弟编号相邻。
+//     由 Gallager 定理，满足兄弟性质的树就是当前权值下的一棵哈夫曼树。
+//     权值 ±1 时，沿叶子到根逐层处理：先把结点与同权值块的首/尾结点交换，再改权值，
+//     每层一次二分查找，单位更新代价 O(码长 · log n)。
+//     与经典 FGK 不同，这里不使用 0 权值 NYT 结点：新标签通过拆分最小权值叶子插入，
+//     叶子权值下限为 1，因此同权值块中永远不会出现自己的祖先或后代。
+//     单位步进代价随 |Δ| 线性增长；|Δ| · 码长超过叶子数时改为按新权值整棵重建（O(n log n)）。
+//     码字缓存：getCode 算出的码字存在叶子上，并沿路径给祖先打 CODE_BELOW 标记；
+//     交换结点时只清理两棵被移动的子树，且只下探带标记的分支，清理总量不超过此前 getCode 的重算量。
+// ====================================================
+
+void AdaptiveHuffmanTree::clear() {
+    nodes_.clear();
+    order_.clear();
+    leafOf_.clear();
+    firstNumber_ = 0;
+    root_ = -1;
+}
+
+int AdaptiveHuffmanTree::newNode(int64_t weight, int label) {
+    nodes_.push_back(Node{ weight, -1, -1, -1, label, 0 });
+    return static_cast<int>(nodes_.size()) - 1;
+}
+
+// 双队列法建树：出队顺序即编号顺序，天然满足兄弟性质
+void AdaptiveHuffmanTree::build(const std::map<int, int>& areaMap) {
+    clear();
+    std::vector<int> leaves;
+    leaves.reserve(areaMap.size());
+    for (const auto& [label, area] : areaMap) {
+        int leaf = newNode(std::max(area, 1), label);
+        leafOf_[label] = leaf;
+        leaves.push_back(leaf);
+    }
+    if (leaves.empty()) return;
+    std::stable_sort(leaves.begin(), leaves.end(), [&](int a, int b) { return nodes_[a].weight < nodes_[b].weight; });
+
+    std::vector<int> internals;
+    internals.reserve(leaves.size());
+    size_t leafHead = 0, internalHead = 0;
+    auto popSmallest = [&]() {
+        int node;
+        if (internalHead >= internals.size() ||
+            (leafHead < leaves.size() && nodes_[leaves[leafHead]].weight <= nodes_[internals[internalHead]].weight)) {
+            node = leaves[leafHead++];
+        }
+        else {
+            node = internals[internalHead++];
+        }
+        nodes_[node].number = static_cast<int>(order_.size());
+        order_.push_back(node);
+        return node;
+        };
+
+    size_t remaining = leaves.size();
+    while (remaining > 1) {
+        int a = popSmallest();
+        int b = popSmallest();
+        int parent = newNode(nodes_[a].weight + nodes_[b].weight, -1);
+        nodes_[parent].left = a;
+        nodes_[parent].right = b;
+        nodes_[a].parent = parent;
+        nodes_[b].parent = parent;
+        internals.push_back(parent);
+        remaining--;
+    }
+    root_ = popSmallest();
+}
+
+// 同权值块的首、尾编号（order_ 按权值非降，直接二分）
+int AdaptiveHuffmanTree::blockFirst(int64_t weight) const {
+    auto it = std::lower_bound(order_.begin(), order_.end(), weight,
+        [&](int node, int64_t w) { return nodes_[node].weight < w; });
+    return *it;
+}
+
+int AdaptiveHuffmanTree::blockLeader(int64_t weight) const {
+    auto it = std::upper_bound(order_.begin(), order_.end(), weight,
+        [&](int64_t w, int node) { return w < nodes_[node].weight; });
+    return *(it - 1);
+}
+
+// 子树位置改变后，其中叶子的码字缓存失效；不带 CODE_BELOW 的分支里没有缓存，直接跳过
+void AdaptiveHuffmanTree::invalidateCodes(int node) {
+    if (!(nodes_[node].cache & CODE_BELOW)) return;
+    std::vector<int> stack(1, node);
+    while (!stack.empty()) {
+        const Node& n = nodes_[stack.back()];
+        stack.pop_back();
+        if (!(n.cache & CODE_BELOW)) continue;
+        n.cache = 0;
+        if (n.left != -1) {
+            stack.push_back(n.left);
+            stack.push_back(n.right);
+        }
+    }
+}
+
+// 交换两个互不为祖先的结点在树中的位置及编号
+void AdaptiveHuffmanTree::swapNodes(int a, int b) {
+    invalidateCodes(a);
+    invalidateCodes(b);
+    Node& na = nodes_[a];
+    Node& nb = nodes_[b];
+    int pa = na.parent, pb = nb.parent;
+    if (pa == pb) {
+        std::swap(nodes_[pa].left, nodes_[pa].right);
+    }
+    else {
+        (nodes_[pa].left == a ? nodes_[pa].left : nodes_[pa].right) = b;
+        (nodes_[pb].left == b ? nodes_[pb].left : nodes_[pb].right) = a;
+        na.parent = pb;
+        nb.parent = pa;
+    }
+    std::swap(order_[na.number - firstNumber_], order_[nb.number - firstNumber_]);
+    std::swap(na.number, nb.number);
+}
+
+void AdaptiveHuffmanTree::incrementPath(int q) {
+    while (q != -1) {
+        int leader = blockLeader(nodes_[q].weight);
+        if (leader != q) swapNodes(q, leader);
+        nodes_[q].weight++;
+        q = nodes_[q].parent;
+    }
+}
+
+void AdaptiveHuffmanTree::decrementPath(int q) {
+    while (q != -1) {
+        int first = blockFirst(nodes_[q].weight);
+        if (first != q) swapNodes(q, first);
+        nodes_[q].weight--;
+        q = nodes_[q].parent;
+    }
+}
+
+// 插入新标签：拆分编号最小的叶子 A，原位置变为内部结点 I，
+// 新叶子 N（权值 0）与 A 取两个更小的新编号，随后 N 的权值逐一增加
+int AdaptiveHuffmanTree::insertLeaf(int label) {
+    if (root_ == -1) {
+        root_ = newNode(0, label);
+        nodes_[root_].number = firstNumber_;
+        order_.push_back(root_);
+        leafOf_[label] = root_;
+        return root_;
+    }
+
+    int a = order_.front();
+    int internal = newNode(nodes_[a].weight, -1);
+    int leaf = newNode(0, label);
+
+    nodes_[internal].parent = nodes_[a].parent;
+    if (nodes_[a].parent != -1) {
+        Node& p = nodes_[nodes_[a].parent];
+        (p.left == a ? p.left : p.right) = internal;
+    }
+    else {
+        root_ = internal;
+    }
+    invalidateCodes(a);
+    nodes_[internal].left = leaf;
+    nodes_[internal].right = a;
+    nodes_[leaf].parent = internal;
+    nodes_[a].parent = internal;
+
+    nodes_[internal].number = nodes_[a].number;
+    order_[nodes_[internal].number - firstNumber_] = internal;
+    firstNumber_ -= 2;
+    order_.push_front(a);
+    order_.push_front(leaf);
+    nodes_[leaf].number = firstNumber_;
+    nodes_[a].number = firstNumber_ + 1;
+
+    leafOf_[label] = leaf;
+    return leaf;
+}
+
+int AdaptiveHuffmanTree::depthOf(int node) const {
+    int depth = 0;
+    for (; nodes_[node].parent != -1; node = nodes_[node].parent) depth++;
+    return depth;
+}
+
+// 按当前各叶子权值（label 取 weight）整棵重建
+void AdaptiveHuffmanTree::rebuildWith(int label, int64_t weight) {
+    std::map<int, int> areaMap;
+    for (const auto& [l, leaf] : leafOf_) areaMap[l] = static_cast<int>(nodes_[leaf].weight);
+    areaMap[label] = static_cast<int>(weight);
+    build(areaMap);
+}
+
+void AdaptiveHuffmanTree::updateWeight(int label, int newWeight) {
+    int64_t target = std::max(newWeight, 1);   // 叶子权值下限为 1
+    auto it = leafOf_.find(label);
+    int leaf = it == leafOf_.end() ? insertLeaf(label) : it->second;
+    if (nodes_[leaf].weight == 0 && leaf == root_) {
+        nodes_[leaf].weight = target;          // 空树中的第一片叶子直接赋值
+        return;
+    }
+    // 单位步进约 |Δ| · d · log n，重建约 n log n：大幅变化（含以大面积插入的新标签）一次重建
+    const int64_t delta = std::abs(target - nodes_[leaf].weight);
+    if (delta * depthOf(leaf) > static_cast<int64_t>(leafOf_.size())) {
+        rebuildWith(label, target);
+        return;
+    }
+    while (nodes_[leaf].weight < target) incrementPath(leaf);
+    while (nodes_[leaf].weight > target) decrementPath(leaf);
+}
+
+int AdaptiveHuffmanTree::weight(int label) const {
+    auto it = leafOf_.find(label);
+    return it == leafOf_.end() ? 0 : static_cast<int>(nodes_[it->second].weight);
+}
+
+// 缓存未命中时由叶子沿父指针上溯得到码字（左 0 右 1），无内存分配，并给路径上的结点打 CODE_BELOW；
+// 码长超过 32 位时返回 false（不缓存）
+bool AdaptiveHuffmanTree::getCode(int label, HuffmanCode& code) const {
+    auto it = leafOf_.find(label);
+    if (it == leafOf_.end()) return false;
+    const Node& leaf = nodes_[it->second];
+    if (leaf.cache & CODE_VALID) {
+        code = leaf.code;
+        return true;
+    }
+    uint64_t bits = 0;
+    int len = 0;
+    for (int q = it->second; nodes_[q].parent != -1; q = nodes_[q].parent) {
+        if (len >= HUFFMAN_MAX_CODE_LENGTH) return false;
+        if (nodes_[nodes_[q].parent].right == q) bits |= static_cast<uint64_t>(1) << len;
+        len++;
+    }
+    code.bits = static_cast<uint32_t>(bits);
+    code.len = static_cast<uint8_t>(len);
+    leaf.code = code;
+    leaf.cache = CODE_VALID | CODE_BELOW;
+    for (int q = leaf.parent; q != -1; q = nodes_[q].parent) nodes_[q].cache |= CODE_BELOW;
+    return true;
+}
+
+// 校验兄弟性质与权值一致性（调试与测试用）
+bool AdaptiveHuffmanTree::checkSiblingProperty() const {
+    for (size_t i = 0; i < order_.size(); ++i) {
+        const Node& n = nodes_[order_[i]];
+        if (n.number - firstNumber_ != static_cast<int>(i)) return false;
+        if (i > 0 && nodes_[order_[i - 1]].weight > n.weight) return false;
+        if (n.left != -1) {
+            const Node& l = nodes_[n.left];
+            const Node& r = nodes_[n.right];
+            if (l.weight + r.weight != n.weight) return false;
+            if (std::abs(l.number - r.number) != 1) return false;
+            if (l.parent != order_[i] || r.parent != order_[i]) return false;
+        }
+    }
+    return root_ == -1 || order_.back() == root_;
+}
@@ -0,0 +1,485 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 标签图压缩编解码（行内游程 + 熵编码）
+//     容器格式（小端）：
+//       "LMHC" | 版本 u8 | 后端 u8 | 保留 u16 | rows u32 | cols u32
+//       标签字典：个数 varint，首标签 zigzag varint，其余为升序差分 varint
+//       哈夫曼后端：标签符号码长表 | 游程桶码长表 | 游程个数 varint | 位流字节数 varint | 位流
+//       rANS 后端：标签模型 | 游程桶模型 | 游程个数 varint | 附加位流 | rANS 流
+//     每个游程先写标签符号（紧凑下标，或字典大小处的"同上"符号，表示与正上方像素同标签），
+//     再写游程长度：桶号 b = floor(log2(len)) 做熵编码，低 b 位原样写出。
+// ====================================================
+
+static const uint8_t LABEL_CODEC_VERSION = 1;
+static const int LABEL_CODEC_MAX_CODE_LENGTH = 24;
+static const int LABEL_CODEC_LUT_BITS = 11;
+static const int RUN_BUCKET_COUNT = 32;
+
+// ---------------------- 位读写工具（定长整数与 varint 见 utils.h） ----------------------
+// 高位在前的位写入器
+struct BitWriter {
+    std::vector<uint8_t>& out;
+    uint64_t acc = 0;
+    int bits = 0;
+    explicit BitWriter(std::vector<uint8_t>& o) : out(o) {}
+    void put(uint32_t value, int len) {
+        if (len == 0) return;
+        acc = (acc << len) | (value & ((static_cast<uint64_t>(1) << len) - 1));
+        bits += len;
+        while (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> bits));
+        }
+    }
+    void flush() {
+        if (bits > 0) out.push_back(static_cast<uint8_t>(acc << (8 - bits)));
+        bits = 0;
+        acc = 0;
+    }
+};
+
+// 高位在前的位读取器：缓冲区始终左对齐，refill 后至少有 56 位可用
+struct BitReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t buf = 0;
+    int bits = 0;
+    BitReader(const uint8_t* begin, const uint8_t* e) : p(begin), end(e) {}
+    void refill() {
+        if (end - p >= 8) {
+            uint64_t word = 0;
+            for (int i = 0; i < 8; ++i) word = (word << 8) | p[i];
+            int take = (63 - bits) >> 3;
+            if (take == 0) return;
+            buf |= (word >> (64 - 8 * take)) << (64 - 8 * take - bits);
+            p += take;
+            bits += 8 * take;
+            return;
+        }
+        while (bits <= 56) {
+            uint64_t byte = p < end ? *p++ : 0;
+            buf |= byte << (56 - bits);
+            bits += 8;
+        }
+    }
+    uint32_t peek(int n) const { return n ? static_cast<uint32_t>(buf >> (64 - n)) : 0; }
+    void consume(int n) { buf <<= n; bits -= n; }
+    uint32_t get(int n) { uint32_t v = peek(n); consume(n); return v; }
+};
+
+// ---------------------- 查表解码器 ----------------------
+// 码长不超过 LUT 位数的码字一次查表得到；更长的码字按范式码逐位比较
+struct HuffmanDecodeTable {
+    int lutBits = LABEL_CODEC_LUT_BITS;
+    std::vector<uint32_t> lut;                       // (symbol << 8) | len，len 为 0 表示走慢速路径
+    uint32_t firstCode[HUFFMAN_MAX_CODE_LENGTH + 1] = { 0 };
+    uint32_t firstIndex[HUFFMAN_MAX_CODE_LENGTH + 1] = { 0 };
+    uint32_t count[HUFFMAN_MAX_CODE_LENGTH + 1] = { 0 };
+    std::vector<uint32_t> sortedSymbols;             // 按 (码长, 符号) 排序
+    int maxLength = 0;
+};
+
+static bool buildDecodeTable(const std::vector<uint8_t>& lengths, HuffmanDecodeTable& table) {
+    std::vector<HuffmanCode> codes;
+    if (!assignCanonicalCodes(lengths, codes)) return false;
+
+    table.lut.assign(static_cast<size_t>(1) << table.lutBits, 0);
+    std::fill(std::begin(table.count), std::end(table.count), 0);
+    table.maxLength = 0;
+    for (uint8_t len : lengths) {
+        if (len) table.count[len]++;
+        table.maxLength = std::max<int>(table.maxLength, len);
+    }
+
+    uint32_t index = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_CODE_LENGTH; ++len) {
+        table.firstIndex[len] = index;
+        index += table.count[len];
+    }
+    table.sortedSymbols.assign(index, 0);
+    std::vector<uint32_t> fill(table.firstIndex, table.firstIndex + HUFFMAN_MAX_CODE_LENGTH + 1);
+    for (size_t s = 0; s < lengths.size(); ++s) {
+        int len = lengths[s];
+        if (!len) continue;
+        if (table.count[len] && fill[len] == table.firstIndex[len]) table.firstCode[len] = codes[s].bits;
+        table.sortedSymbols[fill[len]++] = static_cast<uint32_t>(s);
+
+        if (len <= table.lutBits) {
+            uint32_t start = codes[s].bits << (table.lutBits - len);
+            uint32_t span = 1u << (table.lutBits - len);
+            for (uint32_t i = 0; i < span; ++i) table.lut[start + i] = (static_cast<uint32_t>(s) << 8) | len;
+        }
+    }
+    return true;
+}
+
+// 调用前须保证 reader 中至少有 maxLength 位（refill 后恒成立）
+static inline bool decodeSymbol(BitReader& reader, const HuffmanDecodeTable& table, uint32_t& symbol) {
+    uint32_t entry = table.lut[reader.peek(table.lutBits)];
+    if (entry & 0xFF) {
+        reader.consume(entry & 0xFF);
+        symbol = entry >> 8;
+        return true;
+    }
+    for (int len = table.lutBits + 1; len <= table.maxLength; ++len) {
+        uint32_t code = reader.peek(len);
+        uint32_t offset = code - table.firstCode[len];
+        if (table.count[len] && code >= table.firstCode[len] && offset < table.count[len]) {
+            reader.consume(len);
+            symbol = table.sortedSymbols[table.firstIndex[len] + offset];
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline int runBucket(uint32_t len) {
+    int b = 0;
+    while ((len >> (b + 1)) != 0) ++b;
+    return b;
+}
+
+// ---------------------- 游程扫描 ----------------------
+// 以行为单位扫描，产出每个游程的标签符号与长度；aboveSymbol 为"同上"转义符号。
+// Label 为 int（CV_32S）或 uint16_t（CV_16U），标签值相同时两者产出的码流相同
+template <typename Label>
+static void scanLabelRuns(const cv::Mat& markers, const std::vector<int>& dictionary,
+    std::vector<uint32_t>& labelSymbols, std::vector<uint32_t>& runLengths) {
+    const uint32_t aboveSymbol = static_cast<uint32_t>(dictionary.size());
+    labelSymbols.clear();
+    runLengths.clear();
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        const Label* above = y > 0 ? markers.ptr<Label>(y - 1) : nullptr;
+        int x = 0;
+        while (x < markers.cols) {
+            Label label = row[x];
+            int start = x;
+            while (x < markers.cols && row[x] == label) ++x;
+            if (above && above[start] == label) {
+                labelSymbols.push_back(aboveSymbol);
+            }
+            else {
+                auto it = std::lower_bound(dictionary.begin(), dictionary.end(), static_cast<int>(label));
+                labelSymbols.push_back(static_cast<uint32_t>(it - dictionary.begin()));
+            }
+            runLengths.push_back(static_cast<uint32_t>(x - start));
+        }
+    }
+}
+
+template <typename Label>
+static void collectLabelDictionary(const cv::Mat& markers, std::vector<int>& dictionary) {
+    dictionary.clear();
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        Label last = 0;
+        bool hasLast = false;
+        for (int x = 0; x < markers.cols; ++x) {
+            if (hasLast && row[x] == last) continue;
+            last = row[x];
+            hasLast = true;
+            dictionary.push_back(static_cast<int>(last));
+        }
+        // 字典过大时及时去重，控制内存
+        if (dictionary.size() > 4 * static_cast<size_t>(markers.cols) + 65536) {
+            std::sort(dictionary.begin(), dictionary.end());
+            dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+        }
+    }
+    std::sort(dictionary.begin(), dictionary.end());
+    dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+}
+
+static void writeLabelDictionary(std::vector<uint8_t>& out, const std::vector<int>& dictionary) {
+    putVarint(out, dictionary.size());
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+        if (i == 0) putVarint(out, zigzagEncode(dictionary[0]));
+        else putVarint(out, static_cast<uint64_t>(static_cast<int64_t>(dictionary[i]) - dictionary[i - 1]));
+    }
+}
+
+static bool readLabelDictionary(const uint8_t* data, size_t size, size_t& pos, std::vector<int>& dictionary) {
+    uint64_t count = 0;
+    if (!getVarint(data, size, pos, count) || count > size - pos) return false;
+    dictionary.resize(static_cast<size_t>(count));
+    int64_t value = 0;
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+        uint64_t v = 0;
+        if (!getVarint(data, size, pos, v)) return false;
+        value = i == 0 ? zigzagDecode(v) : value + static_cast<int64_t>(v);
+        if (value < INT_MIN || value > INT_MAX) return false;
+        dictionary[i] = static_cast<int>(value);
+    }
+    return true;
+}
+
+// ---------------------- 编码 ----------------------
+// 哈夫曼后端：标签码、游程桶码与附加位交织在同一条位流中
+static bool encodeRunsHuffman(const std::vector<uint32_t>& labelSymbols, const std::vector<uint32_t>& runLengths,
+    const std::vector<uint64_t>& labelFreq, const std::vector<uint64_t>& runFreq, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> labelLengths, runLengthsTable;
+    computeHuffmanCodeLengths(labelFreq, LABEL_CODEC_MAX_CODE_LENGTH, labelLengths);
+    computeHuffmanCodeLengths(runFreq, LABEL_CODEC_MAX_CODE_LENGTH, runLengthsTable);
+    // 频数为 0 的符号不分配码字
+    for (size_t i = 0; i < labelFreq.size(); ++i) if (!labelFreq[i]) labelLengths[i] = 0;
+    for (size_t i = 0; i < runFreq.size(); ++i) if (!runFreq[i]) runLengthsTable[i] = 0;
+    std::vector<HuffmanCode> labelCodes, runCodes;
+    if (!assignCanonicalCodes(labelLengths, labelCodes) || !assignCanonicalCodes(runLengthsTable, runCodes)) return false;
+
+    serializeCodeLengths(labelLengths, out);
+    serializeCodeLengths(runLengthsTable, out);
+    putVarint(out, labelSymbols.size());
+
+    std::vector<uint8_t> payload;
+    payload.reserve(labelSymbols.size() * 2 + 16);
+    BitWriter writer(payload);
+    for (size_t i = 0; i < labelSymbols.size(); ++i) {
+        const HuffmanCode& lc = labelCodes[labelSymbols[i]];
+        writer.put(lc.bits, lc.len);
+        int bucket = runBucket(runLengths[i]);
+        const HuffmanCode& rc = runCodes[bucket];
+        writer.put(rc.bits, rc.len);
+        writer.put(runLengths[i] - (1u << bucket), bucket);
+    }
+    writer.flush();
+    putVarint(out, payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+    return true;
+}
+
+// rANS 后端：标签符号与游程桶号交替进入交错 rANS 流，附加位单独成一条位流
+static bool encodeRunsRans(const std::vector<uint32_t>& labelSymbols, const std::vector<uint32_t>& runLengths,
+    const std::vector<uint64_t>& labelFreq, const std::vector<uint64_t>& runFreq, std::vector<uint8_t>& out) {
+    int labelScale = 12;
+    while (labelScale < RANS_MAX_SCALE_BITS && (1u << labelScale) < 4 * labelFreq.size()) ++labelScale;
+    RansModel labelModel, runModel;
+    if (!buildRansModel(labelFreq, labelScale, labelModel) || !buildRansModel(runFreq, 12, runModel)) return false;
+
+    std::vector<uint32_t> symbols(labelSymbols.size() * 2);
+    std::vector<uint8_t> extra;
+    BitWriter writer(extra);
+    for (size_t i = 0; i < labelSymbols.size(); ++i) {
+        int bucket = runBucket(runLengths[i]);
+        symbols[2 * i] = labelSymbols[i];
+        symbols[2 * i + 1] = static_cast<uint32_t>(bucket);
+        writer.put(runLengths[i] - (1u << bucket), bucket);
+    }
+    writer.flush();
+    std::vector<uint8_t> stream;
+    const RansModel* models[2] = { &labelModel, &runModel };
+    ransEncodeInterleaved(symbols, models, 2, stream);
+
+    serializeRansModel(labelModel, out);
+    serializeRansModel(runModel, out);
+    putVarint(out, labelSymbols.size());
+    putVarint(out, extra.size());
+    out.insert(out.end(), extra.begin(), extra.end());
+    putVarint(out, stream.size());
+    out.insert(out.end(), stream.begin(), stream.end());
+    return true;
+}
+
+bool encodeLabelMap(const cv::Mat& markers, std::vector<uint8_t>& out, LabelCodecBackend backend) {
+    out.clear();
+    if (markers.empty() || (markers.type() != CV_32S && markers.type() != CV_16U)) return false;
+
+    std::vector<int> dictionary;
+    std::vector<uint32_t> labelSymbols, runLengths;
+    if (markers.type() == CV_16U) {
+        collectLabelDictionary<uint16_t>(markers, dictionary);
+        scanLabelRuns<uint16_t>(markers, dictionary, labelSymbols, runLengths);
+    }
+    else {
+        collectLabelDictionary<int>(markers, dictionary);
+        scanLabelRuns<int>(markers, dictionary, labelSymbols, runLengths);
+    }
+
+    std::vector<uint64_t> labelFreq(dictionary.size() + 1, 0), runFreq(RUN_BUCKET_COUNT, 0);
+    for (uint32_t s : labelSymbols) labelFreq[s]++;
+    for (uint32_t len : runLengths) runFreq[runBucket(len)]++;
+
+    // rANS 模型的符号下标为 16 位，标签种类过多时退回哈夫曼后端
+    if (backend == LABEL_CODEC_RANS && labelFreq.size() > (1u << RANS_MAX_SCALE_BITS) / 4) {
+        backend = LABEL_CODEC_HUFFMAN;
+    }
+
+    // 头部
+    out.insert(out.end(), { 'L', 'M', 'H', 'C' });
+    out.push_back(LABEL_CODEC_VERSION);
+    out.push_back(static_cast<uint8_t>(backend));
+    out.push_back(0);
+    out.push_back(0);
+    putU32(out, static_cast<uint32_t>(markers.rows));
+    putU32(out, static_cast<uint32_t>(markers.cols));
+    writeLabelDictionary(out, dictionary);
+
+    if (backend == LABEL_CODEC_RANS) return encodeRunsRans(labelSymbols, runLengths, labelFreq, runFreq, out);
+    return encodeRunsHuffman(labelSymbols, runLengths, labelFreq, runFreq, out);
+}
+
+// ---------------------- 解码 ----------------------
+// 分配输出前先核对尺寸：每行至少一个游程，单个游程长度受最大桶号限制
+static bool checkRunBounds(uint32_t rows, uint32_t cols, uint64_t runCount, int maxBucket) {
+    if (rows == 0 || cols == 0) return runCount == 0;
+    if (maxBucket < 0 || runCount < rows || runCount > static_cast<uint64_t>(rows) * cols) return false;
+    return static_cast<uint64_t>(rows) * cols <= runCount * ((static_cast<uint64_t>(1) << (maxBucket + 1)) - 1);
+}
+
+// 把一个游程写入当前行，返回 false 表示数据越界
+static inline bool emitRun(int* row, const int* above, int& x, int cols, uint32_t labelSymbol, uint32_t runLength,
+    const std::vector<int>& dictionary) {
+    if (runLength > static_cast<uint32_t>(cols - x)) return false;
+    int label;
+    if (labelSymbol == dictionary.size()) {
+        if (!above) return false;
+        label = above[x];
+    }
+    else {
+        label = dictionary[labelSymbol];
+    }
+    std::fill(row + x, row + x + runLength, label);
+    x += static_cast<int>(runLength);
+    return true;
+}
+
+static bool decodeRunsHuffman(const uint8_t* data, size_t size, size_t pos, const std::vector<int>& dictionary,
+    uint32_t rows, uint32_t cols, cv::Mat& markers) {
+    std::vector<uint8_t> labelLengths, runLengthsTable;
+    size_t used = deserializeCodeLengths(data + pos, size - pos, labelLengths);
+    if (!used) return false;
+    pos += used;
+    used = deserializeCodeLengths(data + pos, size - pos, runLengthsTable);
+    if (!used) return false;
+    pos += used;
+    if (labelLengths.size() != dictionary.size() + 1 || runLengthsTable.size() != RUN_BUCKET_COUNT) return false;
+
+    uint64_t runCount = 0, payloadSize = 0;
+    if (!getVarint(data, size, pos, runCount) || !getVarint(data, size, pos, payloadSize)) return false;
+    if (payloadSize > size - pos) return false;
+
+    HuffmanDecodeTable labelTable, runTable;
+    if (!buildDecodeTable(labelLengths, labelTable) || !buildDecodeTable(runLengthsTable, runTable)) return false;
+
+    // 每个游程至少占 2 位
+    int maxBucket = -1;
+    for (int b = 0; b < RUN_BUCKET_COUNT; ++b) if (runLengthsTable[b]) maxBucket = b;
+    if (runCount > payloadSize * 4 || !checkRunBounds(rows, cols, runCount, maxBucket)) return false;
+
+    markers.create(static_cast<int>(rows), static_cast<int>(cols), CV_32S);
+    BitReader reader(data + pos, data + pos + payloadSize);
+    uint64_t decodedRuns = 0;
+
+    for (int y = 0; y < markers.rows; ++y) {
+        int* row = markers.ptr<int>(y);
+        const int* above = y > 0 ? markers.ptr<int>(y - 1) : nullptr;
+        int x = 0;
+        while (x < markers.cols) {
+            if (decodedRuns++ >= runCount) return false;
+            reader.refill();
+            uint32_t labelSymbol = 0, bucket = 0;
+            if (!decodeSymbol(reader, labelTable, labelSymbol)) return false;
+            if (!decodeSymbol(reader, runTable, bucket)) return false;
+            reader.refill();
+            uint32_t runLength = (1u << bucket) + reader.get(static_cast<int>(bucket));
+            if (!emitRun(row, above, x, markers.cols, labelSymbol, runLength, dictionary)) return false;
+        }
+    }
+    return decodedRuns == runCount;
+}
+
+// rANS 解码直接展开游程，不生成中间符号数组
+static bool decodeRunsRans(const uint8_t* data, size_t size, size_t pos, const std::vector<int>& dictionary,
+    uint32_t rows, uint32_t cols, cv::Mat& markers) {
+    RansModel labelModel, runModel;
+    size_t used = deserializeRansModel(data + pos, size - pos, labelModel);
+    if (!used) return false;
+    pos += used;
+    used = deserializeRansModel(data + pos, size - pos, runModel);
+    if (!used) return false;
+    pos += used;
+    if (labelModel.freq.size() != dictionary.size() + 1 || runModel.freq.size() != RUN_BUCKET_COUNT) return false;
+
+    uint64_t runCount = 0, extraSize = 0, streamSize = 0;
+    if (!getVarint(data, size, pos, runCount) || !getVarint(data, size, pos, extraSize)) return false;
+    if (extraSize > size - pos) return false;
+    const uint8_t* extra = data + pos;
+    pos += static_cast<size_t>(extraSize);
+    if (!getVarint(data, size, pos, streamSize) || streamSize > size - pos || streamSize < 4 * RANS_STATE_COUNT) return false;
+    const uint8_t* p = data + pos;
+    const uint8_t* end = p + streamSize;
+
+    int maxBucket = -1;
+    for (int b = 0; b < RUN_BUCKET_COUNT; ++b) if (runModel.freq[b]) maxBucket = b;
+    if (!checkRunBounds(rows, cols, runCount, maxBucket)) return false;
+
+    uint32_t state[RANS_STATE_COUNT];
+    for (int i = 0; i < RANS_STATE_COUNT; ++i) {
+        state[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+            | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+        p += 4;
+    }
+    // 第 i 个符号使用第 i % RANS_STATE_COUNT 路状态（与 ransEncodeInterleaved 一致）
+    uint64_t symbolIndex = 0;
+    auto decodeNext = [&](const RansModel& model, uint32_t& symbol) {
+        uint32_t& x = state[symbolIndex++ % RANS_STATE_COUNT];
+        const uint32_t mask = (1u << model.scaleBits) - 1;
+        symbol = model.slotToSymbol[x & mask];
+        x = model.freq[symbol] * (x >> model.scaleBits) + (x & mask) - model.cum[symbol];
+        while (x < RANS_BYTE_L) {
+            if (p >= end) return false;
+            x = (x << 8) | *p++;
+        }
+        return true;
+        };
+
+    markers.create(static_cast<int>(rows), static_cast<int>(cols), CV_32S);
+    BitReader reader(extra, extra + extraSize);
+    uint64_t decodedRuns = 0;
+    for (int y = 0; y < markers.rows; ++y) {
+        int* row = markers.ptr<int>(y);
+        const int* above = y > 0 ? markers.ptr<int>(y - 1) : nullptr;
+        int x = 0;
+        while (x < markers.cols) {
+            if (decodedRuns++ >= runCount) return false;
+            uint32_t labelSymbol = 0, bucket = 0;
+            if (!decodeNext(labelModel, labelSymbol) || !decodeNext(runModel, bucket)) return false;
+            reader.refill();
+            uint32_t runLength = (1u << bucket) + reader.get(static_cast<int>(bucket));
+            if (!emitRun(row, above, x, markers.cols, labelSymbol, runLength, dictionary)) return false;
+        }
+    }
+    // 与 ransDecodeInterleaved 相同的收尾检查：各路状态回到初值、字节流恰好读完
+    for (int i = 0; i < RANS_STATE_COUNT; ++i) {
+        if (state[i] != RANS_BYTE_L) return false;
+    }
+    return decodedRuns == runCount && p == end;
+}
+
+bool decodeLabelMap(const uint8_t* data, size_t size, cv::Mat& markers) {
+    size_t pos = 0;
+    if (size < 16 || std::memcmp(data, "LMHC", 4) != 0) return false;
+    pos = 4;
+    uint8_t version = data[pos++];
+    uint8_t backend = data[pos++];
+    pos += 2;
+    if (version != LABEL_CODEC_VERSION) return false;
+
+    uint32_t rows = 0, cols = 0;
+    if (!getU32(data, size, pos, rows) || !getU32(data, size, pos, cols)) return false;
+    if (rows > static_cast<uint32_t>(INT_MAX) || cols > static_cast<uint32_t>(INT_MAX)) return false;
+
+    std::vector<int> dictionary;
+    if (!readLabelDictionary(data, size, pos, dictionary)) return false;
+
+    switch (backend) {
+    case LABEL_CODEC_HUFFMAN: return decodeRunsHuffman(data, size, pos, dictionary, rows, cols, markers);
+    case LABEL_CODEC_RANS: return decodeRunsRans(data, size, pos, dictionary, rows, cols, markers);
+    default: return false;
+    }
+}
+
+bool decodeLabelMap(const std::vector<uint8_t>& data, cv::Mat& markers) {
+    return decodeLabelMap(data.data(), data.size(), markers);
+}
@@ -1,622 +1,876 @@
-﻿#include "utils.h"
-std::vector<AreaEntry> sortedAreas;
-
-
-
-// 统计各区域面积
-std::map<int, int> computeRegionAreas(const cv::Mat& markers) {
-    std::map<int, int> areaMap;
-    for (int y = 0; y < markers.rows; ++y) {
-        const int* row = markers.ptr<int>(y);
-        for (int x = 0; x < markers.cols; ++x) {
-            int label = row[x];
-            if (label > 0) { // 过滤无效标签（边界或未分配区域）
-                areaMap[label]++;
-            }
-        }
-    }
-    return areaMap;
-}
-
-
-
-
-// 生成标签到随机颜色的映射
-std::map<int, cv::Vec3b> generateColorMap(const std::set<int>& labels) {
-    std::map<int, cv::Vec3b> colorMap;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> dis(50, 255); // 避免颜色过暗
-
-    for (int label : labels) {
-        colorMap[label] = cv::Vec3b(
-            dis(gen), // B通道
-            dis(gen), // G通道
-            dis(gen)  // R通道
-        );
-    }
-    return colorMap;
-}
-
-
-
-
-// 计算每个区域的质心坐标
-std::map<int, cv::Point2f> computeRegionCenters(
-    const cv::Mat& markers,
-    const std::map<int, int>& areaMap
-) {
-    std::map<int, cv::Point2f> centerMap;
-    std::map<int, cv::Moments> momentsMap;
-
-    // 计算每个区域的矩
-    for (int y = 0; y < markers.rows; ++y) {
-        const int* row = markers.ptr<int>(y);
-        for (int x = 0; x < markers.cols; ++x) {
-            int label = row[x];
-            if (label > 0 && areaMap.count(label)) {
-                cv::Moments m = momentsMap[label];
-                m.m00 += 1; // 累加像素数
-                m.m10 += x; // 累加 x 坐标
-                m.m01 += y; // 累加 y 坐标
-                momentsMap[label] = m; // 更新 momentsMap
-            }
-        }
-    }
-
-
-    // 计算质心
-    for (auto& [label, m] : momentsMap) {
-        if (m.m00 != 0) {
-            centerMap[label] = cv::Point2f(
-                m.m10 / m.m00, // x坐标
-                m.m01 / m.m00  // y坐标
-            );
-        }
-    }
-    return centerMap;
-}
-
-
-
-// 堆排序并输出最大/最小面积
-void heapSortAndDisplay(std::map<int, int>& areaMap) {
-    if (areaMap.empty()) {
-        std::cerr << "⚠️ 区域面积映射为空，请检查输入数据！" << std::endl;
-        return;
-    }
-
-    // 提取面积值到向量
-    std::vector<int> areas;
-    for (const auto& [label, area] : areaMap) {
-        areas.push_back(area);
-    }
-
-    // 构建最大堆
-    std::make_heap(areas.begin(), areas.end());
-
-    // 输出最大值（堆顶）
-    std::cout << "✅ 最大区域面积: " << areas.front() << std::endl;
-
-    // 遍历找最小值
-    int minArea = INT_MAX;
-    for (const auto& [label, area] : areaMap) {
-        if (area < minArea) {
-            minArea = area;
-        }
-    }
-    std::cout << "✅ 最小区域面积: " << minArea << std::endl;
-
-    // 完整堆排序（可选）
-    // std::sort_heap(areas.begin(), areas.end());
-}
-
-
-
-// 二分查找符合面积范围的区域标签集合
-std::set<int> binarySearchInRange(const std::vector<AreaEntry>& sortedAreas, int low, int high) {
-    std::set<int> targetLabels;
-    if (sortedAreas.empty()) return targetLabels;
-
-    auto lower = std::lower_bound(sortedAreas.begin(), sortedAreas.end(), low,
-        [](const AreaEntry& a, int value) { return a.area < value; });
-
-    auto upper = std::upper_bound(sortedAreas.begin(), sortedAreas.end(), high,
-        [](int value, const AreaEntry& a) { return value < a.area; });
-
-
-
-    for (auto it = lower; it != upper; ++it) {
-        targetLabels.insert(it->label);
-    }
-    return targetLabels;
-}
-
-
-
-// 高亮显示目标区域
-void highlightRegions1(cv::Mat& image, const cv::Mat& markers, const std::set<int>& targetLabels) {
-    if (image.empty() || markers.empty()) {
-        std::cerr << "⚠️ 输入图像或标记矩阵为空！" << std::endl;
-        return;
-    }
-
-    // 定义高亮颜色（红色）
-    const cv::Vec3b HIGHLIGHT_COLOR(0, 0, 255);
-
-    // 遍历标记矩阵，高亮目标标签区域
-    for (int y = 0; y < markers.rows; ++y) {
-        const int* markersRow = markers.ptr<int>(y);
-        cv::Vec3b* imageRow = image.ptr<cv::Vec3b>(y);
-        for (int x = 0; x < markers.cols; ++x) {
-            int label = markersRow[x];
-            if (targetLabels.count(label)) {
-                imageRow[x] = HIGHLIGHT_COLOR; // BGR格式
-            }
-        }
-    }
-}
-
-
-void highlightRegions(
-    cv::Mat& image,
-    const cv::Mat& markers,
-    const std::set<int>& targetLabels,
-    const std::map<int, cv::Vec3b>& colorMap,
-    const std::map<int, int>& areaMap,
-    const std::map<int, cv::Point2f>& centerMap
-) {
-    // 高亮区域颜色
-    for (int y = 0; y < markers.rows; ++y) {
-        const int* markersRow = markers.ptr<int>(y);
-        cv::Vec3b* imageRow = image.ptr<cv::Vec3b>(y);
-        for (int x = 0; x < markers.cols; ++x) {
-            int label = markersRow[x];
-            if (targetLabels.count(label)) {
-                imageRow[x] = colorMap.at(label);
-            }
-        }
-    }
-
-    // 标注面积值
-    for (const auto& [label, center] : centerMap) {
-        if (targetLabels.count(label)) {
-            std::string text = std::to_string(areaMap.at(label));
-            cv::putText(image, text, center,
-                cv::FONT_HERSHEY_SIMPLEX, 0.5,
-                cv::Scalar(0, 0, 0), 2); // 黑色文字，粗体
-        }
-    }
-}
-
-
-
-
-// ================== 哈夫曼树构建 ==================
-HuffmanNode* buildHuffmanTree(const std::map<int, int>& areaMap) {
-    // 自定义优先队列比较函数（按权值升序）
-    auto cmp = [](HuffmanNode* a, HuffmanNode* b) {
-        return a->weight > b->weight;
-        };
-    std::priority_queue<HuffmanNode*, std::vector<HuffmanNode*>, decltype(cmp)> minHeap(cmp);
-
-    // 创建叶子节点（每个区域对应一个叶子）
-    for (const auto& [label, area] : areaMap) {
-        minHeap.push(new HuffmanNode(area, label)); // 保存区域标签和面积
-    }
-
-    // 合并节点直到只剩根节点
-    while (minHeap.size() > 1) {
-        // 取出权值最小的两个节点
-        HuffmanNode* left = minHeap.top();
-        minHeap.pop();
-        HuffmanNode* right = minHeap.top();
-        minHeap.pop();
-
-        // 创建父节点（权值为子节点之和，标签无效）
-        HuffmanNode* parent = new HuffmanNode(left->weight + right->weight);
-        parent->left = left;
-        parent->right = right;
-
-        minHeap.push(parent);
-    }
-
-    return minHeap.empty() ? nullptr : minHeap.top();
-}
-
-
-
-// ================== 哈夫曼编码生成 ==================
-void generateHuffmanCodes(HuffmanNode* root, std::string code, std::map<int, std::string>& codeMap) {
-    if (!root) return;
-
-    // 叶子节点：记录标签对应的编码
-    if (!root->left && !root->right) {
-        codeMap[root->label] = code; // 标签与编码关联
-        return;
-    }
-
-    // 递归左子树（编码追加"0"）
-    generateHuffmanCodes(root->left, code + "0", codeMap);
-    // 递归右子树（编码追加"1"）
-    generateHuffmanCodes(root->right, code + "1", codeMap);
-}
-
-
-
-// ================== 哈夫曼树可视化 ==================
-cv::Mat visualizeHuffmanTree1(HuffmanNode* root) {
-    const int NODE_RADIUS = 20;        // 节点圆的半径
-    const int HORIZONTAL_SPACING = 60; // 水平间距（兄弟节点间）
-    const int VERTICAL_SPACING = 80;   // 垂直间距（父子节点间）
-    const cv::Scalar NODE_COLOR(255, 255, 255);  // 节点颜色（白色）
-    const cv::Scalar LINE_COLOR(0, 200, 0);       // 连线颜色（绿色）
-    const cv::Scalar TEXT_COLOR(0, 0, 0);         // 文本颜色（黑色）
-
-    // ---------------------- 辅助结构：存储节点位置信息 ----------------------
-    struct NodePosition {
-        HuffmanNode* node;
-        cv::Point center;
-        int depth;
-        NodePosition(HuffmanNode* n, cv::Point c, int d) : node(n), center(c), depth(d) {}
-    };
-
-    // ---------------------- 递归计算节点位置 ----------------------
-    std::vector<NodePosition> positions;
-    std::function<void(HuffmanNode*, cv::Point, int, int)> calculatePosition =
-        [&](HuffmanNode* node, cv::Point parentPos, int depth, int horizontalOffset) {
-        if (!node) return;
-
-        // 计算当前节点位置（根节点居中，子节点按偏移量分布）
-        cv::Point currentPos;
-        if (depth == 0) {
-            // 根节点位于画布顶部中央
-            currentPos = cv::Point(horizontalOffset, NODE_RADIUS + 10);
-        }
-        else {
-            currentPos = cv::Point(
-                parentPos.x + horizontalOffset,
-                parentPos.y + VERTICAL_SPACING
-            );
-        }
-        positions.emplace_back(node, currentPos, depth);
-
-        // 递归计算左右子节点位置（右子节点向右偏移，左子节点向左偏移）
-        calculatePosition(node->left, currentPos, depth + 1, -HORIZONTAL_SPACING);
-        calculatePosition(node->right, currentPos, depth + 1, HORIZONTAL_SPACING);
-        };
-
-    // 初始调用：从根节点开始计算位置
-    calculatePosition(root, cv::Point(0, 0), 0, 0);
-
-    // ---------------------- 动态计算画布大小 ----------------------
-    int maxX = 0, minX = 0, maxDepth = 0;
-    for (const auto& pos : positions) {
-        maxX = std::max(maxX, pos.center.x);
-        minX = std::min(minX, pos.center.x);
-        maxDepth = std::max(maxDepth, pos.depth);
-    }
-    int imgWidth = (maxX - minX) + 4 * NODE_RADIUS;
-    int imgHeight = (maxDepth + 1) * VERTICAL_SPACING + 2 * NODE_RADIUS;
-
-    // 创建画布（白色背景）
-    cv::Mat treeImage(imgHeight, imgWidth, CV_8UC3, cv::Scalar(255, 255, 255));
-
-    // ---------------------- 绘制连线和节点 ----------------------
-    for (const auto& pos : positions) {
-        HuffmanNode* node = pos.node;
-        cv::Point center(pos.center.x - minX + 2 * NODE_RADIUS, pos.center.y);
-
-        // 绘制连线到子节点
-        if (node->left) {
-            cv::Point leftChildCenter = [&]() {
-                for (const auto& childPos : positions) {
-                    if (childPos.node == node->left) {
-                        return cv::Point(
-                            childPos.center.x - minX + 2 * NODE_RADIUS,
-                            childPos.center.y
-                        );
-                    }
-                }
-                return cv::Point(0, 0);
-                }();
-            cv::line(treeImage, center, leftChildCenter, LINE_COLOR, 2);
-        }
-        if (node->right) {
-            cv::Point rightChildCenter = [&]() {
-                for (const auto& childPos : positions) {
-                    if (childPos.node == node->right) {
-                        return cv::Point(
-                            childPos.center.x - minX + 2 * NODE_RADIUS,
-                            childPos.center.y
-                        );
-                    }
-                }
-                return cv::Point(0, 0);
-                }();
-            cv::line(treeImage, center, rightChildCenter, LINE_COLOR, 2);
-        }
-
-        // 绘制节点圆
-        cv::circle(treeImage, center, NODE_RADIUS, NODE_COLOR, -1);
-        cv::circle(treeImage, center, NODE_RADIUS, LINE_COLOR, 2);
-
-        // 添加文本（权值和标签）
-        std::string text;
-        if (node->left || node->right) {
-            text = std::to_string(node->weight); // 内部节点显示权值
-        }
-        else {
-            text = "L" + std::to_string(node->label) + "\n" + std::to_string(node->weight);
-        }
-        cv::putText(treeImage, text, cv::Point(center.x - 15, center.y + 5),
-            cv::FONT_HERSHEY_SIMPLEX, 0.5, TEXT_COLOR, 1);
-    }
-
-    return treeImage;
-}
-
-
-cv::Mat visualizeHuffmanTree2(HuffmanNode* root) {
-    const int NODE_RADIUS = 20;        // 节点圆的半径
-    const int HORIZONTAL_SPACING = 100; // 增大水平间距
-    const int VERTICAL_SPACING = 120;   // 增大垂直间距
-    const cv::Scalar NODE_COLOR(255, 255, 255);  // 节点颜色（白色）
-    const cv::Scalar LINE_COLOR(0, 200, 0);       // 连线颜色（绿色）
-    const cv::Scalar TEXT_COLOR(0, 0, 0);         // 文本颜色（黑色）
-
-    struct NodePosition {
-        HuffmanNode* node;
-        cv::Point center;
-        int depth;
-        NodePosition(HuffmanNode* n, cv::Point c, int d) : node(n), center(c), depth(d) {}
-    };
-
-    std::vector<NodePosition> positions;
-    std::function<void(HuffmanNode*, cv::Point, int, int)> calculatePosition =
-        [&](HuffmanNode* node, cv::Point parentPos, int depth, int horizontalOffset) {
-        if (!node) return;
-
-        cv::Point currentPos;
-        if (depth == 0) {
-            currentPos = cv::Point(0, NODE_RADIUS + 10);
-        }
-        else {
-            currentPos = cv::Point(
-                parentPos.x + horizontalOffset,
-                parentPos.y + VERTICAL_SPACING
-            );
-        }
-        positions.emplace_back(node, currentPos, depth);
-
-        calculatePosition(node->left, currentPos, depth + 1, -HORIZONTAL_SPACING / (depth + 1));
-        calculatePosition(node->right, currentPos, depth + 1, HORIZONTAL_SPACING / (depth + 1));
-        };
-
-    calculatePosition(root, cv::Point(0, 0), 0, 0);
-
-    int maxX = 0, minX = 0, maxDepth = 0;
-    for (const auto& pos : positions) {
-        maxX = std::max(maxX, pos.center.x);
-        minX = std::min(minX, pos.center.x);
-        maxDepth = std::max(maxDepth, pos.depth);
-    }
-    int imgWidth = (maxX - minX) + 4 * NODE_RADIUS;
-    int imgHeight = (maxDepth + 1) * VERTICAL_SPACING + 2 * NODE_RADIUS;
-
-    cv::Mat treeImage(imgHeight, imgWidth, CV_8UC3, cv::Scalar(255, 255, 255));
-
-    for (const auto& pos : positions) {
-        HuffmanNode* node = pos.node;
-        cv::Point center(pos.center.x - minX + 2 * NODE_RADIUS, pos.center.y);
-
-        if (node->left) {
-            cv::Point leftChildCenter = [&]() {
-                for (const auto& childPos : positions) {
-                    if (childPos.node == node->left) {
-                        return cv::Point(
-                            childPos.center.x - minX + 2 * NODE_RADIUS,
-                            childPos.center.y
-                        );
-                    }
-                }
-                return cv::Point(0, 0);
-                }();
-            cv::line(treeImage, center, leftChildCenter, LINE_COLOR, 2);
-        }
-        if (node->right) {
-            cv::Point rightChildCenter = [&]() {
-                for (const auto& childPos : positions) {
-                    if (childPos.node == node->right) {
-                        return cv::Point(
-                            childPos.center.x - minX + 2 * NODE_RADIUS,
-                            childPos.center.y
-                        );
-                    }
-                }
-                return cv::Point(0, 0);
-                }();
-            cv::line(treeImage, center, rightChildCenter, LINE_COLOR, 2);
-        }
-
-        cv::circle(treeImage, center, NODE_RADIUS, NODE_COLOR, -1);
-        cv::circle(treeImage, center, NODE_RADIUS, LINE_COLOR, 2);
-
-        std::string text;
-        if (node->left || node->right) {
-            text = std::to_string(node->weight);
-        }
-        else {
-            text = "L" + std::to_string(node->label) + "\n" + std::to_string(node->weight);
-        }
-        cv::putText(treeImage, text, cv::Point(center.x - 15, center.y + 5),
-            cv::FONT_HERSHEY_SIMPLEX, 0.5, TEXT_COLOR, 1);
-    }
-
-    return treeImage;
-}
-
-cv::Mat visualizeHuffmanTree(HuffmanNode* root) {
-    const int NODE_RADIUS = 20;        // 节点圆的半径
-    const int HORIZONTAL_SPACING = 50; // 增大水平间距
-    const int VERTICAL_SPACING = 50;   // 增大垂直间距
-    const cv::Scalar NODE_COLOR(255, 255, 255);  // 节点颜色（白色）
-    const cv::Scalar LINE_COLOR(0, 200, 0);       // 连线颜色（绿色）
-    const cv::Scalar TEXT_COLOR(0, 0, 0);         // 文本颜色（黑色）
-
-    struct NodePosition {
-        HuffmanNode* node;
-        cv::Point center;
-        int depth;
-        NodePosition(HuffmanNode* n, cv::Point c, int d) : node(n), center(c), depth(d) {}
-    };
-    
-    // 计算子树宽度（递归计算每个节点的子树宽度）
-    std::function<int(HuffmanNode*)> calculateSubtreeWidth = [&](HuffmanNode* node) -> int {
-        if (!node) return 0;
-
-        // 叶子节点宽度为 1
-        if (!node->left && !node->right) return 1;
-
-        // 子树宽度为左右子树宽度之和
-        return calculateSubtreeWidth(node->left) + calculateSubtreeWidth(node->right);
-        };
-
-
-    std::vector<NodePosition> positions;
-    std::function<void(HuffmanNode*, cv::Point, int)> calculatePosition =
-        [&](HuffmanNode* node, cv::Point parentPos, int depth) {
-        if (!node) return;
-
-        // 计算当前节点位置
-        cv::Point currentPos = cv::Point(
-            parentPos.x,
-            parentPos.y + VERTICAL_SPACING
-        );
-        positions.emplace_back(node, currentPos, depth);
-
-        // 计算左右子树宽度
-        int leftWidth = calculateSubtreeWidth(node->left);
-        int rightWidth = calculateSubtreeWidth(node->right);
-
-        // 动态调整水平偏移量
-        int leftOffset = -(leftWidth * NODE_RADIUS * 2); // 左子树向左偏移
-        int rightOffset = rightWidth * NODE_RADIUS * 2;  // 右子树向右偏移
-
-        // 递归计算左右子节点位置
-        calculatePosition(node->left, cv::Point(currentPos.x + leftOffset, currentPos.y), depth + 1);
-        calculatePosition(node->right, cv::Point(currentPos.x + rightOffset, currentPos.y), depth + 1);
-        };
-
-
-     calculatePosition(root, cv::Point(500, NODE_RADIUS + 10), 0);
-
-
-    int maxX = 0, minX = 0, maxDepth = 0;
-    for (const auto& pos : positions) {
-        maxX = std::max(maxX, pos.center.x);
-        minX = std::min(minX, pos.center.x);
-        maxDepth = std::max(maxDepth, pos.depth);
-    }
-    int imgWidth = (maxX - minX) + 10 * NODE_RADIUS;
-    int imgHeight = (maxDepth + 1) * VERTICAL_SPACING + 4 * NODE_RADIUS;
-
-    cv::Mat treeImage(imgHeight, imgWidth, CV_8UC3, cv::Scalar(255, 255, 255));
-
-    for (const auto& pos : positions) {
-        HuffmanNode* node = pos.node;
-        cv::Point center(pos.center.x - minX + 2 * NODE_RADIUS, pos.center.y);
-
-        if (node->left) {
-            cv::Point leftChildCenter = [&]() {
-                for (const auto& childPos : positions) {
-                    if (childPos.node == node->left) {
-                        return cv::Point(
-                            childPos.center.x - minX + 2 * NODE_RADIUS,
-                            childPos.center.y
-                        );
-                    }
-                }
-                return cv::Point(0, 0);
-                }();
-            cv::line(treeImage, center, leftChildCenter, LINE_COLOR, 2);
-        }
-        if (node->right) {
-            cv::Point rightChildCenter = [&]() {
-                for (const auto& childPos : positions) {
-                    if (childPos.node == node->right) {
-                        return cv::Point(
-                            childPos.center.x - minX + 2 * NODE_RADIUS,
-                            childPos.center.y
-                        );
-                    }
-                }
-                return cv::Point(0, 0);
-                }();
-            cv::line(treeImage, center, rightChildCenter, LINE_COLOR, 2);
-        }
-
-        cv::circle(treeImage, center, NODE_RADIUS, NODE_COLOR, -1);
-        cv::circle(treeImage, center, NODE_RADIUS, LINE_COLOR, 2);
-
-
-
-        // 添加文本（权值和标签）
-        std::string text;
-        if (node->left || node->right) {
-            text = std::to_string(node->weight); // 内部节点显示权值
-        }
-        else {
-            // 叶子节点：格式为 "L{label}\n{weight}"
-            text = "L" + std::to_string(node->label) + "\n" + std::to_string(node->weight);
-        }
-
-        // 拆分多行文本并逐行绘制
-        std::vector<std::string> lines;
-        size_t pos = text.find('\n');
-        if (pos != std::string::npos) {
-            lines.push_back(text.substr(0, pos));
-            lines.push_back(text.substr(pos + 1));
-        }
-        else {
-            lines.push_back(text);
-        }
-
-        // 计算总文本高度
-        int totalHeight = 0;
-        int baseline = 0;
-        for (const auto& line : lines) {
-            cv::Size textSize = cv::getTextSize(line, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseline);
-            totalHeight += textSize.height + 5; // 行间距
-        }
-
-        // 逐行绘制
-        int currentY = center.y - totalHeight / 2;
-        for (const auto& line : lines) {
-            cv::Size textSize = cv::getTextSize(line, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseline);
-            cv::Point textPos(
-                center.x - textSize.width / 2,
-                currentY + textSize.height
-            );
-            cv::putText(treeImage, line, textPos, cv::FONT_HERSHEY_SIMPLEX, 0.5, TEXT_COLOR, 1);
-            currentY += textSize.height + 5;
-        }
-
-
-    }
-
-    return treeImage;
-}
-
-
-
-
-
-
-// ================== 释放哈夫曼树内存 ==================
-void deleteHuffmanTree(HuffmanNode* root) {
-    if (!root) return;
-    deleteHuffmanTree(root->left);
-    deleteHuffmanTree(root->right);
-    delete root;
+﻿#include "utils.h"
+
+
+
+// 统计各区域面积（标签图为 CV_32S 或 CV_16U，下同）
+template <typename Label>
+static void countRegionAreas(const cv::Mat& markers, std::map<int, int>& areaMap) {
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        for (int x = 0; x < markers.cols; ++x) {
+            int label = row[x];
+            if (label > 0) { // 过滤无效标签（边界或未分配区域）
+                areaMap[label]++;
+            }
+        }
+    }
+}
+
+std::map<int, int> computeRegionAreas(const cv::Mat& markers) {
+    std::map<int, int> areaMap;
+    if (markers.depth() == CV_16U) countRegionAreas<uint16_t>(markers, areaMap);
+    else countRegionAreas<int>(markers, areaMap);
+    return areaMap;
+}
+
+
+
+
+// 生成标签到随机颜色的映射
+std::map<int, cv::Vec3b> generateColorMap(const std::set<int>& labels, TaskEnv* env) {
+    std::map<int, cv::Vec3b> colorMap;
+    std::mt19937 localGen;
+    if (!env) localGen.seed(std::random_device{}());
+    std::mt19937& gen = env ? env->rng : localGen;
+    std::uniform_int_distribution<int> dis(50, 255); // 避免颜色过暗
+
+    for (int label : labels) {
+        colorMap[label] = cv::Vec3b(
+            dis(gen), // B通道
+            dis(gen), // G通道
+            dis(gen)  // R通道
+        );
+    }
+    return colorMap;
+}
+
+
+
+
+// 计算每个区域的矩
+template <typename Label>
+static void accumulateRegionMoments(const cv::Mat& markers, const std::map<int, int>& areaMap,
+    std::map<int, cv::Moments>& momentsMap) {
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* row = markers.ptr<Label>(y);
+        for (int x = 0; x < markers.cols; ++x) {
+            int label = row[x];
+            if (label > 0 && areaMap.count(label)) {
+                cv::Moments m = momentsMap[label];
+                m.m00 += 1; // 累加像素数
+                m.m10 += x; // 累加 x 坐标
+                m.m01 += y; // 累加 y 坐标
+                momentsMap[label] = m; // 更新 momentsMap
+            }
+        }
+    }
+}
+
+// 计算每个区域的质心坐标
+std::map<int, cv::Point2f> computeRegionCenters(
+    const cv::Mat& markers,
+    const std::map<int, int>& areaMap
+) {
+    std::map<int, cv::Point2f> centerMap;
+    std::map<int, cv::Moments> momentsMap;
+    if (markers.depth() == CV_16U) accumulateRegionMoments<uint16_t>(markers, areaMap, momentsMap);
+    else accumulateRegionMoments<int>(markers, areaMap, momentsMap);
+
+
+    // 计算质心
+    for (auto& [label, m] : momentsMap) {
+        if (m.m00 != 0) {
+            centerMap[label] = cv::Point2f(
+                m.m10 / m.m00, // x坐标
+                m.m01 / m.m00  // y坐标
+            );
+        }
+    }
+    return centerMap;
+}
+
+
+
+// 堆排序并输出最大/最小面积（经 env 的日志出口）
+void heapSortAndDisplay(std::map<int, int>& areaMap, TaskEnv* env) {
+    if (areaMap.empty()) {
+        envLog(env, LOG_WARNING, "⚠️ 区域面积映射为空，请检查输入数据！");
+        return;
+    }
+
+    // 提取面积值到向量
+    std::vector<int> areas;
+    for (const auto& [label, area] : areaMap) {
+        areas.push_back(area);
+    }
+
+    // 构建最大堆
+    std::make_heap(areas.begin(), areas.end());
+
+    // 输出最大值（堆顶）
+    envLog(env, LOG_INFO, "✅ 最大区域面积: ", areas.front());
+
+    // 遍历找最小值
+    int minArea = INT_MAX;
+    for (const auto& [label, area] : areaMap) {
+        if (area < minArea) {
+            minArea = area;
+        }
+    }
+    envLog(env, LOG_INFO, "✅ 最小区域面积: ", minArea);
+
+    // 完整堆排序（可选）
+    // std::sort_heap(areas.begin(), areas.end());
+}
+
+
+
+// 二分查找符合面积范围的区域标签集合
+std::set<int> binarySearchInRange(const std::vector<AreaEntry>& sortedAreas, int low, int high) {
+    std::set<int> targetLabels;
+    if (sortedAreas.empty()) return targetLabels;
+
+    auto lower = std::lower_bound(sortedAreas.begin(), sortedAreas.end(), low,
+        [](const AreaEntry& a, int value) { return a.area < value; });
+
+    auto upper = std::upper_bound(sortedAreas.begin(), sortedAreas.end(), high,
+        [](int value, const AreaEntry& a) { return value < a.area; });
+
+
+
+    for (auto it = lower; it != upper; ++it) {
+        targetLabels.insert(it->label);
+    }
+    return targetLabels;
+}
+
+
+
+// 按标签给目标区域像素着色：colorOf(label) 返回该区域的颜色
+template <typename Label, typename ColorOf>
+static void paintTargetRegionsKernel(cv::Mat& image, const cv::Mat& markers, const std::set<int>& targetLabels, ColorOf colorOf) {
+    for (int y = 0; y < markers.rows; ++y) {
+        const Label* markersRow = markers.ptr<Label>(y);
+        cv::Vec3b* imageRow = image.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < markers.cols; ++x) {
+            int label = markersRow[x];
+            if (targetLabels.count(label)) {
+                imageRow[x] = colorOf(label);
+            }
+        }
+    }
+}
+
+template <typename ColorOf>
+static void paintTargetRegions(cv::Mat& image, const cv::Mat& markers, const std::set<int>& targetLabels, ColorOf colorOf) {
+    if (markers.depth() == CV_16U) paintTargetRegionsKernel<uint16_t>(image, markers, targetLabels, colorOf);
+    else paintTargetRegionsKernel<int>(image, markers, targetLabels, colorOf);
+}
+
+// 高亮显示目标区域
+void highlightRegions1(cv::Mat& image, const cv::Mat& markers, const std::set<int>& targetLabels) {
+    if (image.empty() || markers.empty()) {
+        std::cerr << "⚠️ 输入图像或标记矩阵为空！" << std::endl;
+        return;
+    }
+
+    // 定义高亮颜色（红色）
+    const cv::Vec3b HIGHLIGHT_COLOR(0, 0, 255);
+
+    // 遍历标记矩阵，高亮目标标签区域
+    paintTargetRegions(image, markers, targetLabels, [&](int) { return HIGHLIGHT_COLOR; }); // BGR格式
+}
+
+
+void highlightRegions(
+    cv::Mat& image,
+    const cv::Mat& markers,
+    const std::set<int>& targetLabels,
+    const std::map<int, cv::Vec3b>& colorMap,
+    const std::map<int, int>& areaMap,
+    const std::map<int, cv::Point2f>& centerMap
+) {
+    // 高亮区域颜色
+    paintTargetRegions(image, markers, targetLabels, [&](int label) { return colorMap.at(label); });
+
+    // 标注面积值
+    for (const auto& [label, center] : centerMap) {
+        if (targetLabels.count(label)) {
+            std::string text = std::to_string(areaMap.at(label));
+            cv::putText(image, text, center,
+                cv::FONT_HERSHEY_SIMPLEX, 0.5,
+                cv::Scalar(0, 0, 0), 2); // 黑色文字，粗体
+        }
+    }
+}
+
+
+
+
+// ================== 哈夫曼树构建 ==================
+HuffmanNode* buildHuffmanTree(const std::map<int, int>& areaMap) {
+    // 自定义优先队列比较函数（按权值升序）
+    auto cmp = [](HuffmanNode* a, HuffmanNode* b) {
+        return a->weight > b->weight;
+        };
+    std::priority_queue<HuffmanNode*, std::vector<HuffmanNode*>, decltype(cmp)> minHeap(cmp);
+
+    // 创建叶子节点（每个区域对应一个叶子）
+    for (const auto& [label, area] : areaMap) {
+        minHeap.push(new HuffmanNode(area, label)); // 保存区域标签和面积
+    }
+
+    // 合并节点直到只剩根节点
+    while (minHeap.size() > 1) {
+        // 取出权值最小的两个节点
+        HuffmanNode* left = minHeap.top();
+        minHeap.pop();
+        HuffmanNode* right = minHeap.top();
+        minHeap.pop();
+
+        // 创建父节点（权值为子节点之和，标签无效）
+        HuffmanNode* parent = new HuffmanNode(left->weight + right->weight);
+        parent->left = left;
+        parent->right = right;
+
+        minHeap.push(parent);
+    }
+
+    return minHeap.empty() ? nullptr : minHeap.top();
+}
+
+
+
+// ================== 哈夫曼编码生成 ==================
+void generateHuffmanCodes(HuffmanNode* root, std::string code, std::map<int, std::string>& codeMap) {
+    if (!root) return;
+
+    // 叶子节点：记录标签对应的编码
+    if (!root->left && !root->right) {
+        codeMap[root->label] = code; // 标签与编码关联
+        return;
+    }
+
+    // 递归左子树（编码追加"0"）
+    generateHuffmanCodes(root->left, code + "0", codeMap);
+    // 递归右子树（编码追加"1"）
+    generateHuffmanCodes(root->right, code + "1", codeMap);
+}
+
+
+
+// ================== 范式哈夫曼编码 ==================
+// 码长计算：先按权值升序排序（O(n log n)），再用 Moffat-Katajainen 原地算法在 O(n) 内求出码长；
+// 若最长码长超过 maxLength，则改用 package-merge 求长度受限的最优码长。
+// 全程只使用几块平铺数组，不为单个码字分配内存。
+
+// package-merge：sortedWeights 升序，结果写入 sortedLengths（与 sortedWeights 一一对应）
+static void packageMergeLengths(const std::vector<uint64_t>& sortedWeights, int maxLength,
+    std::vector<uint8_t>& sortedLengths) {
+    const size_t n = sortedWeights.size();
+    const size_t listCap = 2 * n;
+
+    // isPackage[level * listCap + i]：第 level 层合并列表中第 i 项是否为"包"
+    std::vector<uint8_t> isPackage(static_cast<size_t>(maxLength) * listCap, 0);
+    std::vector<size_t> listSize(maxLength, 0);
+    std::vector<uint64_t> prev(sortedWeights), cur;
+    cur.reserve(listCap);
+
+    // 最深一层只有叶子
+    listSize[maxLength - 1] = n;
+    for (int level = maxLength - 2; level >= 0; --level) {
+        cur.clear();
+        uint8_t* flags = &isPackage[static_cast<size_t>(level) * listCap];
+        size_t packageCount = prev.size() / 2;
+        size_t li = 0, pi = 0;
+        // 归并叶子与上一层打出的包（权值相同时叶子优先）
+        while (li < n || pi < packageCount) {
+            uint64_t pw = pi < packageCount ? prev[2 * pi] + prev[2 * pi + 1] : 0;
+            if (pi >= packageCount || (li < n && sortedWeights[li] <= pw)) {
+                flags[cur.size()] = 0;
+                cur.push_back(sortedWeights[li++]);
+            }
+            else {
+                flags[cur.size()] = 1;
+                cur.push_back(pw);
+                ++pi;
+            }
+        }
+        listSize[level] = cur.size();
+        prev.swap(cur);
+    }
+
+    // 自顶向下：取第 0 层前 2n-2 项，叶子总是有序前缀，每被选中一次码长加一
+    std::fill(sortedLengths.begin(), sortedLengths.end(), 0);
+    size_t take = 2 * n - 2;
+    for (int level = 0; level < maxLength && take > 0; ++level) {
+        const uint8_t* flags = &isPackage[static_cast<size_t>(level) * listCap];
+        size_t leafCount = 0, packageCount = 0;
+        for (size_t i = 0; i < take && i < listSize[level]; ++i) {
+            if (flags[i]) packageCount++;
+            else leafCount++;
+        }
+        for (size_t i = 0; i < leafCount; ++i) sortedLengths[i]++;
+        take = 2 * packageCount;
+    }
+}
+
+void computeHuffmanCodeLengths(const std::vector<uint64_t>& weights, int maxLength, std::vector<uint8_t>& lengths) {
+    const size_t n = weights.size();
+    lengths.assign(n, 0);
+    if (n == 0) return;
+    if (n == 1) {
+        lengths[0] = 1; // 单符号也至少占 1 位
+        return;
+    }
+    maxLength = std::max(1, std::min(maxLength, HUFFMAN_MAX_CODE_LENGTH));
+    while ((static_cast<uint64_t>(1) << maxLength) < n) maxLength++; // 码长上限必须能容纳 n 个符号
+
+    // 按权值升序排列的下标
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = static_cast<uint32_t>(i);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return weights[a] != weights[b] ? weights[a] < weights[b] : a < b;
+        });
+
+    std::vector<uint64_t> A(n);
+    for (size_t i = 0; i < n; ++i) A[i] = std::max<uint64_t>(weights[order[i]], 1);
+    std::vector<uint64_t> sortedWeights(A);
+
+    // Moffat-Katajainen 第一遍：自左向右合并，A 中内部结点记录父结点下标
+    size_t root = 0, leaf = 2, next;
+    A[0] += A[1];
+    for (next = 1; next < n - 1; ++next) {
+        if (leaf >= n || A[root] < A[leaf]) {
+            A[next] = A[root];
+            A[root++] = next;
+        }
+        else {
+            A[next] = A[leaf++];
+        }
+        if (leaf >= n || (root < next && A[root] < A[leaf])) {
+            A[next] += A[root];
+            A[root++] = next;
+        }
+        else {
+            A[next] += A[leaf++];
+        }
+    }
+    // 第二遍：自右向左求内部结点深度
+    A[n - 2] = 0;
+    for (size_t i = n - 2; i-- > 0;) A[i] = A[A[i]] + 1;
+    // 第三遍：自右向左求叶子深度（权值越大码长越短）
+    int64_t avail = 1, used = 0, depth = 0;
+    int64_t r = static_cast<int64_t>(n) - 2, nx = static_cast<int64_t>(n) - 1;
+    while (avail > 0) {
+        while (r >= 0 && static_cast<int64_t>(A[r]) == depth) { used++; r--; }
+        while (avail > used) { A[nx--] = depth; avail--; }
+        avail = 2 * used;
+        depth++;
+        used = 0;
+    }
+
+    std::vector<uint8_t> sortedLengths(n);
+    bool overflow = false;
+    for (size_t i = 0; i < n; ++i) {
+        if (static_cast<int>(A[i]) > maxLength) overflow = true;
+        sortedLengths[i] = static_cast<uint8_t>(std::min<uint64_t>(A[i], 255));
+    }
+    if (overflow) {
+        packageMergeLengths(sortedWeights, maxLength, sortedLengths);
+    }
+    for (size_t i = 0; i < n; ++i) lengths[order[i]] = sortedLengths[i];
+}
+
+// 由码长分配范式码字：同一码长内按下标递增连续编号
+bool assignCanonicalCodes(const std::vector<uint8_t>& lengths, std::vector<HuffmanCode>& codes) {
+    codes.assign(lengths.size(), HuffmanCode{ 0, 0 });
+    uint32_t lengthCount[HUFFMAN_MAX_CODE_LENGTH + 1] = { 0 };
+    for (uint8_t len : lengths) {
+        if (len > HUFFMAN_MAX_CODE_LENGTH) return false;
+        if (len) lengthCount[len]++;
+    }
+
+    // Kraft 不等式检查，防止损坏的码长表
+    uint64_t kraft = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_CODE_LENGTH; ++len)
+        kraft += static_cast<uint64_t>(lengthCount[len]) << (HUFFMAN_MAX_CODE_LENGTH - len);
+    if (kraft > (static_cast<uint64_t>(1) << HUFFMAN_MAX_CODE_LENGTH)) return false;
+
+    uint64_t nextCode[HUFFMAN_MAX_CODE_LENGTH + 2] = { 0 };
+    uint64_t code = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_CODE_LENGTH; ++len) {
+        code = (code + lengthCount[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        uint8_t len = lengths[i];
+        if (len) codes[i] = HuffmanCode{ static_cast<uint32_t>(nextCode[len]++), len };
+    }
+    return true;
+}
+
+bool buildCanonicalHuffmanTable(const std::map<int, int>& areaMap, CanonicalHuffmanTable& table, int maxLength) {
+    table = CanonicalHuffmanTable();
+    std::vector<uint64_t> weights;
+    table.labels.reserve(areaMap.size());
+    weights.reserve(areaMap.size());
+    for (const auto& [label, area] : areaMap) {   // map 有序，紧凑下标即按标签升序
+        table.labels.push_back(label);
+        weights.push_back(static_cast<uint64_t>(std::max(area, 0)));
+    }
+    computeHuffmanCodeLengths(weights, maxLength, table.lengths);
+    if (!assignCanonicalCodes(table.lengths, table.codes)) {
+        table = CanonicalHuffmanTable();
+        return false;
+    }
+    for (uint8_t len : table.lengths) table.maxLength = std::max<int>(table.maxLength, len);
+    return true;
+}
+
+// 码表序列化：变长整数写符号个数，随后每个符号一个字节的码长
+void serializeCodeLengths(const std::vector<uint8_t>& lengths, std::vector<uint8_t>& out) {
+    putVarint(out, lengths.size());
+    out.insert(out.end(), lengths.begin(), lengths.end());
+}
+
+// 返回消耗的字节数，0 表示数据不完整
+size_t deserializeCodeLengths(const uint8_t* data, size_t size, std::vector<uint8_t>& lengths) {
+    uint64_t n = 0;
+    size_t pos = 0;
+    if (!getVarint(data, size, pos, n) || n > size - pos) return 0;
+    lengths.assign(data + pos, data + pos + n);
+    return pos + static_cast<size_t>(n);
+}
+
+std::string huffmanCodeToString(const HuffmanCode& code) {
+    std::string s(code.len, '0');
+    for (int i = 0; i < code.len; ++i) {
+        if ((code.bits >> (code.len - 1 - i)) & 1) s[i] = '1';
+    }
+    return s;
+}
+
+
+
+// ================== 哈夫曼树可视化 ==================
+cv::Mat visualizeHuffmanTree1(HuffmanNode* root) {
+    const int NODE_RADIUS = 20;        // 节点圆的半径
+    const int HORIZONTAL_SPACING = 60; // 水平间距（兄弟节点间）
+    const int VERTICAL_SPACING = 80;   // 垂直间距（父子节点间）
+    const cv::Scalar NODE_COLOR(255, 255, 255);  // 节点颜色（白色）
+    const cv::Scalar LINE_COLOR(0, 200, 0);       // 连线颜色（绿色）
+    const cv::Scalar TEXT_COLOR(0, 0, 0);         // 文本颜色（黑色）
+
+    // ---------------------- 辅助结构：存储节点位置信息 ----------------------
+    struct NodePosition {
+        HuffmanNode* node;
+        cv::Point center;
+        int depth;
+        NodePosition(HuffmanNode* n, cv::Point c, int d) : node(n), center(c), depth(d) {}
+    };
+
+    // ---------------------- 递归计算节点位置 ----------------------
+    std::vector<NodePosition> positions;
+    std::function<void(HuffmanNode*, cv::Point, int, int)> calculatePosition =
+        [&](HuffmanNode* node, cv::Point parentPos, int depth, int horizontalOffset) {
+        if (!node) return;
+
+        // 计算当前节点位置（根节点居中，子节点按偏移量分布）
+        cv::Point currentPos;
+        if (depth == 0) {
+            // 根节点位于画布顶部中央
+            currentPos = cv::Point(horizontalOffset, NODE_RADIUS + 10);
+        }
+        else {
+            currentPos = cv::Point(
+                parentPos.x + horizontalOffset,
+                parentPos.y + VERTICAL_SPACING
+            );
+        }
+        positions.emplace_back(node, currentPos, depth);
+
+        // 递归计算左右子节点位置（右子节点向右偏移，左子节点向左偏移）
+        calculatePosition(node->left, currentPos, depth + 1, -HORIZONTAL_SPACING);
+        calculatePosition(node->right, currentPos, depth + 1, HORIZONTAL_SPACING);
+        };
+
+    // 初始调用：从根节点开始计算位置
+    calculatePosition(root, cv::Point(0, 0), 0, 0);
+
+    // ---------------------- 动态计算画布大小 ----------------------
+    int maxX = 0, minX = 0, maxDepth = 0;
+    for (const auto& pos : positions) {
+        maxX = std::max(maxX, pos.center.x);
+        minX = std::min(minX, pos.center.x);
+        maxDepth = std::max(maxDepth, pos.depth);
+    }
+    int imgWidth = (maxX - minX) + 4 * NODE_RADIUS;
+    int imgHeight = (maxDepth + 1) * VERTICAL_SPACING + 2 * NODE_RADIUS;
+
+    // 创建画布（白色背景）
+    cv::Mat treeImage(imgHeight, imgWidth, CV_8UC3, cv::Scalar(255, 255, 255));
+
+    // ---------------------- 绘制连线和节点 ----------------------
+    for (const auto& pos : positions) {
+        HuffmanNode* node = pos.node;
+        cv::Point center(pos.center.x - minX + 2 * NODE_RADIUS, pos.center.y);
+
+        // 绘制连线到子节点
+        if (node->left) {
+            cv::Point leftChildCenter = [&]() {
+                for (const auto& childPos : positions) {
+                    if (childPos.node == node->left) {
+                        return cv::Point(
+                            childPos.center.x - minX + 2 * NODE_RADIUS,
+                            childPos.center.y
+                        );
+                    }
+                }
+                return cv::Point(0, 0);
+                }();
+            cv::line(treeImage, center, leftChildCenter, LINE_COLOR, 2);
+        }
+        if (node->right) {
+            cv::Point rightChildCenter = [&]() {
+                for (const auto& childPos : positions) {
+                    if (childPos.node == node->right) {
+                        return cv::Point(
+                            childPos.center.x - minX + 2 * NODE_RADIUS,
+                            childPos.center.y
+                        );
+                    }
+                }
+                return cv::Point(0, 0);
+                }();
+            cv::line(treeImage, center, rightChildCenter, LINE_COLOR, 2);
+        }
+
+        // 绘制节点圆
+        cv::circle(treeImage, center, NODE_RADIUS, NODE_COLOR, -1);
+        cv::circle(treeImage, center, NODE_RADIUS, LINE_COLOR, 2);
+
+        // 添加文本（权值和标签）
+        std::string text;
+        if (node->left || node->right) {
+            text = std::to_string(node->weight); // 内部节点显示权值
+        }
+        else {
+            text = "L" + std::to_string(node->label) + "\n" + std::to_string(node->weight);
+        }
+        cv::putText(treeImage, text, cv::Point(center.x - 15, center.y + 5),
+            cv::FONT_HERSHEY_SIMPLEX, 0.5, TEXT_COLOR, 1);
+    }
+
+    return treeImage;
+}
+
+
+cv::Mat visualizeHuffmanTree2(HuffmanNode* root) {
+    const int NODE_RADIUS = 20;        // 节点圆的半径
+    const int HORIZONTAL_SPACING = 100; // 增大水平间距
+    const int VERTICAL_SPACING = 120;   // 增大垂直间距
+    const cv::Scalar NODE_COLOR(255, 255, 255);  // 节点颜色（白色）
+    const cv::Scalar LINE_COLOR(0, 200, 0);       // 连线颜色（绿色）
+    const cv::Scalar TEXT_COLOR(0, 0, 0);         // 文本颜色（黑色）
+
+    struct NodePosition {
+        HuffmanNode* node;
+        cv::Point center;
+        int depth;
+        NodePosition(HuffmanNode* n, cv::Point c, int d) : node(n), center(c), depth(d) {}
+    };
+
+    std::vector<NodePosition> positions;
+    std::function<void(HuffmanNode*, cv::Point, int, int)> calculatePosition =
+        [&](HuffmanNode* node, cv::Point parentPos, int depth, int horizontalOffset) {
+        if (!node) return;
+
+        cv::Point currentPos;
+        if (depth == 0) {
+            currentPos = cv::Point(0, NODE_RADIUS + 10);
+        }
+        else {
+            currentPos = cv::Point(
+                parentPos.x + horizontalOffset,
+                parentPos.y + VERTICAL_SPACING
+            );
+        }
+        positions.emplace_back(node, currentPos, depth);
+
+        calculatePosition(node->left, currentPos, depth + 1, -HORIZONTAL_SPACING / (depth + 1));
+        calculatePosition(node->right, currentPos, depth + 1, HORIZONTAL_SPACING / (depth + 1));
+        };
+
+    calculatePosition(root, cv::Point(0, 0), 0, 0);
+
+    int maxX = 0, minX = 0, maxDepth = 0;
+    for (const auto& pos : positions) {
+        maxX = std::max(maxX, pos.center.x);
+        minX = std::min(minX, pos.center.x);
+        maxDepth = std::max(maxDepth, pos.depth);
+    }
+    int imgWidth = (maxX - minX) + 4 * NODE_RADIUS;
+    int imgHeight = (maxDepth + 1) * VERTICAL_SPACING + 2 * NODE_RADIUS;
+
+    cv::Mat treeImage(imgHeight, imgWidth, CV_8UC3, cv::Scalar(255, 255, 255));
+
+    for (const auto& pos : positions) {
+        HuffmanNode* node = pos.node;
+        cv::Point center(pos.center.x - minX + 2 * NODE_RADIUS, pos.center.y);
+
+        if (node->left) {
+            cv::Point leftChildCenter = [&]() {
+                for (const auto& childPos : positions) {
+                    if (childPos.node == node->left) {
+                        return cv::Point(
+                            childPos.center.x - minX + 2 * NODE_RADIUS,
+                            childPos.center.y
+                        );
+                    }
+                }
+                return cv::Point(0, 0);
+                }();
+            cv::line(treeImage, center, leftChildCenter, LINE_COLOR, 2);
+        }
+        if (node->right) {
+            cv::Point rightChildCenter = [&]() {
+                for (const auto& childPos : positions) {
+                    if (childPos.node == node->right) {
+                        return cv::Point(
+                            childPos.center.x - minX + 2 * NODE_RADIUS,
+                            childPos.center.y
+                        );
+                    }
+                }
+                return cv::Point(0, 0);
+                }();
+            cv::line(treeImage, center, rightChildCenter, LINE_COLOR, 2);
+        }
+
+        cv::circle(treeImage, center, NODE_RADIUS, NODE_COLOR, -1);
+        cv::circle(treeImage, center, NODE_RADIUS, LINE_COLOR, 2);
+
+        std::string text;
+        if (node->left || node->right) {
+            text = std::to_string(node->weight);
+        }
+        else {
+            text = "L" + std::to_string(node->label) + "\n" + std::to_string(node->weight);
+        }
+        cv::putText(treeImage, text, cv::Point(center.x - 15, center.y + 5),
+            cv::FONT_HERSHEY_SIMPLEX, 0.5, TEXT_COLOR, 1);
+    }
+
+    return treeImage;
+}
+
+// ---------------------- 线性时间布局 ----------------------
+// 叶序布局：叶子按中序依次占据一个水平槽位，内部结点位于左右孩子正中。
+// 一次显式栈后序遍历即可完成（O(n)，不递归，深树也不会栈溢出），
+// 坐标与子树横向范围直接写回结点本身，后续渲染不再查找 positions。
+HuffmanLayout layoutHuffmanTree(HuffmanNode* root) {
+    HuffmanLayout layout;
+    if (!root) return layout;
+
+    std::vector<std::pair<HuffmanNode*, bool>> stack;  // (结点, 孩子是否已处理)
+    root->depth = 0;
+    stack.emplace_back(root, false);
+    while (!stack.empty()) {
+        auto [node, expanded] = stack.back();
+        stack.pop_back();
+        bool isLeaf = !node->left && !node->right;
+
+        if (isLeaf) {
+            node->x = HUFFMAN_NODE_RADIUS * 2 + layout.leafCount * HUFFMAN_LEAF_SPACING;
+            node->minX = node->maxX = node->x;
+            layout.leafCount++;
+        }
+        else if (!expanded) {
+            stack.emplace_back(node, true);
+            // 先压右孩子，保证左子树先出栈（叶子自左向右编号）
+            if (node->right) {
+                node->right->depth = node->depth + 1;
+                stack.emplace_back(node->right, false);
+            }
+            if (node->left) {
+                node->left->depth = node->depth + 1;
+                stack.emplace_back(node->left, false);
+            }
+            continue;
+        }
+        else {
+            HuffmanNode* first = node->left ? node->left : node->right;
+            HuffmanNode* last = node->right ? node->right : node->left;
+            node->x = (first->x + last->x) / 2;
+            node->minX = first->minX;
+            node->maxX = last->maxX;
+        }
+        node->y = HUFFMAN_NODE_RADIUS + 10 + node->depth * HUFFMAN_LEVEL_SPACING;
+        layout.maxDepth = std::max(layout.maxDepth, node->depth);
+    }
+
+    layout.width = root->maxX + HUFFMAN_NODE_RADIUS * 2;
+    layout.height = root->y + layout.maxDepth * HUFFMAN_LEVEL_SPACING + HUFFMAN_NODE_RADIUS * 2 + 10;
+    return layout;
+}
+
+// 结点文本：内部结点显示权值，叶子显示 "L{label}" 与权值两行
+static void drawHuffmanNode(cv::Mat& canvas, const HuffmanNode* node, cv::Point center) {
+    const cv::Scalar NODE_COLOR(255, 255, 255);
+    const cv::Scalar LINE_COLOR(0, 200, 0);
+    const cv::Scalar TEXT_COLOR(0, 0, 0);
+
+    cv::circle(canvas, center, HUFFMAN_NODE_RADIUS, NODE_COLOR, -1);
+    cv::circle(canvas, center, HUFFMAN_NODE_RADIUS, LINE_COLOR, 2);
+
+    std::string lines[2];
+    int lineCount = 1;
+    if (node->left || node->right) {
+        lines[0] = std::to_string(node->weight);
+    }
+    else {
+        lines[0] = "L" + std::to_string(node->label);
+        lines[1] = std::to_string(node->weight);
+        lineCount = 2;
+    }
+
+    int baseline = 0;
+    int totalHeight = 0;
+    cv::Size sizes[2];
+    for (int i = 0; i < lineCount; ++i) {
+        sizes[i] = cv::getTextSize(lines[i], cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseline);
+        totalHeight += sizes[i].height + 5; // 行间距
+    }
+    int currentY = center.y - totalHeight / 2;
+    for (int i = 0; i < lineCount; ++i) {
+        cv::Point textPos(center.x - sizes[i].width / 2, currentY + sizes[i].height);
+        cv::putText(canvas, lines[i], textPos, cv::FONT_HERSHEY_SIMPLEX, 0.5, TEXT_COLOR, 1);
+        currentY += sizes[i].height + 5;
+    }
+}
+
+// ---------------------- 按需分块渲染 ----------------------
+// 只绘制与 tile 相交的结点和连线；子树横向范围 [minX, maxX] 与 tile 不相交时整棵剪掉。
+// 需先调用 layoutHuffmanTree。内存只与 tile 大小和树高有关。
+cv::Mat renderHuffmanTreeTile(HuffmanNode* root, const cv::Rect& tile) {
+    const cv::Scalar LINE_COLOR(0, 200, 0);
+    cv::Mat canvas(tile.size(), CV_8UC3, cv::Scalar(255, 255, 255));
+    if (!root || tile.empty()) return canvas;
+
+    const int margin = HUFFMAN_NODE_RADIUS + 2;
+    const int tileLeft = tile.x - margin, tileRight = tile.x + tile.width + margin;
+    const int tileTop = tile.y - margin, tileBottom = tile.y + tile.height + margin;
+    const cv::Point offset(tile.x, tile.y);
+
+    std::vector<HuffmanNode*> stack;
+    // 先画连线，再画结点，保证结点圆盖住线头
+    for (int pass = 0; pass < 2; ++pass) {
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty()) {
+            HuffmanNode* node = stack.back();
+            stack.pop_back();
+            // 子树横向范围不与 tile 相交，或本结点已在 tile 下方：整棵子树跳过
+            if (node->maxX < tileLeft || node->minX > tileRight || node->y > tileBottom) continue;
+
+            cv::Point center(node->x, node->y);
+            if (pass == 0) {
+                for (HuffmanNode* child : { node->left, node->right }) {
+                    if (!child) continue;
+                    int lx = std::min(node->x, child->x), rx = std::max(node->x, child->x);
+                    if (rx >= tileLeft && lx <= tileRight && child->y >= tileTop && node->y <= tileBottom) {
+                        cv::line(canvas, center - offset, cv::Point(child->x, child->y) - offset, LINE_COLOR, 2);
+                    }
+                }
+            }
+            else if (node->x >= tileLeft && node->x <= tileRight && node->y >= tileTop) {
+                drawHuffmanNode(canvas, node, center - offset);
+            }
+            if (node->right) stack.push_back(node->right);
+            if (node->left) stack.push_back(node->left);
+        }
+    }
+    return canvas;
+}
+
+// ---------------------- 流式 SVG 输出 ----------------------
+// 边遍历边写出，不保留整张画布；需先调用 layoutHuffmanTree
+void writeHuffmanTreeSVG(HuffmanNode* root, const HuffmanLayout& layout, std::ostream& os) {
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" font-family=\"sans-serif\" font-size=\"11\" text-anchor=\"middle\">\n"
+        "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n<g stroke=\"rgb(0,200,0)\" stroke-width=\"2\">\n",
+        layout.width, layout.height);
+    os << buf;
+    if (!root) {
+        os << "</g>\n</svg>\n";
+        return;
+    }
+
+    std::vector<HuffmanNode*> stack;
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) os << "</g>\n<g stroke=\"rgb(0,200,0)\" stroke-width=\"2\" fill=\"white\">\n";
+        stack.push_back(root);
+        while (!stack.empty()) {
+            HuffmanNode* node = stack.back();
+            stack.pop_back();
+            int n = 0;
+            if (pass == 0) {
+                for (HuffmanNode* child : { node->left, node->right }) {
+                    if (!child) continue;
+                    n = std::snprintf(buf, sizeof(buf), "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\"/>\n",
+                        node->x, node->y, child->x, child->y);
+                    os.write(buf, n);
+                }
+            }
+            else if (node->left || node->right) {
+                n = std::snprintf(buf, sizeof(buf), "<circle cx=\"%d\" cy=\"%d\" r=\"%d\"/><text x=\"%d\" y=\"%d\" stroke=\"none\" fill=\"black\">%d</text>\n",
+                    node->x, node->y, HUFFMAN_NODE_RADIUS, node->x, node->y + 4, node->weight);
+                os.write(buf, n);
+            }
+            else {
+                n = std::snprintf(buf, sizeof(buf), "<circle cx=\"%d\" cy=\"%d\" r=\"%d\"/><text x=\"%d\" y=\"%d\" stroke=\"none\" fill=\"black\">L%d<tspan x=\"%d\" dy=\"12\">%d</tspan></text>\n",
+                    node->x, node->y, HUFFMAN_NODE_RADIUS, node->x, node->y - 2, node->label, node->x, node->weight);
+                os.write(buf, n);
+            }
+            if (node->right) stack.push_back(node->right);
+            if (node->left) stack.push_back(node->left);
+        }
+    }
+    os << "</g>\n</svg>\n";
+}
+
+// 整树可视化：画布不超过 HUFFMAN_MAX_CANVAS_PIXELS 时整体渲染，
+// 否则只渲染以根结点为中心的顶部一块，完整结果请用 writeHuffmanTreeSVG 导出
+cv::Mat visualizeHuffmanTree(HuffmanNode* root, TaskEnv* env) {
+    HuffmanLayout layout = layoutHuffmanTree(root);
+    if (!root) return cv::Mat(HUFFMAN_NODE_RADIUS * 4, HUFFMAN_NODE_RADIUS * 4, CV_8UC3, cv::Scalar(255, 255, 255));
+
+    cv::Rect tile(0, 0, layout.width, layout.height);
+    if (static_cast<int64_t>(layout.width) * layout.height > HUFFMAN_MAX_CANVAS_PIXELS) {
+        int w = std::min(layout.width, 4096);
+        int h = std::min(layout.height, static_cast<int>(HUFFMAN_MAX_CANVAS_PIXELS / w));
+        int x = std::max(0, std::min(root->x - w / 2, layout.width - w));
+        tile = cv::Rect(x, 0, w, h);
+        envLog(env, LOG_INFO, " 哈夫曼树画布过大（", layout.width, " x ", layout.height,
+            "），仅显示根结点附近区域，完整结果请导出 SVG。");
+    }
+    return renderHuffmanTreeTile(root, tile);
+}
+
+
+
+// ================== 释放哈夫曼树内存 ==================
+// 频率极度偏斜时树深可达 n - 1，用显式栈逐个释放，不递归
+void deleteHuffmanTree(HuffmanNode* root) {
+    std::vector<HuffmanNode*> stack;
+    if (root) stack.push_back(root);
+    while (!stack.empty()) {
+        HuffmanNode* node = stack.back();
+        stack.pop_back();
+        if (node->left) stack.push_back(node->left);
+        if (node->right) stack.push_back(node->right);
+        delete node;
+    }
 }
\ No newline at end of file
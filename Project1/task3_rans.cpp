@@ -0,0 +1,167 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 静态交错 rANS 熵编码
+//     32 位状态、按字节重归一化（状态下界 RANS_BYTE_L = 2^23），
+//     RANS_STATE_COUNT 路状态交错：第 i 个符号使用第 i % RANS_STATE_COUNT 路状态，
+//     同时按 models[i % modelCount] 选择概率模型，因此可在一条流中交替编码不同字母表。
+//     编码器逆序处理符号并从缓冲区尾部向前写字节，解码器顺序读取。
+// ====================================================
+
+// 把频数归一化到总和 2^scaleBits，出现过的符号频率至少为 1
+bool buildRansModel(const std::vector<uint64_t>& counts, int scaleBits, RansModel& model) {
+    if (scaleBits < 1 || scaleBits > RANS_MAX_SCALE_BITS) return false;
+    const uint32_t target = 1u << scaleBits;
+    uint64_t total = 0;
+    size_t used = 0;
+    for (uint64_t c : counts) {
+        total += c;
+        if (c) used++;
+    }
+    if (used == 0 || used > target) return false;
+
+    std::vector<uint32_t> freq(counts.size(), 0);
+    int64_t sum = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (!counts[i]) continue;
+        uint64_t scaled = static_cast<uint64_t>(static_cast<double>(counts[i]) * target / total);
+        freq[i] = static_cast<uint32_t>(std::max<uint64_t>(scaled, 1));
+        sum += freq[i];
+    }
+
+    // 修正舍入误差：多出的从大频率符号中按比例扣除，不足的补给最大频率符号
+    int64_t diff = static_cast<int64_t>(target) - sum;
+    if (diff != 0) {
+        std::vector<uint32_t> order;
+        order.reserve(used);
+        for (size_t i = 0; i < freq.size(); ++i) if (freq[i]) order.push_back(static_cast<uint32_t>(i));
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return freq[a] > freq[b]; });
+        if (diff > 0) {
+            freq[order[0]] += static_cast<uint32_t>(diff);
+        }
+        else {
+            while (diff < 0) {
+                for (uint32_t s : order) {
+                    if (diff == 0) break;
+                    if (freq[s] <= 1) continue;
+                    uint32_t take = static_cast<uint32_t>(std::min<int64_t>({ static_cast<int64_t>(std::max<uint32_t>(freq[s] / 16, 1)),
+                        static_cast<int64_t>(freq[s] - 1), -diff }));
+                    freq[s] -= take;
+                    diff += take;
+                }
+            }
+        }
+    }
+    return buildRansModelFromFrequencies(freq, scaleBits, model);
+}
+
+// 由已归一化的频率表重建模型（解码端使用）
+bool buildRansModelFromFrequencies(const std::vector<uint32_t>& freq, int scaleBits, RansModel& model) {
+    if (scaleBits < 1 || scaleBits > RANS_MAX_SCALE_BITS || freq.size() > 65536) return false;
+    const uint32_t target = 1u << scaleBits;
+    model.scaleBits = scaleBits;
+    model.freq = freq;
+    model.cum.assign(freq.size() + 1, 0);
+    for (size_t i = 0; i < freq.size(); ++i) {
+        model.cum[i + 1] = model.cum[i] + freq[i];
+        if (model.cum[i + 1] > target) return false;
+    }
+    if (model.cum.back() != target) return false;
+
+    model.slotToSymbol.resize(target);
+    for (size_t i = 0; i < freq.size(); ++i) {
+        std::fill(model.slotToSymbol.begin() + model.cum[i], model.slotToSymbol.begin() + model.cum[i + 1],
+            static_cast<uint16_t>(i));
+    }
+    return true;
+}
+
+// 模型序列化：scaleBits u8 | 符号个数 varint | 各符号频率 varint
+void serializeRansModel(const RansModel& model, std::vector<uint8_t>& out) {
+    out.push_back(static_cast<uint8_t>(model.scaleBits));
+    putVarint(out, model.freq.size());
+    for (uint32_t f : model.freq) putVarint(out, f);
+}
+
+size_t deserializeRansModel(const uint8_t* data, size_t size, RansModel& model) {
+    size_t pos = 0;
+    if (size < 1) return 0;
+    int scaleBits = data[pos++];
+    uint64_t count = 0;
+    if (!getVarint(data, size, pos, count) || count > 65536 || count > size - pos) return 0;
+    std::vector<uint32_t> freq(static_cast<size_t>(count));
+    for (auto& f : freq) {
+        uint64_t v = 0;
+        if (!getVarint(data, size, pos, v) || v > (1u << RANS_MAX_SCALE_BITS)) return 0;
+        f = static_cast<uint32_t>(v);
+    }
+    if (!buildRansModelFromFrequencies(freq, scaleBits, model)) return 0;
+    return pos;
+}
+
+// 交错编码：输出为 [RANS_STATE_COUNT 个 32 位初始状态][字节流]
+void ransEncodeInterleaved(const std::vector<uint32_t>& symbols, const RansModel* const* models, int modelCount,
+    std::vector<uint8_t>& out) {
+    // 每个符号最多输出 2 个字节（scaleBits <= 16），再加上状态
+    std::vector<uint8_t> buffer(symbols.size() * 2 + 4 * RANS_STATE_COUNT + 16);
+    uint8_t* end = buffer.data() + buffer.size();
+    uint8_t* p = end;
+
+    uint32_t state[RANS_STATE_COUNT];
+    for (int i = 0; i < RANS_STATE_COUNT; ++i) state[i] = RANS_BYTE_L;
+
+    for (size_t i = symbols.size(); i-- > 0;) {
+        const RansModel& model = *models[i % modelCount];
+        uint32_t& x = state[i % RANS_STATE_COUNT];
+        const uint32_t s = symbols[i];
+        const uint32_t freq = model.freq[s];
+        const uint32_t start = model.cum[s];
+
+        uint32_t xMax = ((RANS_BYTE_L >> model.scaleBits) << 8) * freq;
+        while (x >= xMax) {
+            *--p = static_cast<uint8_t>(x & 0xFF);
+            x >>= 8;
+        }
+        x = ((x / freq) << model.scaleBits) + (x % freq) + start;
+    }
+
+    // 逆序写出状态，使解码端按 0..RANS_STATE_COUNT-1 顺序读取
+    for (int i = RANS_STATE_COUNT - 1; i >= 0; --i) {
+        for (int b = 0; b < 4; ++b) *--p = static_cast<uint8_t>(state[i] >> (8 * b));
+    }
+    out.assign(p, end);
+}
+
+bool ransDecodeInterleaved(const uint8_t* data, size_t size, const RansModel* const* models, int modelCount,
+    size_t count, std::vector<uint32_t>& symbols) {
+    if (size < 4 * RANS_STATE_COUNT) return false;
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+
+    uint32_t state[RANS_STATE_COUNT];
+    for (int i = 0; i < RANS_STATE_COUNT; ++i) {
+        state[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+            | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+        p += 4;
+    }
+
+    symbols.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const RansModel& model = *models[i % modelCount];
+        uint32_t& x = state[i % RANS_STATE_COUNT];
+        const uint32_t mask = (1u << model.scaleBits) - 1;
+
+        uint32_t s = model.slotToSymbol[x & mask];
+        x = model.freq[s] * (x >> model.scaleBits) + (x & mask) - model.cum[s];
+        while (x < RANS_BYTE_L) {
+            if (p >= end) return false;
+            x = (x << 8) | *p++;
+        }
+        symbols[i] = s;
+    }
+    // 编码从 RANS_BYTE_L 出发，完整解码后各路状态必须回到 RANS_BYTE_L、字节流恰好读完；否则数据被截断或篡改
+    for (int i = 0; i < RANS_STATE_COUNT; ++i) {
+        if (state[i] != RANS_BYTE_L) return false;
+    }
+    return p == end;
+}
@@ -0,0 +1,35 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 控制台日志出口
+//     交互程序与各工具模式把它装进 TaskEnv。库函数的进度与提示只经 TaskEnv 输出，
+//     不直接写 std::cout；文件读写失败、前置条件不满足等按惯例写 std::cerr 后返回 false。
+//     消息在调用线程里拼好，这里只在写出整行时加锁，多路分割共用也不会交错成半行。
+// ====================================================
+LogSink consoleLogSink() {
+    return [](LogLevel level, const std::string& message) {
+        static std::mutex consoleMutex;
+        std::lock_guard<std::mutex> lock(consoleMutex);
+        (level == LOG_INFO ? std::cout : std::cerr) << message << std::endl;
+        };
+}
+
+
+// ====================================================
+// ✅ 计时与条带并行
+//     各模块按行切条带后交给 forEachStripe，条带数由调用方按线程数与最小行数决定。
+// ====================================================
+double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void forEachStripe(int stripes, const std::function<void(int)>& fn) {
+    if (stripes == 1) {
+        fn(0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(stripes);
+    for (int i = 0; i < stripes; ++i) workers.emplace_back([&fn, i] { fn(i); });
+    for (auto& t : workers) t.join();
+}
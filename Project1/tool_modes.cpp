@@ -0,0 +1,246 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 工具模式入口
+//     --lloyd、--pyramid、--hierarchy、--stream 的命令行解析、计时输出与结果窗口；
+//     算法本身（种子细化、金字塔淹没、合并树、条带流式分割）在 SegmentationLib 中。
+// ====================================================
+
+// ---------------------- 种子 Lloyd 细化 ----------------------
+// 分水岭区域的面积变异系数、邻接边数与碎区（面积不足均值 1/10）个数
+static void printRegionSpread(const char* name, SegmentationContext& ctx, const std::vector<cv::Point>& seeds) {
+    ctx.flood(seeds);
+    const RegionAdjacencyCSR& graph = ctx.buildAdjacency();
+    ctx.computeRegionStats();
+    const std::vector<int>& areas = ctx.areas();
+    int64_t total = 0;
+    int regions = 0;
+    for (int a : areas) {
+        total += a;
+        regions += a > 0;
+    }
+    const double mean = regions ? static_cast<double>(total) / regions : 0;
+    int slivers = 0;
+    for (int a : areas) slivers += a > 0 && a < mean / 10;
+    std::cout << " " << name << "：分水岭区域面积变异系数 " << areaCoefficientOfVariation(areas) << "，碎区 " << slivers
+        << " 个，邻接边 " << graph.neighbors.size() / 2 << " 条" << std::endl;
+}
+
+// Lloyd 细化模式：Project1 --lloyd [图像路径] [K] [迭代次数] [线程数]
+int runLloyd(int argc, char** argv) {
+    std::string path = argc > 0 ? argv[0] : "wife.jpg";
+    int K = argc > 1 ? std::atoi(argv[1]) : 1000;
+    LloydOptions options;
+    if (argc > 2) options.iterations = std::atoi(argv[2]);
+    if (argc > 3) options.threads = std::atoi(argv[3]);
+    if (K < 2 || K > 10000 || options.iterations < 1) {
+        std::cerr << " 参数非法：K 应在 [2, 10000] 范围内，迭代次数不小于 1。" << std::endl;
+        return -1;
+    }
+    cv::Mat src = cv::imread(path);
+    if (src.empty()) {
+        std::cerr << " 无法读取图像文件 " << path << std::endl;
+        return -1;
+    }
+
+    std::vector<cv::Point> seeds = generateSeedPoints(src.size(), K);
+    std::vector<cv::Point> refined = seeds;
+    LloydScratch scratch;
+    LloydStats stats;
+    refineSeedsLloyd(refined, src.size(), options, scratch, &stats);
+    std::cout << " " << src.cols << " x " << src.rows << "，K = " << K << "，" << options.iterations << " 轮 Lloyd："
+        << (stats.jfaMs + stats.reduceMs) / options.iterations << " ms/轮（跳跃洪泛 " << stats.jfaMs / options.iterations
+        << "，归约 " << stats.reduceMs / options.iterations << "）" << std::endl;
+    std::cout << " Voronoi 单元面积变异系数：";
+    for (double cv : stats.cellAreaCv) std::cout << cv << " ";
+    std::cout << std::endl;
+
+    SegmentationContext ctx;
+    ctx.computeRelief(src);
+    printRegionSpread("细化前", ctx, seeds);
+    printRegionSpread("细化后", ctx, refined);
+
+    cv::Mat watershedView;
+    ctx.renderWatershed(src, watershedView);
+    cv::imshow("Lloyd - 细化前种子", visualizeSeedOverlay(src, seeds));
+    cv::imshow("Lloyd - 细化后种子", visualizeSeedOverlay(src, refined));
+    cv::imshow("Lloyd - 分水岭区域图", watershedView);
+    cv::waitKey(0);
+    return 0;
+}
+
+
+// ---------------------- 金字塔淹没 ----------------------
+// 金字塔模式：Project1 --pyramid [图像路径] [K] [层数] [band] [preview]
+//   默认：整图地形图 + 金字塔淹没，并与原分辨率淹没对比；
+//   preview：按 2^层数 缩小解码后直接在小图上分割，用于快速预览
+int runPyramid(int argc, char** argv) {
+    std::string path = argc > 0 ? argv[0] : "wife.jpg";
+    int K = argc > 1 ? std::atoi(argv[1]) : 1000;
+    PyramidOptions options;
+    if (argc > 2) options.levels = std::atoi(argv[2]);
+    if (argc > 3) options.band = std::atoi(argv[3]);
+    bool preview = argc > 4 && std::string(argv[4]) == "preview";
+    if (K < 2 || K > 10000 || options.levels < 1 || options.levels > 3 || options.band < 1) {
+        std::cerr << " 参数非法：K 应在 [2, 10000] 范围内，层数为 1~3，band 不小于 1。" << std::endl;
+        return -1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    cv::Mat src = preview ? loadImageReduced(path, 1 << options.levels) : cv::imread(path);
+    double decodeMs = elapsedMs(start);
+    if (src.empty()) {
+        std::cerr << " 无法读取图像文件 " << path << std::endl;
+        return -1;
+    }
+    std::vector<cv::Point> seeds = generateSeedPoints(src.size(), K);
+
+    if (preview) {
+        start = std::chrono::high_resolution_clock::now();
+        cv::Mat markers = computeMarkers(src.size(), seeds, src);
+        double segmentMs = elapsedMs(start);
+        std::cout << " 预览：缩小解码 " << src.cols << " x " << src.rows << "，解码 " << decodeMs << " ms，分割 "
+            << segmentMs << " ms" << std::endl;
+        cv::imshow("金字塔预览 - 分水岭区域图", applyWatershedWithColor(src, markers));
+        cv::waitKey(0);
+        return 0;
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    cv::Mat relief = computeWatershedRelief(src);
+    double reliefMs = elapsedMs(start);
+    // 先做原分辨率对照：它可能重新生成种子，金字塔随后用同一组种子
+    start = std::chrono::high_resolution_clock::now();
+    cv::Mat reference = computeMarkersFromRelief(src.size(), seeds, relief);
+    double fullMs = elapsedMs(start);
+    PyramidStats stats;
+    cv::Mat markers = computeMarkersPyramidFromRelief(seeds, relief, options, &stats);
+    LabelMapAgreement agreement = compareLabelMaps(reference, markers, 1);
+
+    const double pyramidMs = stats.coarseMs + stats.upsampleMs + stats.refineMs;
+    std::cout << " " << src.cols << " x " << src.rows << "，K = " << K << "，下采样 " << (1 << options.levels)
+        << " 倍，band " << options.band << "：解码 " << decodeMs << " ms，地形图 " << reliefMs << " ms" << std::endl;
+    std::cout << " 金字塔淹没 " << pyramidMs << " ms（粗淹没 " << stats.coarseMs << "，上采样 " << stats.upsampleMs
+        << "，条带细化 " << stats.refineMs << "，条带占 " << stats.bandFraction * 100 << "%），原分辨率淹没 "
+        << fullMs << " ms，加速 " << fullMs / std::max(pyramidMs, 1e-9) << "x" << std::endl;
+    std::cout << " 像素一致 " << agreement.pixelAgreement * 100 << "%，边界（容差 1 像素）精确率 "
+        << agreement.boundaryPrecision * 100 << "%，召回率 " << agreement.boundaryRecall * 100 << "%" << std::endl;
+
+    cv::imshow("金字塔 - 分水岭区域图", applyWatershedWithColor(src, markers));
+    cv::waitKey(0);
+    return 0;
+}
+
+
+// ---------------------- 层次分水岭 ----------------------
+// 层次分水岭模式：Project1 --hierarchy [图像路径] [细粒度K] [区域数列表，逗号分隔]
+//   细粒度淹没与合并树只算一次，按列表逐层提取并着色、统计面积
+int runHierarchy(int argc, char** argv) {
+    std::string path = argc > 0 ? argv[0] : "wife.jpg";
+    int fineK = argc > 1 ? std::atoi(argv[1]) : 5000;
+    std::string list = argc > 2 ? argv[2] : "100,500,1000";
+    std::vector<int> levels;
+    for (size_t pos = 0; pos < list.size();) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        levels.push_back(std::atoi(list.substr(pos, comma - pos).c_str()));
+        pos = comma + 1;
+    }
+    if (fineK < 2 || fineK > 60000) {
+        std::cerr << " 参数非法：细粒度 K 应在 [2, 60000] 范围内。" << std::endl;
+        return -1;
+    }
+    for (int k : levels) {
+        if (k < 1 || k > fineK) {
+            std::cerr << " 参数非法：区域数应在 [1, " << fineK << "] 范围内。" << std::endl;
+            return -1;
+        }
+    }
+
+    cv::Mat src = cv::imread(path);
+    if (src.empty()) {
+        std::cerr << " 无法读取图像文件 " << path << std::endl;
+        return -1;
+    }
+
+    SegmentationContext ctx;
+    auto start = std::chrono::high_resolution_clock::now();
+    ctx.computeRelief(src);
+    ctx.flood(generateSeedPoints(src.size(), fineK));
+    ctx.buildAdjacency();
+    ctx.computeRegionStats();
+    double floodMs = elapsedMs(start);
+    WatershedHierarchy hierarchy;
+    start = std::chrono::high_resolution_clock::now();
+    if (!hierarchy.build(ctx)) return -1;
+    double buildMs = elapsedMs(start);
+    std::cout << " " << src.cols << " x " << src.rows << "：细粒度淹没 " << hierarchy.fineRegionCount() << " 个区域 "
+        << floodMs << " ms，合并树 " << buildMs << " ms" << std::endl;
+
+    HierarchyLevel level;
+    cv::Mat coloring;
+    for (int k : levels) {
+        start = std::chrono::high_resolution_clock::now();
+        hierarchy.extract(k, level);
+        double extractMs = elapsedMs(start);
+        start = std::chrono::high_resolution_clock::now();
+        ctx.beginFrame();
+        ctx.attachLevel(level);
+        int conflicts = ctx.colorRegions();
+        double colorMs = elapsedMs(start);
+        std::cout << "  " << k << " 个区域：提取 " << extractMs << " ms（实际 " << level.regionCount << " 个，邻接边 "
+            << level.graph.neighbors.size() / 2 << "），着色 " << colorMs << " ms，冲突 " << conflicts << std::endl;
+        ctx.renderColoring(coloring);
+        cv::imshow("层次分水岭 - " + std::to_string(level.regionCount) + " 个区域", coloring);
+    }
+
+    cv::Mat saliency, saliency8U;
+    hierarchy.saliencyMap(saliency);
+    saliency.convertTo(saliency8U, CV_8U, 255.0 / std::max(1, hierarchy.fineRegionCount()));
+    cv::imshow("层次分水岭 - 超度量轮廓图", saliency8U);
+    cv::waitKey(0);
+    return 0;
+}
+
+
+// ---------------------- 条带流式处理 ----------------------
+// 命令行：--stream <输入 .ppm | .raw> [K] [内存预算 MB] [标签文件] [着色图 .ppm | -] [halo] [raw 宽] [raw 高]
+int runStreaming(int argc, char** argv) {
+    if (argc < 1) {
+        std::cerr << " 用法：--stream <输入 .ppm|.raw> [K] [内存预算MB] [标签文件] [着色图.ppm|-] [halo] [raw宽] [raw高]" << std::endl;
+        return -1;
+    }
+    std::string path = argv[0];
+    int K = argc > 1 ? std::atoi(argv[1]) : 1000;
+    size_t budgetMB = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 512;
+    std::string labelPath = argc > 3 ? argv[3] : "labels.bin";
+    StreamingOptions options;
+    options.memoryBudget = budgetMB << 20;
+    options.coloringPath = argc > 4 && std::string(argv[4]) != "-" ? argv[4] : "";
+    if (argc > 5) options.halo = std::atoi(argv[5]);
+
+    StripImageReader reader;
+    bool opened = argc > 7 ? reader.openRaw(path, std::atoi(argv[6]), std::atoi(argv[7])) : reader.openPPM(path);
+    if (!opened) {
+        std::cerr << " 无法读取图像文件 " << path << "（raw 格式需给出宽和高）" << std::endl;
+        return -1;
+    }
+    if (K < 2 || K > 10000 || options.halo < 8) {
+        std::cerr << " 参数非法：K 应在 [2, 10000] 范围内，halo 不小于 8。" << std::endl;
+        return -1;
+    }
+
+    std::vector<cv::Point> seeds = generateSeedPoints(cv::Size(reader.cols(), reader.rows()), K);
+    StreamingResult result;
+    if (!segmentStreaming(reader, seeds, labelPath, options, result)) {
+        std::cerr << " 流式分割失败。" << std::endl;
+        return -1;
+    }
+    std::cout << " 流式分割完成：" << reader.cols() << " x " << reader.rows() << "，条带 " << result.strips
+        << " 条 × " << result.stripRows << " 行，标签 " << (result.labelDepth == CV_16U ? 16 : 32) << " 位" << std::endl;
+    std::cout << "  地形图统计 " << result.reliefMs << " ms  淹没 " << result.floodMs << " ms  面积/邻接/着色 "
+        << result.statsMs << " ms  着色图输出 " << result.renderMs << " ms" << std::endl;
+    std::cout << "  区域 " << result.regions << " 个，着色冲突边 " << result.conflicts << "，常驻内存峰值 "
+        << (result.peakRss >> 20) << " MB（预算 " << budgetMB << " MB）" << std::endl;
+    return 0;
+}
@@ -1,79 +1,1041 @@
-﻿#pragma once
-#include <opencv2/opencv.hpp>
-#include <vector>
-#include <map>
-#include <set>
-#include <string>
-#include <queue>
-#include <functional>
-#include <random>
-#include <iostream>
-#include <chrono>
-#include <unordered_set>
-#include <stack>
-#include <bitset>
-#include <algorithm>
-#include <cmath>
-#include <climits>
-using namespace std;
-using namespace cv;
-
-// ========== 通用结构体 ==========
-struct RegionGraph {
-    std::map<int, std::set<int>> adjacency;  // 邻接表
-    std::map<int, int> colorMap;             // 区域 label -> 颜色索引（0~3）
-};
-
-// ========== 任务1：分水岭 ==========
-std::vector<cv::Point> generateSeedPoints(cv::Size size, int K);
-cv::Mat computeMarkers(cv::Size size, const std::vector<cv::Point>& seeds, const cv::Mat& src);
-cv::Mat applyWatershedWithColor(const cv::Mat& src, cv::Mat& markers);
-cv::Mat visualizeSeedOverlay(const cv::Mat& image, const std::vector<cv::Point>& seeds);
-bool isPlanarGraph(const std::map<int, std::set<int>>& adjacency);
-// ========== 任务2：四色图着色 ==========
-RegionGraph buildRegionAdjacencyGraph(const cv::Mat& markers);
-bool fourColorGraphBacktracking(RegionGraph& graph);
-cv::Mat visualizeFourColoring(const cv::Mat& markers, const RegionGraph& graph);
-bool fourColorGraphOptimized(RegionGraph& graph);         
-int selectInitialRegion(const RegionGraph& graph);
-bool repeatUntilFourColorSuccess(RegionGraph& graph);
-cv::Mat visualizeFourColoring(const cv::Mat& markers, const RegionGraph& graph);// ✅ 着色结果可视化
-
-
-// ========== 任务3：哈夫曼编码 ==========
-
-struct HuffmanNode {
-    int weight;
-    int label;         // 区域标签（仅叶子节点有效）
-    HuffmanNode* left;
-    HuffmanNode* right;
-    HuffmanNode(int w, int l = -1) : weight(w), label(l), left(nullptr), right(nullptr) {}
-};
-struct AreaEntry {
-    int label;
-    int area;
-};
-
-extern std::vector<AreaEntry> sortedAreas;
-
-cv::Mat visualizeHuffmanTree(HuffmanNode* root);
-std::map<int, int> computeRegionAreas(const cv::Mat& markers);
-void heapSortAndDisplay(std::map<int, int>& areaMap);
-// utils.h 中修正声明
-std::set<int> binarySearchInRange(const std::vector<AreaEntry>& sortedAreas, int low, int high);
-void highlightRegions(
-    cv::Mat& image,
-    const cv::Mat& markers,
-    const std::set<int>& targetLabels,
-    const std::map<int, cv::Vec3b>& colorMap,
-    const std::map<int, int>& areaMap,
-    const std::map<int, cv::Point2f>& centerMap
-);
-HuffmanNode* buildHuffmanTree(const std::map<int, int>& areaMap);
-void generateHuffmanCodes(HuffmanNode* root, std::string code, std::map<int, std::string>& codeMap);
-void deleteHuffmanTree(HuffmanNode* root);
-std::map<int, cv::Vec3b> generateColorMap(const std::set<int>& labels);
-std::map<int, cv::Point2f> computeRegionCenters(
-    const cv::Mat& markers,
-    const std::map<int, int>& areaMap
-);
\ No newline at end of file
+﻿#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <queue>
+#include <functional>
+#include <random>
+#include <iostream>
+#include <chrono>
+#include <unordered_set>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <fstream>
+#include <sstream>
+#include <stack>
+#include <bitset>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <cstdint>
+using namespace std;
+using namespace cv;
+
+// ========== 通用结构体 ==========
+struct RegionGraph {
+    std::map<int, std::set<int>> adjacency;  // 邻接表
+    std::map<int, int> colorMap;             // 区域 label -> 颜色索引（0~3）
+};
+
+// ========== 运行环境：随机数与日志 ==========
+// 三个任务的库函数（SegmentationLib）不读写可变全局状态，随机数引擎与日志出口由调用方经 TaskEnv 显式传入。
+// 一个 TaskEnv 同一时刻只供一个线程使用；并发跑多路分割时每路各建一个，互不共享状态与锁。
+// 库函数的 env 参数为 nullptr 时：随机数取自 std::random_device，日志不输出。
+enum LogLevel { LOG_INFO, LOG_WARNING, LOG_ERROR };
+using LogSink = std::function<void(LogLevel level, const std::string& message)>;
+
+LogSink consoleLogSink();   // LOG_INFO 写 std::cout，其余写 std::cerr；整行加锁输出，多线程共用时各行不交错
+
+struct TaskEnv {
+    std::mt19937 rng;
+    LogSink log;            // 为空时不输出
+    explicit TaskEnv(uint32_t seed = std::random_device{}(), LogSink sink = LogSink())
+        : rng(seed), log(std::move(sink)) {}
+};
+
+// 拼接一行日志交给 env->log；env 或 sink 为空时直接返回，不做格式化
+template <typename... Args>
+void envLog(const TaskEnv* env, LogLevel level, const Args&... args) {
+    if (!env || !env->log) return;
+    std::ostringstream os;
+    (os << ... << args);
+    env->log(level, os.str());
+}
+
+// ========== 计时与条带并行（task_env.cpp） ==========
+double elapsedMs(std::chrono::high_resolution_clock::time_point start);   // 自 start 起的毫秒数
+// 对 i = 0 .. stripes - 1 各起一个线程执行 fn(i)，全部 join 后返回；单条带时在调用线程里直接执行
+void forEachStripe(int stripes, const std::function<void(int)>& fn);
+
+// ========== 字节序列化（码表、rANS 模型、标签图与轮廓编码、映射文件布局共用） ==========
+// 小端 u32；LEB128 无符号变长整数（每字节 7 位，低位在前，最多 10 字节）；zigzag 把有符号差分映射为小的无符号数
+inline void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    do {
+        uint8_t byte = v & 0x7F;
+        v >>= 7;
+        out.push_back(byte | (v ? 0x80 : 0));
+    } while (v);
+}
+
+// 读取失败（数据不完整或超过 10 字节）返回 false，pos 停在出错处
+inline bool getU32(const uint8_t* data, size_t size, size_t& pos, uint32_t& v) {
+    if (size - pos < 4) return false;
+    v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(data[pos++]) << (8 * i);
+    return true;
+}
+
+inline bool getVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift <= 63; shift += 7) {
+        if (pos >= size) return false;
+        uint8_t byte = data[pos++];
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t zigzagEncode(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t zigzagDecode(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// 映射文件（结果缓存记录、服务的共享内存结果）内各段的起始偏移按 8 字节对齐
+inline uint64_t align8(uint64_t v) { return (v + 7) & ~static_cast<uint64_t>(7); }
+
+// ========== 任务1：分水岭 ==========
+// 地形图预处理参数（整图、分割上下文与条带流式三条路径共用；修改后结果缓存自动失效）
+const double RELIEF_CANNY_LOW = 45;
+const double RELIEF_CANNY_HIGH = 65;
+const int RELIEF_CLOSE_KERNEL = 2;          // 闭运算核边长
+const double RELIEF_DISTANCE_WEIGHT = 0.5;  // 距离变换与闭运算结果的融合权重
+const int PLANARITY_MAX_RETRIES = 2;        // 邻接图非平面时重新生成种子的次数上限
+
+std::vector<cv::Point> generateSeedPoints(cv::Size size, int K, std::mt19937& rng);
+std::vector<cv::Point> generateSeedPoints(cv::Size size, int K);   // 引擎以 std::random_device 播种
+// 区域邻接图非平面时会重新生成种子，seeds 随之改写为实际使用的种子点
+cv::Mat computeMarkers(cv::Size size, std::vector<cv::Point>& seeds, const cv::Mat& src, TaskEnv* env = nullptr);
+cv::Mat computeWatershedRelief(const cv::Mat& src);
+cv::Mat computeMarkersFromRelief(cv::Size size, std::vector<cv::Point>& seeds, const cv::Mat& relief,
+    TaskEnv* env = nullptr);   // 非平面时用 env->rng 重新生成种子
+cv::Mat applyWatershedWithColor(const cv::Mat& src, const cv::Mat& markers);   // markers 为 CV_32S 或 CV_16U，只读
+cv::Mat visualizeSeedOverlay(const cv::Mat& image, const std::vector<cv::Point>& seeds);
+bool isPlanarGraph(const std::map<int, std::set<int>>& adjacency);
+
+// ---------- 多分辨率（金字塔）分水岭 ----------
+struct PyramidOptions {
+    int levels = 2;   // 下采样 2^levels 倍
+    int band = 1;     // 粗边界两侧待细化的条带宽度（粗像素）
+};
+
+struct PyramidStats {
+    double coarseMs = 0, upsampleMs = 0, refineMs = 0;
+    double bandFraction = 0;   // 原分辨率上重新淹没的像素占比
+};
+
+struct LabelMapAgreement {
+    double pixelAgreement = 0;
+    double boundaryPrecision = 0, boundaryRecall = 0;
+};
+
+cv::Mat computeMarkersPyramid(const std::vector<cv::Point>& seeds, const cv::Mat& src, const PyramidOptions& options);
+cv::Mat computeMarkersPyramidFromRelief(const std::vector<cv::Point>& seeds, const cv::Mat& relief,
+    const PyramidOptions& options, PyramidStats* stats = nullptr);
+cv::Mat loadImageReduced(const std::string& path, int factor);   // JPEG 按 1/2、1/4、1/8 缩小解码
+LabelMapAgreement compareLabelMaps(const cv::Mat& reference, const cv::Mat& labels, int tolerance);
+
+// ---------- 标签连通性校验（碎片检测与拆分） ----------
+enum FragmentPolicy {
+    FRAGMENTS_REPORT = 0,   // 只统计
+    FRAGMENTS_SPLIT,        // 每个碎片改为新标签（最大的一块保留原标签）
+    FRAGMENTS_ABSORB        // 面积小于下限的碎片并入面积最大的相邻区域，其余碎片改为新标签
+};
+
+struct FragmentReport {
+    int labels = 0;                 // 出现的标签数
+    int components = 0;             // 8 连通分量数
+    int fragmentedLabels = 0;       // 被分成多块的标签数
+    int splitFragments = 0;         // 改为新标签的碎片数
+    int absorbedFragments = 0;      // 并入邻居的碎片数
+    int64_t absorbedPixels = 0;
+    std::vector<int> fragmentsPerLabel;   // 下标为标签，每个标签的连通分量数
+};
+
+// 连通分量标记的工作区，跨帧复用
+struct ComponentScratch {
+    cv::Mat provisional;            // CV_32S 临时分量编号（按条带分段）
+    std::vector<int> parent, labelOf, area;   // 按临时编号；压缩后 parent 存分量号
+    std::vector<int> componentLabel, componentArea, finalLabel, absorbInto;
+    std::vector<int> mainComponent, stripeBegin, stripeEnd;
+};
+
+// 8 连通，标签 <= 0 视为背景；SPLIT / ABSORB 原地改写，CV_16U 放不下新标签时改为 CV_32S
+void resolveLabelFragments(cv::Mat& markers, FragmentPolicy policy, int minFragmentArea, FragmentReport& report,
+    ComponentScratch& scratch, int threads = 0);
+
+// ---------- 区域轮廓（裂缝跟踪链码 / 多边形） ----------
+// 坐标为像素角点：像素 (x, y) 占 [x, x + 1] x [y, y + 1]；所有轮廓共用一块缓冲，按偏移切分
+struct RegionContours {
+    int rows = 0, cols = 0;
+    std::vector<int> labels;               // 第 i 条轮廓的标签，按标签在光栅顺序中首次出现排列
+    std::vector<cv::Point> starts;         // 起点：该标签光栅顺序第一个像素的左上角
+    std::vector<uint32_t> chainOffset;     // 第 i 条链码为 chain[chainOffset[i], chainOffset[i + 1])
+    std::vector<uint8_t> chain;            // Freeman 4 向裂缝码：0 右、1 下、2 左、3 上，区域在行进方向右侧（顺时针）
+    std::vector<uint32_t> polygonOffset;   // 第 i 个多边形为 polygon[polygonOffset[i], polygonOffset[i + 1])
+    std::vector<cv::Point> polygon;        // 折点；epsilon > 0 时为 Douglas-Peucker 化简后的顶点
+
+    size_t size() const { return labels.size(); }
+    int perimeter(size_t i) const { return static_cast<int>(chainOffset[i + 1] - chainOffset[i]); }   // 裂缝数（像素边长）
+};
+
+// 一遍光栅扫描：每个标签第一次出现时沿像素边跟踪其所在 8 连通分量的外边界，标签 <= 0 视为背景。
+// 只输出外边界（不含孔洞）；同一标签有多块碎片时只跟踪最上方的一块，需要时先 resolveLabelFragments 拆分
+void extractRegionContours(const cv::Mat& markers, RegionContours& contours, double epsilon = 0);   // CV_32S 或 CV_16U
+// 紧凑序列化："RCTR" | 版本 | rows | cols | 轮廓数，每条轮廓标签差分、起点下标差分与周长，链码每步 2 位
+bool encodeRegionContours(const RegionContours& contours, std::vector<uint8_t>& out);
+bool decodeRegionContours(const uint8_t* data, size_t size, RegionContours& contours, double epsilon = 0);
+
+// ---------- 种子 Lloyd 细化（跳跃洪泛离散 Voronoi 图） ----------
+struct LloydOptions {
+    int iterations = 3;
+    int threads = 0;                // 0 表示 hardware_concurrency
+};
+
+struct LloydStats {
+    double jfaMs = 0;               // 各轮跳跃洪泛耗时之和
+    double reduceMs = 0;            // 各轮质心归约耗时之和
+    std::vector<double> cellAreaCv; // 每轮移动前 Voronoi 单元面积的变异系数（标准差 / 均值）
+};
+
+struct LloydScratch {
+    cv::Mat site[2];                // CV_32S 最近种子下标，两块交替读写
+    std::vector<int64_t> partial;   // 每个条带的 x、y 坐标和与像素数
+};
+
+// nearest 为 CV_32S，每个像素最近种子的下标（JFA+1：步长 2^k .. 1 后再补一轮步长 1）
+void computeVoronoiJFA(const std::vector<cv::Point>& seeds, cv::Size size, cv::Mat& nearest, LloydScratch& scratch, int threads = 0);
+// 原地把种子移到各自 Voronoi 单元的质心，空单元的种子不动
+void refineSeedsLloyd(std::vector<cv::Point>& seeds, cv::Size size, const LloydOptions& options, LloydScratch& scratch,
+    LloydStats* stats = nullptr);
+double areaCoefficientOfVariation(const std::vector<int>& areas);   // 忽略面积为 0 的下标
+
+// ---------- 交互式标记（增量重淹没） ----------
+struct StrokeUpdate {
+    cv::Rect dirty;                 // 标签有变化、已重绘的矩形
+    int64_t relabeled = 0;          // 重新确定标签的像素数
+    int erasedLabels = 0;           // 失去标记像素、整块重淹没的区域数
+    double floodMs = 0;
+    double paintMs = 0;
+};
+
+// 瓶颈（minimax）淹没：像素的淹没高度为从任一标记出发的路径上最大边权的最小值，边权与 cv::watershed 相同
+// （相邻像素地形图各通道差的最大值），标签取达到该高度的标记；高度唯一，只有等高时的归属与整图淹没可能不同
+class InteractiveWatershed {
+public:
+    void reset(const cv::Mat& src, const std::vector<cv::Point>& seeds);   // 计算地形图，种子画成标记后整图淹没并绘制
+    void refloodAll();                                                   // 按当前标记整图重淹没并重绘
+    int newLabel();                                                      // 新笔画的标签（同时分配颜色）
+    void stroke(cv::Point from, cv::Point to, int label, int thickness, StrokeUpdate& update);   // label 为 0 时擦除
+
+    const cv::Mat& labels() const { return labels_; }      // CV_32S，0 表示没有标记可达
+    const cv::Mat& levels() const { return levels_; }      // CV_16U 淹没高度
+    const cv::Mat& markers() const { return markers_; }    // CV_32S 标记标签，0 表示非标记
+    const cv::Mat& overlay() const { return overlay_; }    // 与原程序相同：区域颜色与灰度图各半，边界为白色
+
+    struct Box {                    // 闭区间外接框，x0 > x1 表示空
+        int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+        bool empty() const { return x0 > x1; }
+    };
+
+private:
+    void push(int pixel, int level) { buckets_[level].push_back(pixel); }
+    void propagate(Box& dirty, int64_t& relabeled);
+    void repaint(cv::Rect rect);
+
+    cv::Mat gray_;                  // 8UC3 灰度底图
+    cv::Mat relief_;
+    cv::Mat markers_, labels_, levels_, overlay_;
+    cv::Mat strokeMask_;
+    std::vector<Box> bounds_;       // 每个标签的外接框（只增不减，擦除后重建）
+    std::vector<cv::Vec3b> palette_;
+    std::vector<int> buckets_[256];
+    std::vector<int> erased_, rim_;
+    cv::RNG rng_;
+    int nextLabel_ = 1;
+};
+int runInteractive(int argc, char** argv);
+// ========== 任务2：四色图着色 ==========
+// 着色引擎的搜索计数与时间预算，由着色测试工具传入；为 nullptr 时引擎行为不变
+struct ColoringProbe {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    int64_t nodes = 0;      // 展开的搜索结点（各引擎的含义见其实现）
+    int restarts = 0;       // 放弃部分解重来的次数：删边重试、整体重试、修补轮
+    bool timedOut = false;
+    // 计一个结点，每 256 个结点读一次时钟；超时后一直返回 false
+    bool expand() {
+        if ((++nodes & 255) == 0 && !timedOut) timedOut = std::chrono::steady_clock::now() >= deadline;
+        return !timedOut;
+    }
+};
+
+RegionGraph buildRegionAdjacencyGraph(const cv::Mat& markers);   // markers 为 CV_32S 或 CV_16U，下同
+bool fourColorGraphBacktracking(RegionGraph& graph, ColoringProbe* probe = nullptr, TaskEnv* env = nullptr);
+cv::Mat visualizeFourColoring(const cv::Mat& markers, const RegionGraph& graph);
+bool fourColorGraphOptimized(RegionGraph& graph, ColoringProbe* probe = nullptr, TaskEnv* env = nullptr);
+int selectInitialRegion(const RegionGraph& graph);
+bool repeatUntilFourColorSuccess(RegionGraph& graph, ColoringProbe* probe = nullptr, TaskEnv* env = nullptr);
+cv::Mat visualizeFourColoring(const cv::Mat& markers, const RegionGraph& graph);// ✅ 着色结果可视化
+
+
+// ========== 任务3：哈夫曼编码 ==========
+
+struct HuffmanNode {
+    int weight;
+    int label;         // 区域标签（仅叶子节点有效）
+    HuffmanNode* left;
+    HuffmanNode* right;
+    // 以下由 layoutHuffmanTree 填写（画布坐标）
+    int x = 0, y = 0, depth = 0;
+    int minX = 0, maxX = 0;   // 子树横向范围，用于分块渲染时剪枝
+    HuffmanNode(int w, int l = -1) : weight(w), label(l), left(nullptr), right(nullptr) {}
+};
+
+// 哈夫曼树布局参数与结果
+const int HUFFMAN_NODE_RADIUS = 20;
+const int HUFFMAN_LEAF_SPACING = 2 * HUFFMAN_NODE_RADIUS + 6;   // 相邻叶子的水平间距
+const int HUFFMAN_LEVEL_SPACING = 50;                           // 相邻层的垂直间距
+const int64_t HUFFMAN_MAX_CANVAS_PIXELS = 64LL * 1024 * 1024;    // 整图渲染的画布上限
+
+struct HuffmanLayout {
+    int leafCount = 0;
+    int maxDepth = 0;
+    int width = 0;
+    int height = 0;
+};
+struct AreaEntry {
+    int label;
+    int area;
+};
+
+cv::Mat visualizeHuffmanTree(HuffmanNode* root, TaskEnv* env = nullptr);   // 画布过大只渲染顶部时经 env 提示
+HuffmanLayout layoutHuffmanTree(HuffmanNode* root);
+cv::Mat renderHuffmanTreeTile(HuffmanNode* root, const cv::Rect& tile);
+void writeHuffmanTreeSVG(HuffmanNode* root, const HuffmanLayout& layout, std::ostream& os);
+std::map<int, int> computeRegionAreas(const cv::Mat& markers);   // 本节的 markers 均接受 CV_32S 或 CV_16U
+void heapSortAndDisplay(std::map<int, int>& areaMap, TaskEnv* env = nullptr);
+// utils.h 中修正声明
+std::set<int> binarySearchInRange(const std::vector<AreaEntry>& sortedAreas, int low, int high);
+void highlightRegions(
+    cv::Mat& image,
+    const cv::Mat& markers,
+    const std::set<int>& targetLabels,
+    const std::map<int, cv::Vec3b>& colorMap,
+    const std::map<int, int>& areaMap,
+    const std::map<int, cv::Point2f>& centerMap
+);
+HuffmanNode* buildHuffmanTree(const std::map<int, int>& areaMap);
+void generateHuffmanCodes(HuffmanNode* root, std::string code, std::map<int, std::string>& codeMap);
+void deleteHuffmanTree(HuffmanNode* root);
+
+// 范式哈夫曼编码：码字按 (码长, 紧凑下标) 顺序分配，码表只需保存码长即可重建
+const int HUFFMAN_MAX_CODE_LENGTH = 32;
+
+struct HuffmanCode {
+    uint32_t bits;     // 码字（高位在前，共 len 位）
+    uint8_t len;       // 码长，0 表示该符号未出现
+};
+
+struct CanonicalHuffmanTable {
+    std::vector<int> labels;           // 紧凑下标 -> 区域标签（按标签升序）
+    std::vector<uint8_t> lengths;      // 紧凑下标 -> 码长
+    std::vector<HuffmanCode> codes;    // 紧凑下标 -> 码字
+    int maxLength = 0;
+};
+
+void computeHuffmanCodeLengths(const std::vector<uint64_t>& weights, int maxLength, std::vector<uint8_t>& lengths);
+bool assignCanonicalCodes(const std::vector<uint8_t>& lengths, std::vector<HuffmanCode>& codes);
+// 码长超过 HUFFMAN_MAX_CODE_LENGTH 等原因无法分配码字时返回 false，table 置空
+bool buildCanonicalHuffmanTable(const std::map<int, int>& areaMap, CanonicalHuffmanTable& table, int maxLength = 24);
+void serializeCodeLengths(const std::vector<uint8_t>& lengths, std::vector<uint8_t>& out);
+size_t deserializeCodeLengths(const uint8_t* data, size_t size, std::vector<uint8_t>& lengths);
+std::string huffmanCodeToString(const HuffmanCode& code);
+std::map<int, cv::Vec3b> generateColorMap(const std::set<int>& labels, TaskEnv* env = nullptr);
+std::map<int, cv::Point2f> computeRegionCenters(
+    const cv::Mat& markers,
+    const std::map<int, int>& areaMap
+);
+
+// ========== 自适应哈夫曼编码 ==========
+// 面积小幅变化时增量维护哈夫曼树（兄弟性质），无需整棵重建。n 为叶子数，d 为叶子码长
+class AdaptiveHuffmanTree {
+public:
+    void build(const std::map<int, int>& areaMap);
+    // 新标签自动插入；权值下限为 1。|Δ| · d <= n 时逐单位沿路径维护，O(|Δ| · d · log n)；
+    // 变化更大时按新权值整棵重建，O(n log n)，各标签码字可能整体改变
+    void updateWeight(int label, int newWeight);
+    // 码字缓存在叶子上：命中 O(1)；叶子所在子树被交换（或整棵重建）后首次查询沿父指针重算，O(d)。
+    // 查询会写缓存，同一棵树不能在多个线程中并发调用
+    bool getCode(int label, HuffmanCode& code) const;
+    int weight(int label) const;
+    size_t size() const { return leafOf_.size(); }
+    bool checkSiblingProperty() const;
+    void clear();
+
+private:
+    struct Node {
+        int64_t weight;
+        int parent, left, right;
+        int label;     // 内部结点为 -1
+        int number;    // 兄弟性质编号
+        // 码字缓存：叶子的 code 在 CODE_VALID 置位时有效；结点子树中可能有有效缓存时置 CODE_BELOW
+        mutable HuffmanCode code = { 0, 0 };
+        mutable uint8_t cache = 0;
+    };
+    static const uint8_t CODE_VALID = 1, CODE_BELOW = 2;
+
+    int newNode(int64_t weight, int label);
+    void invalidateCodes(int node);
+    int depthOf(int node) const;
+    void rebuildWith(int label, int64_t weight);
+    int blockFirst(int64_t weight) const;
+    int blockLeader(int64_t weight) const;
+    void swapNodes(int a, int b);
+    void incrementPath(int q);
+    void decrementPath(int q);
+    int insertLeaf(int label);
+
+    std::vector<Node> nodes_;
+    std::deque<int> order_;                  // 按编号升序排列的结点
+    std::unordered_map<int, int> leafOf_;    // 标签 -> 叶子结点
+    int firstNumber_ = 0;                    // order_[0] 的编号（插入新叶子时递减）
+    int root_ = -1;
+};
+
+// ========== rANS 熵编码 ==========
+const int RANS_STATE_COUNT = 4;       // 交错状态路数
+const int RANS_MAX_SCALE_BITS = 16;   // 概率精度上限（字节重归一化要求 <= 16）
+const uint32_t RANS_BYTE_L = 1u << 23; // 状态下界，低于它时读入一个字节
+
+struct RansModel {
+    int scaleBits = 0;                    // 频率总和为 2^scaleBits
+    std::vector<uint32_t> freq;           // 符号 -> 归一化频率
+    std::vector<uint32_t> cum;            // 符号 -> 累积频率（长度为符号数 + 1）
+    std::vector<uint16_t> slotToSymbol;   // 槽位 -> 符号（解码查表）
+};
+
+bool buildRansModel(const std::vector<uint64_t>& counts, int scaleBits, RansModel& model);
+bool buildRansModelFromFrequencies(const std::vector<uint32_t>& freq, int scaleBits, RansModel& model);
+void serializeRansModel(const RansModel& model, std::vector<uint8_t>& out);
+size_t deserializeRansModel(const uint8_t* data, size_t size, RansModel& model);
+void ransEncodeInterleaved(const std::vector<uint32_t>& symbols, const RansModel* const* models, int modelCount,
+    std::vector<uint8_t>& out);
+// 解码 count 个符号；字节不足、读完后各路状态不等于 RANS_BYTE_L 或还有剩余字节时返回 false
+bool ransDecodeInterleaved(const uint8_t* data, size_t size, const RansModel* const* models, int modelCount,
+    size_t count, std::vector<uint32_t>& symbols);
+
+// ========== 标签图压缩编解码 ==========
+enum LabelCodecBackend {
+    LABEL_CODEC_HUFFMAN = 0,
+    LABEL_CODEC_RANS = 1
+};
+
+bool encodeLabelMap(const cv::Mat& markers, std::vector<uint8_t>& out, LabelCodecBackend backend = LABEL_CODEC_HUFFMAN);   // CV_32S 或 CV_16U
+bool decodeLabelMap(const uint8_t* data, size_t size, cv::Mat& markers);
+bool decodeLabelMap(const std::vector<uint8_t>& data, cv::Mat& markers);
+
+// ========== 逐像素标签扫描内核（运行时指令集分派） ==========
+// 同一可执行文件内含标量、AVX2、AVX-512 三档实现，首次使用时按 CPUID 选择；各档结果与标量版逐字节相同。
+// 标签图均接受 CV_32S 或 CV_16U
+enum LabelKernelIsa {
+    LABEL_ISA_SCALAR = 0,
+    LABEL_ISA_AVX2 = 1,      // 另需 BMI1
+    LABEL_ISA_AVX512 = 2     // F + BW + VL，另需 BMI2
+};
+
+struct LabelKernels {
+    LabelKernelIsa isa;
+    int (*maxLabel)(const cv::Mat& labels);   // 不小于 0
+    // areas、sumX、sumY 长度须大于最大标签，结果累加到其中；标签 <= 0 跳过
+    void (*regionStats)(const cv::Mat& labels, int* areas, int64_t* sumX, int64_t* sumY);
+    // 前 rowCount 行的右、下、右下、左下邻接边（见 appendRegionAdjacencyEdges），present 标记出现的标签
+    void (*adjacencyEdges)(const cv::Mat& labels, int rowCount, std::vector<uint64_t>& edges, std::vector<uint8_t>& present);
+    // out 为同尺寸 CV_8UC3；标签 l 取 lut[l]（l <= 0 或越界取 lut[0]），低 3 字节为 BGR，最高位为 0 时不写该像素
+    void (*renderLut)(const cv::Mat& labels, const std::vector<uint32_t>& lut, cv::Mat& out);
+    // out 为同尺寸 CV_8U：与右邻或下邻标签不同为 1，否则为 0
+    void (*boundaryMask)(const cv::Mat& labels, cv::Mat& out);
+};
+
+LabelKernelIsa detectLabelKernelIsa();                  // CPU 与操作系统都支持的最高档
+const char* labelKernelIsaName(LabelKernelIsa isa);
+const LabelKernels& labelKernels();                     // 当前使用的一档，默认为 detectLabelKernelIsa()
+const LabelKernels& labelKernels(LabelKernelIsa isa);   // 指定一档，超出支持范围时降到可用的最高档
+void setLabelKernelIsa(LabelKernelIsa isa);             // 测试与基准用
+
+// ========== 分割上下文（缓冲区复用） ==========
+// 标签图存储类型：区域数不超过 65535 时用 CV_16U（0 表示边界/未分配），逐像素带宽减半；
+// cv::watershed 只接受 CV_32S，淹没阶段内部仍用 32 位，修复边界时顺带收窄
+enum LabelStorage {
+    LABEL_STORAGE_AUTO = 0,
+    LABEL_STORAGE_16U,
+    LABEL_STORAGE_32S
+};
+const int LABEL16_MAX_LABEL = 65535;
+
+// 返回 CV_16U 或 CV_32S；指定 16 位而标签超出范围时回退 32 位，不另行提示，调用方按返回值判断
+int selectLabelDepth(int maxLabel, LabelStorage storage = LABEL_STORAGE_AUTO);
+
+// 区域邻接图的 CSR 表示：标签 1..maxLabel，neighbors[offsets[l], offsets[l + 1]) 为 l 的邻居（升序）
+struct RegionAdjacencyCSR {
+    int maxLabel = 0;
+    std::vector<int> offsets;
+    std::vector<int> neighbors;
+    std::vector<uint8_t> present;   // 标签是否出现在 markers 中
+    int degree(int label) const { return offsets[label + 1] - offsets[label]; }
+};
+
+// CSR 着色引擎的工作区，跨帧复用
+struct CSRColoringScratch {
+    std::vector<int> degree, bucketHead, bucketNext, bucketPrev, order;
+    std::vector<int> stamp, queue;
+    int generation = 0;
+};
+
+void buildRegionAdjacencyCSR(const cv::Mat& markers, RegionAdjacencyCSR& graph, std::vector<uint64_t>& edgeScratch);
+// 4 邻域版本（仅 CV_32S），供淹没后的平面性判定
+void buildRegionAdjacencyCSR4(const cv::Mat& markers, RegionAdjacencyCSR& graph, std::vector<uint64_t>& edgeScratch);
+// 分条带构建：逐条追加边（present 须已覆盖全部标签），最后统一去重展开
+void appendRegionAdjacencyEdges(const cv::Mat& markers, int rowCount, std::vector<uint64_t>& edges, std::vector<uint8_t>& present);
+void finishRegionAdjacencyCSR(std::vector<uint64_t>& edges, int maxLabel, RegionAdjacencyCSR& graph);
+void repairWatershedBoundaries(cv::Mat& markers);   // CV_32S 原地修复分水岭边界与未分配像素
+// 边界修复内核：in 为 CV_32S，out 按 depth（CV_32S / CV_16U）创建；32 位时 out 可与 in 为同一张图（原地）。
+// 结果与线程数、扫描顺序无关；threads <= 0 取硬件线程数
+void resolveBoundaryLabels(const cv::Mat& in, cv::Mat& out, int depth, int threads = 0);
+void buildColoringLut(const std::vector<int8_t>& colors, std::vector<uint32_t>& lut);   // 供 LabelKernels::renderLut 使用
+void renderLabelColors(const cv::Mat& labels, const std::vector<int8_t>& colors, cv::Mat& out);
+int fourColorCSR(const RegionAdjacencyCSR& graph, std::vector<int8_t>& colors, CSRColoringScratch& scratch,
+    ColoringProbe* probe = nullptr);
+
+// 左右（LR）平面性测试的工作区，跨帧复用
+struct PlanarityScratch {
+    struct Interval {
+        int low = -1, high = -1;   // 回边（CSR 下标），-1 表示空
+    };
+    struct ConflictPair {
+        Interval left, right;
+    };
+    std::vector<int> twin, source, height, parentEdge, lowpt, lowpt2, nesting;
+    std::vector<int> ref, lowptEdge, stackBottom, next, outEnd, ordered, count, roots, dfs;
+    std::vector<uint8_t> direction, skip;
+    std::vector<ConflictPair> stack;
+    std::vector<uint64_t> edges;
+    RegionAdjacencyCSR subgraph;
+};
+
+bool isPlanarCSR(const RegionAdjacencyCSR& graph, PlanarityScratch& scratch);   // O(V + E)
+// 非平面时提取一个 Kuratowski 子图（K5 或 K3,3 的细分）的边，平面时返回 false
+bool findKuratowskiSubgraph(const RegionAdjacencyCSR& graph, std::vector<std::pair<int, int>>& edges, PlanarityScratch& scratch);
+std::string describeKuratowskiSubgraph(const std::vector<std::pair<int, int>>& edges);
+
+class CachedSegmentation;
+struct HierarchyLevel;
+
+// 持有并复用单帧所需的全部缓冲区：地形图、markers、渲染结果、标签表和图数组；
+// 节点型结构（哈夫曼树）分配在单调内存池中，每帧 beginFrame 时整体回收。
+// 帧尺寸与区域数稳定后，除 OpenCV 内部临时内存外不再有堆分配。
+class SegmentationContext {
+public:
+    SegmentationContext();
+    SegmentationContext(const SegmentationContext&) = delete;
+    SegmentationContext& operator=(const SegmentationContext&) = delete;
+
+    void beginFrame();
+    void setLabelStorage(LabelStorage storage) { labelStorage_ = storage; }   // 默认按区域数自动选择
+    void setThreads(int threads) { threads_ = threads; }   // 边界修复等条带内核的线程数，0 取硬件线程数
+    int labelDepth() const { return markers_.depth(); }
+
+    // 任务1
+    const cv::Mat& computeRelief(const cv::Mat& src);
+    const cv::Mat& flood(const std::vector<cv::Point>& seeds);
+    void setMarkers(const cv::Mat& markers);       // 接受 CV_32S 或 CV_16U
+    void attachCached(const CachedSegmentation& entry);   // markers 直接引用映射内存，entry 须在本帧内保持打开
+    void attachLevel(const HierarchyLevel& level);        // 层次分水岭提取的一层，markers 引用 level.labels，不复制
+    void renderWatershed(const cv::Mat& src, cv::Mat& out);
+
+    // 任务2
+    const RegionAdjacencyCSR& buildAdjacency();
+    int colorRegions();                            // 返回仍冲突的边数，0 表示着色成功
+    bool checkPlanarity(std::vector<std::pair<int, int>>* kuratowski = nullptr);   // 在 buildAdjacency 的结果上测试
+    void resolveFragments(FragmentPolicy policy, int minFragmentArea, FragmentReport& report);   // 改写后须重新建图、统计
+    void renderColoring(cv::Mat& out) const;
+
+    // 任务3
+    void computeRegionStats();                     // 面积与质心
+    void selectAreaRange(int low, int high);
+    HuffmanNode* buildHuffmanTree();               // 节点位于内存池，下次 beginFrame 前有效
+    void renderHighlight(const cv::Mat& src, cv::Mat& out, bool annotate = true) const;
+
+    const cv::Mat& relief() const { return relief_; }
+    const cv::Mat& markers() const { return markers_; }
+    const RegionAdjacencyCSR& adjacency() const { return graph_; }
+    const std::vector<int8_t>& colors() const { return colors_; }
+    const std::vector<int>& areas() const { return areas_; }
+    const std::vector<int64_t>& sumX() const { return sumX_; }
+    const std::vector<int64_t>& sumY() const { return sumY_; }
+    const AreaEntry* selectedBegin() const { return sortedAreas_.data() + selBegin_; }
+    const AreaEntry* selectedEnd() const { return sortedAreas_.data() + selEnd_; }
+    size_t arenaCapacity() const { return arenaStorage_.size(); }
+
+private:
+    // 记录单调内存池溢出到上游的字节数，下一帧据此扩容
+    class OverflowResource : public std::pmr::memory_resource {
+    public:
+        size_t overflowBytes = 0;
+    protected:
+        void* do_allocate(size_t bytes, size_t align) override;
+        void do_deallocate(void* p, size_t bytes, size_t align) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    void scanMaxLabel();
+    void detachCachedMarkers();
+
+    // 任务1 缓冲区
+    cv::Mat gray_, edges_, invEdges_, dist_, dist8U_, morph_, combined_, relief_, kernel_;
+    cv::Mat markers_, floodMarkers_, watershedMarkers_, watershedColor_;   // markers_ 为 CV_16U 或 CV_32S
+    LabelStorage labelStorage_ = LABEL_STORAGE_AUTO;
+    int threads_ = 0;
+    bool markersMapped_ = false;   // markers_ 引用外部内存（缓存映射或层级提取结果），写入前须先脱离
+    int maxLabel_ = 0;
+    std::vector<cv::Vec3b> labelPalette_;
+    std::vector<uint8_t> labelSeen_;
+
+    // 任务2 缓冲区
+    RegionAdjacencyCSR graph_;
+    std::vector<uint64_t> edgeScratch_;
+    std::vector<int8_t> colors_;
+    std::vector<uint32_t> colorLut_ = { 0xFF000000u };   // 着色结果的渲染查找表，未着色时全黑
+    CSRColoringScratch coloringScratch_;
+    PlanarityScratch planarityScratch_;
+    ComponentScratch componentScratch_;
+
+    // 任务3 缓冲区
+    std::vector<int> areas_;
+    std::vector<int64_t> sumX_, sumY_;
+    std::vector<AreaEntry> sortedAreas_;
+    std::vector<uint32_t> highlightLut_ = { 0 };   // 下标为标签，见 LabelKernels::renderLut
+    size_t selBegin_ = 0, selEnd_ = 0;
+    std::vector<HuffmanNode*> huffmanQueue_;
+
+    // 单调内存池
+    std::vector<std::byte> arenaStorage_;
+    OverflowResource arenaUpstream_;
+    std::optional<std::pmr::monotonic_buffer_resource> arena_;
+};
+
+// ========== 层次分水岭（合并树） ==========
+// 一次细粒度淹没 + 按鞍点高度的 Kruskal 合并树，任意更粗的区域数都可按需提取
+struct HierarchyLevel {
+    int regionCount = 0;
+    cv::Mat labels;                  // CV_16U 或 CV_32S，标签 1..regionCount
+    RegionAdjacencyCSR graph;
+    std::vector<int> areas;          // 以下数组下标为标签，长度 regionCount + 1
+    std::vector<int64_t> sumX, sumY;
+};
+
+class WatershedHierarchy {
+public:
+    // ctx 须已完成 computeRelief、flood、buildAdjacency 与 computeRegionStats
+    bool build(const SegmentationContext& ctx);
+    int fineRegionCount() const { return fineCount_; }
+    int minRegionCount() const { return fineCount_ - static_cast<int>(merges_.size()); }   // 邻接图连通分量数
+    void extract(int regionCount, HierarchyLevel& level);   // 区域数截断到 [minRegionCount, fineRegionCount]
+    void saliencyMap(cv::Mat& out) const;   // CV_32S 超度量轮廓图，见 task1_hierarchy.cpp
+
+private:
+    struct Merge {
+        int a, b;       // 合并时经过的细区域边
+        int altitude;   // 边界鞍点高度
+    };
+
+    int find(int v);
+    int slotOf(int a, int b) const;   // 边 (a, b) 在 a 的邻居表中的下标
+
+    cv::Mat fine_;
+    RegionAdjacencyCSR graph_;
+    std::vector<int> areas_;
+    std::vector<int64_t> sumX_, sumY_;
+    std::vector<int> edgeAltitude_, edgeLevel_;   // 按 CSR 下标，只使用 a < b 的一侧
+    std::vector<Merge> merges_;
+    std::vector<int> parent_, rootId_, lut_;
+    std::vector<uint64_t> edgeScratch_;
+    int fineCount_ = 0;
+};
+
+// ========== 条带流式处理（超大图像） ==========
+// 文件的内存映射窗口：同一时刻只映射一段，map 会先释放上一段
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, uint64_t size, bool writable);   // writable 时新建并设为 size 字节，否则 size 忽略
+    void close();
+    uint8_t* map(uint64_t offset, size_t length);                       // 失败返回 nullptr
+    void unmap();                                                        // 写回并释放当前窗口
+    uint64_t size() const { return size_; }
+
+private:
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    bool writable_ = false;
+    uint64_t size_ = 0;
+    uint8_t* view_ = nullptr;
+    size_t viewLength_ = 0;
+};
+
+// 按行随机读取图像，不整体载入：8 位二进制 PPM（P6）或无头 BGR 原始数据
+class StripImageReader {
+public:
+    bool openPPM(const std::string& path);
+    bool openRaw(const std::string& path, int width, int height);
+    bool readRows(int y0, int y1, cv::Mat& out);   // [y0, y1) 行，CV_8UC3（BGR）
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+private:
+    std::ifstream in_;
+    uint64_t dataOffset_ = 0;
+    bool rgb_ = false;
+    int rows_ = 0, cols_ = 0;
+};
+
+struct StreamingOptions {
+    size_t memoryBudget = static_cast<size_t>(512) << 20;   // 工作集预算（字节），决定条带高度
+    int halo = 64;                                          // 条带上下文行数（Canny 与淹没），越大越接近整图结果
+    LabelStorage labelStorage = LABEL_STORAGE_AUTO;
+    std::string coloringPath;                               // 非空时流式写出着色图（PPM）
+};
+
+struct StreamingResult {
+    int stripRows = 0, strips = 0;
+    int labelDepth = CV_32S;
+    int regions = 0, conflicts = 0;
+    std::vector<int64_t> areas, sumX, sumY;   // 下标为标签
+    RegionAdjacencyCSR graph;
+    std::vector<int8_t> colors;
+    double reliefMs = 0, floodMs = 0, statsMs = 0, renderMs = 0;
+    size_t peakRss = 0;
+};
+
+// 标签文件格式："LBLS" | 每像素字节 u8 | 保留 3 字节 | rows u32 | cols u32 | 按行排列的标签
+bool segmentStreaming(StripImageReader& reader, const std::vector<cv::Point>& seeds, const std::string& labelPath,
+    const StreamingOptions& options, StreamingResult& result);
+bool readLabelFile(const std::string& path, cv::Mat& labels);
+bool writeLabelFile(const std::string& path, const cv::Mat& labels);   // CV_16U 或 CV_32S，格式同上
+bool writePPM(const std::string& path, const cv::Mat& bgr);
+size_t peakResidentBytes();
+
+// ========== 分割结果缓存 ==========
+// 同一图像、同一 K、随机种子与预处理参数的分割结果（种子点、标签图、面积/质心、CSR 邻接图）按平铺二进制格式存盘，
+// 再次运行时整体内存映射复用，跳过任务1。缓存目录按磁盘上限以最近使用顺序淘汰。
+// 随机种子是键的一部分：换种子就是换一次分割，不会复用旧结果
+const uint32_t SEGMENTATION_CACHE_VERSION = 2;
+
+// 一条已映射的缓存记录：标签图与各数组直接指向映射内存（零拷贝），记录关闭或销毁前有效
+class CachedSegmentation {
+public:
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return base_ != nullptr; }
+
+    uint64_t imageHash() const { return imageHash_; }
+    uint64_t paramsHash() const { return paramsHash_; }
+    int K() const { return K_; }
+    const cv::Mat& labels() const { return labels_; }   // CV_16U 或 CV_32S，只读
+    std::vector<cv::Point> seeds() const;
+    int maxLabel() const { return maxLabel_; }
+    const int32_t* areas() const { return areas_; }      // 以下数组下标为标签，长度 maxLabel + 1
+    const int64_t* sumX() const { return sumX_; }
+    const int64_t* sumY() const { return sumY_; }
+    void adjacency(RegionAdjacencyCSR& graph) const;     // 复制为 CSR（规模与区域数成正比）
+
+private:
+    MappedFile file_;
+    const uint8_t* base_ = nullptr;
+    cv::Mat labels_;
+    uint64_t imageHash_ = 0, paramsHash_ = 0;
+    int K_ = 0;
+    const int32_t* seeds_ = nullptr;
+    int seedCount_ = 0, maxLabel_ = 0;
+    const int32_t* areas_ = nullptr;
+    const int64_t* sumX_ = nullptr;
+    const int64_t* sumY_ = nullptr;
+    const uint8_t* present_ = nullptr;
+    const int32_t* offsets_ = nullptr;
+    const int32_t* neighbors_ = nullptr;
+    int64_t neighborCount_ = 0;
+};
+
+class SegmentationCache {
+public:
+    explicit SegmentationCache(const std::string& directory, uint64_t diskBudget = static_cast<uint64_t>(1) << 30);
+    ~SegmentationCache();   // 命中/未命中/淘汰计数累加写回目录下的 stats 文件
+    SegmentationCache(const SegmentationCache&) = delete;
+    SegmentationCache& operator=(const SegmentationCache&) = delete;
+
+    static uint64_t imageHash(const cv::Mat& image);   // 尺寸、类型与像素内容的 FNV-1a 散列
+    static uint64_t paramsHash(int K, uint32_t seed);  // K、随机种子、地形图预处理参数与格式版本
+
+    bool lookup(uint64_t imageHash, int K, uint32_t seed, CachedSegmentation& entry);   // 命中时刷新最近使用时间
+    bool store(uint64_t imageHash, int K, uint32_t seed, const std::vector<cv::Point>& seeds, const cv::Mat& markers);
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    size_t evictions() const { return evictions_; }
+    uint64_t diskUsage() const;
+    void printStats(std::ostream& os) const;
+
+private:
+    std::string entryPath(uint64_t imageHash, uint64_t paramsHash) const;
+    void evict(uint64_t incoming);
+
+    std::string directory_;
+    uint64_t diskBudget_;
+    size_t hits_ = 0, misses_ = 0, evictions_ = 0;
+};
+
+// ========== 工具模式入口（tool_modes.cpp，只编进应用程序） ==========
+int runLloyd(int argc, char** argv);
+int runPyramid(int argc, char** argv);
+int runHierarchy(int argc, char** argv);
+int runStreaming(int argc, char** argv);
+
+// ========== 常驻分割服务 ==========
+// Unix 域套接字上按行收发请求，结果经共享内存文件返回（协议与结果文件格式见 server.cpp）
+int runServer(int argc, char** argv);
+int runLoadGenerator(int argc, char** argv);
+
+// ========== 内存统计 ==========
+// 全局 operator new / delete 与 cv::Mat 分配器的计数（memory_tracking.cpp）
+// 默认关闭，operator new 只多写一个块头；setAllocationCounting(true) 或 setMemoryTracking(true) 之后的分配才计入
+size_t heapAllocationCount();
+size_t heapLiveBytes();     // operator new 分配、尚未释放的字节数
+size_t heapPeakBytes();     // 自上次 resetHeapPeak 以来在用字节数的峰值
+void resetHeapPeak();
+size_t matAllocationCount();
+void setAllocationCounting(bool enabled);      // 同时开关 operator new 计数与 cv::Mat 分配器接管
+
+// 按阶段统计：分配计入当前线程所在的阶段，释放计回分配它的阶段
+struct MemoryStageStats {
+    std::string name;
+    size_t heapAllocations = 0, heapBytes = 0;   // 累计次数与字节数
+    size_t heapLive = 0, heapPeak = 0;           // 本阶段分配、尚未释放的字节数及其峰值
+    size_t matAllocations = 0, matBytes = 0, matLive = 0, matPeak = 0;
+};
+
+void setMemoryTracking(bool enabled);           // 打开时同时打开 setAllocationCounting
+bool memoryTrackingEnabled();
+int memoryStageId(const std::string& name);     // 同名同号；阶段数超过上限时返回 0（未标记）
+MemoryStageStats memoryStageStats(int stage);
+void printMemoryStage(std::ostream& os, const MemoryStageStats& s);
+
+// 作用域内当前线程的分配计入 stage，可嵌套；阶段不随任务传给其他线程，
+// 作用域内起的条带线程或 cv::parallel_for_ 工作线程的分配计入 0 号（未标记）
+class MemoryStageScope {
+public:
+    explicit MemoryStageScope(int stage);
+    ~MemoryStageScope();
+    MemoryStageScope(const MemoryStageScope&) = delete;
+    MemoryStageScope& operator=(const MemoryStageScope&) = delete;
+private:
+    int previous_;
+};
+
+// ========== 任务图流水线 ==========
+// 依赖图执行器：结点按需（惰性）求值、结果缓存，工作窃取线程池并行调度
+class TaskGraph {
+public:
+    struct NodeTiming {
+        std::string name;
+        double startMs = 0, endMs = 0;   // 相对本次 evaluate 开始
+        int worker = -1;
+        int memoryStage = 0;             // 内存统计中的阶段编号（与结点同名）
+    };
+    struct RunReport {
+        std::vector<NodeTiming> nodes;          // 本次实际计算的结点
+        std::vector<std::string> criticalPath;
+        double wallMs = 0;
+        double cpuMs = 0;                        // 各结点耗时之和
+        double criticalPathMs = 0;               // 最长依赖链耗时
+    };
+
+    explicit TaskGraph(int threadCount = 0);     // 0 表示使用硬件线程数
+    ~TaskGraph();
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    int addNode(const std::string& name, std::function<void()> fn, const std::vector<int>& deps = {});
+    void evaluate(const std::vector<int>& targets);   // 只计算目标及其未完成的依赖
+    bool isDone(int node) const { return nodes_[node].done; }
+    void markDone(int node) { nodes_[node].done = true; }   // 输出已由外部填好（如结果缓存）
+    const RunReport& lastReport() const { return report_; }
+    void printReport(std::ostream& os) const;
+
+private:
+    struct Node {
+        std::string name;
+        std::function<void()> fn;
+        std::vector<int> deps;
+        std::vector<int> dependents;   // 仅本次求值闭包内
+        std::atomic<int> pending{ 0 };
+        bool done = false;
+        NodeTiming timing;
+    };
+    struct Worker {
+        std::deque<int> tasks;
+        std::mutex mutex;
+    };
+
+    void workerLoop(int index);
+    bool popTask(int index, int& node);
+    void pushTask(int index, int node);
+    void runNode(int index, int node);
+
+    std::deque<Node> nodes_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::mutex sleepMutex_;
+    std::condition_variable wakeWorkers_, runFinished_;
+    std::atomic<int> queued_{ 0 }, remaining_{ 0 };
+    bool stopping_ = false;
+    std::chrono::high_resolution_clock::time_point runStart_;
+    RunReport report_;
+};
+
+// 分割流水线的各个阶段
+enum PipelineStage {
+    STAGE_RELIEF = 0,
+    STAGE_SEEDS,
+    STAGE_FLOOD,
+    STAGE_ADJACENCY,
+    STAGE_COLORING,
+    STAGE_STATS,
+    STAGE_SORT,
+    STAGE_HUFFMAN,
+    STAGE_RENDER_SEEDS,
+    STAGE_RENDER_WATERSHED,
+    STAGE_RENDER_COLORING,
+    STAGE_RENDER_HIGHLIGHT,
+    STAGE_RENDER_HUFFMAN,
+    STAGE_COUNT
+};
+
+struct PipelineOutputs {
+    cv::Mat relief;
+    std::vector<cv::Point> seeds;
+    cv::Mat markers;
+    RegionGraph graph;
+    bool coloringOk = false;
+    std::map<int, int> areaMap;
+    std::vector<AreaEntry> sortedAreas;
+    std::set<int> targetLabels;
+    std::map<int, int> filteredAreaMap;
+    HuffmanNode* huffmanTree = nullptr;
+    CanonicalHuffmanTable huffmanTable;
+    cv::Mat seedOverlay, watershedView, colorView, highlightView, huffmanView;
+};
+
+class SegmentationPipeline {
+public:
+    // seed 为种子生成与着色重试所用的随机种子（结果缓存的键之一）
+    SegmentationPipeline(const cv::Mat& src, int K, int areaLow, int areaHigh, uint32_t seed, int threadCount = 0);
+    ~SegmentationPipeline();
+    void evaluate(const std::vector<PipelineStage>& stages);
+    void restore(const CachedSegmentation& entry);   // 用缓存填充种子/淹没/邻接/面积，随后不再计算任务1
+    const PipelineOutputs& outputs() const { return out_; }
+    const TaskGraph& graph() const { return graph_; }
+
+private:
+    cv::Mat src_;
+    int K_, areaLow_, areaHigh_;
+    TaskEnv env_;
+    PipelineOutputs out_;
+    TaskGraph graph_;
+    int ids_[STAGE_COUNT];
+};
+
+int runPipeline(int argc, char** argv);
+
+// ========== 合成负载生成 ==========
+// 给定随机种子可复现的纹理图像、标签图与区域图，用于规模测试（生成方法见 workload.cpp）
+void generateTextureRows(cv::Size size, uint64_t seed, int y0, int y1, cv::Mat& out);   // 整幅图像的 [y0, y1) 行，CV_8UC3
+cv::Mat generateTexturedImage(cv::Size size, uint64_t seed);
+bool writeTexturedPPM(const std::string& path, cv::Size size, uint64_t seed);           // 逐条带生成写出，内存与宽度成正比
+
+struct LabelMapSpec {
+    cv::Size size = cv::Size(1000, 1000);
+    int regions = 1000;         // 标签 1..regions，每个至少一个像素
+    double sizeSkew = 0;        // 0 为均匀；种子坐标按 u^(1 + sizeSkew) 向左上角聚集，面积差异随之增大
+    double fragmentRate = 0;    // 植入一块离体碎片（3 x 3）的区域比例 [0, 1]
+    int depth = CV_32S;         // CV_16U 时区域数不超过 65535
+};
+
+struct LabelMapInfo {
+    int regions = 0;
+    int plantedFragments = 0;   // 落点不足时可能少于 fragmentRate × regions
+    double areaCv = 0;          // 区域面积变异系数
+    int smallestArea = 0, largestArea = 0;
+};
+
+bool generateLabelMap(const LabelMapSpec& spec, uint64_t seed, cv::Mat& labels, LabelMapInfo* info = nullptr);
+
+enum SyntheticGraphKind {
+    SYNTHETIC_APOLLONIAN,        // 随机 Apollonian 网络：极大平面图（3V - 6 条边），度数悬殊，4 着色唯一
+    SYNTHETIC_K5_CHAIN,          // K5 去一边的小块首尾相接：平面图，每块强制两端同色
+    SYNTHETIC_K5_CHAIN_CLOSED    // 再连上链首尾：不可 4 着色，因而非平面，Kuratowski 子图贯穿整条链
+};
+
+// 标签 1..vertices 全部出现；K5 链的顶点数向下取到 4k + 1
+bool generateSyntheticGraph(SyntheticGraphKind kind, int vertices, uint64_t seed, RegionAdjacencyCSR& graph);
+const char* syntheticGraphName(SyntheticGraphKind kind);
+void regionGraphFromCSR(const RegionAdjacencyCSR& csr, RegionGraph& graph);   // 供原有 std::map 着色引擎使用
+bool writeDimacsGraph(const std::string& path, const RegionAdjacencyCSR& graph, const std::string& comment);
+int runGenerate(int argc, char** argv);
+
+// ========== 着色引擎测试 ==========
+// 读入的图标签 1..n 全部出现；DIMACS 沿用文件中的顶点号，边表按编号大小映射
+bool readDimacsGraph(const std::string& path, RegionAdjacencyCSR& graph);
+bool readEdgeListGraph(const std::string& path, RegionAdjacencyCSR& graph);
+bool readGraphFile(const std::string& path, RegionAdjacencyCSR& graph);   // .col / .dimacs 按 DIMACS，其余按边表
+int runColorBench(int argc, char** argv);
+
+// ========== 性能测试 ==========
+int runBenchmarks(int argc, char** argv);
+int runPerfCheck(int argc, char** argv);   // 返回 0 通过（或默认基线尚未建立），1 有回归，-1 出错
+void benchmarkLabelMapCodec(const cv::Mat& markers, int repeats = 5);
+void benchmarkEntropyBackends(const cv::Mat& markers, int repeats = 5);
+void benchmarkHuffmanLayout(int leafCount);
+void benchmarkAdaptiveHuffman(int regionCount, int updates = 20000);
+void benchmarkSegmentationContext(const cv::Mat& src, const std::vector<cv::Point>& seeds, int frames = 8);
+void benchmarkLabelDepth(const cv::Mat& src, int K, int repeats = 5);
+void benchmarkStreaming(const cv::Mat& src, const std::vector<cv::Point>& seeds);
+void benchmarkResultCache(const cv::Mat& src, const std::vector<cv::Point>& seeds);
+void benchmarkPyramid(const cv::Mat& src, const std::vector<cv::Point>& seeds, const std::string& path);
+void benchmarkHierarchy(const cv::Mat& src, const std::vector<int>& levels);
+void benchmarkPlanarity(const cv::Mat& src, const std::vector<int>& regionCounts);
+void benchmarkFragments(const cv::Mat& src, const std::vector<cv::Point>& seeds);
+void benchmarkLloyd(const cv::Mat& src, int K, int iterations);
+void benchmarkContours(const cv::Mat& markers, int repeats = 5);
+void benchmarkBoundary(const cv::Mat& src, int K);
+void benchmarkLabelKernels(const cv::Mat& src, int K, int repeats = 5);
+void benchmarkSynthetic(const std::vector<int>& megapixels, const std::vector<int>& regionCounts,
+    const std::vector<int>& graphSizes);
+void benchmarkInteractive(const cv::Mat& src, int K, int strokes);
@@ -0,0 +1,392 @@
+﻿#include "utils.h"
+
+// ====================================================
+// ✅ 合成负载生成（给定随机种子可完全复现）
+//     1. 纹理图像：三个尺度的格点值噪声叠加，低频一层量化成色块（给 Canny / 分水岭真实的边），
+//        另加逐像素颗粒噪声。每个像素只由 (种子, 坐标) 决定，可按任意行区间生成，
+//        写 PPM 时逐条带生成、逐条带写出，内存与宽度成正比，可直接作为 --stream 的输入；
+//     2. 标签图：指定区域数的种子经跳跃洪泛求 Voronoi 图，种子坐标按 u^(1 + 偏斜) 向左上角聚集以拉开面积差异，
+//        再按比例给区域植入一块离体碎片（3 x 3，四周 5 x 5 全属另一区域）；
+//     3. 区域图：随机 Apollonian 网络（极大平面图，4 着色唯一），以及 K5 去一边的小块首尾相接成链
+//        （每块强制两端同色，链长任意，仍是平面图；再连上链首尾即为非平面图）。
+//     随机数用 splitmix64 自行换算，不经 std:: 分布（各标准库实现不同），换编译器后同一种子的结果不变。
+// ====================================================
+
+// ---------- 可复现随机数 ----------
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+struct SplitMix64 {
+    uint64_t state;
+    uint64_t next() { return mix64(state++ * 0x9E3779B97F4A7C15ull); }
+    int below(int n) { return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32); }   // [0, n)
+    double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }           // [0, 1)
+};
+
+// 条带数不超过线程数，每条至少 16 行
+static int stripeCount(int rows) {
+    const int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    return std::max(1, std::min(threads, rows / 16));
+}
+
+// ---------------------- 纹理图像 ----------------------
+// 三个尺度（格距 128 / 32 / 8 像素）与各自的权重；第一层量化成 TEXTURE_LEVELS 级
+static const int TEXTURE_CELLS[3] = { 128, 32, 8 };
+static const float TEXTURE_WEIGHTS[3] = { 0.65f, 0.25f, 0.10f };
+static const int TEXTURE_LEVELS = 5;
+static const int TEXTURE_GRAIN = 12;   // 逐像素颗粒噪声幅度（灰度级）
+
+static float latticeValue(uint64_t seed, int channel, int octave, int gx, int gy) {
+    const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(gy)) << 32 | static_cast<uint32_t>(gx))
+        ^ (static_cast<uint64_t>(channel * 3 + octave) << 58);
+    return static_cast<float>(mix64(seed ^ mix64(key)) >> 40) * (1.0f / 16777216.0f);
+}
+
+static float smoothstep(float t) { return t * t * (3 - 2 * t); }
+
+// [y0, y1) 行：每个尺度先沿 y 在两行格点间插值得到一行格点值，再按格内位置的权重表沿 x 插值
+static void textureRows(cv::Size size, uint64_t seed, int y0, int y1, cv::Mat& out, int outRow0) {
+    const int cols = size.width;
+    std::vector<float> weight[3], lattice(static_cast<size_t>(cols / TEXTURE_CELLS[2] + 2));
+    for (int o = 0; o < 3; ++o) {
+        weight[o].resize(TEXTURE_CELLS[o]);
+        for (int i = 0; i < TEXTURE_CELLS[o]; ++i) weight[o][i] = smoothstep(static_cast<float>(i) / TEXTURE_CELLS[o]);
+    }
+    std::vector<float> value(static_cast<size_t>(cols) * 3);
+    for (int y = y0; y < y1; ++y) {
+        std::fill(value.begin(), value.end(), 0.0f);
+        for (int c = 0; c < 3; ++c) {
+            for (int o = 0; o < 3; ++o) {
+                const int cell = TEXTURE_CELLS[o];
+                const int gy = y / cell;
+                const float fy = weight[o][y % cell];
+                const int latticeCols = cols / cell + 2;
+                for (int gx = 0; gx < latticeCols; ++gx) {
+                    const float a = latticeValue(seed, c, o, gx, gy), b = latticeValue(seed, c, o, gx, gy + 1);
+                    lattice[gx] = a + (b - a) * fy;
+                }
+                float* v = value.data() + c;
+                for (int x0 = 0, gx = 0; x0 < cols; x0 += cell, ++gx) {
+                    const float left = lattice[gx], slope = lattice[gx + 1] - lattice[gx];
+                    const int x1 = std::min(cols, x0 + cell);
+                    for (int x = x0; x < x1; ++x) {
+                        float t = left + slope * weight[o][x - x0];
+                        if (o == 0) t = std::min(std::floor(t * TEXTURE_LEVELS), TEXTURE_LEVELS - 1.0f) / (TEXTURE_LEVELS - 1);
+                        v[3 * x] += TEXTURE_WEIGHTS[o] * t;
+                    }
+                }
+            }
+        }
+        // 颗粒噪声：每像素一次散列，三个通道各取 16 位
+        uchar* dst = out.ptr<uchar>(outRow0 + y - y0);
+        for (int x = 0; x < cols; ++x) {
+            const uint64_t h = mix64(seed ^ (static_cast<uint64_t>(y) << 32 | static_cast<uint32_t>(x)));
+            for (int c = 0; c < 3; ++c) {
+                const int grain = static_cast<int>((h >> (16 * c)) & 0xFFFF) % (2 * TEXTURE_GRAIN + 1) - TEXTURE_GRAIN;
+                dst[3 * x + c] = cv::saturate_cast<uchar>(value[3 * x + c] * 255.0f + grain);
+            }
+        }
+    }
+}
+
+void generateTextureRows(cv::Size size, uint64_t seed, int y0, int y1, cv::Mat& out) {
+    out.create(y1 - y0, size.width, CV_8UC3);
+    const int stripes = stripeCount(y1 - y0);
+    forEachStripe(stripes, [&](int i) {
+        const int a = y0 + static_cast<int>(static_cast<int64_t>(y1 - y0) * i / stripes);
+        const int b = y0 + static_cast<int>(static_cast<int64_t>(y1 - y0) * (i + 1) / stripes);
+        textureRows(size, seed, a, b, out, a - y0);
+    });
+}
+
+cv::Mat generateTexturedImage(cv::Size size, uint64_t seed) {
+    cv::Mat image;
+    generateTextureRows(size, seed, 0, size.height, image);
+    return image;
+}
+
+// 逐条带生成并写出，每条 256 行
+bool writeTexturedPPM(const std::string& path, cv::Size size, uint64_t seed) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    out << "P6\n" << size.width << " " << size.height << "\n255\n";
+    cv::Mat strip;
+    std::vector<uint8_t> row(static_cast<size_t>(size.width) * 3);
+    for (int y0 = 0; y0 < size.height; y0 += 256) {
+        const int y1 = std::min(size.height, y0 + 256);
+        generateTextureRows(size, seed, y0, y1, strip);
+        for (int y = 0; y < strip.rows; ++y) {
+            const uchar* src = strip.ptr<uchar>(y);
+            for (int x = 0; x < size.width; ++x) {
+                row[3 * x] = src[3 * x + 2];
+                row[3 * x + 1] = src[3 * x + 1];
+                row[3 * x + 2] = src[3 * x];
+            }
+            out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+// ---------------------- 标签图 ----------------------
+bool generateLabelMap(const LabelMapSpec& spec, uint64_t seed, cv::Mat& labels, LabelMapInfo* info) {
+    const int rows = spec.size.height, cols = spec.size.width;
+    const int64_t pixels = static_cast<int64_t>(rows) * cols;
+    if (rows <= 0 || cols <= 0 || spec.regions < 1 || spec.regions > pixels || spec.sizeSkew < 0 ||
+        spec.fragmentRate < 0 || spec.fragmentRate > 1) {
+        std::cerr << " 标签图参数非法：区域数应在 [1, 像素数] 内，偏斜不小于 0，碎片率在 [0, 1] 内。" << std::endl;
+        return false;
+    }
+    if (spec.depth == CV_16U && spec.regions > 65535) {
+        std::cerr << " 16 位标签图最多 65535 个区域。" << std::endl;
+        return false;
+    }
+
+    // 种子互不重合，每个种子至少占有自身像素，区域数恰为 spec.regions
+    SplitMix64 rng{ seed };
+    std::vector<cv::Point> seeds;
+    seeds.reserve(spec.regions);
+    std::unordered_set<int64_t> taken;
+    taken.reserve(spec.regions * 2);
+    const double exponent = 1 + spec.sizeSkew;
+    int misses = 0;
+    while (static_cast<int>(seeds.size()) < spec.regions) {
+        // 聚集处取满后（连续落在已有种子上）改为均匀取点，保证能取满
+        cv::Point p;
+        if (misses < 16) {
+            p.x = std::min(cols - 1, static_cast<int>(std::pow(rng.uniform(), exponent) * cols));
+            p.y = std::min(rows - 1, static_cast<int>(std::pow(rng.uniform(), exponent) * rows));
+        }
+        else {
+            p.x = rng.below(cols);
+            p.y = rng.below(rows);
+        }
+        if (taken.insert(static_cast<int64_t>(p.y) * cols + p.x).second) {
+            seeds.push_back(p);
+            misses = 0;
+        }
+        else {
+            ++misses;
+        }
+    }
+
+    LloydScratch scratch;
+    cv::Mat nearest;
+    computeVoronoiJFA(seeds, spec.size, nearest, scratch);
+    for (int y = 0; y < rows; ++y) {
+        int* row = nearest.ptr<int>(y);
+        for (int x = 0; x < cols; ++x) ++row[x];
+    }
+
+    // 碎片：区域按随机顺序取前 fragmentRate 比例，每个最多尝试 64 个落点
+    int planted = 0;
+    const int wanted = static_cast<int>(std::lround(spec.fragmentRate * spec.regions));
+    if (wanted > 0 && rows >= 5 && cols >= 5) {
+        std::vector<int> order(spec.regions);
+        for (int i = 0; i < spec.regions; ++i) order[i] = i + 1;
+        for (int i = spec.regions - 1; i > 0; --i) std::swap(order[i], order[rng.below(i + 1)]);
+        for (int i = 0; i < wanted; ++i) {
+            const int l = order[i];
+            for (int attempt = 0; attempt < 64; ++attempt) {
+                const int cx = 2 + rng.below(cols - 4), cy = 2 + rng.below(rows - 4);
+                const int host = nearest.at<int>(cy, cx);
+                bool clear = host != l;
+                for (int dy = -2; dy <= 2 && clear; ++dy) {
+                    const int* row = nearest.ptr<int>(cy + dy);
+                    for (int dx = -2; dx <= 2 && clear; ++dx) clear = row[cx + dx] == host;
+                }
+                if (!clear) continue;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    int* row = nearest.ptr<int>(cy + dy);
+                    for (int dx = -1; dx <= 1; ++dx) row[cx + dx] = l;
+                }
+                ++planted;
+                break;
+            }
+        }
+    }
+
+    if (spec.depth == CV_16U) nearest.convertTo(labels, CV_16U);
+    else labels = nearest;
+    if (info) {
+        std::vector<int> areas(spec.regions + 1, 0);
+        for (int y = 0; y < rows; ++y) {
+            const int* row = nearest.ptr<int>(y);
+            for (int x = 0; x < cols; ++x) ++areas[row[x]];
+        }
+        info->regions = spec.regions;
+        info->plantedFragments = planted;
+        info->areaCv = areaCoefficientOfVariation(areas);
+        info->largestArea = *std::max_element(areas.begin(), areas.end());
+        info->smallestArea = *std::min_element(areas.begin() + 1, areas.end());
+    }
+    return true;
+}
+
+// ---------------------- 区域图 ----------------------
+// 0 起的顶点编号按随机排列映射到标签 1..vertices，结构不随编号泄露
+static void finishSyntheticGraph(std::vector<std::pair<int, int>>& pairs, int vertices, SplitMix64& rng, RegionAdjacencyCSR& graph) {
+    std::vector<int> label(vertices);
+    for (int i = 0; i < vertices; ++i) label[i] = i + 1;
+    for (int i = vertices - 1; i > 0; --i) std::swap(label[i], label[rng.below(i + 1)]);
+    std::vector<uint64_t> edges;
+    edges.reserve(pairs.size());
+    for (const auto& [u, v] : pairs) {
+        const int a = label[u], b = label[v];
+        edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | static_cast<uint32_t>(std::max(a, b)));
+    }
+    finishRegionAdjacencyCSR(edges, vertices, graph);
+    graph.present.assign(vertices + 1, 1);
+    graph.present[0] = 0;
+}
+
+bool generateSyntheticGraph(SyntheticGraphKind kind, int vertices, uint64_t seed, RegionAdjacencyCSR& graph) {
+    SplitMix64 rng{ seed };
+    std::vector<std::pair<int, int>> pairs;
+    if (kind == SYNTHETIC_APOLLONIAN) {
+        if (vertices < 3) {
+            std::cerr << " Apollonian 网络至少 3 个顶点。" << std::endl;
+            return false;
+        }
+        // 随机取一个三角面，插入新顶点连向三个角，面一分为三
+        struct Face { int a, b, c; };
+        std::vector<Face> faces = { { 0, 1, 2 } };
+        faces.reserve(2 * static_cast<size_t>(vertices));
+        pairs = { { 0, 1 }, { 1, 2 }, { 0, 2 } };
+        pairs.reserve(3 * static_cast<size_t>(vertices));
+        for (int v = 3; v < vertices; ++v) {
+            const int f = rng.below(static_cast<int>(faces.size()));
+            const Face face = faces[f];
+            pairs.insert(pairs.end(), { { face.a, v }, { face.b, v }, { face.c, v } });
+            faces[f] = { face.a, face.b, v };
+            faces.push_back({ face.b, face.c, v });
+            faces.push_back({ face.a, face.c, v });
+        }
+    }
+    else {
+        // 块 i 的两端为 4i 与 4i + 4，中间三角形 4i + 1..4i + 3，两端不相连
+        const int blocks = (vertices - 1) / 4;
+        if (blocks < 1) {
+            std::cerr << " K5 链至少 5 个顶点。" << std::endl;
+            return false;
+        }
+        vertices = 4 * blocks + 1;
+        for (int i = 0; i < blocks; ++i) {
+            const int u = 4 * i, v = 4 * i + 4;
+            for (int a = u + 1; a <= u + 3; ++a) {
+                pairs.insert(pairs.end(), { { u, a }, { a, v } });
+                for (int b = a + 1; b <= u + 3; ++b) pairs.emplace_back(a, b);
+            }
+        }
+        if (kind == SYNTHETIC_K5_CHAIN_CLOSED) pairs.emplace_back(0, vertices - 1);
+    }
+    finishSyntheticGraph(pairs, vertices, rng, graph);
+    return true;
+}
+
+const char* syntheticGraphName(SyntheticGraphKind kind) {
+    switch (kind) {
+    case SYNTHETIC_APOLLONIAN: return "apollonian";
+    case SYNTHETIC_K5_CHAIN: return "k5chain";
+    default: return "k5closed";
+    }
+}
+
+// 供原有 std::map 着色引擎使用；孤立标签也建空邻接表，着色结果覆盖全部标签
+void regionGraphFromCSR(const RegionAdjacencyCSR& csr, RegionGraph& graph) {
+    graph.adjacency.clear();
+    graph.colorMap.clear();
+    for (int l = 1; l <= csr.maxLabel; ++l) {
+        if (!csr.present[l]) continue;
+        graph.adjacency[l].insert(csr.neighbors.begin() + csr.offsets[l], csr.neighbors.begin() + csr.offsets[l + 1]);
+    }
+}
+
+// DIMACS 图格式（.col）：c 注释行，p edge 顶点数 边数，每条边一行 e u v（顶点从 1 起）
+bool writeDimacsGraph(const std::string& path, const RegionAdjacencyCSR& graph, const std::string& comment) {
+    std::ofstream out(path);
+    if (!out) return false;
+    if (!comment.empty()) out << "c " << comment << "\n";
+    out << "p edge " << graph.maxLabel << " " << graph.neighbors.size() / 2 << "\n";
+    for (int l = 1; l <= graph.maxLabel; ++l) {
+        for (int i = graph.offsets[l]; i < graph.offsets[l + 1]; ++i) {
+            if (graph.neighbors[i] > l) out << "e " << l << " " << graph.neighbors[i] << "\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+// 合成负载模式：
+//   Project1 --generate image <输出.ppm> <宽> <高> [随机种子]
+//   Project1 --generate labels <输出标签文件> <宽> <高> <区域数> [面积偏斜] [碎片率] [16|32] [随机种子]
+//   Project1 --generate graph <输出.col> <apollonian|k5chain|k5closed> <顶点数> [随机种子]
+int runGenerate(int argc, char** argv) {
+    const std::string kind = argc > 0 ? argv[0] : "";
+    const std::string path = argc > 1 ? argv[1] : "";
+    auto start = std::chrono::high_resolution_clock::now();
+    if (kind == "image" && argc >= 4) {
+        const cv::Size size(std::atoi(argv[2]), std::atoi(argv[3]));
+        const uint64_t seed = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1;
+        if (size.width <= 0 || size.height <= 0) {
+            std::cerr << " 参数非法：宽、高应为正数。" << std::endl;
+            return -1;
+        }
+        if (!writeTexturedPPM(path, size, seed)) {
+            std::cerr << " 无法写出 " << path << std::endl;
+            return -1;
+        }
+        const double ms = elapsedMs(start);
+        std::cout << " 纹理图像 " << size.width << " x " << size.height << "（" << size.area() / 1e6 << " MP，种子 " << seed
+            << "）已写出 " << path << "，" << ms << " ms，" << size.area() / 1e3 / std::max(ms, 1e-9) << " MP/s" << std::endl;
+        return 0;
+    }
+    if (kind == "labels" && argc >= 5) {
+        LabelMapSpec spec;
+        spec.size = cv::Size(std::atoi(argv[2]), std::atoi(argv[3]));
+        spec.regions = std::atoi(argv[4]);
+        if (argc > 5) spec.sizeSkew = std::atof(argv[5]);
+        if (argc > 6) spec.fragmentRate = std::atof(argv[6]);
+        if (argc > 7) spec.depth = std::atoi(argv[7]) == 16 ? CV_16U : CV_32S;
+        const uint64_t seed = argc > 8 ? std::strtoull(argv[8], nullptr, 10) : 1;
+        cv::Mat labels;
+        LabelMapInfo info;
+        if (!generateLabelMap(spec, seed, labels, &info)) return -1;
+        if (!writeLabelFile(path, labels)) {
+            std::cerr << " 无法写出 " << path << std::endl;
+            return -1;
+        }
+        std::cout << " 标签图 " << spec.size.width << " x " << spec.size.height << "，" << info.regions << " 个区域，面积 "
+            << info.smallestArea << " ~ " << info.largestArea << "（变异系数 " << info.areaCv << "），植入碎片 "
+            << info.plantedFragments << " 个，已写出 " << path << "，" << elapsedMs(start) << " ms" << std::endl;
+        return 0;
+    }
+    if (kind == "graph" && argc >= 4) {
+        const std::string name = argv[2];
+        SyntheticGraphKind graphKind = SYNTHETIC_APOLLONIAN;
+        if (name == "k5chain") graphKind = SYNTHETIC_K5_CHAIN;
+        else if (name == "k5closed") graphKind = SYNTHETIC_K5_CHAIN_CLOSED;
+        else if (name != "apollonian") {
+            std::cerr << " 未知的图类型：" << name << std::endl;
+            return -1;
+        }
+        const uint64_t seed = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1;
+        RegionAdjacencyCSR graph;
+        if (!generateSyntheticGraph(graphKind, std::atoi(argv[3]), seed, graph)) return -1;
+        const std::string comment = std::string(syntheticGraphName(graphKind)) + " seed " + std::to_string(seed);
+        if (!writeDimacsGraph(path, graph, comment)) {
+            std::cerr << " 无法写出 " << path << std::endl;
+            return -1;
+        }
+        std::cout << " " << syntheticGraphName(graphKind) << "：" << graph.maxLabel << " 个顶点，" << graph.neighbors.size() / 2
+            << " 条边，已写出 " << path << "，" << elapsedMs(start) << " ms" << std::endl;
+        return 0;
+    }
+    std::cerr << " 用法：--generate image <输出.ppm> <宽> <高> [随机种子]\n"
+        << "       --generate labels <输出标签文件> <宽> <高> <区域数> [面积偏斜] [碎片率] [16|32] [随机种子]\n"
+        << "       --generate graph <输出.col> <apollonian|k5chain|k5closed> <顶点数> [随机种子]" << std::endl;
+    return -1;
+}